@@ -437,6 +437,11 @@ ScopedAStatus DisplayConfigAIDL::getDebugProperty(const std::string& propName,
   int error = -EINVAL;
   char val[64] = {};
 
+  if (propName == sdm::kFrameLatencyStatsProp) {
+    *value = sdm::FrameLatencyStats::DumpAll();
+    return ScopedAStatus::ok();
+  }
+
   vendor_prop_name += propName.c_str();
   if (sdm::HWCDebugHandler::Get()->GetProperty(vendor_prop_name.c_str(), val) == sdm::kErrorNone) {
     *value = val;
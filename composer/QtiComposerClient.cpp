@@ -471,10 +471,12 @@ Return<void> QtiComposerClient::getDisplayType(uint64_t display, getDisplayType_
 Return<void> QtiComposerClient::getDozeSupport(uint64_t display, getDozeSupport_cb _hidl_cb) {
   int32_t hwc_support = 0;
 
-  std::lock_guard<std::mutex> lock(mDisplayDataMutex);
-  if (mDisplayData.find(display) == mDisplayData.end()) {
-    _hidl_cb(Error::BAD_DISPLAY, hwc_support);
-    return Void();
+  {
+    std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+    if (mDisplayData.find(display) == mDisplayData.end()) {
+      _hidl_cb(Error::BAD_DISPLAY, hwc_support);
+      return Void();
+    }
   }
 
   auto error = hwc_session_->GetDozeSupport(display, &hwc_support);
@@ -750,10 +752,12 @@ Return<void> QtiComposerClient::getRenderIntents(uint64_t display, common_V1_1::
     return Void();
   }
 
-  std::lock_guard<std::mutex> lock(mDisplayDataMutex);
-  if (mDisplayData.find(display) == mDisplayData.end()) {
-    _hidl_cb(Error::BAD_DISPLAY, intents);
-    return Void();
+  {
+    std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+    if (mDisplayData.find(display) == mDisplayData.end()) {
+      _hidl_cb(Error::BAD_DISPLAY, intents);
+      return Void();
+    }
   }
 
   intents.resize(count);
@@ -993,10 +997,12 @@ Return<void> QtiComposerClient::getDisplayCapabilities(uint64_t display,
 
   hidl_vec<composer_V2_3::IComposerClient::DisplayCapability> capabilities;
 
-  std::lock_guard<std::mutex> lock(mDisplayDataMutex);
-  if (mDisplayData.find(display) == mDisplayData.end()) {
-     _hidl_cb(Error::BAD_DISPLAY, capabilities);
-    return Void();
+  {
+    std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+    if (mDisplayData.find(display) == mDisplayData.end()) {
+      _hidl_cb(Error::BAD_DISPLAY, capabilities);
+      return Void();
+    }
   }
 
   HwcDisplayConnectionType display_conn_type = HwcDisplayConnectionType::INTERNAL;
@@ -1069,10 +1075,12 @@ Return<void> QtiComposerClient::getDisplayBrightnessSupport(uint64_t display,
                                                          getDisplayBrightnessSupport_cb _hidl_cb) {
   bool support = false;
 
-  std::lock_guard<std::mutex> lock(mDisplayDataMutex);
-  if (mDisplayData.find(display) == mDisplayData.end()) {
-    _hidl_cb(Error::BAD_DISPLAY, support);
-    return Void();
+  {
+    std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+    if (mDisplayData.find(display) == mDisplayData.end()) {
+      _hidl_cb(Error::BAD_DISPLAY, support);
+      return Void();
+    }
   }
 
   auto error = hwc_session_->GetDisplayBrightnessSupport(display, &support);
@@ -1310,6 +1318,10 @@ Error QtiComposerClient::CommandReader::parse() {
       break;
     }
 
+    if (!isLayerBatchCommand(qticommand)) {
+      endLayerBatch();
+    }
+
     bool parsed = false;
     switch (qticommand) {
       case IQtiComposerClient::Command::SET_LAYER_TYPE:
@@ -1338,9 +1350,81 @@ Error QtiComposerClient::CommandReader::parse() {
     }
   }
 
+  endLayerBatch();
+
   return (isEmpty()) ? Error::NONE : Error::BAD_PARAMETER;
 }
 
+bool QtiComposerClient::CommandReader::isLayerBatchCommand(IQtiComposerClient::Command command) {
+  switch (command) {
+    case IQtiComposerClient::Command::SET_LAYER_TYPE:
+    case IQtiComposerClient::Command::SET_LAYER_FLAG_3_1:
+      return true;
+    default:
+      break;
+  }
+
+  // Cursor position goes through HWCSession as it also updates the display, so it is not batched.
+  switch (static_cast<IComposerClient::Command>(command)) {
+    case IComposerClient::Command::SELECT_LAYER:
+    case IComposerClient::Command::SET_LAYER_BUFFER:
+    case IComposerClient::Command::SET_LAYER_SURFACE_DAMAGE:
+    case IComposerClient::Command::SET_LAYER_BLEND_MODE:
+    case IComposerClient::Command::SET_LAYER_COLOR:
+    case IComposerClient::Command::SET_LAYER_COMPOSITION_TYPE:
+    case IComposerClient::Command::SET_LAYER_DATASPACE:
+    case IComposerClient::Command::SET_LAYER_DISPLAY_FRAME:
+    case IComposerClient::Command::SET_LAYER_PLANE_ALPHA:
+    case IComposerClient::Command::SET_LAYER_SIDEBAND_STREAM:
+    case IComposerClient::Command::SET_LAYER_SOURCE_CROP:
+    case IComposerClient::Command::SET_LAYER_TRANSFORM:
+    case IComposerClient::Command::SET_LAYER_VISIBLE_REGION:
+    case IComposerClient::Command::SET_LAYER_Z_ORDER:
+    case IComposerClient::Command::SET_LAYER_PER_FRAME_METADATA:
+    case IComposerClient::Command::SET_LAYER_FLOAT_COLOR:
+    case IComposerClient::Command::SET_LAYER_COLOR_TRANSFORM:
+    case IComposerClient::Command::SET_LAYER_PER_FRAME_METADATA_BLOBS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+sdm::HWCDisplay* QtiComposerClient::CommandReader::getBatchDisplay(Error* error) {
+  if (!mBatchDisplay) {
+    mBatchDisplay = mClient.hwc_session_->LockDisplayForLayerBatch(mDisplay);
+    if (!mBatchDisplay) {
+      *error = Error::BAD_DISPLAY;
+    }
+  }
+
+  return mBatchDisplay;
+}
+
+sdm::HWCLayer* QtiComposerClient::CommandReader::getBatchLayer(Error* error) {
+  if (!getBatchDisplay(error)) {
+    return nullptr;
+  }
+
+  if (!mBatchLayer) {
+    mBatchLayer = mBatchDisplay->GetHWCLayer(mLayer);
+    if (!mBatchLayer) {
+      *error = Error::BAD_LAYER;
+    }
+  }
+
+  return mBatchLayer;
+}
+
+void QtiComposerClient::CommandReader::endLayerBatch() {
+  if (mBatchDisplay) {
+    mClient.hwc_session_->UnlockDisplayForLayerBatch(mDisplay);
+  }
+
+  mBatchDisplay = nullptr;
+  mBatchLayer = nullptr;
+}
+
 bool QtiComposerClient::CommandReader::parseSelectDisplay(uint16_t length) {
   if (length != CommandWriter::kSelectDisplayLength) {
     return false;
@@ -1358,6 +1442,7 @@ bool QtiComposerClient::CommandReader::parseSelectLayer(uint16_t length) {
   }
 
   mLayer = read64();
+  mBatchLayer = nullptr;
 
   return true;
 }
@@ -1393,8 +1478,7 @@ bool QtiComposerClient::CommandReader::parseSetClientTarget(uint16_t length) {
   shared_ptr<Fence> fence = nullptr;
   readFence(&fence, "fbt");
   auto dataspace = readSigned();
-  auto damage = readRegion((length - 4) / 4);
-  hwc_region region = {damage.size(), damage.data()};
+  auto region = readRegion((length - 4) / 4);
   auto err = lookupBuffer(BufferCache::CLIENT_TARGETS, slot, useCache, clientTarget, &clientTarget);
   if (err == Error::NONE) {
     auto error = mClient.hwc_session_->SetClientTarget(mDisplay, clientTarget, fence,
@@ -1552,8 +1636,8 @@ Error QtiComposerClient::CommandReader::postPresentDisplay(shared_ptr<Fence>* pr
     return Error::NONE;
   }
 
-  std::vector<Layer> layers;
-  std::vector<shared_ptr<Fence>> releaseFences;
+  std::vector<Layer>& layers = mReleaseLayers;
+  std::vector<shared_ptr<Fence>>& releaseFences = mReleaseFences;
   layers.resize(count);
   releaseFences.resize(count);
   err = mClient.hwc_session_->GetReleaseFences(mDisplay, &count, layers.data(), &releaseFences);
@@ -1565,16 +1649,18 @@ Error QtiComposerClient::CommandReader::postPresentDisplay(shared_ptr<Fence>* pr
   }
   mWriter.setPresentFence(*presentFence);
   mWriter.setReleaseFences(layers, releaseFences);
+  // The writer holds its own fds, drop the references but keep the storage.
+  releaseFences.clear();
 
   return Error::NONE;
 }
 
 Error QtiComposerClient::CommandReader::postValidateDisplay(uint32_t& types_count,
                                                             uint32_t& reqs_count) {
-  std::vector<Layer> changedLayers;
-  std::vector<IComposerClient::Composition> compositionTypes;
-  std::vector<Layer> requestedLayers;
-  std::vector<uint32_t> requestMasks;
+  std::vector<Layer>& changedLayers = mChangedLayers;
+  std::vector<IComposerClient::Composition>& compositionTypes = mCompositionTypes;
+  std::vector<Layer>& requestedLayers = mRequestedLayers;
+  std::vector<uint32_t>& requestMasks = mRequestMasks;
   IComposerClient::ClientTargetProperty clientTargetProperty;
   changedLayers.resize(types_count);
   compositionTypes.resize(types_count);
@@ -1697,8 +1783,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerBuffer(uint16_t length) {
   readFence(&fence, "layer");
   auto error = lookupBuffer(BufferCache::LAYER_BUFFERS, slot, useCache, buffer, &buffer);
   if (error == Error::NONE) {
-    auto err = mClient.hwc_session_->SetLayerBuffer(mDisplay, mLayer, buffer, fence);
-    error = static_cast<Error>(err);
+    error = callLayerFunction(&sdm::HWCLayer::SetLayerBuffer, buffer, fence);
     auto updateBufErr = updateBuffer(BufferCache::LAYER_BUFFERS, slot, useCache, buffer);
     if (static_cast<Error>(error) == Error::NONE) {
       error = updateBufErr;
@@ -1718,8 +1803,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerSurfaceDamage(uint16_t lengt
   }
 
   auto damage = readRegion(length / 4);
-  hwc_region region = {damage.size(), damage.data()};
-  auto err = mClient.hwc_session_->SetLayerSurfaceDamage(mDisplay, mLayer, region);
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerSurfaceDamage, damage);
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1732,7 +1816,11 @@ bool QtiComposerClient::CommandReader::parseSetLayerBlendMode(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerBlendMode(mDisplay, mLayer, readSigned());
+  auto mode = readSigned();
+  auto err = Error::BAD_PARAMETER;
+  if (mode >= HWC2_BLEND_MODE_INVALID && mode <= HWC2_BLEND_MODE_COVERAGE) {
+    err = callLayerFunction(&sdm::HWCLayer::SetLayerBlendMode, static_cast<HWC2::BlendMode>(mode));
+  }
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1746,7 +1834,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerColor(uint16_t length) {
   }
   auto color = readColor();
   hwc_color_t hwc_color{color.r, color.g, color.b, color.a};
-  auto err = mClient.hwc_session_->SetLayerColor(mDisplay, mLayer, hwc_color);
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerColor, hwc_color);
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1759,7 +1847,8 @@ bool QtiComposerClient::CommandReader::parseSetLayerCompositionType(uint16_t len
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerCompositionType(mDisplay, mLayer, readSigned());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerCompositionType,
+                               static_cast<HWC2::Composition>(readSigned()));
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1772,7 +1861,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerDataspace(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerDataspace(mDisplay, mLayer, readSigned());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerDataspace, readSigned());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1785,7 +1874,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerDisplayFrame(uint16_t length
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerDisplayFrame(mDisplay, mLayer, readRect());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerDisplayFrame, readRect());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1798,7 +1887,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerPlaneAlpha(uint16_t length)
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerPlaneAlpha(mDisplay, mLayer, readFloat());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerPlaneAlpha, readFloat());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1820,7 +1909,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerSourceCrop(uint16_t length)
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerSourceCrop(mDisplay, mLayer, readFRect());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerSourceCrop, readFRect());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1833,7 +1922,8 @@ bool QtiComposerClient::CommandReader::parseSetLayerTransform(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerTransform(mDisplay, mLayer, readSigned());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerTransform,
+                               static_cast<HWC2::Transform>(readSigned()));
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1847,9 +1937,8 @@ bool QtiComposerClient::CommandReader::parseSetLayerVisibleRegion(uint16_t lengt
     return false;
   }
 
-  auto region = readRegion(length / 4);
-  hwc_region visibleRegion = {region.size(), region.data()};
-  auto err = mClient.hwc_session_->SetLayerVisibleRegion(mDisplay, mLayer, visibleRegion);
+  auto visibleRegion = readRegion(length / 4);
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerVisibleRegion, visibleRegion);
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1862,7 +1951,12 @@ bool QtiComposerClient::CommandReader::parseSetLayerZOrder(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerZOrder(mDisplay, mLayer, read());
+  auto z = read();
+  auto err = Error::NONE;
+  auto hwc_display = getBatchDisplay(&err);
+  if (hwc_display) {
+    err = static_cast<Error>(hwc_display->SetLayerZOrder(mLayer, z));
+  }
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1875,8 +1969,12 @@ bool QtiComposerClient::CommandReader::parseSetLayerType(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerType(mDisplay, mLayer,
-            static_cast<IQtiComposerClient::LayerType>(read()));
+  auto type = static_cast<IQtiComposerClient::LayerType>(read());
+  auto err = Error::NONE;
+  auto hwc_display = getBatchDisplay(&err);
+  if (hwc_display) {
+    err = static_cast<Error>(hwc_display->SetLayerType(mLayer, type));
+  }
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1889,8 +1987,8 @@ bool QtiComposerClient::CommandReader::parseSetLayerFlag(uint16_t length) {
     return false;
   }
 
-  auto err = mClient.hwc_session_->SetLayerFlag(mDisplay, mLayer,
-                                                static_cast<IQtiComposerClient::LayerFlag>(read()));
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerFlag,
+                               static_cast<IQtiComposerClient::LayerFlag>(read()));
   if (static_cast<Error>(err) != Error::NONE) {
      mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1922,8 +2020,10 @@ bool QtiComposerClient::CommandReader::parseSetLayerPerFrameMetadata(uint16_t le
     values.push_back(m.value);
   }
 
-  auto err = mClient.hwc_session_->SetLayerPerFrameMetadata(mDisplay, mLayer, metadata.size(),
-                                                            keys.data(), values.data());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerPerFrameMetadata,
+                               static_cast<uint32_t>(metadata.size()),
+                               reinterpret_cast<const sdm::PerFrameMetadataKey*>(keys.data()),
+                               values.data());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -1953,7 +2053,7 @@ bool QtiComposerClient::CommandReader::parseSetLayerColorTransform(uint16_t leng
     matrix[i] = readFloat();
   }
 
-  auto error = mClient.hwc_session_->SetLayerColorTransform(mDisplay, mLayer, matrix);
+  auto error = callLayerFunction(&sdm::HWCLayer::SetLayerColorTransform, matrix);
   if (static_cast<Error>(error) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(error));
   }
@@ -2000,10 +2100,10 @@ bool QtiComposerClient::CommandReader::parseSetLayerPerFrameMetadataBlobs(uint16
       blob_of_data_.push_back(m.blob[i]);
     }
   }
-  auto err = mClient.hwc_session_->SetLayerPerFrameMetadataBlobs(mDisplay, mLayer, metadata.size(),
-                                                                 keys.data(),
-                                                                 sizes_of_metablob_.data(),
-                                                                 blob_of_data_.data());
+  auto err = callLayerFunction(&sdm::HWCLayer::SetLayerPerFrameMetadataBlobs,
+                               static_cast<uint32_t>(metadata.size()),
+                               reinterpret_cast<const sdm::PerFrameMetadataKey*>(keys.data()),
+                               sizes_of_metablob_.data(), blob_of_data_.data());
   if (static_cast<Error>(err) != Error::NONE) {
     mWriter.setError(getCommandLoc(), static_cast<Error>(err));
   }
@@ -2024,33 +2124,21 @@ bool QtiComposerClient::CommandReader::parseSetDisplayElapseTime(uint16_t length
   return true;
 }
 
+// Rects and float rects are sent as left, top, right, bottom words, same as the hwc structs.
+static_assert(sizeof(hwc_rect_t) == 4 * sizeof(int32_t), "hwc_rect_t does not match the wire");
+static_assert(sizeof(hwc_frect_t) == 4 * sizeof(float), "hwc_frect_t does not match the wire");
+
 hwc_rect_t QtiComposerClient::CommandReader::readRect() {
-  return hwc_rect_t{
-    readSigned(),
-    readSigned(),
-    readSigned(),
-    readSigned(),
-  };
+  return readStruct<hwc_rect_t>();
 }
 
-std::vector<hwc_rect_t> QtiComposerClient::CommandReader::readRegion(size_t count) {
-  std::vector<hwc_rect_t> region;
-  region.reserve(count);
-  while (count > 0) {
-    region.emplace_back(readRect());
-    count--;
-  }
-
-  return region;
+hwc_region_t QtiComposerClient::CommandReader::readRegion(size_t count) {
+  // The region points into the command data, callees copy the rects they keep.
+  return hwc_region_t{count, readArray<hwc_rect_t>(count)};
 }
 
 hwc_frect_t QtiComposerClient::CommandReader::readFRect() {
-  return hwc_frect_t{
-    readFloat(),
-    readFloat(),
-    readFloat(),
-    readFloat(),
-  };
+  return readStruct<hwc_frect_t>();
 }
 
 Error QtiComposerClient::CommandReader::lookupBufferCacheEntryLocked(BufferCache cache,
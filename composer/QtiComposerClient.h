@@ -331,12 +331,40 @@ class QtiComposerClient : public IQtiComposerClient {
     bool parseCommonCmd(IComposerClient::Command command, uint16_t length);
 
     hwc_rect_t readRect();
-    std::vector<hwc_rect_t> readRegion(size_t count);
+    hwc_region_t readRegion(size_t count);
     hwc_frect_t readFRect();
+
+    // Consecutive layer commands of the selected display are applied under one hold of the
+    // display lock, with the selected HWCLayer looked up once per SELECT_LAYER.
+    bool isLayerBatchCommand(IQtiComposerClient::Command command);
+    sdm::HWCDisplay* getBatchDisplay(Error* error);
+    sdm::HWCLayer* getBatchLayer(Error* error);
+    void endLayerBatch();
+
+    template <typename... Params, typename... Args>
+    Error callLayerFunction(HWC2::Error (sdm::HWCLayer::*member)(Params...), Args&&... args) {
+      Error error = Error::NONE;
+      auto hwc_layer = getBatchLayer(&error);
+      if (hwc_layer) {
+        error = static_cast<Error>((hwc_layer->*member)(std::forward<Args>(args)...));
+      }
+      return error;
+    }
+
     QtiComposerClient& mClient;
     CommandWriter& mWriter;
     Display mDisplay;
     Layer mLayer;
+    sdm::HWCDisplay* mBatchDisplay = nullptr;
+    sdm::HWCLayer* mBatchLayer = nullptr;
+
+    // Results of the post validate and present steps, kept to reuse their storage every frame.
+    std::vector<Layer> mChangedLayers;
+    std::vector<IComposerClient::Composition> mCompositionTypes;
+    std::vector<Layer> mRequestedLayers;
+    std::vector<uint32_t> mRequestMasks;
+    std::vector<Layer> mReleaseLayers;
+    std::vector<shared_ptr<Fence>> mReleaseFences;
 
     // Buffer cache impl
     enum class BufferCache {
@@ -371,6 +399,8 @@ class QtiComposerClient : public IQtiComposerClient {
   static constexpr size_t kWriterInitialSize = 64 * 1024 / sizeof(uint32_t) - 16;
   CommandWriter mWriter;
   CommandReader mReader;
+  // Lock order is HWCSession's locker_[display] first, the command reader looks up buffer slots
+  // with a layer batch held. Never call into HWCSession with this held.
   std::mutex mDisplayDataMutex;
   std::unordered_map<Display, DisplayData> mDisplayData;
 };
@@ -28,6 +28,7 @@
 
 #include <limits>
 #include <algorithm>
+#include <type_traits>
 #include <vector>
 #include <string>
 
@@ -63,7 +64,12 @@ class CommandWriter {
     reset();
   }
 
-  ~CommandWriter() { reset(); }
+  ~CommandWriter() {
+    reset();
+    for (auto handle : mFenceHandles) {
+      native_handle_delete(handle);
+    }
+  }
 
   void reset() {
     mDataWritten = 0;
@@ -72,10 +78,15 @@ class CommandWriter {
     // handles in mDataHandles are owned by the caller
     mDataHandles.clear();
 
-    // handles in mTemporaryHandles are owned by the writer
+    // handles in mTemporaryHandles are owned by the writer, fence handles are kept for the next
+    // frame once their fds are closed
     for (auto handle : mTemporaryHandles) {
       native_handle_close(handle);
-      native_handle_delete(handle);
+      if (handle->numFds == 1 && handle->numInts == 0) {
+        mFenceHandles.push_back(handle);
+      } else {
+        native_handle_delete(handle);
+      }
     }
     mTemporaryHandles.clear();
   }
@@ -630,7 +641,13 @@ class CommandWriter {
   }
 
   native_handle_t* getTemporaryHandle(int numFds, int numInts) {
-    native_handle_t* handle = native_handle_create(numFds, numInts);
+    native_handle_t* handle = nullptr;
+    if (numFds == 1 && numInts == 0 && !mFenceHandles.empty()) {
+      handle = mFenceHandles.back();
+      mFenceHandles.pop_back();
+    } else {
+      handle = native_handle_create(numFds, numInts);
+    }
     if (handle) {
       mTemporaryHandles.push_back(handle);
     }
@@ -687,6 +704,8 @@ class CommandWriter {
 
   std::vector<hidl_handle> mDataHandles;
   std::vector<native_handle_t *> mTemporaryHandles;
+  // closed single fd handles of earlier frames, reused for fences
+  std::vector<native_handle_t *> mFenceHandles;
 
   std::unique_ptr<CommandQueueType> mQueue;
 };
@@ -806,6 +825,28 @@ class CommandReaderBase {
     return (static_cast<uint64_t>(hi) << 32) | lo;
   }
 
+  // Decodes a struct whose fields are laid out as consecutive 32-bit words in the command.
+  template <typename T>
+  T readStruct() {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) % sizeof(uint32_t)) == 0,
+                  "struct must be made of 32-bit words");
+    T val;
+    memcpy(&val, &mData[mDataRead], sizeof(val));
+    mDataRead += sizeof(T) / sizeof(uint32_t);
+    return val;
+  }
+
+  // Returns count structs of 32-bit words in place in the command data, without a copy. The
+  // view is valid until the next readQueue.
+  template <typename T>
+  const T* readArray(size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) % sizeof(uint32_t)) == 0 &&
+                  alignof(T) <= alignof(uint32_t), "struct must be made of 32-bit words");
+    auto view = reinterpret_cast<const T*>(&mData[mDataRead]);
+    mDataRead += count * (sizeof(T) / sizeof(uint32_t));
+    return view;
+  }
+
   void readBlob(uint32_t size, void* blob) {
     memcpy(blob, &mData[mDataRead], size);
     uint32_t numElements = size / sizeof(uint32_t);
@@ -18,6 +18,7 @@
  */
 
 #include <log/log.h>
+#include <QtiGrallocPriv.h>
 
 #include "QtiComposerHandleImporter.h"
 #include <cutils/properties.h>
@@ -32,7 +33,12 @@ namespace V3_1 {
 
 using android::hardware::graphics::mapper::V4_0::Error;
 
-ComposerHandleImporter::ComposerHandleImporter() : mInitialized(false) {}
+ComposerHandleImporter::ComposerHandleImporter()
+  : mInitialized(false),
+    mImportTable([this](buffer_handle_t handle, buffer_handle_t *imported) {
+                   return mapperImport(handle, imported);
+                 },
+                 [this](buffer_handle_t imported) { mapperFree(imported); }) {}
 
 void ComposerHandleImporter::initialize() {
     // allow only one client
@@ -96,25 +102,29 @@ void ComposerHandleImporter::InoFdMapRemove(int fd) {
   }
 }
 
-// In IComposer, any buffer_handle_t is owned by the caller and we need to
-// make a clone for hwcomposer2.  We also need to translate empty handle
-// to nullptr.  This function does that, in-place.
-bool ComposerHandleImporter::importBuffer(buffer_handle_t& handle) {
-  if (!handle) {
-    return true;
+bool ComposerHandleImporter::getImportKey(buffer_handle_t handle, HandleImportKey *key) {
+  if (private_handle_t::validate(handle) != 0) {
+    return false;
   }
 
-  if (!handle->numFds && !handle->numInts) {
-    handle = nullptr;
-    return true;
+  struct stat buf;
+  if (fstat(handle->data[0], &buf)) {
+    return false;
   }
 
-  Mutex::Autolock lock(mLock);
-  if (!mInitialized) {
-    initialize();
+  key->ino = (uint64_t)buf.st_ino;
+  key->buffer_id = reinterpret_cast<const private_handle_t *>(handle)->id;
+  return true;
+}
+
+bool ComposerHandleImporter::mapperImport(buffer_handle_t handle, buffer_handle_t *imported) {
+  sp<IMapper> mapper;
+  {
+    Mutex::Autolock lock(mLock);
+    mapper = mMapper;
   }
 
-  if (mMapper == nullptr) {
+  if (mapper == nullptr) {
     ALOGE("%s: mMapper is null!", __FUNCTION__);
     return false;
   }
@@ -122,11 +132,11 @@ bool ComposerHandleImporter::importBuffer(buffer_handle_t& handle) {
   Error error;
   buffer_handle_t importedHandle;
 
-  auto ret = mMapper->importBuffer(hidl_handle(handle),
-                                   [&](const auto &tmpError, const auto &tmpBufferHandle) {
-                                     error = tmpError;
-                                     importedHandle = static_cast<buffer_handle_t>(tmpBufferHandle);
-                                   });
+  auto ret = mapper->importBuffer(hidl_handle(handle),
+                                  [&](const auto &tmpError, const auto &tmpBufferHandle) {
+                                    error = tmpError;
+                                    importedHandle = static_cast<buffer_handle_t>(tmpBufferHandle);
+                                  });
 
   if (!ret.isOk()) {
     ALOGE("%s: mapper importBuffer failed: %s", __FUNCTION__, ret.description().c_str());
@@ -137,41 +147,75 @@ bool ComposerHandleImporter::importBuffer(buffer_handle_t& handle) {
     return false;
   }
 
-  handle = importedHandle;
+  *imported = importedHandle;
 
   if (enable_memory_mapping_) {
-    for (int i = 0; i < handle->numFds; i++) {
+    Mutex::Autolock lock(mLock);
+    for (int i = 0; i < importedHandle->numFds; i++) {
       // handle->data is the int array of fds. run insert on all fds.
-      InoFdMapInsert(handle->data[i]);
+      InoFdMapInsert(importedHandle->data[i]);
     }
   }
 
   return true;
 }
 
-void ComposerHandleImporter::freeBuffer(buffer_handle_t handle) {
-  if (!handle) {
-    return;
+void ComposerHandleImporter::mapperFree(buffer_handle_t imported) {
+  sp<IMapper> mapper;
+  {
+    Mutex::Autolock lock(mLock);
+    mapper = mMapper;
+    if (mapper != nullptr && enable_memory_mapping_) {
+      for (int i = 0; i < imported->numFds; i++) {
+        // handle->data is the int array of fds. run remove on all fds.
+        InoFdMapRemove(imported->data[i]);
+      }
+    }
   }
 
-  Mutex::Autolock lock(mLock);
-
-  if (mMapper == nullptr) {
+  if (mapper == nullptr) {
     ALOGE("%s: mMapper is null!", __FUNCTION__);
     return;
   }
 
-  if (enable_memory_mapping_) {
-    for (int i = 0; i < handle->numFds; i++) {
-      // handle->data is the int array of fds. run remove on all fds.
-      InoFdMapRemove(handle->data[i]);
+  auto ret = mapper->freeBuffer(const_cast<native_handle_t *>(imported));
+  if (!ret.isOk()) {
+    ALOGE("%s: mapper freeBuffer failed: %s", __FUNCTION__, ret.description().c_str());
+  }
+}
+
+// In IComposer, any buffer_handle_t is owned by the caller and we need to
+// make a clone for hwcomposer2.  We also need to translate empty handle
+// to nullptr.  This function does that, in-place.
+bool ComposerHandleImporter::importBuffer(buffer_handle_t& handle) {
+  if (!handle) {
+    return true;
+  }
+
+  if (!handle->numFds && !handle->numInts) {
+    handle = nullptr;
+    return true;
+  }
+
+  {
+    Mutex::Autolock lock(mLock);
+    if (!mInitialized) {
+      initialize();
     }
   }
 
-  auto ret = mMapper->freeBuffer(const_cast<native_handle_t *>(handle));
-  if (!ret.isOk()) {
-    ALOGE("%s: mapper freeBuffer failed: %s", __FUNCTION__, ret.description().c_str());
+  // The mapper is called without mLock held, the table only locks around its own bookkeeping.
+  HandleImportKey key;
+  bool keyed = getImportKey(handle, &key);
+  return mImportTable.Import(keyed ? &key : nullptr, handle, &handle);
+}
+
+void ComposerHandleImporter::freeBuffer(buffer_handle_t handle) {
+  if (!handle) {
+    return;
   }
+
+  mImportTable.Release(handle);
 }
 
 }  // namespace V3_1
@@ -26,6 +26,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "handle_import_table.h"
+
 namespace vendor {
 namespace qti {
 namespace hardware {
@@ -39,6 +41,8 @@ using ::android::Mutex;
 using ::android::sp;
 using ::android::hardware::hidl_handle;
 using ::android::hardware::graphics::mapper::V4_0::IMapper;
+using ::sdm::HandleImportKey;
+using ::sdm::HandleImportTable;
 
 class ComposerHandleImporter {
  public:
@@ -47,6 +51,8 @@ class ComposerHandleImporter {
   // In IComposer, any buffer_handle_t is owned by the caller and we need to
   // make a clone for hwcomposer2.  We also need to translate empty handle
   // to nullptr.  This function does that, in-place.
+  // A buffer that is still imported, e.g. resent under a new slot, gets the
+  // existing clone back with one more reference.
   bool importBuffer(buffer_handle_t& handle);
   void freeBuffer(buffer_handle_t handle);
   void initialize();
@@ -55,11 +61,16 @@ class ComposerHandleImporter {
   void InoFdMapRemove(int fd);
 
  private:
+  bool getImportKey(buffer_handle_t handle, HandleImportKey *key);
+  bool mapperImport(buffer_handle_t handle, buffer_handle_t *imported);
+  void mapperFree(buffer_handle_t imported);
+
   Mutex mLock;
   bool mInitialized = false;
   bool enable_memory_mapping_ = false;
   std::map<uint64_t, std::vector<uint32_t>> ino_fds_map_;
   sp<IMapper> mMapper;
+  HandleImportTable mImportTable;
 };
 
 }  // namespace V3_1
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+#include <QtiGrallocPriv.h>
+#include <gr_utils.h>
+#include <utils/debug.h>
+
+#include <vector>
+
+#include "cpu_blit_common.h"
+
+#define __CLASS__ "CPUBlitCommon"
+
+using aidl::android::hardware::graphics::common::PlaneLayout;
+
+namespace sdm {
+
+static CPUPixelFormat GetCPUFormat(int format) {
+  switch (format) {
+    case HAL_PIXEL_FORMAT_RGBA_8888:
+    case HAL_PIXEL_FORMAT_RGBX_8888:
+      return kCPUFormatRGBA8888;
+    case HAL_PIXEL_FORMAT_NV12_ENCODEABLE:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+      return kCPUFormatNV12;
+    case HAL_PIXEL_FORMAT_YCbCr_420_P010:
+    case HAL_PIXEL_FORMAT_YCbCr_420_P010_VENUS:
+      return kCPUFormatP010;
+    default:
+      return kCPUFormatInvalid;
+  }
+}
+
+static int SyncBuffer(int fd, uint64_t flags) {
+  struct dma_buf_sync sync = {};
+  sync.flags = flags;
+  if (ioctl(fd, INT(DMA_BUF_IOCTL_SYNC), &sync)) {
+    DLOGW("DMA_BUF_IOCTL_SYNC failed. fd = %d error = %s", fd, strerror(errno));
+    return -errno;
+  }
+
+  return 0;
+}
+
+int CPUBlitCommon::MapBuffer(const native_handle_t *hnd, bool write, CPUMappedBuffer *buffer) {
+  private_handle_t *handle = const_cast<private_handle_t *>(
+                                 reinterpret_cast<const private_handle_t *>(hnd));
+  if (!handle || private_handle_t::validate(handle) != 0) {
+    DLOGE("Invalid buffer handle %p", hnd);
+    return -EINVAL;
+  }
+
+  CPUPixelFormat format = GetCPUFormat(handle->format);
+  if ((format == kCPUFormatInvalid) || (handle->flags & (qtigralloc::PRIV_FLAGS_UBWC_ALIGNED |
+      qtigralloc::PRIV_FLAGS_UBWC_ALIGNED_PI | qtigralloc::PRIV_FLAGS_SECURE_BUFFER))) {
+    DLOGW("Unsupported buffer format %d flags 0x%x", handle->format, handle->flags);
+    return -ENOTSUP;
+  }
+
+  std::vector<PlaneLayout> plane_layouts;
+  if (gralloc::GetPlaneLayout(handle, &plane_layouts) != gralloc::Error::NONE ||
+      plane_layouts.size() < ((format == kCPUFormatRGBA8888) ? 1 : 2)) {
+    DLOGE("Failed to get plane layout for format %d", handle->format);
+    return -EINVAL;
+  }
+
+  void *base = mmap(nullptr, handle->size, PROT_READ | (write ? PROT_WRITE : 0), MAP_SHARED,
+                    handle->fd, 0);
+  if (base == MAP_FAILED) {
+    DLOGE("mmap failed. fd = %d size = %u error = %s", handle->fd, handle->size, strerror(errno));
+    return -errno;
+  }
+
+  SyncBuffer(handle->fd, DMA_BUF_SYNC_START | (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ));
+
+  buffer->base = base;
+  buffer->size = handle->size;
+  buffer->fd = handle->fd;
+  buffer->write = write;
+  buffer->image.format = format;
+  buffer->image.width = UINT32(handle->unaligned_width);
+  buffer->image.height = UINT32(handle->unaligned_height);
+  for (size_t i = 0; i < ((format == kCPUFormatRGBA8888) ? 1 : 2); i++) {
+    buffer->image.planes[i] = reinterpret_cast<uint8_t *>(base) + plane_layouts[i].offsetInBytes;
+    buffer->image.stride_bytes[i] = UINT32(plane_layouts[i].strideInBytes);
+  }
+
+  return 0;
+}
+
+void CPUBlitCommon::UnmapBuffer(CPUMappedBuffer *buffer) {
+  if (!buffer->base) {
+    return;
+  }
+
+  SyncBuffer(buffer->fd, DMA_BUF_SYNC_END | (buffer->write ? DMA_BUF_SYNC_RW :
+                                                             DMA_BUF_SYNC_READ));
+  munmap(buffer->base, buffer->size);
+  *buffer = CPUMappedBuffer();
+}
+
+int CPUBlitCommon::WaitOnInputFence(const std::vector<shared_ptr<Fence>> &in_fences) {
+  DTRACE_SCOPED();
+
+  // Unlike the GPU path there is no queue to defer the wait to, block until inputs are ready.
+  shared_ptr<Fence> in_fence = Fence::Merge(in_fences, true /* ignore signaled*/);
+  if (in_fence == nullptr) {
+    return 0;
+  }
+
+  if (Fence::Wait(in_fence) != kErrorNone) {
+    DLOGE("Failed to wait on input fence: %s", Fence::GetStr(in_fence).c_str());
+    return -1;
+  }
+
+  return 0;
+}
+
+CPUColorMatrix CPUBlitCommon::GetColorMatrix(const native_handle_t *hnd) {
+  ColorMetaData color_metadata = {};
+  void *handle = const_cast<native_handle_t *>(hnd);
+  if (gralloc::GetMetaDataValue(handle, qtigralloc::MetadataType_ColorMetadata.value,
+                                &color_metadata) != gralloc::Error::NONE) {
+    // Match the GPU path which always converts with BT.601.
+    return kCPUMatrixBT601;
+  }
+
+  switch (color_metadata.colorPrimaries) {
+    case ColorPrimaries_BT709_5:
+      return kCPUMatrixBT709;
+    case ColorPrimaries_BT2020:
+      return kCPUMatrixBT2020;
+    default:
+      return kCPUMatrixBT601;
+  }
+}
+
+CPURect CPUBlitCommon::ToCPURect(const GLRect &rect) {
+  CPURect cpu_rect;
+  cpu_rect.left = INT32(rect.left);
+  cpu_rect.top = INT32(rect.top);
+  cpu_rect.right = INT32(rect.right);
+  cpu_rect.bottom = INT32(rect.bottom);
+
+  return cpu_rect;
+}
+
+}  // namespace sdm
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_BLIT_COMMON_H__
+#define __CPU_BLIT_COMMON_H__
+
+#include <cutils/native_handle.h>
+#include <utils/fence.h>
+
+#include <vector>
+
+#include "cpu_blit_kernels.h"
+#include "gl_common.h"
+
+namespace sdm {
+
+// CPU mapping of a gralloc buffer for the duration of one blit.
+struct CPUMappedBuffer {
+  CPUImage image;
+  void *base = nullptr;
+  size_t size = 0;
+  int fd = -1;
+  bool write = false;
+};
+
+class CPUBlitCommon {
+ public:
+  // Maps a linear, non-secure RGBA8888/NV12/P010 buffer. Returns -ENOTSUP for other buffers.
+  virtual int MapBuffer(const native_handle_t *hnd, bool write, CPUMappedBuffer *buffer);
+  virtual void UnmapBuffer(CPUMappedBuffer *buffer);
+  virtual int WaitOnInputFence(const std::vector<shared_ptr<Fence>> &in_fences);
+  virtual CPUColorMatrix GetColorMatrix(const native_handle_t *hnd);
+  virtual CPURect ToCPURect(const GLRect &rect);
+
+ protected:
+  virtual ~CPUBlitCommon() { }
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_BLIT_COMMON_H__
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cpu_blit_kernels.h"
+
+namespace sdm {
+
+// Kernels below are branch free integer loops over precomputed sample maps so that the compiler
+// can vectorize the inner loops. All conversions use 14 bit fixed point coefficients.
+static const int kFracBits = 14;
+static const int32_t kFracHalf = 1 << (kFracBits - 1);
+
+struct RGBToYUVCoeffs {
+  int32_t y[3] = {};
+  int32_t u[3] = {};
+  int32_t v[3] = {};
+  int32_t y_offset = 0;
+  int32_t c_offset = 0;
+};
+
+struct YUVToRGBCoeffs {
+  int32_t y = 0;
+  int32_t r_v = 0;
+  int32_t g_u = 0;
+  int32_t g_v = 0;
+  int32_t b_u = 0;
+  int32_t y_offset = 0;
+  int32_t c_offset = 0;
+};
+
+static void GetLumaWeights(CPUColorMatrix matrix, double *kr, double *kb) {
+  switch (matrix) {
+    case kCPUMatrixBT709:
+      *kr = 0.2126;
+      *kb = 0.0722;
+      break;
+    case kCPUMatrixBT2020:
+      *kr = 0.2627;
+      *kb = 0.0593;
+      break;
+    case kCPUMatrixBT601:
+    default:
+      *kr = 0.299;
+      *kb = 0.114;
+      break;
+  }
+}
+
+static int32_t ToFixed(double value) {
+  return static_cast<int32_t>(std::lround(value * (1 << kFracBits)));
+}
+
+// RGB inputs are 8 bit, outputs are limited range at the given bit depth.
+static RGBToYUVCoeffs GetRGBToYUVCoeffs(CPUColorMatrix matrix, int bit_depth) {
+  RGBToYUVCoeffs coeffs;
+  double kr = 0, kb = 0;
+  GetLumaWeights(matrix, &kr, &kb);
+  double kg = 1.0 - kr - kb;
+  int shift = bit_depth - 8;
+  double y_scale = (219 << shift) / 255.0;
+  double c_scale = (224 << shift) / 255.0;
+
+  // Keep the coefficient sums exact so that greys map to neutral chroma and nominal luma.
+  coeffs.y[0] = ToFixed(kr * y_scale);
+  coeffs.y[2] = ToFixed(kb * y_scale);
+  coeffs.y[1] = ToFixed(y_scale) - coeffs.y[0] - coeffs.y[2];
+  coeffs.u[0] = ToFixed(-kr / (2 * (1 - kb)) * c_scale);
+  coeffs.u[1] = ToFixed(-kg / (2 * (1 - kb)) * c_scale);
+  coeffs.u[2] = -(coeffs.u[0] + coeffs.u[1]);
+  coeffs.v[1] = ToFixed(-kg / (2 * (1 - kr)) * c_scale);
+  coeffs.v[2] = ToFixed(-kb / (2 * (1 - kr)) * c_scale);
+  coeffs.v[0] = -(coeffs.v[1] + coeffs.v[2]);
+  coeffs.y_offset = (16 << shift) << kFracBits;
+  coeffs.c_offset = (128 << shift) << kFracBits;
+
+  return coeffs;
+}
+
+// YUV inputs are limited range at the given bit depth, RGB outputs are 8 bit.
+static YUVToRGBCoeffs GetYUVToRGBCoeffs(CPUColorMatrix matrix, int bit_depth) {
+  YUVToRGBCoeffs coeffs;
+  double kr = 0, kb = 0;
+  GetLumaWeights(matrix, &kr, &kb);
+  double kg = 1.0 - kr - kb;
+  int shift = bit_depth - 8;
+  double y_scale = 255.0 / (219 << shift);
+  double c_scale = 255.0 / (224 << shift);
+
+  coeffs.y = ToFixed(y_scale);
+  coeffs.r_v = ToFixed(2 * (1 - kr) * c_scale);
+  coeffs.g_u = ToFixed(-2 * kb * (1 - kb) / kg * c_scale);
+  coeffs.g_v = ToFixed(-2 * kr * (1 - kr) / kg * c_scale);
+  coeffs.b_u = ToFixed(2 * (1 - kb) * c_scale);
+  coeffs.y_offset = 16 << shift;
+  coeffs.c_offset = 128 << shift;
+
+  return coeffs;
+}
+
+static inline int32_t Clamp(int32_t value, int32_t max) {
+  return std::min(std::max(value, 0), max);
+}
+
+static bool ClipRect(const CPUImage &image, const CPURect &rect, CPURect *clipped) {
+  clipped->left = std::max(rect.left, 0);
+  clipped->top = std::max(rect.top, 0);
+  clipped->right = std::min(rect.right, static_cast<int32_t>(image.width));
+  clipped->bottom = std::min(rect.bottom, static_cast<int32_t>(image.height));
+
+  return (clipped->right > clipped->left) && (clipped->bottom > clipped->top);
+}
+
+// Maps every destination coordinate in [clip_start, clip_end) to the nearest source coordinate,
+// at the scale of [src_start, src_end) to [dst_start, dst_end). Samples are kept within
+// [src_min, src_max), the part of the source inside the source image.
+static void BuildSampleMap(int32_t src_start, int32_t src_end, int32_t dst_start, int32_t dst_end,
+                           int32_t clip_start, int32_t clip_end, int32_t src_min, int32_t src_max,
+                           std::vector<int32_t> *map) {
+  int64_t src_len = src_end - src_start;
+  int64_t dst_len = dst_end - dst_start;
+  int64_t step = (src_len << 16) / dst_len;
+
+  map->resize(static_cast<size_t>(clip_end - clip_start));
+  for (int64_t i = clip_start - dst_start; i < clip_end - dst_start; i++) {
+    int64_t pos = src_start + ((i * step + step / 2) >> 16);
+    pos = std::min<int64_t>(std::max<int64_t>(pos, src_min), src_max - 1);
+    (*map)[static_cast<size_t>(i - (clip_start - dst_start))] = static_cast<int32_t>(pos);
+  }
+}
+
+// Shrinks dst_rect to the part that src_clip, the visible part of src_rect, scales onto.
+static CPURect ScaleClip(const CPURect &src_rect, const CPURect &src_clip,
+                         const CPURect &dst_rect) {
+  int64_t src_w = src_rect.right - src_rect.left;
+  int64_t src_h = src_rect.bottom - src_rect.top;
+  int64_t dst_w = dst_rect.right - dst_rect.left;
+  int64_t dst_h = dst_rect.bottom - dst_rect.top;
+  CPURect rect;
+  rect.left = dst_rect.left + static_cast<int32_t>((src_clip.left - src_rect.left) * dst_w / src_w);
+  rect.top = dst_rect.top + static_cast<int32_t>((src_clip.top - src_rect.top) * dst_h / src_h);
+  rect.right = dst_rect.left + static_cast<int32_t>(((src_clip.right - src_rect.left) * dst_w +
+                                                     src_w - 1) / src_w);
+  rect.bottom = dst_rect.top + static_cast<int32_t>(((src_clip.bottom - src_rect.top) * dst_h +
+                                                     src_h - 1) / src_h);
+  return rect;
+}
+
+static inline const uint8_t *RGBAPixel(const CPUImage &image, int32_t x, int32_t y) {
+  return image.planes[0] + static_cast<size_t>(y) * image.stride_bytes[0] + x * 4;
+}
+
+static void BlitRGBAToRGBA(const CPUImage &src, const CPUImage &dst, const CPURect &dst_rect,
+                           const std::vector<int32_t> &x_map, const std::vector<int32_t> &y_map,
+                           bool unscaled) {
+  int32_t width = dst_rect.right - dst_rect.left;
+  // Unscaled rows are copied whole, which is the common case for stitching.
+  for (int32_t y = dst_rect.top; y < dst_rect.bottom; y++) {
+    const uint8_t *src_row = RGBAPixel(src, 0, y_map[y - dst_rect.top]);
+    uint8_t *dst_row = const_cast<uint8_t *>(RGBAPixel(dst, dst_rect.left, y));
+    if (unscaled) {
+      memcpy(dst_row, src_row + x_map[0] * 4, static_cast<size_t>(width) * 4);
+      continue;
+    }
+    for (int32_t x = 0; x < width; x++) {
+      memcpy(dst_row + x * 4, src_row + x_map[x] * 4, 4);
+    }
+  }
+}
+
+template <typename T>
+static void BlitRGBAToYUV(const CPUImage &src, const CPUImage &dst, const CPURect &dst_rect,
+                          const std::vector<int32_t> &x_map, const std::vector<int32_t> &y_map,
+                          const RGBToYUVCoeffs &c, int out_shift) {
+  int32_t max = (sizeof(T) == 1) ? 255 : 1023;
+  for (int32_t y = dst_rect.top; y < dst_rect.bottom; y += 2) {
+    int32_t row = y - dst_rect.top;
+    const uint8_t *src_rows[2] = {RGBAPixel(src, 0, y_map[row]), RGBAPixel(src, 0, y_map[row + 1])};
+    T *luma_rows[2] = {
+      reinterpret_cast<T *>(dst.planes[0] + static_cast<size_t>(y) * dst.stride_bytes[0]),
+      reinterpret_cast<T *>(dst.planes[0] + static_cast<size_t>(y + 1) * dst.stride_bytes[0])};
+    T *chroma_row = reinterpret_cast<T *>(dst.planes[1] +
+                                          static_cast<size_t>(y / 2) * dst.stride_bytes[1]);
+
+    for (int32_t x = dst_rect.left; x < dst_rect.right; x += 2) {
+      int32_t col = x - dst_rect.left;
+      int32_t sum_r = 0, sum_g = 0, sum_b = 0;
+      for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+          const uint8_t *px = src_rows[i] + x_map[col + j] * 4;
+          int32_t r = px[0], g = px[1], b = px[2];
+          int32_t luma = (c.y[0] * r + c.y[1] * g + c.y[2] * b + c.y_offset + kFracHalf) >>
+                         kFracBits;
+          luma_rows[i][x + j] = static_cast<T>(Clamp(luma, max) << out_shift);
+          sum_r += r;
+          sum_g += g;
+          sum_b += b;
+        }
+      }
+      // Chroma is sited at the center of the 2x2 block, use the block average.
+      int32_t cb = (c.u[0] * sum_r + c.u[1] * sum_g + c.u[2] * sum_b + 4 * c.c_offset +
+                    4 * kFracHalf) >> (kFracBits + 2);
+      int32_t cr = (c.v[0] * sum_r + c.v[1] * sum_g + c.v[2] * sum_b + 4 * c.c_offset +
+                    4 * kFracHalf) >> (kFracBits + 2);
+      chroma_row[x] = static_cast<T>(Clamp(cb, max) << out_shift);
+      chroma_row[x + 1] = static_cast<T>(Clamp(cr, max) << out_shift);
+    }
+  }
+}
+
+template <typename T>
+static void BlitYUVToRGBA(const CPUImage &src, const CPUImage &dst, const CPURect &dst_rect,
+                          const std::vector<int32_t> &x_map, const std::vector<int32_t> &y_map,
+                          const YUVToRGBCoeffs &c, int in_shift) {
+  for (int32_t y = dst_rect.top; y < dst_rect.bottom; y++) {
+    int32_t sy = y_map[y - dst_rect.top];
+    const T *luma_row = reinterpret_cast<const T *>(src.planes[0] +
+                                                    static_cast<size_t>(sy) * src.stride_bytes[0]);
+    const T *chroma_row = reinterpret_cast<const T *>(src.planes[1] +
+                                                      static_cast<size_t>(sy / 2) *
+                                                      src.stride_bytes[1]);
+    uint8_t *dst_row = const_cast<uint8_t *>(RGBAPixel(dst, dst_rect.left, y));
+
+    for (int32_t x = 0; x < dst_rect.right - dst_rect.left; x++) {
+      int32_t sx = x_map[x];
+      int32_t luma = (luma_row[sx] >> in_shift) - c.y_offset;
+      int32_t cb = (chroma_row[sx & ~1] >> in_shift) - c.c_offset;
+      int32_t cr = (chroma_row[(sx & ~1) + 1] >> in_shift) - c.c_offset;
+      int32_t ys = c.y * luma + kFracHalf;
+      dst_row[x * 4 + 0] = static_cast<uint8_t>(Clamp((ys + c.r_v * cr) >> kFracBits, 255));
+      dst_row[x * 4 + 1] = static_cast<uint8_t>(Clamp((ys + c.g_u * cb + c.g_v * cr) >> kFracBits,
+                                                      255));
+      dst_row[x * 4 + 2] = static_cast<uint8_t>(Clamp((ys + c.b_u * cb) >> kFracBits, 255));
+      dst_row[x * 4 + 3] = 255;
+    }
+  }
+}
+
+static bool IsYUV(CPUPixelFormat format) {
+  return (format == kCPUFormatNV12) || (format == kCPUFormatP010);
+}
+
+int CPUBlit(const CPUImage &src, const CPURect &src_rect, const CPUImage &dst,
+            const CPURect &dst_rect, CPUColorMatrix matrix) {
+  if ((src_rect.right <= src_rect.left) || (src_rect.bottom <= src_rect.top) ||
+      (dst_rect.right <= dst_rect.left) || (dst_rect.bottom <= dst_rect.top)) {
+    return -EINVAL;
+  }
+
+  // Whatever is cut from one rect is cut from the other at the same ratio, so the visible part
+  // keeps the scale of the full rects.
+  CPURect src_clip, dst_clip;
+  if (!ClipRect(src, src_rect, &src_clip) ||
+      !ClipRect(dst, ScaleClip(src_rect, src_clip, dst_rect), &dst_clip)) {
+    return -EINVAL;
+  }
+
+  if (IsYUV(dst.format)) {
+    // Chroma is subsampled 2x2, write whole blocks only.
+    dst_clip.left &= ~1;
+    dst_clip.top &= ~1;
+    dst_clip.right = std::min((dst_clip.right + 1) & ~1, static_cast<int32_t>(dst.width & ~1U));
+    dst_clip.bottom = std::min((dst_clip.bottom + 1) & ~1,
+                               static_cast<int32_t>(dst.height & ~1U));
+    if ((dst_clip.right <= dst_clip.left) || (dst_clip.bottom <= dst_clip.top)) {
+      return -EINVAL;
+    }
+  }
+
+  std::vector<int32_t> x_map, y_map;
+  BuildSampleMap(src_rect.left, src_rect.right, dst_rect.left, dst_rect.right, dst_clip.left,
+                 dst_clip.right, src_clip.left, src_clip.right, &x_map);
+  BuildSampleMap(src_rect.top, src_rect.bottom, dst_rect.top, dst_rect.bottom, dst_clip.top,
+                 dst_clip.bottom, src_clip.top, src_clip.bottom, &y_map);
+
+  if (src.format == kCPUFormatRGBA8888) {
+    switch (dst.format) {
+      case kCPUFormatRGBA8888:
+        BlitRGBAToRGBA(src, dst, dst_clip, x_map, y_map,
+                       (src_rect.right - src_rect.left) == (dst_rect.right - dst_rect.left));
+        return 0;
+      case kCPUFormatNV12:
+        BlitRGBAToYUV<uint8_t>(src, dst, dst_clip, x_map, y_map, GetRGBToYUVCoeffs(matrix, 8), 0);
+        return 0;
+      case kCPUFormatP010:
+        BlitRGBAToYUV<uint16_t>(src, dst, dst_clip, x_map, y_map, GetRGBToYUVCoeffs(matrix, 10),
+                                6);
+        return 0;
+      default:
+        return -EINVAL;
+    }
+  }
+
+  if (dst.format == kCPUFormatRGBA8888) {
+    switch (src.format) {
+      case kCPUFormatNV12:
+        BlitYUVToRGBA<uint8_t>(src, dst, dst_clip, x_map, y_map, GetYUVToRGBCoeffs(matrix, 8), 0);
+        return 0;
+      case kCPUFormatP010:
+        BlitYUVToRGBA<uint16_t>(src, dst, dst_clip, x_map, y_map, GetYUVToRGBCoeffs(matrix, 10),
+                                6);
+        return 0;
+      default:
+        return -EINVAL;
+    }
+  }
+
+  return -EINVAL;
+}
+
+void CPUClearRGBA(const CPUImage &dst, const CPURect &rect) {
+  CPURect clip;
+  if (dst.format != kCPUFormatRGBA8888 || !ClipRect(dst, rect, &clip)) {
+    return;
+  }
+
+  size_t row_bytes = static_cast<size_t>(clip.right - clip.left) * 4;
+  for (int32_t y = clip.top; y < clip.bottom; y++) {
+    memset(const_cast<uint8_t *>(RGBAPixel(dst, clip.left, y)), 0, row_bytes);
+  }
+}
+
+}  // namespace sdm
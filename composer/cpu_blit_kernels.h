@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_BLIT_KERNELS_H__
+#define __CPU_BLIT_KERNELS_H__
+
+#include <stdint.h>
+
+namespace sdm {
+
+enum CPUPixelFormat {
+  kCPUFormatInvalid,
+  kCPUFormatRGBA8888,
+  kCPUFormatNV12,
+  kCPUFormatP010,
+};
+
+enum CPUColorMatrix {
+  kCPUMatrixBT601,
+  kCPUMatrixBT709,
+  kCPUMatrixBT2020,
+};
+
+// CPU view of a linear (non UBWC) buffer. RGBA uses plane 0 only, NV12/P010 use plane 0 for luma
+// and plane 1 for interleaved chroma. P010 samples hold 10 bits in the msbs of 16 bit words.
+struct CPUImage {
+  CPUPixelFormat format = kCPUFormatInvalid;
+  uint8_t *planes[2] = {nullptr, nullptr};
+  uint32_t stride_bytes[2] = {0, 0};
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+struct CPURect {
+  int32_t left = 0;
+  int32_t top = 0;
+  int32_t right = 0;
+  int32_t bottom = 0;
+};
+
+// Scales src_rect of src into dst_rect of dst with nearest sampling, converting between RGBA and
+// limited range YUV using the given matrix. YUV destination rects are aligned to even
+// coordinates. Returns 0 on success or -EINVAL for unsupported format pairs and invalid rects.
+int CPUBlit(const CPUImage &src, const CPURect &src_rect, const CPUImage &dst,
+            const CPURect &dst_rect, CPUColorMatrix matrix);
+
+// Fills rect of an RGBA image with transparent black.
+void CPUClearRGBA(const CPUImage &dst, const CPURect &rect);
+
+}  // namespace sdm
+
+#endif  // __CPU_BLIT_KERNELS_H__
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cpu_color_convert_impl.h"
+
+#define __CLASS__ "CPUColorConvertImpl"
+
+namespace sdm {
+
+// Narrows dst to its intersection with damage and src to the matching source region. Unscaled
+// blits map exactly, scaled ones may sample one source pixel differently at the damage edges.
+static void ClipToDamage(const CPURect &damage, CPURect *src, CPURect *dst) {
+  CPURect clip;
+  clip.left = std::max(damage.left, dst->left);
+  clip.top = std::max(damage.top, dst->top);
+  clip.right = std::min(damage.right, dst->right);
+  clip.bottom = std::min(damage.bottom, dst->bottom);
+  if (clip.right <= clip.left || clip.bottom <= clip.top) {
+    return;
+  }
+
+  int64_t src_w = src->right - src->left, src_h = src->bottom - src->top;
+  int64_t dst_w = dst->right - dst->left, dst_h = dst->bottom - dst->top;
+  CPURect src_clip;
+  src_clip.left = src->left + INT32((clip.left - dst->left) * src_w / dst_w);
+  src_clip.top = src->top + INT32((clip.top - dst->top) * src_h / dst_h);
+  src_clip.right = src->left + INT32(((clip.right - dst->left) * src_w + dst_w - 1) / dst_w);
+  src_clip.bottom = src->top + INT32(((clip.bottom - dst->top) * src_h + dst_h - 1) / dst_h);
+
+  *src = src_clip;
+  *dst = clip;
+}
+
+CPUColorConvertImpl::CPUColorConvertImpl(GLRenderTarget target) {
+  target_ = target;
+}
+
+CPUColorConvertImpl::~CPUColorConvertImpl() {}
+
+int CPUColorConvertImpl::Init() {
+  if (target_ != kTargetRGBA && target_ != kTargetYUV) {
+    DLOGE("Invalid GLRenderTarget: %d", target_);
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+int CPUColorConvertImpl::Deinit() {
+  return 0;
+}
+
+void CPUColorConvertImpl::Reset() {}
+
+int CPUColorConvertImpl::Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
+                              const GLRect &src_rect, const GLRect &dst_rect,
+                              const GLRect &damage_rect,
+                              const shared_ptr<Fence> &src_acquire_fence,
+                              const shared_ptr<Fence> &dst_acquire_fence,
+                              shared_ptr<Fence> *release_fence) {
+  DTRACE_SCOPED();
+  // Output is complete on return.
+  *release_fence = nullptr;
+
+  std::vector<shared_ptr<Fence>> in_fence = {src_acquire_fence, dst_acquire_fence};
+  int status = WaitOnInputFence(in_fence);
+  if (status != 0) {
+    return status;
+  }
+
+  CPUMappedBuffer src = {}, dst = {};
+  status = MapBuffer(src_hnd, false /* write */, &src);
+  if (status == 0) {
+    status = MapBuffer(dst_hnd, true /* write */, &dst);
+  }
+
+  if (status == 0) {
+    CPURect src_crop = ToCPURect(src_rect);
+    if (src_crop.right <= src_crop.left || src_crop.bottom <= src_crop.top) {
+      // Callers leave the source rect empty to request the full buffer.
+      src_crop = {0, 0, INT32(src.image.width), INT32(src.image.height)};
+    }
+    CPURect dst_crop = ToCPURect(dst_rect);
+    CPURect damage = ToCPURect(damage_rect);
+    if (damage.right > damage.left && damage.bottom > damage.top) {
+      ClipToDamage(damage, &src_crop, &dst_crop);
+    }
+    status = CPUBlit(src.image, src_crop, dst.image, dst_crop,
+                     GetColorMatrix((target_ == kTargetYUV) ? dst_hnd : src_hnd));
+    if (status != 0) {
+      DLOGE("Blit failed %d. src format %d dst format %d", status, src.image.format,
+            dst.image.format);
+    }
+  }
+
+  UnmapBuffer(&dst);
+  UnmapBuffer(&src);
+
+  return status;
+}
+
+}  // namespace sdm
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_COLOR_CONVERT_IMPL_H__
+#define __CPU_COLOR_CONVERT_IMPL_H__
+
+#include "cpu_blit_common.h"
+#include "gl_color_convert.h"
+
+namespace sdm {
+
+// Reference color convert backend used when the GPU path is unavailable or disabled.
+class CPUColorConvertImpl : public GLColorConvert, public CPUBlitCommon {
+ public:
+  explicit CPUColorConvertImpl(GLRenderTarget target);
+  virtual ~CPUColorConvertImpl();
+  virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
+                   const GLRect &src_rect, const GLRect &dst_rect, const GLRect &damage_rect,
+                   const shared_ptr<Fence> &src_acquire_fence,
+                   const shared_ptr<Fence> &dst_acquire_fence, shared_ptr<Fence> *release_fence);
+  virtual int Init();
+  virtual int Deinit();
+  virtual void Reset();
+ private:
+  GLRenderTarget target_ = kTargetRGBA;
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_COLOR_CONVERT_IMPL_H__
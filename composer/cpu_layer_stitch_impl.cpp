@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <vector>
+
+#include "cpu_layer_stitch_impl.h"
+
+#define __CLASS__ "CPULayerStitchImpl"
+
+namespace sdm {
+
+CPULayerStitchImpl::~CPULayerStitchImpl() {}
+
+int CPULayerStitchImpl::Init() {
+  return 0;
+}
+
+int CPULayerStitchImpl::Deinit() {
+  return 0;
+}
+
+int CPULayerStitchImpl::Blit(const std::vector<StitchParams> &stitch_params,
+                             shared_ptr<Fence> *release_fence) {
+  DTRACE_SCOPED();
+  // Output is complete on return.
+  *release_fence = nullptr;
+
+  int status = 0;
+  for (auto &info : stitch_params) {
+    std::vector<shared_ptr<Fence>> in_fence = {info.src_acquire_fence, info.dst_acquire_fence};
+    status = WaitOnInputFence(in_fence);
+    if (status != 0) {
+      break;
+    }
+
+    CPUMappedBuffer src = {}, dst = {};
+    status = MapBuffer(info.src_hnd, false /* write */, &src);
+    if (status == 0) {
+      status = MapBuffer(info.dst_hnd, true /* write */, &dst);
+    }
+
+    if (status == 0) {
+      CPURect scissor_rect = ToCPURect(info.scissor_rect);
+      if (scissor_rect.right > scissor_rect.left && scissor_rect.bottom > scissor_rect.top) {
+        CPUClearRGBA(dst.image, scissor_rect);
+      }
+
+      CPURect src_crop = ToCPURect(info.src_rect);
+      if (src_crop.right <= src_crop.left || src_crop.bottom <= src_crop.top) {
+        src_crop = {0, 0, INT32(src.image.width), INT32(src.image.height)};
+      }
+      status = CPUBlit(src.image, src_crop, dst.image, ToCPURect(info.dst_rect),
+                       GetColorMatrix(info.src_hnd));
+    }
+
+    UnmapBuffer(&dst);
+    UnmapBuffer(&src);
+
+    if (status != 0) {
+      DLOGE("Stitch failed %d", status);
+      break;
+    }
+  }
+
+  return status;
+}
+
+}  // namespace sdm
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_LAYER_STITCH_IMPL_H__
+#define __CPU_LAYER_STITCH_IMPL_H__
+
+#include <vector>
+
+#include "cpu_blit_common.h"
+#include "gl_layer_stitch.h"
+
+namespace sdm {
+
+// Reference layer stitch backend used when the GPU path is unavailable or disabled.
+class CPULayerStitchImpl : public GLLayerStitch, public CPUBlitCommon {
+ public:
+  CPULayerStitchImpl() { }
+  virtual ~CPULayerStitchImpl();
+  virtual int Blit(const std::vector<StitchParams> &stitch_params, shared_ptr<Fence> *release_fence);
+  virtual int Init();
+  virtual int Deinit();
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_LAYER_STITCH_IMPL_H__
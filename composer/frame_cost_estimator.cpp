@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "frame_cost_estimator.h"
+
+namespace sdm {
+
+FrameCostEstimator::HintAction FrameCostEstimator::Update(int64_t frame_cost_ns,
+                                                          int64_t now_ns) {
+  if (vsync_period_ <= 0 || frame_cost_ns < 0) {
+    return boosted_ ? kHintRequest : kHintNone;
+  }
+
+  if (!primed_) {
+    avg_ = frame_cost_ns;
+    dev_ = 0;
+    primed_ = true;
+  } else {
+    int64_t error = frame_cost_ns - avg_;
+    avg_ += error / kAvgWeight;
+    dev_ += ((error < 0 ? -error : error) - dev_) / kDevWeight;
+  }
+
+  int64_t predicted = GetPredictedCost();
+  bool missed = frame_cost_ns > vsync_period_;
+  bool over = (predicted * 100) > (vsync_period_ * kBoostOnPercent);
+  bool under = (predicted * 100) < (vsync_period_ * kBoostOffPercent);
+
+  if (!boosted_) {
+    over_count_ = over ? over_count_ + 1 : 0;
+    if (missed || over_count_ >= kBoostOnFrames) {
+      boosted_ = true;
+      over_count_ = 0;
+      low_pending_ = false;
+      return kHintRequest;
+    }
+    return kHintNone;
+  }
+
+  if (!under || missed) {
+    low_pending_ = false;
+    return kHintRequest;
+  }
+
+  if (!low_pending_) {
+    low_pending_ = true;
+    low_since_ = now_ns;
+  }
+
+  if ((now_ns - low_since_) >= release_hold_) {
+    boosted_ = false;
+    low_pending_ = false;
+    return kHintRelease;
+  }
+
+  return kHintRequest;
+}
+
+void FrameCostEstimator::Reset() {
+  avg_ = 0;
+  dev_ = 0;
+  primed_ = false;
+  boosted_ = false;
+  over_count_ = 0;
+  low_pending_ = false;
+  low_since_ = 0;
+}
+
+}  // namespace sdm
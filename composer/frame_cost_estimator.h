@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FRAME_COST_ESTIMATOR_H__
+#define __FRAME_COST_ESTIMATOR_H__
+
+#include <stdint.h>
+
+namespace sdm {
+
+// Predicts whether the composition CPU time of the next frame is going to miss the vsync budget,
+// based on the measured validate to present time of past frames. The prediction is a smoothed
+// mean plus twice the smoothed deviation, so bursty costs are boosted earlier than steady ones.
+// A boost is requested when the prediction crosses kBoostOnPercent of the budget on consecutive
+// frames, or right away on an actual miss, and released only after the prediction stayed below
+// kBoostOffPercent for the release hold time.
+class FrameCostEstimator {
+ public:
+  enum HintAction {
+    kHintNone,     // Leave the hint as it is (not boosted)
+    kHintRequest,  // Request the hint, or keep it alive if it is already held
+    kHintRelease,  // Release the held hint
+  };
+
+  void SetVsyncPeriod(int64_t vsync_period_ns) { vsync_period_ = vsync_period_ns; }
+  void SetReleaseHold(int64_t release_hold_ns) { release_hold_ = release_hold_ns; }
+  HintAction Update(int64_t frame_cost_ns, int64_t now_ns);
+  void Reset();
+  bool IsBoosted() const { return boosted_; }
+  int64_t GetPredictedCost() const { return avg_ + 2 * dev_; }
+
+ private:
+  static const int64_t kBoostOnPercent = 75;
+  static const int64_t kBoostOffPercent = 50;
+  static const int kBoostOnFrames = 2;
+  static const int64_t kAvgWeight = 8;  // New sample contributes 1/8 to the mean
+  static const int64_t kDevWeight = 4;  // New sample contributes 1/4 to the deviation
+
+  int64_t vsync_period_ = 0;
+  int64_t release_hold_ = 100000000;  // 100ms
+  int64_t avg_ = 0;
+  int64_t dev_ = 0;
+  bool primed_ = false;
+  bool boosted_ = false;
+  int over_count_ = 0;
+  bool low_pending_ = false;
+  int64_t low_since_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __FRAME_COST_ESTIMATOR_H__
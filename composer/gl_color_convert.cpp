@@ -27,39 +27,60 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_color_convert_impl.h"
 #include "gl_color_convert_impl.h"
 #include "gl_color_convert.h"
+#include "hwc_debugger.h"
 
 #define __CLASS__ "GLColorConvert"
 
 namespace sdm {
 
 GLColorConvert* GLColorConvert::GetInstance(GLRenderTarget target, bool secure) {
-  GLColorConvertImpl* color_convert = new GLColorConvertImpl(target, secure);
-  if (color_convert == nullptr) {
-    DLOGE("Failed to create color convert instance for %d target %d secure", target, secure);
-    return nullptr;
-  }
+  int use_cpu_blit = 0;
+  HWCDebugHandler::Get()->GetProperty(USE_CPU_BLIT_PROP, &use_cpu_blit);
+
+  if (!use_cpu_blit) {
+    GLColorConvertImpl* color_convert = new GLColorConvertImpl(target, secure);
+    if (color_convert == nullptr) {
+      DLOGE("Failed to create color convert instance for %d target %d secure", target, secure);
+      return nullptr;
+    }
+
+    int status = color_convert->Init();
+    if (status == 0) {
+      DLOGI("Created instance successfully");
+      return color_convert;
+    }
 
-  int status = color_convert->Init();
-  if (status != 0) {
     DLOGE("Failed to initialize GL Color convert instance %d", status);
+    color_convert->Deinit();
     delete color_convert;
+  }
+
+  // CPU cannot access secure buffers.
+  if (secure) {
+    return nullptr;
+  }
+
+  CPUColorConvertImpl* cpu_color_convert = new CPUColorConvertImpl(target);
+  if (cpu_color_convert == nullptr || cpu_color_convert->Init() != 0) {
+    DLOGE("Failed to create CPU color convert instance for %d target", target);
+    delete cpu_color_convert;
     return nullptr;
   }
 
-  DLOGI("Created instance successfully");
+  DLOGI("Created CPU instance successfully");
 
-  return color_convert;
+  return cpu_color_convert;
 }
 
 void GLColorConvert::Destroy(GLColorConvert* intf) {
-  GLColorConvertImpl* color_convert = static_cast<GLColorConvertImpl*>(intf);
-  if (color_convert->Deinit() != 0) {
+  if (intf->Deinit() != 0) {
     DLOGE("De Init failed");
   }
 
-  delete color_convert;
+  delete intf;
 }
 
 }  // namespace sdm
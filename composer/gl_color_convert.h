@@ -44,12 +44,15 @@ class GLColorConvert {
   static GLColorConvert* GetInstance(GLRenderTarget target, bool secure);
   static void Destroy(GLColorConvert* intf);
 
+  // Only damage_rect of dst_rect is written when it is not empty. It is in destination
+  // coordinates and the source to destination mapping is the one of the full rects.
   virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
-                   const GLRect &src_rect, const GLRect &dst_rect,
+                   const GLRect &src_rect, const GLRect &dst_rect, const GLRect &damage_rect,
                    const shared_ptr<Fence> &src_acquire_fence,
                    const shared_ptr<Fence> &dst_acquire_fence,
                    shared_ptr<Fence> *release_fence) = 0;
   virtual void Reset() = 0;
+  virtual int Deinit() = 0;
  protected:
   virtual ~GLColorConvert() { }
 };
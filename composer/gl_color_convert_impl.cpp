@@ -124,6 +124,10 @@ int GLColorConvertImpl::CreateContext(GLRenderTarget target, bool secure) {
                                     secure ? EGL_TRUE : EGL_NONE,
                                     EGL_NONE};
   ctx_.egl_context = eglCreateContext(ctx_.egl_display, eglConfig, NULL, egl_contextAttribList);
+  if (ctx_.egl_context == EGL_NO_CONTEXT) {
+    DLOGE("Failed to create EGL context. error = 0x%x", eglGetError());
+    return -1;
+  }
 
   // eglCreatePbufferSurface creates an off-screen pixel buffer surface and returns its handle
   EGLint egl_surfaceAttribList[] = {EGL_WIDTH, 1,
@@ -157,6 +161,7 @@ int GLColorConvertImpl::CreateContext(GLRenderTarget target, bool secure) {
 
 int GLColorConvertImpl::Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
                              const GLRect &src_rect, const GLRect &dst_rect,
+                             const GLRect &damage_rect,
                              const shared_ptr<Fence> &src_acquire_fence,
                              const shared_ptr<Fence> &dst_acquire_fence,
                              shared_ptr<Fence> *release_fence) {
@@ -169,12 +174,14 @@ int GLColorConvertImpl::Blit(const native_handle_t *src_hnd, const native_handle
   SetSourceBuffer(src_hnd);
   SetDestinationBuffer(dst_hnd);
   SetViewport(dst_rect);
+  SetScissor(damage_rect);
 
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, kFullScreenVertices);
   glEnableVertexAttribArray(1);
   glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, kFullScreenTexCoords);
   glDrawArrays(GL_TRIANGLES, 0, 3);
+  GL(glDisable(GL_SCISSOR_TEST));
 
   std::vector<shared_ptr<Fence>> in_fence = {Fence::Merge(src_acquire_fence, dst_acquire_fence)};
   WaitOnInputFence(in_fence);
@@ -43,7 +43,7 @@ class GLColorConvertImpl : public GLColorConvert, public GLCommon {
   GLColorConvertImpl(GLRenderTarget target, bool secure);
   virtual ~GLColorConvertImpl();
   virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
-                   const GLRect &src_rect, const GLRect &dst_rect,
+                   const GLRect &src_rect, const GLRect &dst_rect, const GLRect &damage_rect,
                    const shared_ptr<Fence> &src_acquire_fence,
                    const shared_ptr<Fence> &dst_acquire_fence, shared_ptr<Fence> *release_fence);
   virtual int CreateContext(GLRenderTarget target, bool secure);
@@ -194,5 +194,17 @@ void GLCommon::SetViewport(const GLRect &dst_rect) {
   GL(glViewport(dst_rect.left, dst_rect.top, width, height));
 }
 
+void GLCommon::SetScissor(const GLRect &rect) {
+  DTRACE_SCOPED();
+  float width = rect.right - rect.left;
+  float height = rect.bottom - rect.top;
+  if (width <= 0.0f || height <= 0.0f) {
+    GL(glDisable(GL_SCISSOR_TEST));
+    return;
+  }
+  GL(glEnable(GL_SCISSOR_TEST));
+  GL(glScissor(rect.left, rect.top, width, height));
+}
+
 }  // namespace sdm
 
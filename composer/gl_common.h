@@ -70,6 +70,8 @@ class GLCommon {
   virtual void ClearCache();
   virtual void SetRealTimePriority();
   virtual void SetViewport(const GLRect &dst_rect);
+  // Restricts rendering to rect, or to the whole viewport when rect is empty
+  virtual void SetScissor(const GLRect &rect);
 
  protected:
   virtual ~GLCommon() { }
@@ -27,39 +27,60 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_layer_stitch_impl.h"
 #include "gl_layer_stitch_impl.h"
 #include "gl_layer_stitch.h"
+#include "hwc_debugger.h"
 
 #define __CLASS__ "GLLayerStitch"
 
 namespace sdm {
 
 GLLayerStitch* GLLayerStitch::GetInstance(bool secure) {
-  GLLayerStitchImpl *layer_stitch = new GLLayerStitchImpl(secure);
-  if (layer_stitch == nullptr) {
-    DLOGE("Failed to create layer stitch instance. secure: %d", secure);
-    return nullptr;
-  }
+  int use_cpu_blit = 0;
+  HWCDebugHandler::Get()->GetProperty(USE_CPU_BLIT_PROP, &use_cpu_blit);
+
+  if (!use_cpu_blit) {
+    GLLayerStitchImpl *layer_stitch = new GLLayerStitchImpl(secure);
+    if (layer_stitch == nullptr) {
+      DLOGE("Failed to create layer stitch instance. secure: %d", secure);
+      return nullptr;
+    }
+
+    int status = layer_stitch->Init();
+    if (status == 0) {
+      DLOGI("Created instance successfully");
+      return layer_stitch;
+    }
 
-  int status = layer_stitch->Init();
-  if (status != 0) {
     DLOGE("Failed to initialize GL layer stitch instance %d", status);
+    layer_stitch->Deinit();
     delete layer_stitch;
+  }
+
+  // CPU cannot access secure buffers.
+  if (secure) {
+    return nullptr;
+  }
+
+  CPULayerStitchImpl *cpu_layer_stitch = new CPULayerStitchImpl();
+  if (cpu_layer_stitch == nullptr || cpu_layer_stitch->Init() != 0) {
+    DLOGE("Failed to create CPU layer stitch instance");
+    delete cpu_layer_stitch;
     return nullptr;
   }
 
-  DLOGI("Created instance successfully");
+  DLOGI("Created CPU instance successfully");
 
-  return layer_stitch;
+  return cpu_layer_stitch;
 }
 
 void GLLayerStitch::Destroy(GLLayerStitch *intf) {
-  GLLayerStitchImpl *layer_stitch = static_cast<GLLayerStitchImpl *>(intf);
-  if (layer_stitch->Deinit() != 0) {
+  if (intf->Deinit() != 0) {
     DLOGE("De Init failed");
   }
 
-  delete layer_stitch;
+  delete intf;
 }
 
 }  // namespace sdm
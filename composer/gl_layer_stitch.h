@@ -50,6 +50,7 @@ class GLLayerStitch {
   static void Destroy(GLLayerStitch *intf);
   virtual int Blit(const std::vector<StitchParams> &stitch_params,
                    shared_ptr<Fence> *release_fence) = 0;
+  virtual int Deinit() = 0;
 
  protected:
   virtual ~GLLayerStitch() { }
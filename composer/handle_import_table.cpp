@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "handle_import_table.h"
+
+namespace sdm {
+
+bool HandleImportTable::Import(const HandleImportKey *key, buffer_handle_t handle,
+                               buffer_handle_t *imported) {
+  if (key) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = handles_.find(*key);
+    if (it != handles_.end()) {
+      entries_[it->second].refs++;
+      stats_.aliases++;
+      *imported = it->second;
+      return true;
+    }
+  }
+
+  buffer_handle_t new_handle = nullptr;
+  bool imported_ok = import_proc_(handle, &new_handle);
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stats_.imports++;
+  }
+  if (!imported_ok) {
+    return false;
+  }
+
+  if (!key) {
+    *imported = new_handle;
+    return true;
+  }
+
+  buffer_handle_t duplicate = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = handles_.find(*key);
+    if (it != handles_.end()) {
+      // Another thread imported the same buffer meanwhile, share its handle.
+      entries_[it->second].refs++;
+      stats_.aliases++;
+      duplicate = new_handle;
+      new_handle = it->second;
+    } else {
+      handles_[*key] = new_handle;
+      Entry &entry = entries_[new_handle];
+      entry.key = *key;
+      entry.refs = 1;
+    }
+  }
+
+  if (duplicate) {
+    Release(duplicate);
+  }
+
+  *imported = new_handle;
+  return true;
+}
+
+void HandleImportTable::Release(buffer_handle_t imported) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = entries_.find(imported);
+    if (it != entries_.end()) {
+      if (--it->second.refs) {
+        return;
+      }
+      handles_.erase(it->second.key);
+      entries_.erase(it);
+    }
+    stats_.frees++;
+  }
+
+  free_proc_(imported);
+}
+
+HandleImportTable::Stats HandleImportTable::GetStats() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return stats_;
+}
+
+size_t HandleImportTable::GetSize() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return entries_.size();
+}
+
+}  // namespace sdm
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HANDLE_IMPORT_TABLE_H__
+#define __HANDLE_IMPORT_TABLE_H__
+
+#include <cutils/native_handle.h>
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace sdm {
+
+// Identifies the dma-buf behind a client handle: the inode of its first fd and the gralloc
+// buffer id. Two handles with the same key describe the same allocation.
+struct HandleImportKey {
+  uint64_t ino = 0;
+  uint64_t buffer_id = 0;
+
+  bool operator<(const HandleImportKey &other) const {
+    return (ino != other.ino) ? (ino < other.ino) : (buffer_id < other.buffer_id);
+  }
+};
+
+// Refcounted table of imported buffer handles. SurfaceFlinger resends the same dma-buf under new
+// slots or layers; instead of importing it again, the handle already imported for the key is
+// handed out with one more reference. The import and free callbacks run without the table lock,
+// so a slow mapper call does not stall lookups or releases of other buffers.
+class HandleImportTable {
+ public:
+  typedef std::function<bool(buffer_handle_t handle, buffer_handle_t *imported)> ImportProc;
+  typedef std::function<void(buffer_handle_t imported)> FreeProc;
+
+  struct Stats {
+    uint64_t imports = 0;  // Calls into the import callback
+    uint64_t aliases = 0;  // Imports served from the table
+    uint64_t frees = 0;    // Calls into the free callback
+  };
+
+  HandleImportTable(ImportProc import_proc, FreeProc free_proc)
+    : import_proc_(std::move(import_proc)), free_proc_(std::move(free_proc)) {}
+
+  // Imports handle into *imported. A null key imports without deduplication.
+  bool Import(const HandleImportKey *key, buffer_handle_t handle, buffer_handle_t *imported);
+  // Drops one reference to an imported handle and frees it with the last one. Handles the table
+  // does not know about are freed right away.
+  void Release(buffer_handle_t imported);
+  Stats GetStats();
+  size_t GetSize();
+
+ private:
+  struct Entry {
+    HandleImportKey key;
+    uint32_t refs = 0;
+  };
+
+  ImportProc import_proc_;
+  FreeProc free_proc_;
+  std::mutex lock_;
+  std::map<HandleImportKey, buffer_handle_t> handles_;
+  std::unordered_map<buffer_handle_t, Entry> entries_;
+  Stats stats_ = {};
+};
+
+}  // namespace sdm
+
+#endif  // __HANDLE_IMPORT_TABLE_H__
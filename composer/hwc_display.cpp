@@ -41,6 +41,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -501,6 +502,8 @@ int HWCDisplay::Init() {
     }
   }
 
+  latency_stats_ = FrameLatencyStats::Get(sdm_id_);
+
   HWCDebugHandler::Get()->GetProperty(DISABLE_HDR, &disable_hdr_handling_);
   if (disable_hdr_handling_) {
     DLOGI("HDR Handling disabled");
@@ -648,6 +651,7 @@ HWC2::Error HWCDisplay::DestroyLayer(hwc2_layer_t layer_id) {
   }
   const auto layer = map_layer->second;
   layer_map_.erase(map_layer);
+  stack_aggregates_.Update(layer->GetStackContribution(), 0);
   const auto z_range = layer_set_.equal_range(layer);
   for (auto current = z_range.first; current != z_range.second; ++current) {
     if (*current == layer) {
@@ -676,7 +680,11 @@ static bool IsHDRLayerPresent(Layer *layer) {
 }
 
 void HWCDisplay::BuildLayerStack() {
+  // Keep the capacity of the layer list across frames.
+  std::vector<Layer *> layers = std::move(layer_stack_.layers);
+  layers.clear();
   layer_stack_ = LayerStack();
+  layer_stack_.layers = std::move(layers);
   display_rect_ = LayerRect();
   layer_stack_.flags.use_metadata_refresh_rate = false;
   layer_stack_.flags.animating = animating_;
@@ -685,98 +693,72 @@ void HWCDisplay::BuildLayerStack() {
   layer_stack_.tonemapper_active = tone_mapper_ && tone_mapper_->IsActive();
 
   DTRACE_SCOPED();
+  // The layer flags only depend on client state, re-derive them for the layers the client changed
+  // since the last frame, or for all of them when a display wide input changed.
+  DisplayLayerInputs layer_inputs = {};
+  layer_inputs.client_target_valid = (client_target_->GetSDMLayer()->input_buffer.buffer_id != 0);
+  layer_inputs.hdr_handling = !disable_hdr_handling_;
+  layer_inputs.game_supported = game_supported_;
+  layer_inputs.top_most_id = layer_set_.empty() ? 0 : (*layer_set_.rbegin())->GetId();
+  bool derive_all = (layer_inputs != layer_inputs_);
+  layer_inputs_ = layer_inputs;
+
   // Add one layer for fb target
   for (auto hwc_layer : layer_set_) {
     // Reset layer data which SDM may change
     hwc_layer->ResetPerFrameData();
 
     Layer *layer = hwc_layer->GetSDMLayer();
-    layer->flags = {};   // Reset earlier flags
-    // Mark all layers to skip, when client target handle is NULL
-    if (hwc_layer->GetClientRequestedCompositionType() == HWC2::Composition::Client ||
-        !client_target_->GetSDMLayer()->input_buffer.buffer_id) {
-      layer->flags.skip = true;
-    } else if (hwc_layer->GetClientRequestedCompositionType() == HWC2::Composition::SolidColor) {
-      layer->flags.solid_fill = true;
-    }
-
-    if (!hwc_layer->IsDataSpaceSupported()) {
-      layer->flags.skip = true;
-    }
-
     if (swap_interval_zero_) {
       layer->input_buffer.acquire_fence = nullptr;
     }
 
-    bool is_secure = false;
-    bool is_video = false;
-    void *hdl = reinterpret_cast<native_handle_t *>(layer->input_buffer.buffer_id);
-    if (hdl) {
-      int buffer_type;
-      gralloc::GetMetaDataValue(hdl, QTI_BUFFER_TYPE, &buffer_type);
-      if (buffer_type == BUFFER_TYPE_VIDEO) {
-        layer_stack_.flags.video_present = true;
-        is_video = true;
+    uint32_t dirty_flags = hwc_layer->GetDirtyFlags();
+    if (derive_all || dirty_flags) {
+      if (dirty_flags & (kDirtyBuffer | kDirtyColor)) {
+        hwc_layer->SetHDR(IsHDRLayerPresent(layer));
       }
+
+      // Buffer type and secure flags are read from the buffer metadata in SetLayerBuffer.
       // TZ Protected Buffer - L1
       // Gralloc Usage Protected Buffer - L3 - which needs to be treated as Secure & avoid fallback
-      int32_t handle_flags;
-      gralloc::GetMetaDataValue(hdl, QTI_PRIVATE_FLAGS, &handle_flags);
-      if (handle_flags & qtigralloc::PRIV_FLAGS_SECURE_BUFFER) {
-        layer_stack_.flags.secure_present = true;
-        is_secure = true;
-      }
-      // UBWC PI format
-      if (handle_flags & qtigralloc::PRIV_FLAGS_UBWC_ALIGNED_PI) {
-        layer->input_buffer.flags.ubwc_pi = true;
+      auto composition = hwc_layer->GetClientRequestedCompositionType();
+      LayerStateInputs inputs = {};
+      inputs.client_composition = (composition == HWC2::Composition::Client);
+      inputs.solid_color = (composition == HWC2::Composition::SolidColor);
+      inputs.cursor_composition = (composition == HWC2::Composition::Cursor);
+      inputs.top_most = (hwc_layer->GetId() == layer_inputs.top_most_id);
+      inputs.dataspace_supported = hwc_layer->IsDataSpaceSupported();
+      inputs.video = layer->input_buffer.flags.video;
+      inputs.secure = hwc_layer->IsProtected() || layer->input_buffer.flags.secure_display;
+      inputs.rgb = IS_RGB_FORMAT(layer->input_buffer.format);
+      inputs.scaling = hwc_layer->IsScalingPresent();
+      inputs.rotation = hwc_layer->IsRotationPresent();
+      inputs.single_buffered = hwc_layer->IsSingleBuffered();
+      inputs.hdr = hwc_layer->IsHDR();
+      inputs.game = (hwc_layer->GetType() == kLayerGame);
+      inputs.non_integral_crop = hwc_layer->IsNonIntegralSourceCrop();
+      inputs.metadata_refresh_rate = hwc_layer->HasMetaDataRefreshRate();
+      inputs.color_transform = hwc_layer->IsColorTransformSet();
+      inputs.compatible = hwc_layer->IsLayerCompatible();
+      inputs.mask = layer->input_buffer.flags.mask_layer;
+
+      LayerFlags flags = {};
+      uint32_t contribution = DeriveLayerFlags(layer_inputs, inputs, &flags);
+      stack_aggregates_.Update(hwc_layer->GetStackContribution(), contribution);
+      hwc_layer->SetDerivedState(flags, contribution);
+      layer->input_buffer.flags.hdr = ((contribution & kStackHdr) != 0);
+      layer->input_buffer.flags.game = flags.is_game;
+
+      if (dirty_flags & kDirtyBuffer) {
+        // The name comes from the buffer metadata.
+        layer->layer_id = hwc_layer->GetId();
+        layer->layer_name = hwc_layer->GetName();
       }
+      // Consumed before the scan adjustment below, which changes the display frame once more.
+      hwc_layer->ResetDirtyFlags();
     }
-
-    if (layer->input_buffer.flags.secure_display) {
-      layer_stack_.flags.secure_present = true;
-      is_secure = true;
-    }
-
-    if (IS_RGB_FORMAT(layer->input_buffer.format) && hwc_layer->IsScalingPresent()) {
-      layer_stack_.flags.scaling_rgb_layer_present = true;
-    }
-
-    if (hwc_layer->IsSingleBuffered() &&
-       !(hwc_layer->IsRotationPresent() || hwc_layer->IsScalingPresent())) {
-      layer->flags.single_buffer = true;
-      layer_stack_.flags.single_buffered_layer_present = true;
-    }
-
-    bool hdr_layer = IsHDRLayerPresent(layer);
-    if (hdr_layer && !disable_hdr_handling_) {
-      // Dont honor HDR when its handling is disabled
-      layer->input_buffer.flags.hdr = true;
-      layer_stack_.flags.hdr_present = true;
-    }
-
-    if (game_supported_ && (hwc_layer->GetType() == kLayerGame) && !hdr_layer) {
-      layer->flags.is_game = true;
-      layer->input_buffer.flags.game = true;
-    }
-
-    if (hwc_layer->IsNonIntegralSourceCrop() && !is_secure && !hdr_layer &&
-        !layer->flags.single_buffer && !layer->flags.solid_fill && !is_video &&
-        !layer->flags.is_game) {
-      layer->flags.skip = true;
-    }
-
-    if (!layer->flags.skip &&
-        (hwc_layer->GetClientRequestedCompositionType() == HWC2::Composition::Cursor)) {
-      // Currently we support only one HWCursor & only at top most z-order
-      if ((*layer_set_.rbegin())->GetId() == hwc_layer->GetId()) {
-        layer->flags.cursor = true;
-        layer_stack_.flags.cursor_present = true;
-      }
-    }
-
-    if (layer->flags.skip) {
-      layer_stack_.flags.skip_present = true;
-    }
+    layer->flags = hwc_layer->GetDerivedFlags();
 
     // TODO(user): Move to a getter if this is needed at other places
     hwc_rect_t scaled_display_frame = {INT(layer->dst_rect.left), INT(layer->dst_rect.top),
@@ -799,9 +781,7 @@ void HWCDisplay::BuildLayerStack() {
       layer->src_rect.bottom = layer_buffer->height;
     }
 
-    if (hwc_layer->HasMetaDataRefreshRate()) {
-      layer->flags.has_metadata_refresh_rate = true;
-    }
+    layer->cadence_rate = enable_cadence_refresh_rate_ ? hwc_layer->GetCadenceRate() : 0;
 
     display_rect_ = Union(display_rect_, layer->dst_rect);
     geometry_changes_ |= hwc_layer->GetGeometryChanges();
@@ -811,20 +791,20 @@ void HWCDisplay::BuildLayerStack() {
       layer->flags.updating = IsLayerUpdating(hwc_layer);
     }
 
-    if (hwc_layer->IsColorTransformSet()) {
-      layer->flags.color_transform = true;
-    }
-
-    layer_stack_.flags.mask_present |= layer->input_buffer.flags.mask_layer;
-
-    layer->flags.compatible = hwc_layer->IsLayerCompatible();
-
-    layer->layer_id = hwc_layer->GetId();
-    layer->layer_name = hwc_layer->GetName();
     layer->geometry_changes = hwc_layer->GetGeometryChanges();
     layer_stack_.layers.push_back(layer);
   }
 
+  layer_stack_.flags.video_present = stack_aggregates_.IsPresent(kStackVideo);
+  layer_stack_.flags.secure_present = stack_aggregates_.IsPresent(kStackSecure);
+  layer_stack_.flags.scaling_rgb_layer_present = stack_aggregates_.IsPresent(kStackScalingRgb);
+  layer_stack_.flags.single_buffered_layer_present =
+      stack_aggregates_.IsPresent(kStackSingleBuffered);
+  layer_stack_.flags.hdr_present = stack_aggregates_.IsPresent(kStackHdr);
+  layer_stack_.flags.cursor_present = stack_aggregates_.IsPresent(kStackCursor);
+  layer_stack_.flags.skip_present = stack_aggregates_.IsPresent(kStackSkip);
+  layer_stack_.flags.mask_present = stack_aggregates_.IsPresent(kStackMask);
+
   // TODO(user): Set correctly when SDM supports geometry_changes as bitmask
 
   layer_stack_.flags.geometry_changed = UINT32((geometry_changes_ ||
@@ -938,6 +918,11 @@ HWC2::Error HWCDisplay::SetVsyncEnabled(HWC2::Vsync enabled) {
     return HWC2::Error::BadDisplay;
   }
 
+  if (!state) {
+    // Vsyncs after the gap do not continue the fitted grid
+    ResetVsyncModel();
+  }
+
   return HWC2::Error::None;
 }
 
@@ -1012,6 +997,10 @@ HWC2::Error HWCDisplay::SetPowerMode(HWC2::PowerMode mode, bool teardown) {
 
   // Update release fence.
   release_fence_ = release_fence;
+  if (current_power_mode_ != mode) {
+    // The panel timing restarts with a power state change, the old fit no longer applies
+    ResetVsyncModel();
+  }
   current_power_mode_ = mode;
 
   PostPowerMode();
@@ -1413,6 +1402,8 @@ HWC2::PowerMode HWCDisplay::GetCurrentPowerMode() {
 }
 
 DisplayError HWCDisplay::VSync(const DisplayEventVSync &vsync) {
+  UpdateVsyncModel(vsync.timestamp);
+
   if (callbacks_->Vsync_2_4CallbackRegistered()) {
     VsyncPeriodNanos vsync_period;
     if (GetDisplayVsyncPeriod(&vsync_period) != HWC2::Error::None) {
@@ -2542,54 +2533,107 @@ DisplayClass HWCDisplay::GetDisplayClass() {
   return display_class_;
 }
 
-void HWCDisplay::Dump(std::ostringstream *os) {
-  *os << "\n------------HWC----------------\n";
-  *os << "HWC2 display_id: " << id_ << std::endl;
+HWCDisplay::DumpFormatter HWCDisplay::CollectDump() {
+  auto dump_state = std::make_shared<DumpState>();
+
+  dump_state->id = id_;
+  dump_state->layers.reserve(layer_set_.size());
   for (auto layer : layer_set_) {
     auto sdm_layer = layer->GetSDMLayer();
-    auto transform = sdm_layer->transform;
-    *os << "layer: " << std::setw(4) << layer->GetId();
-    *os << " name: " << std::setw(100) << layer->GetName();
-    *os << " z: " << layer->GetZ();
+    DumpLayer dump_layer;
+    dump_layer.id = layer->GetId();
+    dump_layer.name = layer->GetName();
+    dump_layer.z = layer->GetZ();
+    dump_layer.client_requested = layer->GetOrigClientRequestedCompositionType();
+    dump_layer.device_selected = layer->GetDeviceSelectedCompositionType();
+    dump_layer.plane_alpha = sdm_layer->plane_alpha;
+    dump_layer.format = sdm_layer->input_buffer.format;
+    dump_layer.dataspace = layer->GetLayerDataspace();
+    dump_layer.transform = sdm_layer->transform;
+    dump_layer.buffer_id = sdm_layer->input_buffer.buffer_id;
+    dump_layer.secure = layer->IsProtected();
+    dump_state->layers.push_back(std::move(dump_layer));
+  }
+
+  if (has_client_composition_) {
+    auto sdm_layer = client_target_->GetSDMLayer();
+    dump_state->has_client_target = true;
+    dump_state->client_target.format = sdm_layer->input_buffer.format;
+    dump_state->client_target.dataspace = client_target_->GetLayerDataspace();
+    dump_state->client_target.buffer_id = sdm_layer->input_buffer.buffer_id;
+    dump_state->client_target.secure = client_target_->IsProtected();
+  }
+
+  if (latency_stats_) {
+    dump_state->latency_stats = latency_stats_->Dump();
+  }
+
+  dump_state->layer_stack_invalid = layer_stack_invalid_;
+  if (!layer_stack_invalid_) {
+    if (color_mode_) {
+      std::ostringstream color_modes;
+      color_mode_->Dump(&color_modes);
+      dump_state->color_modes = color_modes.str();
+    }
+    if (display_intf_) {
+      dump_state->format_sdm = display_intf_->CollectDump();
+    }
+  }
+
+  return [dump_state](std::ostringstream *os) { FormatDump(*dump_state, os); };
+}
+
+void HWCDisplay::FormatDump(const DumpState &dump_state, std::ostringstream *os) {
+  *os << "\n------------HWC----------------\n";
+  *os << "HWC2 display_id: " << dump_state.id << std::endl;
+  for (auto &layer : dump_state.layers) {
+    auto &transform = layer.transform;
+    *os << "layer: " << std::setw(4) << layer.id;
+    *os << " name: " << std::setw(100) << layer.name;
+    *os << " z: " << layer.z;
     *os << " composition: " <<
-          to_string(layer->GetOrigClientRequestedCompositionType()).c_str();
+          to_string(layer.client_requested).c_str();
     *os << "/" <<
-          to_string(layer->GetDeviceSelectedCompositionType()).c_str();
-    *os << " alpha: " << std::to_string(sdm_layer->plane_alpha).c_str();
-    *os << " format: " << std::setw(22) << GetFormatString(sdm_layer->input_buffer.format);
+          to_string(layer.device_selected).c_str();
+    *os << " alpha: " << std::to_string(layer.plane_alpha).c_str();
+    *os << " format: " << std::setw(22) << GetFormatString(layer.format);
     *os << " dataspace:" << std::hex << "0x" << std::setw(8) << std::setfill('0')
-        << layer->GetLayerDataspace() << std::dec << std::setfill(' ');
+        << layer.dataspace << std::dec << std::setfill(' ');
     *os << " transform: " << transform.rotation << "/" << transform.flip_horizontal <<
           "/"<< transform.flip_vertical;
-    *os << " buffer_id: " << std::hex << "0x" << sdm_layer->input_buffer.buffer_id << std::dec;
-    *os << " secure: " << layer->IsProtected()
+    *os << " buffer_id: " << std::hex << "0x" << layer.buffer_id << std::dec;
+    *os << " secure: " << layer.secure
         << std::endl;
   }
 
-  if (has_client_composition_) {
+  if (dump_state.has_client_target) {
+    auto &client_target = dump_state.client_target;
     *os << "\n---------client target---------\n";
-    auto sdm_layer = client_target_->GetSDMLayer();
-    *os << "format: " << std::setw(14) << GetFormatString(sdm_layer->input_buffer.format);
+    *os << "format: " << std::setw(14) << GetFormatString(client_target.format);
     *os << " dataspace:" << std::hex << "0x" << std::setw(8) << std::setfill('0')
-        << client_target_->GetLayerDataspace() << std::dec << std::setfill(' ');
-    *os << "  buffer_id: " << std::hex << "0x" << sdm_layer->input_buffer.buffer_id << std::dec;
-    *os << " secure: " << client_target_->IsProtected()
+        << client_target.dataspace << std::dec << std::setfill(' ');
+    *os << "  buffer_id: " << std::hex << "0x" << client_target.buffer_id << std::dec;
+    *os << " secure: " << client_target.secure
         << std::endl;
   }
 
-  if (layer_stack_invalid_) {
+  if (!dump_state.latency_stats.empty()) {
+    *os << "\n" << dump_state.latency_stats;
+  }
+
+  if (dump_state.layer_stack_invalid) {
     *os << "\n Layers added or removed but not reflected to SDM's layer stack yet\n";
     return;
   }
 
-  if (color_mode_) {
+  if (!dump_state.color_modes.empty()) {
     *os << "\n----------Color Modes---------\n";
-    color_mode_->Dump(os);
+    *os << dump_state.color_modes;
   }
 
-  if (display_intf_) {
+  if (dump_state.format_sdm) {
     *os << "\n------------SDM----------------\n";
-    *os << display_intf_->Dump();
+    *os << dump_state.format_sdm();
   }
 
   *os << "\n";
@@ -2853,6 +2897,24 @@ void HWCDisplay::ProcessActiveConfigChange() {
   }
 }
 
+void HWCDisplay::UpdateVsyncModel(int64_t timestamp) {
+  std::lock_guard<std::mutex> lock(vsync_model_lock_);
+  if (!vsync_model_.GetNominalPeriod()) {
+    VsyncPeriodNanos vsync_period = 0;
+    if (GetVsyncPeriodByActiveConfig(&vsync_period) != HWC2::Error::None) {
+      return;
+    }
+    vsync_model_.Reset(vsync_period);
+  }
+  vsync_model_.AddVsync(timestamp);
+}
+
+void HWCDisplay::ResetVsyncModel() {
+  std::lock_guard<std::mutex> lock(vsync_model_lock_);
+  // Picks up the nominal period of the active config again on the next vsync
+  vsync_model_.Reset(0);
+}
+
 HWC2::Error HWCDisplay::GetVsyncPeriodByActiveConfig(VsyncPeriodNanos *vsync_period) {
   hwc2_config_t active_config;
 
@@ -2906,6 +2968,18 @@ std::tuple<int64_t, int64_t> HWCDisplay::RequestActiveConfigChange(
 std::tuple<int64_t, int64_t> HWCDisplay::EstimateVsyncPeriodChangeTimeline(
     VsyncPeriodNanos current_vsync_period, int64_t desired_time) {
   const auto now = systemTime(SYSTEM_TIME_MONOTONIC);
+  {
+    std::lock_guard<std::mutex> lock(vsync_model_lock_);
+    if (vsync_model_.GetNominalPeriodAt(now) != current_vsync_period) {
+      // Period changed outside of the timeline, the fitted phase no longer applies.
+      vsync_model_.Reset(current_vsync_period);
+    }
+    if (vsync_model_.IsValid()) {
+      return vsync_model_.EstimateChange(desired_time, now, vsyncs_to_apply_rate_change_);
+    }
+  }
+
+  // No hardware vsync seen yet, assume desired_time is on the vsync grid.
   const auto delta = desired_time - now;
   const auto refresh_rate_activate_period = current_vsync_period * vsyncs_to_apply_rate_change_;
   nsecs_t refresh_time;
@@ -2934,7 +3008,19 @@ void HWCDisplay::SubmitActiveConfigChange(VsyncPeriodNanos current_vsync_period)
       EstimateVsyncPeriodChangeTimeline(current_vsync_period, pending_refresh_rate_refresh_time_);
 
   transient_refresh_rate_info_.push_back({current_vsync_period, timeline.newVsyncAppliedTimeNanos});
-  if (timeline.newVsyncAppliedTimeNanos != pending_refresh_rate_applied_time_) {
+
+  int32_t new_vsync_period = 0;
+  if (GetDisplayAttribute(pending_refresh_rate_config_, HwcAttribute::VSYNC_PERIOD,
+                          &new_vsync_period) == HWC2::Error::None) {
+    std::lock_guard<std::mutex> lock(vsync_model_lock_);
+    vsync_model_.SchedulePeriodChange(new_vsync_period, timeline.newVsyncAppliedTimeNanos);
+  }
+
+  // The fit keeps refining between request and commit; only a shift to another vsync is a
+  // change of timeline worth reporting.
+  int64_t applied_time_shift = timeline.newVsyncAppliedTimeNanos -
+                               pending_refresh_rate_applied_time_;
+  if (std::abs(applied_time_shift) > static_cast<int64_t>(current_vsync_period / 2)) {
     timeline.refreshRequired = false;
     callbacks_->VsyncPeriodTimingChanged(id_, &timeline);
   }
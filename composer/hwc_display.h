@@ -33,8 +33,10 @@
 #include <hardware/hwcomposer.h>
 #include <private/color_params.h>
 #include <sys/stat.h>
+#include <utils/frame_latency_stats.h>
 #include <algorithm>
 #include <bitset>
+#include <functional>
 #include <map>
 #include <queue>
 #include <set>
@@ -47,6 +49,8 @@
 #include "hwc_display_event_handler.h"
 #include "hwc_layers.h"
 #include "hwc_buffer_sync_handler.h"
+#include "layer_stack_aggregates.h"
+#include "vsync_timeline_model.h"
 #include <vendor/qti/hardware/display/composer/3.1/IQtiComposerClient.h>
 
 using android::hardware::graphics::common::V1_2::ColorMode;
@@ -224,7 +228,10 @@ class HWCDisplay : public DisplayEventHandler {
   virtual uint32_t GetAvailableMixerCount();
   virtual void GetPanelResolution(uint32_t *width, uint32_t *height);
   virtual void GetRealPanelResolution(uint32_t *width, uint32_t *height);
-  virtual void Dump(std::ostringstream *os);
+  typedef std::function<void(std::ostringstream *os)> DumpFormatter;
+  // Copies the dump state, called with the display lock held. The returned formatter does not
+  // access the display and is called after the lock is released.
+  virtual DumpFormatter CollectDump();
 
   // CWB related methods
   virtual int GetCwbBufferResolution(CwbConfig *cwb_config, uint32_t *x_pixels,
@@ -315,6 +322,7 @@ class HWCDisplay : public DisplayEventHandler {
     return HWC2::Error::Unsupported;
   }
   bool IsFirstCommitDone() { return !first_cycle_; }
+  FrameLatencyStats *GetLatencyStats() { return latency_stats_; }
   virtual void ProcessActiveConfigChange();
 
   // HWC2 APIs
@@ -486,6 +494,33 @@ class HWCDisplay : public DisplayEventHandler {
   virtual void MarkClientActive(bool is_client_up);
 
  protected:
+  struct DumpLayer {
+    hwc2_layer_t id = 0;
+    std::string name;
+    uint32_t z = 0;
+    HWC2::Composition client_requested = HWC2::Composition::Invalid;
+    HWC2::Composition device_selected = HWC2::Composition::Invalid;
+    float plane_alpha = 1.0f;
+    LayerBufferFormat format = kFormatRGBA8888;
+    int32_t dataspace = 0;
+    LayerTransform transform = {};
+    uint64_t buffer_id = 0;
+    bool secure = false;
+  };
+
+  struct DumpState {
+    hwc2_display_t id = 0;
+    std::vector<DumpLayer> layers;
+    bool has_client_target = false;
+    DumpLayer client_target = {};
+    std::string latency_stats;
+    bool layer_stack_invalid = false;
+    std::string color_modes;
+    std::function<std::string()> format_sdm = nullptr;
+  };
+
+  static void FormatDump(const DumpState &dump_state, std::ostringstream *os);
+
   static uint32_t throttling_refresh_rate_;
   // Maximum number of layers supported by display manager.
   static const uint32_t kMaxLayerCount = 32;
@@ -530,6 +565,8 @@ class HWCDisplay : public DisplayEventHandler {
   std::tuple<int64_t, int64_t> EstimateVsyncPeriodChangeTimeline(
       VsyncPeriodNanos current_vsync_period, int64_t desired_time);
   void SubmitActiveConfigChange(VsyncPeriodNanos current_vsync_period);
+  void UpdateVsyncModel(int64_t timestamp);
+  void ResetVsyncModel();
   bool IsActiveConfigReadyToSubmit(int64_t time);
   bool IsActiveConfigApplied(int64_t time, int64_t vsync_applied_time);
   bool IsSameGroup(hwc2_config_t config_id1, hwc2_config_t config_id2);
@@ -562,11 +599,14 @@ class HWCDisplay : public DisplayEventHandler {
   DisplayType type_ = kDisplayTypeMax;
   hwc2_display_t id_ = UINT64_MAX;
   int32_t sdm_id_ = -1;
+  FrameLatencyStats *latency_stats_ = nullptr;
   DisplayInterface *display_intf_ = NULL;
   LayerStack layer_stack_;
   HWCLayer *client_target_ = nullptr;                   // Also known as framebuffer target
   std::map<hwc2_layer_t, HWCLayer *> layer_map_;        // Look up by Id - TODO
   std::multiset<HWCLayer *, SortLayersByZ> layer_set_;  // Maintain a set sorted by Z
+  LayerStackAggregates stack_aggregates_;  // Stack wide flags of the layers in layer_set_
+  DisplayLayerInputs layer_inputs_;        // Display wide inputs of the last derivation
   std::map<hwc2_layer_t, HWC2::Composition> layer_changes_;
   std::map<hwc2_layer_t, HWC2::LayerRequest> layer_requests_;
   bool flush_on_error_ = false;
@@ -580,6 +620,7 @@ class HWCDisplay : public DisplayEventHandler {
   uint32_t qsync_fps_ = 0;
   uint32_t current_refresh_rate_ = 0;
   bool use_metadata_refresh_rate_ = false;
+  bool enable_cadence_refresh_rate_ = false;
   bool boot_animation_completed_ = false;
   bool shutdown_pending_ = false;
   std::bitset<kSecureMax> active_secure_sessions_ = 0;
@@ -611,6 +652,8 @@ class HWCDisplay : public DisplayEventHandler {
   int64_t pending_refresh_rate_applied_time_ = INT64_MAX;
   std::deque<TransientRefreshRateInfo> transient_refresh_rate_info_;
   std::mutex transient_refresh_rate_lock_;
+  VsyncTimelineModel vsync_model_;
+  std::mutex vsync_model_lock_;
   std::mutex active_config_lock_;
   int active_config_index_ = -1;
   uint32_t active_refresh_rate_ = 0;
@@ -128,6 +128,11 @@ int HWCDisplayBuiltIn::Init() {
     layer_stack_.flags.use_metadata_refresh_rate = false;
   }
 
+  int enable_cadence_refresh_rate = 0;
+  HWCDebugHandler::Get()->GetProperty(ENABLE_CADENCE_REFRESH_RATE_PROP,
+                                      &enable_cadence_refresh_rate);
+  enable_cadence_refresh_rate_ = (enable_cadence_refresh_rate != 0);
+
   int status = HWCDisplay::Init();
   if (status) {
     return status;
@@ -180,6 +185,11 @@ int HWCDisplayBuiltIn::Init() {
     large_comp_hint_threshold_ = value;
   }
 
+  value = 0;
+  HWCDebugHandler::Get()->GetProperty(ENABLE_FRAME_COST_PERF_HINT, &value);
+  enable_frame_cost_hint_ = (value == 1);
+  frame_cost_estimator_.SetReleaseHold(milliseconds_to_nanoseconds(elapse_time_threshold_));
+
   uint32_t config_index = 0;
   GetActiveDisplayConfig(&config_index);
   DisplayConfigVariableInfo attr = {};
@@ -198,9 +208,13 @@ int HWCDisplayBuiltIn::Init() {
   return status;
 }
 
-void HWCDisplayBuiltIn::Dump(std::ostringstream *os) {
-  HWCDisplay::Dump(os);
-  *os << histogram.Dump();
+HWCDisplay::DumpFormatter HWCDisplayBuiltIn::CollectDump() {
+  DumpFormatter format_display = HWCDisplay::CollectDump();
+  std::string histogram_dump = histogram.Dump();
+  return [format_display, histogram_dump](std::ostringstream *os) {
+    format_display(os);
+    *os << histogram_dump;
+  };
 }
 
 void HWCDisplayBuiltIn::ValidateUiScaling() {
@@ -1387,6 +1401,12 @@ HWC2::Error HWCDisplayBuiltIn::PostCommitLayerStack(shared_ptr<Fence> *out_retir
   PostCommitStitchLayers();
 
   auto status = HWCDisplay::PostCommitLayerStack(out_retire_fence);
+
+  if (perf_hint_large_comp_cycle_ && enable_frame_cost_hint_ && frame_start_time_) {
+    HandleFrameCostHint(systemTime(SYSTEM_TIME_MONOTONIC) - frame_start_time_);
+    frame_start_time_ = 0;
+  }
+
 /*  display_intf_->GetConfig(&fixed_info);
   is_cmd_mode_ = fixed_info.is_cmdmode;
 
@@ -1453,10 +1473,11 @@ HWC2::Error HWCDisplayBuiltIn::CommitOrPrepare(bool validate_only,
                                                uint32_t *out_num_requests, bool *needs_commit) {
   DTRACE_SCOPED();
 
+  frame_start_time_ = systemTime(SYSTEM_TIME_MONOTONIC);
   auto status = HWCDisplay::CommitOrPrepare(validate_only, out_retire_fence, out_num_types,
                                             out_num_requests, needs_commit);
 
-  if (perf_hint_large_comp_cycle_) {
+  if (perf_hint_large_comp_cycle_ && !enable_frame_cost_hint_) {
     bool needs_hint = NeedsLargeCompPerfHint();
     HandleLargeCompositionHint(!needs_hint);
   }
@@ -1608,10 +1629,39 @@ void HWCDisplayBuiltIn::HandleLargeCompositionHint(bool release) {
   hint_release_start_time_ = 0;
 }
 
+void HWCDisplayBuiltIn::HandleFrameCostHint(nsecs_t frame_cost) {
+  if (!cpu_hint_) {
+    return;
+  }
+
+  // Budget the validate to present time against the current vsync period
+  VsyncPeriodNanos vsync_period = 0;
+  if (GetDisplayVsyncPeriod(&vsync_period) == HWC2::Error::None) {
+    frame_cost_estimator_.SetVsyncPeriod(vsync_period);
+  }
+
+  auto action = frame_cost_estimator_.Update(frame_cost, systemTime(SYSTEM_TIME_MONOTONIC));
+  DLOGV_IF(kTagResources, "Frame cost:%" PRId64 " predicted:%" PRId64 " vsync:%u action:%d",
+           frame_cost, frame_cost_estimator_.GetPredictedCost(), vsync_period, action);
+
+  switch (action) {
+    case FrameCostEstimator::kHintRequest:
+      // Renewal of a held hint is handled by CPUHint
+      HandleLargeCompositionHint(false);
+      break;
+    case FrameCostEstimator::kHintRelease:
+      cpu_hint_->ReqHintRelease();
+      break;
+    default:
+      break;
+  }
+}
+
 void HWCDisplayBuiltIn::ReqPerfHintRelease() {
   if (!cpu_hint_) {
     return;
   }
+  frame_cost_estimator_.Reset();
   cpu_hint_->ReqHintRelease();
 }
 
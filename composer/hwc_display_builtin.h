@@ -45,6 +45,7 @@
 #include "utils/sync_task.h"
 #include "utils/constants.h"
 #include "cpuhint.h"
+#include "frame_cost_estimator.h"
 #include "hwc_display.h"
 #include "hwc_layers.h"
 
@@ -139,7 +140,7 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
       uint64_t max_frames, uint64_t timestamp, uint64_t *numFrames,
       int32_t samples_size[NUM_HISTOGRAM_COLOR_COMPONENTS],
       uint64_t *samples[NUM_HISTOGRAM_COLOR_COMPONENTS]);
-  void Dump(std::ostringstream *os) override;
+  DumpFormatter CollectDump() override;
   virtual HWC2::Error SetPowerMode(HWC2::PowerMode mode, bool teardown);
   virtual bool IsDisplayIdle();
   virtual bool HasReadBackBufferSupport();
@@ -183,6 +184,7 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   uint32_t GetUpdatingAppLayersCount();
   void LoadMixedModePerfHintThreshold();
   void HandleLargeCompositionHint(bool release);
+  void HandleFrameCostHint(nsecs_t frame_cost);
   void ReqPerfHintRelease();
 
   // SyncTask methods.
@@ -231,6 +233,11 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   uint32_t large_comp_hint_threshold_ = 0;
   nsecs_t hint_release_start_time_ = 0;
   nsecs_t elapse_time_threshold_ = 100;  // Time is in milliseconds
+
+  // Frame cost driven large composition hint
+  bool enable_frame_cost_hint_ = false;
+  FrameCostEstimator frame_cost_estimator_;
+  nsecs_t frame_start_time_ = 0;
 };
 
 }  // namespace sdm
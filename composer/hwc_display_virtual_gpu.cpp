@@ -33,6 +33,10 @@
  * SPDX-License-Identifier: BSD-3-Clause-Clear
  */
 
+#include <math.h>
+#include <utils/rect.h>
+#include <algorithm>
+
 #include "hwc_display_virtual_gpu.h"
 #include "hwc_session.h"
 #include "QtiGralloc.h"
@@ -143,6 +147,7 @@ HWC2::Error HWCDisplayVirtualGPU::SetOutputBuffer(buffer_handle_t buf,
   }
 
   native_handle_t *hnd = const_cast<native_handle_t *>(buf);
+  buffer_allocator_->GetBufferId(hnd, output_buffer_unique_id_);
   buffer_allocator_->GetWidth(hnd, output_buffer_->width);
   buffer_allocator_->GetHeight(hnd, output_buffer_->height);
   buffer_allocator_->GetUnalignedWidth(hnd, output_buffer_->unaligned_width);
@@ -165,6 +170,7 @@ HWC2::Error HWCDisplayVirtualGPU::SetOutputBuffer(buffer_handle_t buf,
       output_buffer_->width = UINT32(new_aligned_w);
       output_buffer_->height = UINT32(new_aligned_h);
       color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeReset, nullptr);
+      ResetDamageHistory();
     }
   }
 
@@ -181,11 +187,17 @@ HWC2::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
   }
 
   if (NeedsGPUBypass()) {
+    // Output buffers are not written here, their contents are unknown from now on.
+    ResetDamageHistory();
     return status;
   }
 
   layer_stack_.output_buffer = output_buffer_;
 
+  GLRect dst_rect = {0, 0, FLOAT(output_buffer_->unaligned_width),
+                     FLOAT(output_buffer_->unaligned_height)};
+  UpdateDamageHistory(dst_rect);
+
   // Ensure that blit is initialized.
   // GPU context gets in secure or non-secure mode depending on output buffer provided.
   if (!gl_color_convert_) {
@@ -205,12 +217,26 @@ HWC2::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
   LayerBuffer &input_buffer = sdm_layer->input_buffer;
   ctx.src_hnd = reinterpret_cast<const native_handle_t *>(input_buffer.buffer_id);
   ctx.dst_hnd = reinterpret_cast<const native_handle_t *>(output_handle_);
-  ctx.dst_rect = {0, 0, FLOAT(output_buffer_->unaligned_width),
-                  FLOAT(output_buffer_->unaligned_height)};
+  ctx.dst_rect = dst_rect;
+  ctx.damage_rect = GetOutputDamage(dst_rect);
   ctx.src_acquire_fence = input_buffer.acquire_fence;
   ctx.dst_acquire_fence = output_buffer_->acquire_fence;
 
-  color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeBlit, &ctx);
+  uint64_t full_area = UINT64(dst_rect.right) * UINT64(dst_rect.bottom);
+  uint64_t damage_area = UINT64(ctx.damage_rect.right - ctx.damage_rect.left) *
+                         UINT64(ctx.damage_rect.bottom - ctx.damage_rect.top);
+  if (damage_area == full_area) {
+    // Full conversion, no need to scissor.
+    ctx.damage_rect = {};
+  }
+
+  if (damage_area) {
+    color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeBlit, &ctx);
+  }
+  output_frame_map_[output_buffer_unique_id_] = frame_count_;
+  converted_frames_++;
+  converted_area_ += damage_area;
+  full_area_ += full_area;
 
   // todo blit
   DumpVDSBuffer();
@@ -231,7 +257,7 @@ void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
         DTRACE_SCOPED();
         ColorConvertBlitContext* ctx = reinterpret_cast<ColorConvertBlitContext*>(task_context);
         gl_color_convert_->Blit(ctx->src_hnd, ctx->dst_hnd, ctx->src_rect, ctx->dst_rect,
-                                ctx->src_acquire_fence, ctx->dst_acquire_fence,
+                                ctx->damage_rect, ctx->src_acquire_fence, ctx->dst_acquire_fence,
                                 &(ctx->release_fence));
       }
       break;
@@ -251,6 +277,107 @@ void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
   }
 }
 
+void HWCDisplayVirtualGPU::UpdateDamageHistory(const GLRect &dst_rect) {
+  Layer *sdm_layer = client_target_->GetSDMLayer();
+  LayerBuffer &input_buffer = sdm_layer->input_buffer;
+  int32_t dataspace = client_target_->GetLayerDataspace();
+
+  // A different source size or dataspace changes every output pixel.
+  if (input_buffer.unaligned_width != src_width_ || input_buffer.unaligned_height != src_height_ ||
+      dataspace != src_dataspace_) {
+    ResetDamageHistory();
+    src_width_ = input_buffer.unaligned_width;
+    src_height_ = input_buffer.unaligned_height;
+    src_dataspace_ = dataspace;
+  }
+
+  frame_count_++;
+
+  // No damage rects means the whole client target changed, a single empty rect means nothing did.
+  GLRect damage = dst_rect;
+  auto &dirty_regions = sdm_layer->dirty_regions;
+  if (dirty_regions.size() == 1 && dirty_regions.at(0).right == 0 &&
+      dirty_regions.at(0).bottom == 0) {
+    damage = {};
+  } else if (dirty_regions.size() && src_width_ && src_height_) {
+    LayerRect bounds = dirty_regions.at(0);
+    for (auto &rect : dirty_regions) {
+      bounds = Union(bounds, rect);
+    }
+    float scale_x = (dst_rect.right - dst_rect.left) / FLOAT(src_width_);
+    float scale_y = (dst_rect.bottom - dst_rect.top) / FLOAT(src_height_);
+    // Expand to even pixels, the output is chroma subsampled.
+    damage.left = FLOAT(INT(bounds.left * scale_x) & ~1);
+    damage.top = FLOAT(INT(bounds.top * scale_y) & ~1);
+    damage.right = FLOAT((INT(ceilf(bounds.right * scale_x)) + 1) & ~1);
+    damage.bottom = FLOAT((INT(ceilf(bounds.bottom * scale_y)) + 1) & ~1);
+    damage.left = std::max(damage.left, dst_rect.left);
+    damage.top = std::max(damage.top, dst_rect.top);
+    damage.right = std::min(damage.right, dst_rect.right);
+    damage.bottom = std::min(damage.bottom, dst_rect.bottom);
+  }
+
+  damage_history_[frame_count_ % kDamageHistory] = damage;
+
+  // Buffers that fell out of the history need a full conversion anyway.
+  if (output_frame_map_.size() > 2 * kDamageHistory) {
+    for (auto it = output_frame_map_.begin(); it != output_frame_map_.end();) {
+      if (frame_count_ - it->second > kDamageHistory) {
+        it = output_frame_map_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+}
+
+GLRect HWCDisplayVirtualGPU::GetOutputDamage(const GLRect &dst_rect) {
+  auto it = output_frame_map_.find(output_buffer_unique_id_);
+  if (it == output_frame_map_.end() || (frame_count_ - it->second) > kDamageHistory ||
+      it->second >= frame_count_) {
+    return dst_rect;
+  }
+
+  // Union of the damage of every frame after the one the buffer holds.
+  GLRect damage = {};
+  for (uint64_t frame = it->second + 1; frame <= frame_count_; frame++) {
+    const GLRect &rect = damage_history_[frame % kDamageHistory];
+    if (rect.right <= rect.left || rect.bottom <= rect.top) {
+      continue;
+    }
+    if (damage.right <= damage.left || damage.bottom <= damage.top) {
+      damage = rect;
+      continue;
+    }
+    damage.left = std::min(damage.left, rect.left);
+    damage.top = std::min(damage.top, rect.top);
+    damage.right = std::max(damage.right, rect.right);
+    damage.bottom = std::max(damage.bottom, rect.bottom);
+  }
+
+  return damage;
+}
+
+void HWCDisplayVirtualGPU::ResetDamageHistory() {
+  output_frame_map_.clear();
+}
+
+HWCDisplay::DumpFormatter HWCDisplayVirtualGPU::CollectDump() {
+  DumpFormatter format_display = HWCDisplay::CollectDump();
+  uint64_t converted_frames = converted_frames_;
+  uint64_t converted_area = converted_area_;
+  uint64_t full_area = full_area_;
+  return [=](std::ostringstream *os) {
+    format_display(os);
+    *os << "color convert: frames: " << converted_frames;
+    *os << " converted area: " << converted_area << "/" << full_area;
+    if (full_area) {
+      *os << " (" << (converted_area * 100 / full_area) << "%)";
+    }
+    *os << std::endl;
+  };
+}
+
 bool HWCDisplayVirtualGPU::FreezeScreen() {
   if (!disable_animation_) {
     return false;
@@ -37,6 +37,8 @@
 #ifndef __HWC_DISPLAY_VIRTUAL_GPU_H__
 #define __HWC_DISPLAY_VIRTUAL_GPU_H__
 
+#include <unordered_map>
+
 #include "utils/sync_task.h"
 #include "hwc_display_virtual.h"
 #include "gl_color_convert.h"
@@ -59,6 +61,7 @@ struct ColorConvertBlitContext : public SyncTask<ColorConvertTaskCode>::TaskCont
   const native_handle_t *dst_hnd = nullptr;
   GLRect src_rect = {};
   GLRect dst_rect = {};
+  GLRect damage_rect = {};
   shared_ptr<Fence> src_acquire_fence = nullptr;
   shared_ptr<Fence> dst_acquire_fence = nullptr;
   shared_ptr<Fence> release_fence = nullptr;
@@ -79,17 +82,36 @@ class HWCDisplayVirtualGPU : public HWCDisplayVirtual,
                                       uint32_t *out_num_types,
                                       uint32_t *out_num_requests, bool *needs_commit);
   virtual bool FreezeScreen();
+  virtual DumpFormatter CollectDump();
 
  private:
   // SyncTask methods.
   void OnTask(const ColorConvertTaskCode &task_code,
               SyncTask<ColorConvertTaskCode>::TaskContext *task_context);
+  void UpdateDamageHistory(const GLRect &dst_rect);
+  GLRect GetOutputDamage(const GLRect &dst_rect);
+  void ResetDamageHistory();
 
   SyncTask<ColorConvertTaskCode> color_convert_task_;
   GLColorConvert *gl_color_convert_ = nullptr;
 
   bool disable_animation_ = false;
   bool animation_in_progress_ = false;
+
+  // Damage tracking for partial conversion. Each output buffer remembers the client target frame
+  // it holds, so a reused buffer is brought up to date with the damage of the frames since then.
+  static const uint64_t kDamageHistory = 4;
+  GLRect damage_history_[kDamageHistory] = {};
+  uint64_t frame_count_ = 0;
+  uint64_t output_buffer_unique_id_ = 0;
+  std::unordered_map<uint64_t, uint64_t> output_frame_map_ = {};
+  uint32_t src_width_ = 0;
+  uint32_t src_height_ = 0;
+  int32_t src_dataspace_ = 0;
+
+  uint64_t converted_frames_ = 0;
+  uint64_t converted_area_ = 0;
+  uint64_t full_area_ = 0;
 };
 
 }  // namespace sdm
@@ -70,6 +70,7 @@ using aidl::android::hardware::graphics::common::StandardMetadataType;
 namespace sdm {
 
 std::atomic<hwc2_layer_t> HWCLayer::next_id_(1);
+uint32_t HWCLayer::max_damage_rects_ = 0;
 
 DisplayError SetCSC(const native_handle_t *handle, ColorMetaData *color_metadata) {
   void *hnd = const_cast<native_handle_t *>(handle);
@@ -421,6 +422,7 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, shared_ptr<Fence> a
   gralloc::GetMetaDataValue(hnd, (int64_t)qtigralloc::MetadataType_BufferType.value, &buffer_type);
 
   layer_buffer->flags.video = (buffer_type == BUFFER_TYPE_VIDEO) ? true : false;
+  dirty_flags_ |= kDirtyBuffer;
   if (SetMetaData(handle, layer_) != kErrorNone) {
     return HWC2::Error::BadLayer;
   }
@@ -438,6 +440,8 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, shared_ptr<Fence> a
   layer_buffer->flags.secure = secure_;
   layer_buffer->flags.secure_camera = secure_camera;
   layer_buffer->flags.secure_display = secure_display;
+  // UBWC PI format
+  layer_buffer->flags.ubwc_pi = (flag & qtigralloc::PRIV_FLAGS_UBWC_ALIGNED_PI);
 
   layer_buffer->acquire_fence = acquire_fence;
 
@@ -462,6 +466,9 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, shared_ptr<Fence> a
     DLOGW("Failed to retrieve allocation size");
   }
   buffer_flipped_ = reinterpret_cast<uint64_t>(handle) != layer_buffer->buffer_id;
+  if (buffer_flipped_) {
+    cadence_detector_.OnBufferUpdate(static_cast<int64_t>(GetSystemTimeInNs()));
+  }
   layer_buffer->buffer_id = reinterpret_cast<uint64_t>(handle);
   int64_t hd_id, hd_usage;
   err = gralloc::GetMetaDataValue(hnd, (int64_t)StandardMetadataType::BUFFER_ID,
@@ -487,20 +494,12 @@ HWC2::Error HWCLayer::SetLayerSurfaceDamage(hwc_region_t damage) {
   }
 
   // Check if there is an update in SurfaceDamage rects.
-  if (layer_->dirty_regions.size() != damage.numRects) {
-    layer_->update_mask.set(kSurfaceInvalidate);
-  } else {
-    for (uint32_t j = 0; j < damage.numRects; j++) {
-      LayerRect damage_rect;
-      SetRect(damage.rects[j], &damage_rect);
-      if (damage_rect != layer_->dirty_regions.at(j)) {
-        layer_->update_mask.set(kSurfaceDamage);
-        break;
-      }
-    }
+  bool resized = (surface_damage_.GetSize() != damage.numRects);
+  if (surface_damage_.Set(damage)) {
+    layer_->update_mask.set(resized ? kSurfaceInvalidate : kSurfaceDamage);
+    SetDirtyRegions();
   }
 
-  SetDirtyRegions(damage);
   return HWC2::Error::None;
 }
 
@@ -539,7 +538,10 @@ HWC2::Error HWCLayer::SetLayerColor(hwc_color_t color) {
     surface_updated_ = false;
   }
 
-  layer_->input_buffer.format = kFormatARGB8888;
+  if (layer_->input_buffer.format != kFormatARGB8888) {
+    layer_->input_buffer.format = kFormatARGB8888;
+    dirty_flags_ |= kDirtyColor;
+  }
   DLOGV_IF(kTagClient, "[%" PRIu64 "][%" PRIu64 "] Layer color set to %x", display_id_, id_,
            layer_->solid_fill_color);
   return HWC2::Error::None;
@@ -551,6 +553,9 @@ HWC2::Error HWCLayer::SetLayerCompositionType(HWC2::Composition type) {
       (type == HWC2::Composition::Client)) {
     layer_->update_mask.set(kClientCompRequest);
   }
+  if (type != client_requested_) {
+    dirty_flags_ |= kDirtyComposition;
+  }
   client_requested_ = type;
   client_requested_orig_ = type;
   switch (type) {
@@ -579,6 +584,7 @@ HWC2::Error HWCLayer::SetLayerDataspace(int32_t dataspace) {
   // cache the dataspace, to be used later to update SDM ColorMetaData
   if (dataspace_ != dataspace) {
     geometry_changes_ |= kDataspace;
+    dirty_flags_ |= kDirtyColor;
     dataspace_ = dataspace;
     if (layer_->input_buffer.buffer_id) {
       ValidateAndSetCSC(reinterpret_cast<native_handle_t *>(layer_->input_buffer.buffer_id));
@@ -593,6 +599,7 @@ HWC2::Error HWCLayer::SetLayerDisplayFrame(hwc_rect_t frame) {
   SetRect(frame, &dst_rect);
   if (dst_rect_ != dst_rect) {
     geometry_changes_ |= kDisplayFrame;
+    dirty_flags_ |= kDirtyGeometry;
     dst_rect_ = dst_rect;
   }
 
@@ -642,14 +649,19 @@ HWC2::Error HWCLayer::SetLayerPlaneAlpha(float alpha) {
 HWC2::Error HWCLayer::SetLayerSourceCrop(hwc_frect_t crop) {
   LayerRect src_rect = {};
   SetRect(crop, &src_rect);
-  non_integral_source_crop_ =
+  bool non_integral_source_crop =
       ((crop.left != roundf(crop.left)) || (crop.top != roundf(crop.top)) ||
        (crop.right != roundf(crop.right)) || (crop.bottom != roundf(crop.bottom)));
+  if (non_integral_source_crop_ != non_integral_source_crop) {
+    dirty_flags_ |= kDirtyGeometry;
+    non_integral_source_crop_ = non_integral_source_crop;
+  }
   if (non_integral_source_crop_) {
     DLOGV_IF(kTagClient, "Crop: LTRB %f %f %f %f", crop.left, crop.top, crop.right, crop.bottom);
   }
   if (layer_->src_rect != src_rect) {
     geometry_changes_ |= kSourceCrop;
+    dirty_flags_ |= kDirtyGeometry;
     layer_->src_rect = src_rect;
   }
 
@@ -694,6 +706,7 @@ HWC2::Error HWCLayer::SetLayerTransform(HWC2::Transform transform) {
 
   if (layer_transform_ != layer_transform) {
     geometry_changes_ |= kTransform;
+    dirty_flags_ |= kDirtyGeometry;
     layer_transform_ = layer_transform;
   }
 
@@ -701,11 +714,8 @@ HWC2::Error HWCLayer::SetLayerTransform(HWC2::Transform transform) {
 }
 
 HWC2::Error HWCLayer::SetLayerVisibleRegion(hwc_region_t visible) {
-  layer_->visible_regions.clear();
-  for (uint32_t i = 0; i < visible.numRects; i++) {
-    LayerRect rect;
-    SetRect(visible.rects[i], &rect);
-    layer_->visible_regions.push_back(rect);
+  if (visible_region_.Set(visible)) {
+    visible_region_.GetLayerRects(0, &layer_->visible_regions);
   }
 
   return HWC2::Error::None;
@@ -740,12 +750,19 @@ HWC2::Error HWCLayer::SetLayerType(IQtiComposerClient::LayerType type) {
       break;
   }
 
-  type_ = layer_type;
+  if (type_ != layer_type) {
+    dirty_flags_ |= kDirtyType;
+    type_ = layer_type;
+  }
   return HWC2::Error::None;
 }
 
 HWC2::Error HWCLayer::SetLayerFlag(IQtiComposerClient::LayerFlag flag) {
-  compatible_ = (flag == IQtiComposerClient::LayerFlag::COMPATIBLE);
+  bool compatible = (flag == IQtiComposerClient::LayerFlag::COMPATIBLE);
+  if (compatible_ != compatible) {
+    dirty_flags_ |= kDirtyType;
+    compatible_ = compatible;
+  }
 
   return HWC2::Error::None;
 }
@@ -754,6 +771,7 @@ HWC2::Error HWCLayer::SetLayerColorTransform(const float *matrix) {
   if (std::memcmp(matrix, layer_->color_transform_matrix, sizeof(layer_->color_transform_matrix))) {
     std::memcpy(layer_->color_transform_matrix, matrix, sizeof(layer_->color_transform_matrix));
     layer_->update_mask.set(kColorTransformUpdate);
+    dirty_flags_ |= kDirtyColorTransform;
     color_transform_matrix_set_ = true;
     if (!std::memcmp(matrix, kIdentityMatrix, sizeof(kIdentityMatrix))) {
       color_transform_matrix_set_ = false;
@@ -817,6 +835,7 @@ HWC2::Error HWCLayer::SetLayerPerFrameMetadata(uint32_t num_elements,
       (!SameConfig(&old_content_light, &content_light, UINT32(sizeof(ContentLightLevel))))) {
     layer_->update_mask.set(kContentMetadata);
     geometry_changes_ |= kDataspace;
+    dirty_flags_ |= kDirtyColor;
   }
   return HWC2::Error::None;
 }
@@ -842,6 +861,7 @@ HWC2::Error HWCLayer::SetLayerPerFrameMetadataBlobs(uint32_t num_elements,
         if (!SameConfig(static_cast<const uint8_t *>(color_metadata.dynamicMetaDataPayload),
                         metadata, sizes[i])) {
           geometry_changes_ |= kDataspace;
+          dirty_flags_ |= kDirtyColor;
           color_metadata.dynamicMetaDataValid = true;
           color_metadata.dynamicMetaDataLen = sizes[i];
           std::memcpy(color_metadata.dynamicMetaDataPayload, metadata, sizes[i]);
@@ -1344,23 +1364,27 @@ bool HWCLayer::IsScalingPresent() {
   return ((src_width != dst_width) || (dst_height != src_height));
 }
 
-void HWCLayer::SetDirtyRegions(hwc_region_t surface_damage) {
-  layer_->dirty_regions.clear();
-  for (uint32_t i = 0; i < surface_damage.numRects; i++) {
-    LayerRect rect;
-    SetRect(surface_damage.rects[i], &rect);
-    layer_->dirty_regions.push_back(rect);
-  }
+void HWCLayer::SetDirtyRegions() {
+  // Damage only widens when merged, visible regions are kept exact.
+  surface_damage_.GetLayerRects(max_damage_rects_, &layer_->dirty_regions);
 }
 
 void HWCLayer::SetLayerAsMask() {
   layer_->input_buffer.flags.mask_layer = true;
+  dirty_flags_ |= kDirtyType;
   DLOGV_IF(kTagClient,
            " Layer Id: "
            "[%" PRIu64 "]",
            id_);
 }
 
+void HWCLayer::UpdateClientCompositionType(HWC2::Composition type) {
+  if (client_requested_ != type) {
+    dirty_flags_ |= kDirtyComposition;
+    client_requested_ = type;
+  }
+}
+
 void HWCLayer::ResetGeometryChanges() {
   geometry_changes_ = GeometryChanges::kNone;
   layer_->geometry_changes = GeometryChanges::kNone;
@@ -28,6 +28,7 @@
 #include <core/layer_stack.h>
 #include <core/layer_buffer.h>
 #include <utils/utils.h>
+#include <utils/cadence_detector.h>
 #define HWC2_INCLUDE_STRINGIFICATION
 #define HWC2_USE_CPP11
 #include <hardware/hwcomposer2.h>
@@ -41,6 +42,7 @@
 
 #include "core/buffer_allocator.h"
 #include "hwc_buffer_allocator.h"
+#include "hwc_region.h"
 
 using PerFrameMetadataKey =
     android::hardware::graphics::composer::V2_3::IComposerClient::PerFrameMetadataKey;
@@ -66,6 +68,18 @@ enum LayerTypes {
   kLayerBrowser = 3,
 };
 
+// Client state changed since HWCDisplay::BuildLayerStack last consumed the layer
+enum LayerDirtyFlags {
+  kDirtyNone = 0,
+  kDirtyBuffer = 0x01,       // Buffer handle and the metadata read from it
+  kDirtyColor = 0x02,        // Dataspace, color metadata, or the format of a solid color layer
+  kDirtyComposition = 0x04,  // Client requested composition type
+  kDirtyGeometry = 0x08,     // Display frame, source crop or transform
+  kDirtyType = 0x10,         // Layer type, layer flag or mask
+  kDirtyColorTransform = 0x20,
+  kDirtyAll = 0x3F,
+};
+
 class HWCLayer {
  public:
   explicit HWCLayer(hwc2_display_t display_id, HWCBufferAllocator *buf_allocator);
@@ -100,7 +114,7 @@ class HWCLayer {
   void SetComposition(const LayerComposition &sdm_composition);
   HWC2::Composition GetClientRequestedCompositionType() { return client_requested_; }
   HWC2::Composition GetOrigClientRequestedCompositionType() { return client_requested_orig_; }
-  void UpdateClientCompositionType(HWC2::Composition type) { client_requested_ = type; }
+  void UpdateClientCompositionType(HWC2::Composition type);
   HWC2::Composition GetDeviceSelectedCompositionType() { return device_selected_; }
   int32_t GetLayerDataspace() { return dataspace_; }
   uint32_t GetGeometryChanges() { return geometry_changes_; }
@@ -116,6 +130,7 @@ class HWCLayer {
   bool IsSurfaceUpdated() { return surface_updated_; }
   bool IsNonIntegralSourceCrop() { return non_integral_source_crop_; }
   bool HasMetaDataRefreshRate() { return has_metadata_refresh_rate_; }
+  uint32_t GetCadenceRate() { return cadence_detector_.GetRate(); }
   bool IsColorTransformSet() { return color_transform_matrix_set_; }
   void SetLayerAsMask();
   bool BufferLatched() { return buffer_flipped_; }
@@ -124,6 +139,18 @@ class HWCLayer {
   void SetReleaseFence(const shared_ptr<Fence> &release_fence);
   bool IsLayerCompatible() { return compatible_; }
   void IgnoreSdrHistogramMetadata(bool disable) { ignore_sdr_histogram_md_ = disable; }
+  uint32_t GetDirtyFlags() { return dirty_flags_; }
+  void ResetDirtyFlags() { dirty_flags_ = kDirtyNone; }
+  bool IsHDR() { return hdr_; }
+  void SetHDR(bool hdr) { hdr_ = hdr; }
+  const LayerFlags &GetDerivedFlags() { return derived_flags_; }
+  uint32_t GetStackContribution() { return stack_contribution_; }
+  void SetDerivedState(const LayerFlags &flags, uint32_t stack_contribution) {
+    derived_flags_ = flags;
+    stack_contribution_ = stack_contribution;
+  }
+  // Caps the damage rects handed to SDM per layer, 0 passes them all.
+  static void SetMaxDamageRects(uint32_t max_rects) { max_damage_rects_ = max_rects; }
 
  private:
   Layer *layer_ = nullptr;
@@ -149,6 +176,14 @@ class HWCLayer {
   bool secure_ = false;
   bool compatible_ = false;
   bool ignore_sdr_histogram_md_ = false;
+  uint32_t dirty_flags_ = kDirtyAll;
+  bool hdr_ = false;  // Derived from the buffer format and color metadata
+  LayerFlags derived_flags_ = {};   // Layer flags as of the last derivation
+  uint32_t stack_contribution_ = 0;  // LayerStackContribution bits as of the last derivation
+  CadenceDetector cadence_detector_;
+  HWCRegion surface_damage_;
+  HWCRegion visible_region_;
+  static uint32_t max_damage_rects_;
 
   // Composition requested by client(SF) Original
   HWC2::Composition client_requested_orig_ = HWC2::Composition::Device;
@@ -165,7 +200,7 @@ class HWCLayer {
   DisplayError SetMetaData(const native_handle_t *pvt_handle, Layer *layer);
   uint32_t RoundToStandardFPS(float fps);
   void ValidateAndSetCSC(const native_handle_t *handle);
-  void SetDirtyRegions(hwc_region_t surface_damage);
+  void SetDirtyRegions();
 };
 
 struct SortLayersByZ {
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+
+#include "hwc_region.h"
+
+namespace sdm {
+
+static int64_t Area(const hwc_rect_t &rect) {
+  return int64_t(std::max(rect.right - rect.left, 0)) * std::max(rect.bottom - rect.top, 0);
+}
+
+static hwc_rect_t Bounds(const hwc_rect_t &a, const hwc_rect_t &b) {
+  return hwc_rect_t{std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right),
+                    std::max(a.bottom, b.bottom)};
+}
+
+bool HWCRegion::Set(const hwc_region_t &region) {
+  // hwc_rect_t is plain ints, memcmp compares whole vectors of rects at a time.
+  size_t size = region.numRects * sizeof(hwc_rect_t);
+  if (rects_.size() == region.numRects && (!size || !memcmp(rects_.data(), region.rects, size))) {
+    return false;
+  }
+
+  rects_.assign(region.rects, region.rects + region.numRects);
+  return true;
+}
+
+void HWCRegion::GetLayerRects(uint32_t max_rects, std::vector<LayerRect> *layer_rects) {
+  const std::vector<hwc_rect_t> *rects = &rects_;
+  if (max_rects && rects_.size() > max_rects) {
+    Coalesce(max_rects);
+    rects = &merged_;
+  }
+
+  layer_rects->resize(rects->size());
+  for (size_t i = 0; i < rects->size(); i++) {
+    const hwc_rect_t &rect = (*rects)[i];
+    (*layer_rects)[i] = LayerRect(FLOAT(rect.left), FLOAT(rect.top), FLOAT(rect.right),
+                                  FLOAT(rect.bottom));
+  }
+}
+
+void HWCRegion::Coalesce(uint32_t max_rects) {
+  // Every greedy merge rescans all pairs, O(n^3) for the region. Larger regions are first folded
+  // in client order into runs of neighbouring rects, so at most kMaxCoalesceInput rects reach the
+  // greedy pass, whose worst case is then about 680 pair costs.
+  size_t runs = std::max<size_t>(max_rects, kMaxCoalesceInput);
+  if (rects_.size() > runs) {
+    merged_.resize(runs);
+    for (size_t run = 0; run < runs; run++) {
+      size_t begin = run * rects_.size() / runs;
+      size_t end = (run + 1) * rects_.size() / runs;
+      merged_[run] = rects_[begin];
+      for (size_t i = begin + 1; i < end; i++) {
+        merged_[run] = Bounds(merged_[run], rects_[i]);
+      }
+    }
+  } else {
+    merged_ = rects_;
+  }
+
+  while (merged_.size() > max_rects) {
+    size_t best_i = 0;
+    size_t best_j = 1;
+    int64_t best_cost = INT64_MAX;
+    for (size_t i = 0; i < merged_.size(); i++) {
+      for (size_t j = i + 1; j < merged_.size(); j++) {
+        // Area the merge adds on top of both rects, overlapping pairs come out cheapest.
+        int64_t cost = Area(Bounds(merged_[i], merged_[j])) - Area(merged_[i]) - Area(merged_[j]);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+    merged_[best_i] = Bounds(merged_[best_i], merged_[best_j]);
+    merged_[best_j] = merged_.back();
+    merged_.pop_back();
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_REGION_H__
+#define __HWC_REGION_H__
+
+#include <core/layer_stack.h>
+#include <hardware/hwcomposer_defs.h>
+
+#include <vector>
+
+namespace sdm {
+
+// Integer copy of a region set by the client, e.g. surface damage or visible region. The rects
+// are kept as received so that an unchanged region is detected with a single block compare, and
+// the float LayerRects SDM consumes are only rebuilt, in place, when the region changed.
+class HWCRegion {
+ public:
+  // Stores region. Returns false if it holds the same rects in the same order as before.
+  bool Set(const hwc_region_t &region);
+  size_t GetSize() const { return rects_.size(); }
+  const hwc_rect_t *GetRects() const { return rects_.data(); }
+
+  // Writes the rects to layer_rects, reusing its storage. If max_rects is non zero and the region
+  // has more rects, the pairs of rects whose bounding box adds the least area are merged until
+  // max_rects remain. The result covers at least the original region. Regions of more than
+  // kMaxCoalesceInput rects are first merged in runs of consecutive rects, which bounds the cost.
+  void GetLayerRects(uint32_t max_rects, std::vector<LayerRect> *layer_rects);
+
+  static const uint32_t kMaxCoalesceInput = 16;
+
+ private:
+  void Coalesce(uint32_t max_rects);
+
+  std::vector<hwc_rect_t> rects_;
+  std::vector<hwc_rect_t> merged_;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_REGION_H__
@@ -320,6 +320,11 @@ int HWCSession::Init() {
   async_vds_creation_ = (value == 1);
   DLOGI("async_vds_creation: %d", async_vds_creation_);
 
+  value = 0;
+  Debug::Get()->GetProperty(MAX_DAMAGE_RECTS, &value);
+  HWCLayer::SetMaxDamageRects(UINT32(std::max(value, 0)));
+  DLOGI("max_damage_rects: %d", value);
+
   DLOGI("Initializing supported display slots");
   InitSupportedDisplaySlots();
   DLOGI("Initializing supported display slots...done!");
@@ -612,13 +617,20 @@ void HWCSession::Dump(uint32_t *out_size, char *out_buffer) {
   if (out_buffer == nullptr) {
     *out_size = max_dump_size;
   } else {
-    std::ostringstream os;
+    std::vector<HWCDisplay::DumpFormatter> display_dumps;
     for (int id = 0; id < HWCCallbacks::kNumRealDisplays; id++) {
       SCOPE_LOCK(locker_[id]);
       if (hwc_display_[id]) {
-        hwc_display_[id]->Dump(&os);
+        display_dumps.push_back(hwc_display_[id]->CollectDump());
       }
     }
+
+    // Only the state copies are taken under the display locks, a dumpsys does not hold off the
+    // next present while its report is formatted.
+    std::ostringstream os;
+    for (auto &format_display : display_dumps) {
+      format_display(&os);
+    }
     Fence::Dump(&os);
 
     std::string s = os.str();
@@ -857,6 +869,7 @@ int32_t HWCSession::PresentDisplay(hwc2_display_t display, shared_ptr<Fence> *ou
     if (pending_power_mode_[display]) {
       status = HWC2::Error::None;
     } else {
+      ScopedFrameLatency latency(hwc_display_[display]->GetLatencyStats(), kLatencyHwcPresent);
       hwc_display_[display]->ProcessActiveConfigChange();
       status = hwc_display_[display]->Present(out_retire_fence);
       if (status == HWC2::Error::None) {
@@ -1061,6 +1074,28 @@ int32_t HWCSession::SetColorTransform(hwc2_display_t display, const float *matri
   return CallDisplayFunction(display, &HWCDisplay::SetColorTransform, matrix, transform_hint);
 }
 
+HWCDisplay *HWCSession::LockDisplayForLayerBatch(hwc2_display_t display) {
+  if (display >= HWCCallbacks::kNumDisplays) {
+    return nullptr;
+  }
+
+  locker_[display].Lock();
+  if (!hwc_display_[display]) {
+    locker_[display].Unlock();
+    return nullptr;
+  }
+
+  return hwc_display_[display];
+}
+
+void HWCSession::UnlockDisplayForLayerBatch(hwc2_display_t display) {
+  if (display >= HWCCallbacks::kNumDisplays) {
+    return;
+  }
+
+  locker_[display].Unlock();
+}
+
 int32_t HWCSession::SetCursorPosition(hwc2_display_t display, hwc2_layer_t layer, int32_t x,
                                       int32_t y) {
   auto status = INT32(HWC2::Error::None);
@@ -2020,6 +2055,21 @@ android::status_t HWCSession::notifyCallback(uint32_t command, const android::Pa
     }
     break;
 
+    case qService::IQService::GET_FRAME_LATENCY_STATS: {
+      if (!output_parcel) {
+        DLOGE("QService command = %d: output_parcel needed.", command);
+        break;
+      }
+      output_parcel->writeCString(FrameLatencyStats::DumpAll().c_str());
+      status = 0;
+    }
+    break;
+
+    case qService::IQService::RESET_FRAME_LATENCY_STATS:
+      FrameLatencyStats::ResetAll();
+      status = 0;
+      break;
+
     default:
       DLOGW("QService command = %d is not supported.", command);
       break;
@@ -4505,6 +4555,7 @@ HWC2::Error HWCSession::CommitOrPrepare(hwc2_display_t display, bool validate_on
   auto status = HWC2::Error::None;
   {
     SEQUENCE_ENTRY_SCOPE_LOCK(locker_[display]);
+    ScopedFrameLatency latency(hwc_display_[display]->GetLatencyStats(), kLatencyHwcValidate);
     hwc_display_[display]->ProcessActiveConfigChange();
     hwc_display_[display]->IsMultiDisplay((map_active_displays_.size() > 1) ? true : false);
     status = hwc_display_[display]->CommitOrPrepare(validate_only, out_retire_fence, out_num_types,
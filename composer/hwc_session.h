@@ -89,6 +89,10 @@ using vendor::qti::hardware::display::composer::V3_1::IQtiComposerClient;
 
 int32_t GetDataspaceFromColorMode(ColorMode mode);
 
+// Debug property name answered with the frame latency histograms of all displays instead of a
+// system property value.
+constexpr char kFrameLatencyStatsProp[] = "frame_latency_stats";
+
 typedef DisplayConfig::DisplayType DispType;
 
 // Create a singleton uevent listener thread valid for life of hardware composer process.
@@ -190,6 +194,13 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
     return INT32(status);
   }
 
+  // Layer command batching. The composer command reader applies a run of layer commands of one
+  // display under a single hold of locker_[display] instead of locking once per command.
+  // LockDisplayForLayerBatch returns the display with the lock held, or nullptr (lock not held)
+  // when the display does not exist. Display level calls must not be made while a batch is held.
+  HWCDisplay *LockDisplayForLayerBatch(hwc2_display_t display);
+  void UnlockDisplayForLayerBatch(hwc2_display_t display);
+
   // HWC2 Functions that require a concrete implementation in hwc session
   // and hence need to be member functions
   static HWCSession *GetInstance();
@@ -818,6 +818,11 @@ int HWCSession::DisplayConfigImpl::GetDebugProperty(const std::string prop_name,
   int error = -EINVAL;
   char val[64] = {};
 
+  if (prop_name == kFrameLatencyStatsProp) {
+    *value = FrameLatencyStats::DumpAll();
+    return 0;
+  }
+
   vendor_prop_name += prop_name.c_str();
   if (HWCDebugHandler::Get()->GetProperty(vendor_prop_name.c_str(), val) == kErrorNone) {
     *value = val;
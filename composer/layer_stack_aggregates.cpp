@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "layer_stack_aggregates.h"
+
+namespace sdm {
+
+uint32_t DeriveLayerFlags(const DisplayLayerInputs &display, const LayerStateInputs &layer,
+                          LayerFlags *flags) {
+  uint32_t contribution = 0;
+
+  *flags = {};
+  // Mark all layers to skip, when client target handle is NULL
+  if (layer.client_composition || !display.client_target_valid) {
+    flags->skip = true;
+  } else if (layer.solid_color) {
+    flags->solid_fill = true;
+  }
+
+  if (!layer.dataspace_supported) {
+    flags->skip = true;
+  }
+
+  if (layer.video) {
+    contribution |= kStackVideo;
+  }
+  if (layer.secure) {
+    contribution |= kStackSecure;
+  }
+
+  if (layer.rgb && layer.scaling) {
+    contribution |= kStackScalingRgb;
+  }
+
+  if (layer.single_buffered && !(layer.rotation || layer.scaling)) {
+    flags->single_buffer = true;
+    contribution |= kStackSingleBuffered;
+  }
+
+  // Dont honor HDR when its handling is disabled
+  if (layer.hdr && display.hdr_handling) {
+    contribution |= kStackHdr;
+  }
+
+  if (display.game_supported && layer.game && !layer.hdr) {
+    flags->is_game = true;
+  }
+
+  if (layer.non_integral_crop && !layer.secure && !layer.hdr && !flags->single_buffer &&
+      !flags->solid_fill && !layer.video && !flags->is_game) {
+    flags->skip = true;
+  }
+
+  // Currently we support only one HWCursor & only at top most z-order
+  if (!flags->skip && layer.cursor_composition && layer.top_most) {
+    flags->cursor = true;
+    contribution |= kStackCursor;
+  }
+
+  if (flags->skip) {
+    contribution |= kStackSkip;
+  }
+
+  flags->has_metadata_refresh_rate = layer.metadata_refresh_rate;
+  flags->color_transform = layer.color_transform;
+  flags->compatible = layer.compatible;
+
+  if (layer.mask) {
+    contribution |= kStackMask;
+  }
+
+  return contribution;
+}
+
+void LayerStackAggregates::Update(uint32_t old_bits, uint32_t new_bits) {
+  for (uint32_t i = 0; i < kContributionCount; i++) {
+    uint32_t bit = 1u << i;
+    if ((old_bits & bit) && !(new_bits & bit) && count_[i]) {
+      count_[i]--;
+    } else if (!(old_bits & bit) && (new_bits & bit)) {
+      count_[i]++;
+    }
+  }
+}
+
+bool LayerStackAggregates::IsPresent(LayerStackContribution contribution) const {
+  for (uint32_t i = 0; i < kContributionCount; i++) {
+    if (contribution == (1u << i)) {
+      return count_[i] > 0;
+    }
+  }
+
+  return false;
+}
+
+void LayerStackAggregates::Reset() {
+  for (uint32_t i = 0; i < kContributionCount; i++) {
+    count_[i] = 0;
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __LAYER_STACK_AGGREGATES_H__
+#define __LAYER_STACK_AGGREGATES_H__
+
+#include <core/layer_stack.h>
+#include <stdint.h>
+
+namespace sdm {
+
+// Stack wide flags a layer contributes to, see LayerStackFlags.
+enum LayerStackContribution {
+  kStackVideo = 0x01,
+  kStackSecure = 0x02,
+  kStackScalingRgb = 0x04,
+  kStackSingleBuffered = 0x08,
+  kStackHdr = 0x10,
+  kStackCursor = 0x20,
+  kStackSkip = 0x40,
+  kStackMask = 0x80,
+};
+
+// Display wide inputs of the layer flags. A change re-derives every layer of the display.
+struct DisplayLayerInputs {
+  bool client_target_valid = false;
+  bool hdr_handling = true;
+  bool game_supported = false;
+  uint64_t top_most_id = 0;
+
+  bool operator==(const DisplayLayerInputs &other) const {
+    return client_target_valid == other.client_target_valid &&
+           hdr_handling == other.hdr_handling && game_supported == other.game_supported &&
+           top_most_id == other.top_most_id;
+  }
+  bool operator!=(const DisplayLayerInputs &other) const { return !operator==(other); }
+};
+
+// Per layer inputs of the layer flags, as last set by the client on the layer.
+struct LayerStateInputs {
+  bool client_composition = false;  // Client requested composition
+  bool solid_color = false;         // Client requested solid color composition
+  bool cursor_composition = false;  // Client requested cursor composition
+  bool top_most = false;
+  bool dataspace_supported = true;
+  bool video = false;
+  bool secure = false;  // TZ protected buffer, or secure display
+  bool rgb = false;
+  bool scaling = false;
+  bool rotation = false;
+  bool single_buffered = false;
+  bool hdr = false;
+  bool game = false;
+  bool non_integral_crop = false;
+  bool metadata_refresh_rate = false;
+  bool color_transform = false;
+  bool compatible = false;
+  bool mask = false;
+};
+
+// Derives the SDM flags of a layer and returns the LayerStackContribution bits it adds to the
+// stack. The updating flag is per frame and left to the caller.
+uint32_t DeriveLayerFlags(const DisplayLayerInputs &display, const LayerStateInputs &layer,
+                          LayerFlags *flags);
+
+// Counts the layers contributing to each stack wide flag, so a frame where only a few layers
+// changed updates the flags from those layers instead of walking the whole stack.
+class LayerStackAggregates {
+ public:
+  // Replaces the old contribution bits of a layer with its new ones. Destroyed layers pass 0 as
+  // the new bits, created layers pass 0 as the old bits.
+  void Update(uint32_t old_bits, uint32_t new_bits);
+  bool IsPresent(LayerStackContribution contribution) const;
+  void Reset();
+
+ private:
+  static const uint32_t kContributionCount = 8;
+
+  uint32_t count_[kContributionCount] = {};
+};
+
+}  // namespace sdm
+
+#endif  // __LAYER_STACK_AGGREGATES_H__
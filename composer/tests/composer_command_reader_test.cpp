@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <hardware/hwcomposer_defs.h>
+#include <stdlib.h>
+#include <utils/locker.h>
+#include <vendor/qti/hardware/display/composer/3.1/IQtiComposerClient.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <new>
+#include <vector>
+
+#include "../QtiComposerCommandBuffer.h"
+#include "../hwc_region.h"
+
+// Counts the heap allocations of the whole binary, the loops below read it around a frame.
+static std::atomic<uint64_t> g_allocations(0);
+
+void *operator new(size_t size) {
+  g_allocations++;
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    abort();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+using namespace vendor::qti::hardware::display::composer::V3_1;
+using ::android::hardware::graphics::composer::V2_1::Layer;
+using sdm::HWCRegion;
+using sdm::Locker;
+
+namespace {
+
+// Same as QtiComposerClient::kWriterInitialSize.
+const uint32_t kWriterSize = 64 * 1024 / sizeof(uint32_t) - 16;
+
+// Layer commands SurfaceFlinger sends for one layer of a frame.
+struct LayerCommands {
+  Layer layer;
+  IQtiComposerClient::Rect frame;
+  IQtiComposerClient::FRect crop;
+  std::vector<IQtiComposerClient::Rect> damage[2];  // Alternates between frames
+  std::vector<IQtiComposerClient::Rect> visible;
+  float alpha;
+  uint32_t z;
+};
+
+// Client state of a layer, as the HWCLayer setters keep it.
+struct LayerState {
+  hwc_rect_t frame;
+  hwc_frect_t crop;
+  HWCRegion damage;
+  HWCRegion visible;
+  float alpha;
+  uint32_t z;
+  int32_t blend;
+  int32_t composition;
+  int32_t dataspace;
+  int32_t transform;
+};
+
+// Stands in for HWCSession and HWCDisplay, the display lock and layer map a layer command goes
+// through to reach its HWCLayer.
+struct StubDisplay {
+  Locker locker;
+  std::map<Layer, LayerState *> layer_map;
+};
+
+// A home screen like frame: full screen layers with a few damage rects each and a status bar.
+std::vector<LayerCommands> RecordFrame(uint32_t count) {
+  std::vector<LayerCommands> layers(count);
+  for (uint32_t i = 0; i < count; i++) {
+    LayerCommands &layer = layers[i];
+    int32_t top = INT32(i * 40);
+    layer.layer = i + 1;
+    layer.frame = {0, top, 1080, top + 1200};
+    layer.crop = {0.0f, 0.0f, 1080.0f, 1200.0f};
+    for (uint32_t n = 0; n < 4; n++) {
+      int32_t offset = INT32(n * 100);
+      layer.damage[0].push_back({offset, top, offset + 80, top + 40});
+      layer.damage[1].push_back({offset, top + 8, offset + 80, top + 48});
+    }
+    layer.visible = {layer.frame, {0, 0, 1080, 80}};
+    layer.alpha = 1.0f;
+    layer.z = i;
+  }
+  return layers;
+}
+
+void WriteFrame(const std::vector<LayerCommands> &layers, uint32_t frame, CommandWriter *writer) {
+  writer->selectDisplay(0);
+  for (auto &layer : layers) {
+    writer->selectLayer(layer.layer);
+    writer->setLayerDisplayFrame(layer.frame);
+    writer->setLayerSourceCrop(layer.crop);
+    writer->setLayerSurfaceDamage(layer.damage[frame % 2]);
+    writer->setLayerVisibleRegion(layer.visible);
+    writer->setLayerPlaneAlpha(layer.alpha);
+    writer->setLayerZOrder(layer.z);
+    writer->setLayerBlendMode(IQtiComposerClient::BlendMode::PREMULTIPLIED);
+    writer->setLayerCompositionType(IQtiComposerClient::Composition::DEVICE);
+    writer->setLayerDataspace(Dataspace::V0_SRGB);
+    writer->setLayerTransform(Transform(0));
+  }
+  writer->presentOrvalidateDisplay();
+}
+
+class FrameReader : public CommandReaderBase {
+ public:
+  // Routes the layer commands through display. With batch set, the display is locked once for a
+  // run of layer commands and the layer looked up once per SELECT_LAYER, as the reader does now.
+  // Otherwise every command locks the display and looks up the layer, as CallLayerFunction did.
+  void SetDisplay(StubDisplay *display, bool batch) {
+    display_ = display;
+    batch_ = batch;
+  }
+
+  // Decodes a frame into layers the way QtiComposerClient::CommandReader does, returns the number
+  // of commands or 0 on a malformed frame. With copy_fields set, rects are decoded field by field
+  // and every region into its own std::vector, as the reader did before.
+  uint32_t Parse(bool copy_fields, std::vector<LayerState> *layers) {
+    uint32_t commands = 0;
+    Layer selected = 0;
+    IQtiComposerClient::Command command;
+    uint16_t length = 0;
+    while (!isEmpty()) {
+      if (!beginCommand(command, length)) {
+        EndBatch();
+        return 0;
+      }
+
+      LayerState *layer = nullptr;
+      if (IsLayerCommand(command)) {
+        layer = GetLayer(selected, layers);
+        if (!layer) {
+          EndBatch();
+          return 0;
+        }
+      } else if (command != IQtiComposerClient::Command::SELECT_LAYER) {
+        EndBatch();
+      }
+
+      switch (command) {
+        case IQtiComposerClient::Command::SELECT_DISPLAY:
+          read64();
+          break;
+        case IQtiComposerClient::Command::SELECT_LAYER:
+          selected = read64();
+          batch_layer_ = nullptr;
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_DISPLAY_FRAME:
+          layer->frame = copy_fields ? ReadRectFields() : readStruct<hwc_rect_t>();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_SOURCE_CROP:
+          if (copy_fields) {
+            layer->crop = hwc_frect_t{readFloat(), readFloat(), readFloat(), readFloat()};
+          } else {
+            layer->crop = readStruct<hwc_frect_t>();
+          }
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_SURFACE_DAMAGE:
+          ReadRegion(copy_fields, length / 4, &layer->damage);
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_VISIBLE_REGION:
+          ReadRegion(copy_fields, length / 4, &layer->visible);
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_PLANE_ALPHA:
+          layer->alpha = readFloat();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_Z_ORDER:
+          layer->z = read();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_BLEND_MODE:
+          layer->blend = readSigned();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_COMPOSITION_TYPE:
+          layer->composition = readSigned();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_DATASPACE:
+          layer->dataspace = readSigned();
+          break;
+        case IQtiComposerClient::Command::SET_LAYER_TRANSFORM:
+          layer->transform = readSigned();
+          break;
+        case IQtiComposerClient::Command::PRESENT_OR_VALIDATE_DISPLAY:
+          break;
+        default:
+          EndBatch();
+          return 0;
+      }
+      if (display_ && !batch_ && layer) {
+        display_->locker.Unlock();
+      }
+      endCommand();
+      commands++;
+    }
+    EndBatch();
+
+    return commands;
+  }
+
+ private:
+  static bool IsLayerCommand(IQtiComposerClient::Command command) {
+    switch (command) {
+      case IQtiComposerClient::Command::SET_LAYER_DISPLAY_FRAME:
+      case IQtiComposerClient::Command::SET_LAYER_SOURCE_CROP:
+      case IQtiComposerClient::Command::SET_LAYER_SURFACE_DAMAGE:
+      case IQtiComposerClient::Command::SET_LAYER_VISIBLE_REGION:
+      case IQtiComposerClient::Command::SET_LAYER_PLANE_ALPHA:
+      case IQtiComposerClient::Command::SET_LAYER_Z_ORDER:
+      case IQtiComposerClient::Command::SET_LAYER_BLEND_MODE:
+      case IQtiComposerClient::Command::SET_LAYER_COMPOSITION_TYPE:
+      case IQtiComposerClient::Command::SET_LAYER_DATASPACE:
+      case IQtiComposerClient::Command::SET_LAYER_TRANSFORM:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  LayerState *GetLayer(Layer selected, std::vector<LayerState> *layers) {
+    if (!display_) {
+      return &(*layers)[selected - 1];
+    }
+
+    if (!batch_) {
+      // Unlocked once the command is applied.
+      display_->locker.Lock();
+      auto it = display_->layer_map.find(selected);
+      if (it == display_->layer_map.end()) {
+        display_->locker.Unlock();
+        return nullptr;
+      }
+      return it->second;
+    }
+
+    if (!batch_locked_) {
+      display_->locker.Lock();
+      batch_locked_ = true;
+    }
+    if (!batch_layer_) {
+      auto it = display_->layer_map.find(selected);
+      batch_layer_ = (it != display_->layer_map.end()) ? it->second : nullptr;
+    }
+    return batch_layer_;
+  }
+
+  void EndBatch() {
+    if (batch_locked_) {
+      display_->locker.Unlock();
+      batch_locked_ = false;
+    }
+    batch_layer_ = nullptr;
+  }
+
+  StubDisplay *display_ = nullptr;
+  bool batch_ = false;
+  bool batch_locked_ = false;
+  LayerState *batch_layer_ = nullptr;
+
+  hwc_rect_t ReadRectFields() {
+    return hwc_rect_t{readSigned(), readSigned(), readSigned(), readSigned()};
+  }
+
+  void ReadRegion(bool copy_fields, size_t count, HWCRegion *region) {
+    if (!copy_fields) {
+      region->Set(hwc_region_t{count, readArray<hwc_rect_t>(count)});
+      return;
+    }
+
+    std::vector<hwc_rect_t> rects;
+    rects.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      rects.emplace_back(ReadRectFields());
+    }
+    region->Set(hwc_region_t{rects.size(), rects.data()});
+  }
+};
+
+// Writes a frame, hands it over the message queue and decodes it. Returns the decoded commands.
+uint32_t SendFrame(const std::vector<LayerCommands> &commands, uint32_t frame, bool copy_fields,
+                   CommandWriter *writer, FrameReader *reader, std::vector<LayerState> *layers) {
+  writer->reset();
+  WriteFrame(commands, frame, writer);
+
+  bool queue_changed = false;
+  uint32_t length = 0;
+  hidl_vec<hidl_handle> handles;
+  if (!writer->writeQueue(queue_changed, length, handles)) {
+    return 0;
+  }
+  if (queue_changed && !reader->setMQDescriptor(*writer->getMQDescriptor())) {
+    return 0;
+  }
+  if (!reader->readQueue(length, handles)) {
+    return 0;
+  }
+
+  return reader->Parse(copy_fields, layers);
+}
+
+TEST(ComposerCommandReaderTest, DecodesInPlaceLikeFieldByField) {
+  std::vector<LayerCommands> commands = RecordFrame(4);
+  CommandWriter writer(kWriterSize);
+  FrameReader reader;
+
+  for (uint32_t frame = 0; frame < 2; frame++) {
+    std::vector<LayerState> copied(commands.size());
+    std::vector<LayerState> in_place(commands.size());
+    ASSERT_EQ(SendFrame(commands, frame, true, &writer, &reader, &copied), 1 + 4 * 11 + 1);
+    ASSERT_EQ(SendFrame(commands, frame, false, &writer, &reader, &in_place), 1 + 4 * 11 + 1);
+
+    for (size_t i = 0; i < commands.size(); i++) {
+      const LayerCommands &layer = commands[i];
+      EXPECT_EQ(memcmp(&in_place[i].frame, &copied[i].frame, sizeof(hwc_rect_t)), 0);
+      EXPECT_EQ(in_place[i].frame.top, layer.frame.top);
+      EXPECT_EQ(memcmp(&in_place[i].crop, &copied[i].crop, sizeof(hwc_frect_t)), 0);
+      EXPECT_EQ(in_place[i].crop.right, layer.crop.right);
+      ASSERT_EQ(in_place[i].damage.GetSize(), layer.damage[frame].size());
+      EXPECT_EQ(memcmp(in_place[i].damage.GetRects(), layer.damage[frame].data(),
+                       layer.damage[frame].size() * sizeof(hwc_rect_t)), 0);
+      EXPECT_FALSE(copied[i].damage.Set(hwc_region_t{in_place[i].damage.GetSize(),
+                                                     in_place[i].damage.GetRects()}));
+      EXPECT_EQ(in_place[i].visible.GetSize(), 2u);
+      EXPECT_EQ(in_place[i].z, layer.z);
+      EXPECT_EQ(in_place[i].composition, INT32(IQtiComposerClient::Composition::DEVICE));
+    }
+  }
+}
+
+// Timing loop over a recorded 20 layer frame written, queued and decoded every frame. Reports ns
+// per command and heap allocations per frame of the in place decoding against the previous field
+// by field decoding with a vector per region.
+TEST(ComposerCommandReaderTest, BenchmarkDecodeFrame) {
+  const uint32_t kFrames = 20000;
+  std::vector<LayerCommands> commands = RecordFrame(20);
+
+  for (bool copy_fields : {true, false}) {
+    CommandWriter writer(kWriterSize);
+    FrameReader reader;
+    std::vector<LayerState> layers(commands.size());
+    // Warm up, the queue and the stored regions are allocated once.
+    ASSERT_NE(SendFrame(commands, 0, copy_fields, &writer, &reader, &layers), 0u);
+    ASSERT_NE(SendFrame(commands, 1, copy_fields, &writer, &reader, &layers), 0u);
+
+    uint64_t decoded = 0;
+    uint64_t allocations = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+      decoded += SendFrame(commands, frame, copy_fields, &writer, &reader, &layers);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+    allocations = g_allocations - allocations;
+
+    EXPECT_EQ(decoded, uint64_t(kFrames) * (1 + commands.size() * 11 + 1));
+    if (!copy_fields) {
+      EXPECT_EQ(allocations, 0u);
+    }
+    printf("%s: %.1f ns/command, %.1f allocations/frame\n",
+           copy_fields ? "field by field" : "in place", double(ns) / double(decoded),
+           double(allocations) / kFrames);
+  }
+}
+
+// Timing loop over the same recorded frame dispatched through a stub display. Reports ns per
+// command of locking the display and looking up the layer for every layer command, against one
+// lock per run of layer commands and one lookup per SELECT_LAYER.
+TEST(ComposerCommandReaderTest, BenchmarkLayerBatching) {
+  const uint32_t kFrames = 20000;
+  std::vector<LayerCommands> commands = RecordFrame(20);
+  uint32_t frame_commands = 1 + UINT32(commands.size()) * 11 + 1;
+
+  for (bool batch : {false, true}) {
+    CommandWriter writer(kWriterSize);
+    FrameReader reader;
+    std::vector<LayerState> layers(commands.size());
+    StubDisplay display;
+    for (size_t i = 0; i < commands.size(); i++) {
+      display.layer_map[commands[i].layer] = &layers[i];
+    }
+    reader.SetDisplay(&display, batch);
+    ASSERT_EQ(SendFrame(commands, 0, false, &writer, &reader, &layers), frame_commands);
+
+    uint64_t decoded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+      decoded += SendFrame(commands, frame, false, &writer, &reader, &layers);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(decoded, uint64_t(kFrames) * frame_commands);
+    EXPECT_EQ(layers.back().z, commands.back().z);
+    // The batch is released at the end of the frame.
+    EXPECT_EQ(display.locker.TryLock(), 0);
+    display.locker.Unlock();
+    printf("%s: %.1f ns/command\n", batch ? "lock per batch" : "lock per command",
+           double(ns) / double(decoded));
+  }
+}
+
+}  // namespace
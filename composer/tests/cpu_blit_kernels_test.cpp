@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "cpu_blit_kernels.h"
+
+using namespace sdm;
+
+namespace {
+
+struct TestImage {
+  std::vector<uint8_t> data;
+  CPUImage image;
+};
+
+TestImage MakeRGBA(uint32_t width, uint32_t height, uint32_t stride_pixels) {
+  TestImage img;
+  img.data.assign(stride_pixels * height * 4, 0);
+  img.image.format = kCPUFormatRGBA8888;
+  img.image.planes[0] = img.data.data();
+  img.image.stride_bytes[0] = stride_pixels * 4;
+  img.image.width = width;
+  img.image.height = height;
+  return img;
+}
+
+TestImage MakeYUV(CPUPixelFormat format, uint32_t width, uint32_t height) {
+  TestImage img;
+  uint32_t bpp = (format == kCPUFormatP010) ? 2 : 1;
+  uint32_t stride = width * bpp;
+  img.data.assign(stride * height * 3 / 2, 0);
+  img.image.format = format;
+  img.image.planes[0] = img.data.data();
+  img.image.planes[1] = img.data.data() + stride * height;
+  img.image.stride_bytes[0] = stride;
+  img.image.stride_bytes[1] = stride;
+  img.image.width = width;
+  img.image.height = height;
+  return img;
+}
+
+void Fill(TestImage *img, uint8_t r, uint8_t g, uint8_t b) {
+  for (uint32_t y = 0; y < img->image.height; y++) {
+    uint8_t *row = img->image.planes[0] + y * img->image.stride_bytes[0];
+    for (uint32_t x = 0; x < img->image.width; x++) {
+      row[x * 4 + 0] = r;
+      row[x * 4 + 1] = g;
+      row[x * 4 + 2] = b;
+      row[x * 4 + 3] = 255;
+    }
+  }
+}
+
+const uint8_t *Pixel(const TestImage &img, uint32_t x, uint32_t y) {
+  return img.image.planes[0] + y * img.image.stride_bytes[0] + x * 4;
+}
+
+CPURect Rect(int32_t l, int32_t t, int32_t r, int32_t b) {
+  CPURect rect;
+  rect.left = l;
+  rect.top = t;
+  rect.right = r;
+  rect.bottom = b;
+  return rect;
+}
+
+}  // namespace
+
+TEST(CPUBlitKernels, CopiesAndScalesRGBA) {
+  TestImage src = MakeRGBA(2, 2, 4);
+  TestImage dst = MakeRGBA(4, 4, 8);
+  uint8_t colors[4][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {10, 20, 30}};
+  for (int i = 0; i < 4; i++) {
+    uint8_t *px = const_cast<uint8_t *>(Pixel(src, i % 2, i / 2));
+    px[0] = colors[i][0];
+    px[1] = colors[i][1];
+    px[2] = colors[i][2];
+    px[3] = 255;
+  }
+
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 2, 2), dst.image, Rect(0, 0, 4, 4), kCPUMatrixBT601));
+
+  for (uint32_t y = 0; y < 4; y++) {
+    for (uint32_t x = 0; x < 4; x++) {
+      const uint8_t *expected = colors[(y / 2) * 2 + (x / 2)];
+      EXPECT_EQ(expected[0], Pixel(dst, x, y)[0]) << x << "," << y;
+      EXPECT_EQ(expected[1], Pixel(dst, x, y)[1]) << x << "," << y;
+      EXPECT_EQ(expected[2], Pixel(dst, x, y)[2]) << x << "," << y;
+    }
+  }
+}
+
+TEST(CPUBlitKernels, HonorsDestinationRect) {
+  TestImage src = MakeRGBA(4, 4, 4);
+  TestImage dst = MakeRGBA(8, 8, 8);
+  Fill(&src, 100, 150, 200);
+
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 4, 4), dst.image, Rect(4, 2, 8, 6), kCPUMatrixBT601));
+
+  EXPECT_EQ(0, Pixel(dst, 3, 2)[3]);
+  EXPECT_EQ(0, Pixel(dst, 4, 1)[3]);
+  EXPECT_EQ(100, Pixel(dst, 4, 2)[0]);
+  EXPECT_EQ(200, Pixel(dst, 7, 5)[2]);
+  EXPECT_EQ(0, Pixel(dst, 7, 6)[3]);
+}
+
+TEST(CPUBlitKernels, ClipsSourceWithDestination) {
+  // A 2x upscale of an 8 pixel gradient half off the left and right edges of the destination.
+  TestImage src = MakeRGBA(8, 2, 8);
+  TestImage dst = MakeRGBA(8, 2, 8);
+  for (uint32_t x = 0; x < 8; x++) {
+    for (uint32_t y = 0; y < 2; y++) {
+      uint8_t *px = const_cast<uint8_t *>(Pixel(src, x, y));
+      px[0] = static_cast<uint8_t>(x * 10);
+      px[3] = 255;
+    }
+  }
+
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 8, 2), dst.image, Rect(-4, 0, 12, 2),
+                       kCPUMatrixBT601));
+  // Only the middle of the source is visible, at the same 2x scale.
+  for (uint32_t x = 0; x < 8; x++) {
+    EXPECT_EQ((2 + x / 2) * 10, Pixel(dst, x, 0)[0]) << "x " << x;
+    EXPECT_EQ((2 + x / 2) * 10, Pixel(dst, x, 1)[0]) << "x " << x;
+  }
+
+  // A source crop past the source image shrinks the destination by the same ratio.
+  TestImage out = MakeRGBA(8, 2, 8);
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(4, 0, 12, 2), out.image, Rect(0, 0, 8, 2),
+                       kCPUMatrixBT601));
+  EXPECT_EQ(40, Pixel(out, 0, 0)[0]);
+  EXPECT_EQ(70, Pixel(out, 3, 0)[0]);
+  EXPECT_EQ(0, Pixel(out, 4, 0)[3]);
+  EXPECT_EQ(0, Pixel(out, 7, 1)[3]);
+
+  // Entirely off screen.
+  EXPECT_NE(0, CPUBlit(src.image, Rect(0, 0, 8, 2), dst.image, Rect(-16, 0, -8, 2),
+                       kCPUMatrixBT601));
+}
+
+TEST(CPUBlitKernels, ConvertsGreysToNeutralNV12) {
+  TestImage src = MakeRGBA(4, 4, 4);
+  TestImage dst = MakeYUV(kCPUFormatNV12, 4, 4);
+
+  Fill(&src, 255, 255, 255);
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 4, 4), dst.image, Rect(0, 0, 4, 4), kCPUMatrixBT709));
+  EXPECT_EQ(235, dst.image.planes[0][0]);
+  EXPECT_EQ(128, dst.image.planes[1][0]);
+  EXPECT_EQ(128, dst.image.planes[1][1]);
+
+  Fill(&src, 0, 0, 0);
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 4, 4), dst.image, Rect(0, 0, 4, 4), kCPUMatrixBT709));
+  EXPECT_EQ(16, dst.image.planes[0][5]);
+  EXPECT_EQ(128, dst.image.planes[1][2]);
+}
+
+TEST(CPUBlitKernels, ConvertsPrimariesPerMatrix) {
+  TestImage src = MakeRGBA(2, 2, 2);
+  TestImage dst = MakeYUV(kCPUFormatNV12, 2, 2);
+  Fill(&src, 255, 0, 0);
+
+  // Reference values from the limited range equations of each standard.
+  struct { CPUColorMatrix matrix; uint8_t y, u, v; } cases[] = {
+    {kCPUMatrixBT601, 81, 90, 240},
+    {kCPUMatrixBT709, 63, 102, 240},
+    {kCPUMatrixBT2020, 74, 97, 240},
+  };
+  for (auto &c : cases) {
+    ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 2, 2), dst.image, Rect(0, 0, 2, 2), c.matrix));
+    EXPECT_EQ(c.y, dst.image.planes[0][0]) << c.matrix;
+    EXPECT_EQ(c.u, dst.image.planes[1][0]) << c.matrix;
+    EXPECT_EQ(c.v, dst.image.planes[1][1]) << c.matrix;
+  }
+}
+
+TEST(CPUBlitKernels, RoundTripsThroughYUV) {
+  const CPUPixelFormat formats[] = {kCPUFormatNV12, kCPUFormatP010};
+  const CPUColorMatrix matrices[] = {kCPUMatrixBT601, kCPUMatrixBT709, kCPUMatrixBT2020};
+  for (auto format : formats) {
+    for (auto matrix : matrices) {
+      TestImage src = MakeRGBA(16, 16, 16);
+      TestImage yuv = MakeYUV(format, 16, 16);
+      TestImage out = MakeRGBA(16, 16, 16);
+      // Flat 2x2 blocks so that chroma subsampling is lossless.
+      for (uint32_t y = 0; y < 16; y++) {
+        for (uint32_t x = 0; x < 16; x++) {
+          uint8_t *px = const_cast<uint8_t *>(Pixel(src, x, y));
+          px[0] = static_cast<uint8_t>((x / 2) * 36);
+          px[1] = static_cast<uint8_t>((y / 2) * 36);
+          px[2] = static_cast<uint8_t>((x / 2 + y / 2) * 17);
+          px[3] = 255;
+        }
+      }
+
+      ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 16, 16), yuv.image, Rect(0, 0, 16, 16), matrix));
+      ASSERT_EQ(0, CPUBlit(yuv.image, Rect(0, 0, 16, 16), out.image, Rect(0, 0, 16, 16), matrix));
+
+      int tolerance = (format == kCPUFormatP010) ? 1 : 3;
+      for (uint32_t y = 0; y < 16; y++) {
+        for (uint32_t x = 0; x < 16; x++) {
+          for (int c = 0; c < 3; c++) {
+            EXPECT_LE(std::abs(Pixel(src, x, y)[c] - Pixel(out, x, y)[c]), tolerance)
+                << "format " << format << " matrix " << matrix << " at " << x << "," << y;
+          }
+          EXPECT_EQ(255, Pixel(out, x, y)[3]);
+        }
+      }
+    }
+  }
+}
+
+TEST(CPUBlitKernels, StoresP010InMsbs) {
+  TestImage src = MakeRGBA(2, 2, 2);
+  TestImage dst = MakeYUV(kCPUFormatP010, 2, 2);
+  Fill(&src, 255, 255, 255);
+
+  ASSERT_EQ(0, CPUBlit(src.image, Rect(0, 0, 2, 2), dst.image, Rect(0, 0, 2, 2), kCPUMatrixBT2020));
+  const uint16_t *luma = reinterpret_cast<const uint16_t *>(dst.image.planes[0]);
+  const uint16_t *chroma = reinterpret_cast<const uint16_t *>(dst.image.planes[1]);
+  EXPECT_EQ(940 << 6, luma[0]);
+  EXPECT_EQ(512 << 6, chroma[0]);
+  EXPECT_EQ(512 << 6, chroma[1]);
+}
+
+TEST(CPUBlitKernels, ClearsRect) {
+  TestImage dst = MakeRGBA(4, 4, 4);
+  Fill(&dst, 1, 2, 3);
+
+  CPUClearRGBA(dst.image, Rect(1, 1, 3, 3));
+  EXPECT_EQ(255, Pixel(dst, 0, 0)[3]);
+  EXPECT_EQ(0, Pixel(dst, 1, 1)[3]);
+  EXPECT_EQ(0, Pixel(dst, 2, 2)[0]);
+  EXPECT_EQ(255, Pixel(dst, 3, 3)[3]);
+}
+
+TEST(CPUBlitKernels, RejectsInvalidInput) {
+  TestImage src = MakeRGBA(4, 4, 4);
+  TestImage yuv = MakeYUV(kCPUFormatNV12, 4, 4);
+
+  EXPECT_NE(0, CPUBlit(src.image, Rect(0, 0, 0, 4), src.image, Rect(0, 0, 4, 4), kCPUMatrixBT601));
+  EXPECT_NE(0, CPUBlit(src.image, Rect(0, 0, 4, 4), src.image, Rect(8, 8, 12, 12),
+                       kCPUMatrixBT601));
+  EXPECT_NE(0, CPUBlit(yuv.image, Rect(0, 0, 4, 4), yuv.image, Rect(0, 0, 4, 4), kCPUMatrixBT601));
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "frame_cost_estimator.h"
+
+using namespace sdm;
+
+namespace {
+
+const int64_t kMs = 1000000;
+const int64_t kPeriod120 = 8333333;
+const int64_t kPeriod60 = 16666667;
+
+// Stands in for CPUHint and applies the estimator decisions the way HWCDisplayBuiltIn does.
+struct MockCPUHint {
+  bool active = false;
+  int acquires = 0;
+  int releases = 0;
+
+  void Apply(FrameCostEstimator::HintAction action) {
+    if (action == FrameCostEstimator::kHintRequest && !active) {
+      active = true;
+      acquires++;
+    } else if (action == FrameCostEstimator::kHintRelease && active) {
+      active = false;
+      releases++;
+    }
+  }
+};
+
+class FrameCostEstimatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override { estimator_.SetVsyncPeriod(kPeriod120); }
+
+  // Feeds one frame per period with the given costs, returns the index of the first acquire
+  int Run(const std::vector<int64_t> &costs) {
+    int first_acquire = -1;
+    for (size_t i = 0; i < costs.size(); i++) {
+      int acquires = hint_.acquires;
+      hint_.Apply(estimator_.Update(costs[i], now_));
+      if (first_acquire < 0 && hint_.acquires != acquires) {
+        first_acquire = static_cast<int>(i);
+      }
+      now_ += kPeriod120;
+    }
+    return first_acquire;
+  }
+
+  FrameCostEstimator estimator_;
+  MockCPUHint hint_;
+  int64_t now_ = 0;
+};
+
+TEST_F(FrameCostEstimatorTest, CheapFramesNeverBoost) {
+  std::vector<int64_t> costs(240, 3 * kMs);
+  EXPECT_EQ(Run(costs), -1);
+  EXPECT_EQ(hint_.acquires, 0);
+  EXPECT_FALSE(estimator_.IsBoosted());
+}
+
+TEST_F(FrameCostEstimatorTest, SustainedHeavyFramesBoost) {
+  std::vector<int64_t> costs(20, 3 * kMs);
+  costs.insert(costs.end(), 20, 7 * kMs);
+  int first = Run(costs);
+  EXPECT_GE(first, 20);
+  EXPECT_LT(first, 40);
+  EXPECT_TRUE(hint_.active);
+  EXPECT_EQ(hint_.acquires, 1);
+}
+
+TEST_F(FrameCostEstimatorTest, DeadlineMissBoostsImmediately) {
+  std::vector<int64_t> costs(20, 2 * kMs);
+  costs.push_back(10 * kMs);
+  EXPECT_EQ(Run(costs), 20);
+}
+
+TEST_F(FrameCostEstimatorTest, ReleaseWaitsForHoldTime) {
+  estimator_.SetReleaseHold(100 * kMs);
+  std::vector<int64_t> costs(40, 7 * kMs);
+  Run(costs);
+  ASSERT_TRUE(hint_.active);
+
+  // Load drops; the deviation settles first, then the hold time must elapse.
+  int frames_to_release = 0;
+  while (hint_.active && frames_to_release < 1000) {
+    hint_.Apply(estimator_.Update(1 * kMs, now_));
+    now_ += kPeriod120;
+    frames_to_release++;
+  }
+  EXPECT_FALSE(hint_.active);
+  EXPECT_GE(frames_to_release * kPeriod120, 100 * kMs);
+  EXPECT_EQ(hint_.releases, 1);
+}
+
+TEST_F(FrameCostEstimatorTest, HysteresisBandKeepsHint) {
+  std::vector<int64_t> costs(40, 7 * kMs);
+  Run(costs);
+  ASSERT_TRUE(hint_.active);
+
+  // 60% of the budget is below the boost threshold but above the release threshold.
+  std::vector<int64_t> mid(600, 5 * kMs);
+  Run(mid);
+  EXPECT_TRUE(hint_.active);
+  EXPECT_EQ(hint_.acquires, 1);
+  EXPECT_EQ(hint_.releases, 0);
+}
+
+TEST_F(FrameCostEstimatorTest, JitteryCostBoostsBeforeMeanCrosses) {
+  // Mean is 4.5ms, 54% of the budget, but the spread predicts misses.
+  std::vector<int64_t> costs;
+  for (int i = 0; i < 60; i++) {
+    costs.push_back((i % 2) ? 1 * kMs : 8 * kMs);
+  }
+  EXPECT_GE(Run(costs), 0);
+  EXPECT_TRUE(hint_.active);
+}
+
+TEST_F(FrameCostEstimatorTest, LongerPeriodRelaxesBudget) {
+  estimator_.SetVsyncPeriod(kPeriod60);
+  std::vector<int64_t> costs(120, 7 * kMs);
+  EXPECT_EQ(Run(costs), -1);
+}
+
+TEST_F(FrameCostEstimatorTest, ResetDropsBoost) {
+  std::vector<int64_t> costs(40, 7 * kMs);
+  Run(costs);
+  ASSERT_TRUE(estimator_.IsBoosted());
+  estimator_.Reset();
+  EXPECT_FALSE(estimator_.IsBoosted());
+  EXPECT_EQ(estimator_.GetPredictedCost(), 0);
+}
+
+}  // namespace
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+
+#include "handle_import_table.h"
+
+using namespace sdm;
+
+namespace {
+
+// The table never dereferences handles, plain tokens stand in for client and imported handles.
+buffer_handle_t FakeHandle(uintptr_t id) {
+  return reinterpret_cast<buffer_handle_t>(id << 4);
+}
+
+// Mapper stand-in that clones every client handle into a new token and tracks live clones.
+class FakeMapper {
+ public:
+  bool Import(buffer_handle_t handle, buffer_handle_t *imported) {
+    std::lock_guard<std::mutex> lock(lock_);
+    *imported = FakeHandle(next_++);
+    live_[*imported] = handle;
+    return true;
+  }
+
+  void Free(buffer_handle_t imported) {
+    std::lock_guard<std::mutex> lock(lock_);
+    live_.erase(imported);
+  }
+
+  size_t GetLive() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return live_.size();
+  }
+
+ private:
+  std::mutex lock_;
+  uintptr_t next_ = 1000;
+  std::map<buffer_handle_t, buffer_handle_t> live_;
+};
+
+HandleImportTable MakeTable(FakeMapper *mapper) {
+  return HandleImportTable(
+      [mapper](buffer_handle_t handle, buffer_handle_t *imported) {
+        return mapper->Import(handle, imported);
+      },
+      [mapper](buffer_handle_t imported) { mapper->Free(imported); });
+}
+
+TEST(HandleImportTableTest, ResentBufferIsAliased) {
+  FakeMapper mapper;
+  HandleImportTable table = MakeTable(&mapper);
+  HandleImportKey key = {};
+  key.ino = 42;
+  key.buffer_id = 7;
+
+  // The same dma-buf arrives twice under different client handles, e.g. in two slots.
+  buffer_handle_t first = nullptr;
+  buffer_handle_t second = nullptr;
+  ASSERT_TRUE(table.Import(&key, FakeHandle(1), &first));
+  ASSERT_TRUE(table.Import(&key, FakeHandle(2), &second));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(table.GetStats().imports, 1u);
+  EXPECT_EQ(table.GetStats().aliases, 1u);
+  EXPECT_EQ(mapper.GetLive(), 1u);
+
+  // A different allocation on the same inode is not aliased.
+  HandleImportKey other = key;
+  other.buffer_id = 8;
+  buffer_handle_t third = nullptr;
+  ASSERT_TRUE(table.Import(&other, FakeHandle(3), &third));
+  EXPECT_NE(third, first);
+  EXPECT_EQ(table.GetStats().imports, 2u);
+
+  // The clone is freed only with its last reference.
+  table.Release(first);
+  EXPECT_EQ(table.GetStats().frees, 0u);
+  EXPECT_EQ(mapper.GetLive(), 2u);
+  table.Release(second);
+  EXPECT_EQ(table.GetStats().frees, 1u);
+  table.Release(third);
+  EXPECT_EQ(mapper.GetLive(), 0u);
+  EXPECT_EQ(table.GetSize(), 0u);
+
+  // Once freed, the buffer is imported again.
+  ASSERT_TRUE(table.Import(&key, FakeHandle(1), &first));
+  EXPECT_EQ(table.GetStats().imports, 3u);
+  table.Release(first);
+}
+
+TEST(HandleImportTableTest, UnkeyedHandlesAreNotShared) {
+  FakeMapper mapper;
+  HandleImportTable table = MakeTable(&mapper);
+
+  buffer_handle_t first = nullptr;
+  buffer_handle_t second = nullptr;
+  ASSERT_TRUE(table.Import(nullptr, FakeHandle(1), &first));
+  ASSERT_TRUE(table.Import(nullptr, FakeHandle(1), &second));
+  EXPECT_NE(first, second);
+  EXPECT_EQ(table.GetStats().imports, 2u);
+  EXPECT_EQ(table.GetSize(), 0u);
+
+  table.Release(first);
+  table.Release(second);
+  EXPECT_EQ(table.GetStats().frees, 2u);
+  EXPECT_EQ(mapper.GetLive(), 0u);
+}
+
+TEST(HandleImportTableTest, FailedImport) {
+  HandleImportTable table([](buffer_handle_t, buffer_handle_t *) { return false; },
+                          [](buffer_handle_t) { FAIL(); });
+  HandleImportKey key = {};
+  key.ino = 1;
+  buffer_handle_t imported = nullptr;
+  EXPECT_FALSE(table.Import(&key, FakeHandle(1), &imported));
+  EXPECT_EQ(table.GetSize(), 0u);
+}
+
+TEST(HandleImportTableTest, MapperRunsWithoutTableLock) {
+  FakeMapper mapper;
+  std::promise<void> entered;
+  std::promise<void> resume;
+  std::shared_future<void> resume_future = resume.get_future().share();
+  buffer_handle_t slow_handle = FakeHandle(1);
+
+  HandleImportTable table(
+      [&](buffer_handle_t handle, buffer_handle_t *imported) {
+        if (handle == slow_handle) {
+          entered.set_value();
+          resume_future.wait();
+        }
+        return mapper.Import(handle, imported);
+      },
+      [&](buffer_handle_t imported) { mapper.Free(imported); });
+
+  HandleImportKey slow_key = {};
+  slow_key.ino = 1;
+  HandleImportKey fast_key = {};
+  fast_key.ino = 2;
+  buffer_handle_t fast = nullptr;
+  ASSERT_TRUE(table.Import(&fast_key, FakeHandle(2), &fast));
+
+  buffer_handle_t slow = nullptr;
+  auto slow_import = std::async(std::launch::async, [&]() {
+    return table.Import(&slow_key, slow_handle, &slow);
+  });
+  entered.get_future().wait();
+
+  // While one import sits in the mapper, other buffers are imported, aliased and released.
+  auto other = std::async(std::launch::async, [&]() {
+    buffer_handle_t handle = nullptr;
+    HandleImportKey key = {};
+    key.ino = 3;
+    bool ok = table.Import(&key, FakeHandle(3), &handle);
+    table.Release(handle);
+    ok = ok && table.Import(&fast_key, FakeHandle(4), &handle) && (handle == fast);
+    table.Release(handle);
+    return ok;
+  });
+  ASSERT_EQ(other.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_TRUE(other.get());
+
+  resume.set_value();
+  EXPECT_TRUE(slow_import.get());
+  table.Release(slow);
+  table.Release(fast);
+  EXPECT_EQ(mapper.GetLive(), 0u);
+}
+
+TEST(HandleImportTableTest, ConcurrentImportOfSameBuffer) {
+  FakeMapper mapper;
+  std::promise<void> first_entered;
+  std::promise<void> resume;
+  std::shared_future<void> resume_future = resume.get_future().share();
+  bool first = true;
+  std::mutex first_lock;
+
+  HandleImportTable table(
+      [&](buffer_handle_t handle, buffer_handle_t *imported) {
+        bool block = false;
+        {
+          std::lock_guard<std::mutex> lock(first_lock);
+          block = first;
+          first = false;
+        }
+        if (block) {
+          first_entered.set_value();
+          resume_future.wait();
+        }
+        return mapper.Import(handle, imported);
+      },
+      [&](buffer_handle_t imported) { mapper.Free(imported); });
+
+  HandleImportKey key = {};
+  key.ino = 9;
+  buffer_handle_t a = nullptr;
+  buffer_handle_t b = nullptr;
+  auto slow_import = std::async(std::launch::async, [&]() {
+    return table.Import(&key, FakeHandle(1), &a);
+  });
+  first_entered.get_future().wait();
+  // The second import of the buffer finishes first and owns the entry.
+  ASSERT_TRUE(table.Import(&key, FakeHandle(2), &b));
+  resume.set_value();
+  ASSERT_TRUE(slow_import.get());
+
+  // The losing clone was dropped and both callers share the winner.
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(table.GetStats().imports, 2u);
+  EXPECT_EQ(table.GetStats().frees, 1u);
+  EXPECT_EQ(mapper.GetLive(), 1u);
+  table.Release(a);
+  table.Release(b);
+  EXPECT_EQ(mapper.GetLive(), 0u);
+}
+
+}  // namespace
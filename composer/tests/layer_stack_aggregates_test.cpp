@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "../layer_stack_aggregates.h"
+
+using namespace sdm;
+
+namespace {
+
+const uint32_t kStackBits[] = {kStackVideo, kStackSecure, kStackScalingRgb, kStackSingleBuffered,
+                               kStackHdr,   kStackCursor, kStackSkip,       kStackMask};
+
+DisplayLayerInputs Display() {
+  DisplayLayerInputs display = {};
+  display.client_target_valid = true;
+  display.game_supported = true;
+  return display;
+}
+
+uint32_t PresentBits(const LayerStackAggregates &aggregates) {
+  uint32_t bits = 0;
+  for (uint32_t bit : kStackBits) {
+    if (aggregates.IsPresent(LayerStackContribution(bit))) {
+      bits |= bit;
+    }
+  }
+  return bits;
+}
+
+TEST(DeriveLayerFlagsTest, PlainLayer) {
+  LayerFlags flags = {};
+  EXPECT_EQ(DeriveLayerFlags(Display(), LayerStateInputs(), &flags), 0u);
+  EXPECT_FALSE(flags.skip);
+  EXPECT_FALSE(flags.solid_fill);
+}
+
+TEST(DeriveLayerFlagsTest, SkipsWithoutClientTarget) {
+  DisplayLayerInputs display = Display();
+  display.client_target_valid = false;
+  LayerStateInputs layer = {};
+  layer.solid_color = true;
+  LayerFlags flags = {};
+
+  EXPECT_EQ(DeriveLayerFlags(display, layer, &flags), UINT32(kStackSkip));
+  EXPECT_TRUE(flags.skip);
+  EXPECT_FALSE(flags.solid_fill);
+}
+
+TEST(DeriveLayerFlagsTest, HdrHandling) {
+  DisplayLayerInputs display = Display();
+  LayerStateInputs layer = {};
+  layer.hdr = true;
+  layer.game = true;
+  layer.non_integral_crop = true;
+  LayerFlags flags = {};
+
+  // An HDR layer is never a game layer, and is not skipped for a fractional crop.
+  EXPECT_EQ(DeriveLayerFlags(display, layer, &flags), UINT32(kStackHdr));
+  EXPECT_FALSE(flags.is_game);
+  EXPECT_FALSE(flags.skip);
+
+  // With HDR handling disabled the layer is still treated as HDR, but not reported as one.
+  display.hdr_handling = false;
+  EXPECT_EQ(DeriveLayerFlags(display, layer, &flags), 0u);
+  EXPECT_FALSE(flags.skip);
+}
+
+TEST(DeriveLayerFlagsTest, NonIntegralCropSkips) {
+  LayerStateInputs layer = {};
+  layer.non_integral_crop = true;
+  LayerFlags flags = {};
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackSkip));
+  EXPECT_TRUE(flags.skip);
+
+  // Video and game layers keep their fractional crop.
+  layer.video = true;
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackVideo));
+  layer.video = false;
+  layer.game = true;
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), 0u);
+  EXPECT_TRUE(flags.is_game);
+}
+
+TEST(DeriveLayerFlagsTest, CursorOnlyOnTop) {
+  LayerStateInputs layer = {};
+  layer.cursor_composition = true;
+  LayerFlags flags = {};
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), 0u);
+  EXPECT_FALSE(flags.cursor);
+
+  layer.top_most = true;
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackCursor));
+  EXPECT_TRUE(flags.cursor);
+
+  // A skipped layer can not be the cursor.
+  layer.dataspace_supported = false;
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackSkip));
+  EXPECT_FALSE(flags.cursor);
+}
+
+TEST(DeriveLayerFlagsTest, SingleBufferedNeedsDirectScanout) {
+  LayerStateInputs layer = {};
+  layer.single_buffered = true;
+  layer.rgb = true;
+  LayerFlags flags = {};
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackSingleBuffered));
+  EXPECT_TRUE(flags.single_buffer);
+
+  layer.scaling = true;
+  EXPECT_EQ(DeriveLayerFlags(Display(), layer, &flags), UINT32(kStackScalingRgb));
+  EXPECT_FALSE(flags.single_buffer);
+}
+
+TEST(LayerStackAggregatesTest, CountsContributingLayers) {
+  LayerStackAggregates aggregates;
+  aggregates.Update(0, kStackVideo | kStackSkip);
+  aggregates.Update(0, kStackVideo);
+  EXPECT_EQ(PresentBits(aggregates), UINT32(kStackVideo | kStackSkip));
+
+  // The first video layer stops being skipped, the second one is destroyed.
+  aggregates.Update(kStackVideo | kStackSkip, kStackVideo);
+  EXPECT_EQ(PresentBits(aggregates), UINT32(kStackVideo));
+  aggregates.Update(kStackVideo, 0);
+  EXPECT_EQ(PresentBits(aggregates), UINT32(kStackVideo));
+  aggregates.Update(kStackVideo, 0);
+  EXPECT_EQ(PresentBits(aggregates), 0u);
+
+  // Removing a layer twice does not underflow.
+  aggregates.Update(kStackVideo, 0);
+  aggregates.Update(0, kStackVideo);
+  EXPECT_TRUE(aggregates.IsPresent(kStackVideo));
+
+  aggregates.Reset();
+  EXPECT_EQ(PresentBits(aggregates), 0u);
+}
+
+// Client state of a layer, as HWCLayer keeps it.
+struct ClientLayer {
+  float src[4];
+  float dst[4];
+  float rotation;
+  bool video;
+  bool rgb;
+  bool single_buffered;
+  bool non_integral_crop;
+  bool dirty;
+  LayerFlags flags;
+  uint32_t contribution;
+};
+
+// Same work as HWCDisplay::BuildLayerStack does per layer to collect the inputs.
+LayerStateInputs Gather(const ClientLayer &client, bool top_most) {
+  LayerStateInputs inputs = {};
+  uint32_t src_width = static_cast<uint32_t>(client.src[2] - client.src[0]);
+  uint32_t src_height = static_cast<uint32_t>(client.src[3] - client.src[1]);
+  uint32_t dst_width = static_cast<uint32_t>(client.dst[2] - client.dst[0]);
+  uint32_t dst_height = static_cast<uint32_t>(client.dst[3] - client.dst[1]);
+  if (client.rotation == 90.0f || client.rotation == 270.0f) {
+    std::swap(src_width, src_height);
+  }
+  inputs.scaling = (src_width != dst_width) || (src_height != dst_height);
+  inputs.rotation = (client.rotation != 0.0f);
+  inputs.video = client.video;
+  inputs.rgb = client.rgb;
+  inputs.single_buffered = client.single_buffered;
+  inputs.non_integral_crop = client.non_integral_crop;
+  inputs.top_most = top_most;
+  return inputs;
+}
+
+std::vector<ClientLayer> MakeStack(uint32_t count) {
+  std::vector<ClientLayer> layers(count);
+  for (uint32_t i = 0; i < count; i++) {
+    ClientLayer &layer = layers[i];
+    float size = FLOAT(100 + 10 * i);
+    layer = {{0, 0, size, size}, {0, 0, size, size}, 0.0f, (i == 3), (i != 3),
+             (i == 7), false, true, {}, 0};
+  }
+  return layers;
+}
+
+// Moves one layer every frame and toggles the crop of a second one every other frame, as a
+// scrolling list with a blinking indicator does.
+void ChangeFrame(uint32_t frame, std::vector<ClientLayer> *layers) {
+  ClientLayer &moving = (*layers)[1 + frame % 4];
+  moving.dst[0] = FLOAT(frame % 50);
+  moving.dst[2] = moving.dst[0] + moving.src[2] + FLOAT(frame % 2);
+  moving.dirty = true;
+  if (frame % 2) {
+    ClientLayer &blinking = (*layers)[12];
+    blinking.non_integral_crop = !blinking.non_integral_crop;
+    blinking.dirty = true;
+  }
+}
+
+uint32_t FullStackBits(std::vector<ClientLayer> *layers, const DisplayLayerInputs &display) {
+  uint32_t bits = 0;
+  for (uint32_t i = 0; i < layers->size(); i++) {
+    ClientLayer &layer = (*layers)[i];
+    bits |= DeriveLayerFlags(display, Gather(layer, i + 1 == layers->size()), &layer.flags);
+    layer.dirty = false;
+  }
+  return bits;
+}
+
+uint32_t IncrementalStackBits(std::vector<ClientLayer> *layers, const DisplayLayerInputs &display,
+                              LayerStackAggregates *aggregates, uint32_t *derived) {
+  for (uint32_t i = 0; i < layers->size(); i++) {
+    ClientLayer &layer = (*layers)[i];
+    if (!layer.dirty) {
+      continue;
+    }
+    uint32_t contribution = DeriveLayerFlags(display, Gather(layer, i + 1 == layers->size()),
+                                             &layer.flags);
+    aggregates->Update(layer.contribution, contribution);
+    layer.contribution = contribution;
+    layer.dirty = false;
+    (*derived)++;
+  }
+  return PresentBits(*aggregates);
+}
+
+// Timing loop over 20 layer frames where only 1-2 layers change per frame. Reports the per frame
+// cost of deriving every layer against deriving only the changed ones, and checks both agree.
+TEST(LayerStackAggregatesTest, Benchmark20LayersFewChanged) {
+  const uint32_t kLayers = 20;
+  const uint32_t kFrames = 200000;
+  DisplayLayerInputs display = Display();
+
+  std::vector<ClientLayer> full = MakeStack(kLayers);
+  std::vector<ClientLayer> incremental = MakeStack(kLayers);
+  LayerStackAggregates aggregates;
+  uint32_t derived = 0;
+  for (uint32_t frame = 0; frame < 1000; frame++) {
+    ChangeFrame(frame, &full);
+    ChangeFrame(frame, &incremental);
+    ASSERT_EQ(FullStackBits(&full, display),
+              IncrementalStackBits(&incremental, display, &aggregates, &derived));
+    for (uint32_t i = 0; i < kLayers; i++) {
+      ASSERT_EQ(full[i].flags.flags, incremental[i].flags.flags) << "frame " << frame;
+    }
+  }
+  // The first frame derives every layer, then one or two per frame.
+  EXPECT_EQ(derived, kLayers + 1000 + 499);
+
+  volatile uint32_t sink = 0;  // Keeps the loops from being optimized out
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < kFrames; frame++) {
+    ChangeFrame(frame, &full);
+    sink = sink + FullStackBits(&full, display);
+  }
+  auto full_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < kFrames; frame++) {
+    ChangeFrame(frame, &incremental);
+    sink = sink + IncrementalStackBits(&incremental, display, &aggregates, &derived);
+  }
+  auto incremental_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+
+  printf("%u layers, %u frames: derive all %.1f ns/frame, derive changed %.1f ns/frame\n",
+         kLayers, kFrames, double(full_ns) / kFrames, double(incremental_ns) / kFrames);
+}
+
+}  // namespace
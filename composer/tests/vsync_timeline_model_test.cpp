@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <tuple>
+
+#include "vsync_timeline_model.h"
+
+using namespace sdm;
+
+namespace {
+
+const int64_t kUs = 1000;
+const int64_t kMs = 1000000;
+const int64_t kPeriod60 = 16666667;
+const int64_t kPeriod90 = 11111111;
+const int64_t kPeriod120 = 8333333;
+
+// Hardware vsync trace on a fixed grid with bounded, deterministic jitter.
+class VsyncTrace {
+ public:
+  VsyncTrace(int64_t first_edge, int64_t period, int64_t jitter)
+    : edge_(first_edge), period_(period), jitter_(jitter) {}
+
+  int64_t Edge() const { return edge_; }
+  int64_t Period() const { return period_; }
+  int64_t Next() {
+    int64_t timestamp = edge_ + Noise();
+    edge_ += period_;
+    return timestamp;
+  }
+  void SetPeriod(int64_t period) { period_ = period; }
+
+ private:
+  int64_t Noise() {
+    if (!jitter_) {
+      return 0;
+    }
+    seed_ = seed_ * 1103515245 + 12345;
+    return static_cast<int64_t>((seed_ >> 16) % (2 * jitter_ + 1)) - jitter_;
+  }
+
+  int64_t edge_;
+  int64_t period_;
+  int64_t jitter_;
+  uint64_t seed_ = 1;
+};
+
+// Drives the model the way HWCDisplay does: vsyncs feed the fit, a change request is estimated,
+// then re-estimated on commit once the refresh time is reached and scheduled.
+struct SwitchResult {
+  int64_t requested_applied = 0;
+  int64_t committed_applied = 0;
+  int64_t actual_applied = 0;
+};
+
+SwitchResult RunSwitch(VsyncTimelineModel *model, VsyncTrace *trace, int64_t new_period,
+                       int64_t desired_offset) {
+  SwitchResult result;
+  int64_t now = trace->Edge() - trace->Period() / 3;
+  int64_t refresh_time = 0;
+  std::tie(refresh_time, result.requested_applied) =
+      model->EstimateChange(now + desired_offset, now, 1);
+
+  // Frames keep coming; the composer commits the new config on the first frame after the
+  // refresh time, which latches on the next edge and switches the period after it.
+  while (trace->Edge() <= refresh_time) {
+    model->AddVsync(trace->Next());
+  }
+  int64_t commit_time = trace->Edge() - trace->Period() / 2;
+  std::tie(std::ignore, result.committed_applied) =
+      model->EstimateChange(refresh_time, commit_time, 1);
+  model->SchedulePeriodChange(new_period, result.committed_applied);
+
+  result.actual_applied = trace->Edge();
+  trace->SetPeriod(new_period);
+  return result;
+}
+
+TEST(VsyncTimelineModelTest, FitsPeriodAndPhase) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod60);
+  VsyncTrace trace(3 * kMs, kPeriod60, 150 * kUs);
+  for (int i = 0; i < 30; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  EXPECT_NEAR(model.GetPeriod(), kPeriod60, 20 * kUs);
+  EXPECT_LE(model.GetJitter(), 150 * kUs);
+  int64_t probe = trace.Edge() + 5 * kPeriod60 + kPeriod60 / 3;
+  EXPECT_NEAR(model.NextVsync(probe), trace.Edge() + 6 * kPeriod60, 200 * kUs);
+  EXPECT_NEAR(model.PrevVsync(probe), trace.Edge() + 5 * kPeriod60, 200 * kUs);
+}
+
+TEST(VsyncTimelineModelTest, TracksClockOffNominal) {
+  // Panel clock runs 0.5% slow; the nominal period would drift a full frame in ~3s.
+  const int64_t actual = kPeriod120 + kPeriod120 / 200;
+  VsyncTimelineModel model;
+  model.Reset(kPeriod120);
+  VsyncTrace trace(0, actual, 50 * kUs);
+  for (int i = 0; i < 20; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  EXPECT_NEAR(model.GetPeriod(), actual, 10 * kUs);
+  int64_t edge = trace.Edge() + 100 * actual;
+  EXPECT_NEAR(model.NextVsync(edge - actual / 2), edge, 500 * kUs);
+}
+
+TEST(VsyncTimelineModelTest, RefreshTimeIsOnRealEdge) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod60);
+  VsyncTrace trace(7 * kMs, kPeriod60, 100 * kUs);
+  for (int i = 0; i < 10; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  // Desired time well in the future and off the grid.
+  int64_t now = trace.Edge() - kPeriod60 / 2;
+  int64_t desired = now + 100 * kMs + 3 * kMs;
+  int64_t refresh_time = 0, applied_time = 0;
+  std::tie(refresh_time, applied_time) = model.EstimateChange(desired, now, 1);
+
+  int64_t edges = (refresh_time - trace.Edge() + kPeriod60 / 2) / kPeriod60;
+  EXPECT_NEAR(refresh_time, trace.Edge() + edges * kPeriod60, 200 * kUs);
+  EXPECT_NEAR(applied_time - refresh_time, kPeriod60, 20 * kUs);
+  EXPECT_LE(applied_time, desired + kPeriod60 / 8);
+  EXPECT_GT(applied_time + kPeriod60, desired);
+}
+
+TEST(VsyncTimelineModelTest, Switch60To120) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod60);
+  VsyncTrace trace(2 * kMs, kPeriod60, 100 * kUs);
+  for (int i = 0; i < 12; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  SwitchResult result = RunSwitch(&model, &trace, kPeriod120, 40 * kMs);
+  EXPECT_NEAR(result.requested_applied, result.actual_applied, 200 * kUs);
+  EXPECT_NEAR(result.committed_applied, result.requested_applied, 100 * kUs);
+
+  // Before any 120Hz vsync arrives the model already predicts the new grid.
+  EXPECT_NEAR(model.NextVsync(result.actual_applied + kMs), result.actual_applied + kPeriod120,
+              200 * kUs);
+  for (int i = 0; i < 12; i++) {
+    model.AddVsync(trace.Next());
+  }
+  EXPECT_EQ(model.GetNominalPeriod(), kPeriod120);
+  EXPECT_NEAR(model.GetPeriod(), kPeriod120, 20 * kUs);
+  EXPECT_NEAR(model.NextVsync(trace.Edge() - kMs), trace.Edge(), 200 * kUs);
+}
+
+TEST(VsyncTimelineModelTest, Switch120To90) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod120);
+  VsyncTrace trace(5 * kMs, kPeriod120, 100 * kUs);
+  for (int i = 0; i < 16; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  // Desired time inside the activation window, the earliest possible edge is used.
+  SwitchResult result = RunSwitch(&model, &trace, kPeriod90, kPeriod120 / 2);
+  EXPECT_NEAR(result.requested_applied, result.actual_applied, 200 * kUs);
+  EXPECT_NEAR(result.committed_applied, result.requested_applied, 100 * kUs);
+
+  // During the transient, times before the applied edge stay on the 120Hz grid.
+  EXPECT_NEAR(model.PrevVsync(result.actual_applied - kMs),
+              result.actual_applied - kPeriod120, 200 * kUs);
+  EXPECT_NEAR(model.NextVsync(result.actual_applied + kMs), result.actual_applied + kPeriod90,
+              200 * kUs);
+  for (int i = 0; i < 10; i++) {
+    model.AddVsync(trace.Next());
+  }
+  EXPECT_NEAR(model.GetPeriod(), kPeriod90, 20 * kUs);
+}
+
+TEST(VsyncTimelineModelTest, LateCommitMovesAppliedTime) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod60);
+  VsyncTrace trace(0, kPeriod60, 0);
+  for (int i = 0; i < 8; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  int64_t now = trace.Edge() - kPeriod60 / 2;
+  int64_t refresh_time = 0, applied_time = 0;
+  std::tie(refresh_time, applied_time) = model.EstimateChange(now, now, 1);
+
+  // The frame that should have carried the change misses its edge by a full vsync.
+  int64_t late_applied = 0;
+  std::tie(std::ignore, late_applied) =
+      model.EstimateChange(refresh_time, refresh_time + kPeriod60 + kMs, 1);
+  EXPECT_EQ(late_applied, applied_time + kPeriod60);
+}
+
+TEST(VsyncTimelineModelTest, PhaseJumpRestartsFit) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod60);
+  VsyncTrace trace(0, kPeriod60, 0);
+  for (int i = 0; i < 8; i++) {
+    model.AddVsync(trace.Next());
+  }
+
+  // Display was power cycled and resumed on a different phase.
+  VsyncTrace resumed(trace.Edge() + 500 * kMs + kPeriod60 / 2, kPeriod60, 0);
+  model.AddVsync(resumed.Next());
+  EXPECT_EQ(model.NextVsync(resumed.Edge() - kMs), resumed.Edge());
+}
+
+TEST(VsyncTimelineModelTest, MissedVsyncsKeepPhase) {
+  VsyncTimelineModel model;
+  model.Reset(kPeriod120);
+  VsyncTrace trace(1 * kMs, kPeriod120, 50 * kUs);
+  for (int i = 0; i < 40; i++) {
+    int64_t timestamp = trace.Next();
+    // Vsync delivery is gated by the client, every other burst is dropped.
+    if ((i / 5) % 2 == 0) {
+      model.AddVsync(timestamp);
+    }
+  }
+  EXPECT_NEAR(model.GetPeriod(), kPeriod120, 20 * kUs);
+  EXPECT_NEAR(model.NextVsync(trace.Edge() - kMs), trace.Edge(), 200 * kUs);
+}
+
+}  // namespace
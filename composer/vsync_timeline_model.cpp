@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "vsync_timeline_model.h"
+
+namespace sdm {
+
+static int64_t FloorDiv(int64_t num, int64_t den) {
+  int64_t quot = num / den;
+  return ((num % den) < 0) ? (quot - 1) : quot;
+}
+
+void VsyncTimelineModel::Reset(int64_t nominal_period) {
+  nominal_period_ = nominal_period;
+  period_ = nominal_period;
+  anchor_ = 0;
+  has_anchor_ = false;
+  jitter_ = 0;
+  samples_.clear();
+  has_pending_ = false;
+}
+
+void VsyncTimelineModel::AddVsync(int64_t timestamp) {
+  if (has_pending_ && timestamp >= pending_applied_time_ - EdgeTolerance(pending_period_)) {
+    // The first vsync of the new period; samples of the old one no longer fit.
+    nominal_period_ = pending_period_;
+    period_ = pending_period_;
+    has_pending_ = false;
+    jitter_ = 0;
+    samples_.clear();
+  }
+
+  if (period_ <= 0) {
+    return;
+  }
+
+  if (!samples_.empty()) {
+    int64_t delta = timestamp - samples_.back();
+    if (delta <= 0) {
+      return;
+    }
+    int64_t vsyncs = (delta + period_ / 2) / period_;
+    int64_t residual = delta - vsyncs * period_;
+    if (!vsyncs || llabs(residual) > period_ / 4) {
+      // Phase or period moved without going through the timeline, start a new fit.
+      samples_.clear();
+      period_ = nominal_period_;
+      jitter_ = 0;
+    }
+  }
+
+  samples_.push_back(timestamp);
+  if (samples_.size() > kMaxSamples) {
+    samples_.pop_front();
+  }
+  Fit();
+}
+
+void VsyncTimelineModel::Fit() {
+  anchor_ = samples_.back();
+  has_anchor_ = true;
+  if (samples_.size() < 3) {
+    return;
+  }
+
+  // Regress the timestamps against their vsync index, relative to the oldest sample to keep the
+  // doubles well within precision.
+  int64_t base = samples_.front();
+  size_t count = samples_.size();
+  double index[kMaxSamples];
+  double offset[kMaxSamples];
+  double mean_index = 0.0;
+  double mean_offset = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    int64_t delta = samples_[i] - base;
+    index[i] = static_cast<double>((delta + period_ / 2) / period_);
+    offset[i] = static_cast<double>(delta);
+    mean_index += index[i];
+    mean_offset += offset[i];
+  }
+  mean_index /= count;
+  mean_offset /= count;
+
+  if (index[count - 1] < 2.0) {
+    return;
+  }
+
+  double covariance = 0.0;
+  double variance = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    covariance += (index[i] - mean_index) * (offset[i] - mean_offset);
+    variance += (index[i] - mean_index) * (index[i] - mean_index);
+  }
+  double slope = covariance / variance;
+  double max_drift = static_cast<double>(nominal_period_ * kMaxPeriodDriftPercent) / 100.0;
+  if (std::fabs(slope - static_cast<double>(nominal_period_)) > max_drift) {
+    slope = static_cast<double>(nominal_period_);
+  }
+  double intercept = mean_offset - slope * mean_index;
+
+  double residuals = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    residuals += std::fabs(offset[i] - (intercept + slope * index[i]));
+  }
+
+  period_ = std::llround(slope);
+  anchor_ = base + std::llround(intercept + slope * index[count - 1]);
+  jitter_ = std::llround(residuals / count);
+}
+
+void VsyncTimelineModel::SchedulePeriodChange(int64_t nominal_period, int64_t applied_time) {
+  if (nominal_period <= 0) {
+    return;
+  }
+  has_pending_ = true;
+  pending_period_ = nominal_period;
+  pending_applied_time_ = applied_time;
+}
+
+int64_t VsyncTimelineModel::PrevVsync(int64_t time) const {
+  if (has_pending_ && time >= pending_applied_time_) {
+    return pending_applied_time_ +
+           FloorDiv(time - pending_applied_time_, pending_period_) * pending_period_;
+  }
+  return anchor_ + FloorDiv(time - anchor_, period_) * period_;
+}
+
+int64_t VsyncTimelineModel::NextVsync(int64_t time) const {
+  if (has_pending_ && time >= pending_applied_time_) {
+    return pending_applied_time_ +
+           (FloorDiv(time - pending_applied_time_, pending_period_) + 1) * pending_period_;
+  }
+  int64_t next = anchor_ + (FloorDiv(time - anchor_, period_) + 1) * period_;
+  return has_pending_ ? std::min(next, pending_applied_time_) : next;
+}
+
+std::tuple<int64_t, int64_t> VsyncTimelineModel::EstimateChange(int64_t desired_time, int64_t now,
+                                                                uint32_t vsyncs_to_apply) const {
+  bool pending_now = has_pending_ && now >= pending_applied_time_;
+  int64_t period = pending_now ? pending_period_ : period_;
+  if (period <= 0) {
+    return std::make_tuple(desired_time, desired_time);
+  }
+  int64_t target = std::max(now, desired_time - period * vsyncs_to_apply);
+
+  // Requests are usually computed on the client's own vsync model, snap them to the nearest edge
+  // within tolerance rather than losing a whole vsync to a small phase disagreement.
+  int64_t refresh_time = PrevVsync(target + EdgeTolerance(period));
+  int64_t applied_time = refresh_time;
+  for (uint32_t i = 0; i < std::max(vsyncs_to_apply, 1u); i++) {
+    applied_time = NextVsync(applied_time);
+  }
+
+  return std::make_tuple(refresh_time, applied_time);
+}
+
+}  // namespace sdm
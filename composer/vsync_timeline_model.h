@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __VSYNC_TIMELINE_MODEL_H__
+#define __VSYNC_TIMELINE_MODEL_H__
+
+#include <stdint.h>
+
+#include <deque>
+#include <tuple>
+
+namespace sdm {
+
+// Models the vsync grid of a display from hardware vsync timestamps, so that refresh rate change
+// timelines line up with real vsync edges instead of assuming the requested time is on the grid.
+// The period and phase are a least squares fit over recent vsyncs; a scheduled period change
+// switches the grid at its applied time until vsyncs of the new period refine it.
+class VsyncTimelineModel {
+ public:
+  // Drops the fit and starts over with the given nominal period, e.g. on a mode change that
+  // bypassed the timeline
+  void Reset(int64_t nominal_period);
+  void AddVsync(int64_t timestamp);
+  void SchedulePeriodChange(int64_t nominal_period, int64_t applied_time);
+
+  bool IsValid() const { return has_anchor_; }
+  int64_t GetPeriod() const { return period_; }
+  int64_t GetNominalPeriod() const { return nominal_period_; }
+  int64_t GetNominalPeriodAt(int64_t time) const {
+    return (has_pending_ && time >= pending_applied_time_) ? pending_period_ : nominal_period_;
+  }
+  int64_t GetJitter() const { return jitter_; }
+
+  // Latest predicted vsync at or before time, and first predicted vsync after time
+  int64_t PrevVsync(int64_t time) const;
+  int64_t NextVsync(int64_t time) const;
+
+  // Returns {refresh time, new vsync applied time} for a change requested to take effect at
+  // desired_time, with the new period applied vsyncs_to_apply vsyncs after the refresh.
+  std::tuple<int64_t, int64_t> EstimateChange(int64_t desired_time, int64_t now,
+                                              uint32_t vsyncs_to_apply) const;
+
+ private:
+  static const size_t kMaxSamples = 16;
+  static const int64_t kMaxPeriodDriftPercent = 5;  // Fit clamp around the nominal period
+
+  void Fit();
+  // Tolerance for treating a time as being on a vsync edge
+  int64_t EdgeTolerance(int64_t period) const { return (period / 8) + jitter_; }
+
+  int64_t nominal_period_ = 0;
+  int64_t period_ = 0;
+  int64_t anchor_ = 0;  // A vsync edge of the current grid
+  bool has_anchor_ = false;
+  int64_t jitter_ = 0;  // Mean absolute residual of the fit
+  std::deque<int64_t> samples_;
+
+  bool has_pending_ = false;
+  int64_t pending_period_ = 0;
+  int64_t pending_applied_time_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __VSYNC_TIMELINE_MODEL_H__
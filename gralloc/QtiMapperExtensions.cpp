@@ -34,6 +34,7 @@
 #include <cutils/properties.h>
 #include <cutils/trace.h>
 #include <sync/sync.h>
+#include "gr_metadata_copy.h"
 #include "gr_utils.h"
 #include <QtiGralloc.h>
 
@@ -51,6 +52,7 @@ using MetadataType = ::android::hardware::graphics::mapper::V4_0::IMapper::Metad
 QtiMapperExtensions::QtiMapperExtensions() {
   buf_mgr_ = BufferManager::GetInstance();
   enable_logs_ = property_get_bool(ENABLE_LOGS_PROP, 0);
+  full_metadata_copy_ = property_get_bool(FULL_METADATA_COPY_PROP, 0);
 }
 
 Return<void> QtiMapperExtensions::getMapSecureBufferFlag(void *buffer,
@@ -443,7 +445,7 @@ Return<Error> QtiMapperExtensions::copyMetaData(void *src, void *dst) {
             Error::NONE) {
       MetaData_t *src_data = reinterpret_cast<MetaData_t *>(src_hnd->base_metadata);
       MetaData_t *dst_data = reinterpret_cast<MetaData_t *>(dst_hnd->base_metadata);
-      *dst_data = *src_data;
+      gralloc::CopyMetaDataDelta(src_data, dst_data, full_metadata_copy_);
       error = Error::NONE;
     }
   } else {
@@ -463,7 +465,7 @@ Return<Error> QtiMapperExtensions::setMetadataBlob(const hidl_vec<uint8_t> &src,
         Error::NONE) {
       const MetaData_t *src_data = reinterpret_cast<const MetaData_t *>(src.data());
       MetaData_t *dst_data = reinterpret_cast<MetaData_t *>(dst_hnd->base_metadata);
-      *dst_data = *src_data;
+      gralloc::CopyMetaDataDelta(src_data, dst_data, full_metadata_copy_);
       error = Error::NONE;
     }
   } else {
@@ -483,7 +485,8 @@ Return<void> QtiMapperExtensions::getMetadataBlob(void *src, getMetadataBlob_cb
         Error::NONE) {
       MetaData_t *src_data = reinterpret_cast<MetaData_t *>(src_hnd->base_metadata);
       MetaData_t *dst_data = reinterpret_cast<MetaData_t *>(out.data());
-      memcpy(dst_data, src_data, sizeof(MetaData_t));
+      // Unset payloads stay zero filled from the resize
+      gralloc::CopyMetaDataDelta(src_data, dst_data, full_metadata_copy_);
       error = Error::NONE;
       _hidl_cb(error, out);
     }
@@ -101,6 +101,7 @@ class QtiMapperExtensions : public IQtiMapperExtensions {
  private:
   BufferManager *buf_mgr_ = nullptr;
   bool enable_logs_ = false;
+  bool full_metadata_copy_ = false;
 };
 
 }  // namespace implementation
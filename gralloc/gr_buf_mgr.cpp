@@ -32,6 +32,7 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -40,6 +41,7 @@
 
 #include "gr_adreno_info.h"
 #include "gr_buf_descriptor.h"
+#include "gr_metadata_copy.h"
 #include "gr_utils.h"
 #include "qd_utils.h"
 #include "color_extensions.h"
@@ -263,9 +265,10 @@ int BufferManager::GetCustomDimensions(private_handle_t *hnd, int *stride, int *
 }
 
 BufferManager::BufferManager() : next_id_(0) {
-  handles_map_.clear();
   allocator_ = new Allocator();
   enable_logs = property_get_bool(ENABLE_LOGS_PROP, 0);
+  // Create the allocator backend up front, AllocateBuffer runs concurrently without a global lock
+  AllocInterface::GetInstance();
 }
 
 BufferManager *BufferManager::GetInstance() {
@@ -357,7 +360,7 @@ void BufferManager::RegisterHandleLocked(const private_handle_t *hnd, int ion_ha
 #endif
   }
 
-  handles_map_.emplace(std::make_pair(hnd, buffer));
+  GetShard(hnd).handles_map.emplace(std::make_pair(hnd, buffer));
 }
 
 Error BufferManager::ImportHandleLocked(private_handle_t *hnd) {
@@ -391,18 +394,28 @@ Error BufferManager::ImportHandleLocked(private_handle_t *hnd) {
   }
 
   RegisterHandleLocked(hnd, ion_handle, ion_handle_meta);
-  allocated_ += hnd->size;
+  return Error::NONE;
+}
+
+void BufferManager::CheckAllocThreshold() {
+  std::lock_guard<std::mutex> lock(alloc_threshold_lock_);
   if (allocated_ >= kAllocThreshold) {
     kAllocThreshold += kMemoryOffset;
     BuffersDump();
   }
-  return Error::NONE;
+}
+
+BufferManager::HandleMapShard &BufferManager::GetShard(const private_handle_t *hnd) {
+  // Handles are malloc'ed, drop the allocator alignment bits before picking a shard
+  auto key = reinterpret_cast<uintptr_t>(hnd) >> 4;
+  return shards_[key % kHandleMapShards];
 }
 
 std::shared_ptr<BufferManager::Buffer> BufferManager::GetBufferFromHandleLocked(
     const private_handle_t *hnd) {
-  auto it = handles_map_.find(hnd);
-  if (it != handles_map_.end()) {
+  auto &handles_map = GetShard(hnd).handles_map;
+  auto it = handles_map.find(hnd);
+  if (it != handles_map.end()) {
     return it->second;
   } else {
     return nullptr;
@@ -422,7 +435,7 @@ Error BufferManager::MapBuffer(private_handle_t const *handle) {
 }
 
 Error BufferManager::IsBufferImported(const private_handle_t *hnd) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(hnd).lock);
   auto buf = GetBufferFromHandleLocked(hnd);
   if (buf != nullptr) {
     return Error::NONE;
@@ -433,39 +446,54 @@ Error BufferManager::IsBufferImported(const private_handle_t *hnd) {
 Error BufferManager::RetainBuffer(private_handle_t const *hnd) {
   ALOGD_IF(enable_logs, "Retain buffer handle:%p id: %" PRIu64, hnd, hnd->id);
   auto err = Error::NONE;
-  std::lock_guard<std::mutex> lock(buffer_lock_);
-  auto buf = GetBufferFromHandleLocked(hnd);
-  if (buf != nullptr) {
-    buf->IncRef();
-  } else {
+  {
+    std::lock_guard<std::mutex> lock(GetShard(hnd).lock);
+    auto buf = GetBufferFromHandleLocked(hnd);
+    if (buf != nullptr) {
+      buf->IncRef();
+      return err;
+    }
+
     private_handle_t *handle = const_cast<private_handle_t *>(hnd);
     err = ImportHandleLocked(handle);
   }
+
+  if (err == Error::NONE) {
+    allocated_ += hnd->size;
+    CheckAllocThreshold();
+  }
   return err;
 }
 
 Error BufferManager::ReleaseBuffer(private_handle_t const *hnd) {
   ALOGD_IF(enable_logs, "Release buffer handle:%p", hnd);
-  std::lock_guard<std::mutex> lock(buffer_lock_);
-  auto buf = GetBufferFromHandleLocked(hnd);
-  if (buf == nullptr) {
-    ALOGE("Could not find handle: %p", hnd);
-    return Error::BAD_BUFFER;
-  } else {
-    if (buf->DecRef()) {
-      handles_map_.erase(hnd);
-      // Unmap, close ion handle and close fd
-      if (allocated_ >= hnd->size) {
-        allocated_ -= hnd->size;
-      }
-      FreeBuffer(buf);
+  std::shared_ptr<Buffer> buf = nullptr;
+  {
+    auto &shard = GetShard(hnd);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    buf = GetBufferFromHandleLocked(hnd);
+    if (buf == nullptr) {
+      ALOGE("Could not find handle: %p", hnd);
+      return Error::BAD_BUFFER;
+    }
+    if (!buf->DecRef()) {
+      return Error::NONE;
     }
+    shard.handles_map.erase(hnd);
   }
+
+  // The handle is no longer reachable, unmap, close ion handle and close fd without the lock
+  // Only imported buffers are counted, the release of a buffer allocated here must not wrap
+  uint64_t allocated = allocated_.load();
+  while (allocated >= hnd->size &&
+         !allocated_.compare_exchange_weak(allocated, allocated - hnd->size)) {
+  }
+  FreeBuffer(buf);
   return Error::NONE;
 }
 
 Error BufferManager::LockBuffer(const private_handle_t *hnd, uint64_t usage) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(hnd).lock);
   auto err = Error::NONE;
   ALOGD_IF(enable_logs, "LockBuffer buffer handle:%p id: %" PRIu64, hnd, hnd->id);
 
@@ -507,7 +535,7 @@ Error BufferManager::LockBuffer(const private_handle_t *hnd, uint64_t usage) {
 }
 
 Error BufferManager::FlushBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
@@ -525,7 +553,7 @@ Error BufferManager::FlushBuffer(const private_handle_t *handle) {
 }
 
 Error BufferManager::RereadBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
@@ -543,7 +571,7 @@ Error BufferManager::RereadBuffer(const private_handle_t *handle) {
 }
 
 Error BufferManager::UnlockBuffer(const private_handle_t *handle) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   auto status = Error::NONE;
 
   private_handle_t *hnd = const_cast<private_handle_t *>(handle);
@@ -600,7 +628,6 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
                                     unsigned int bufferSize, bool testAlloc) {
   if (!handle)
     return Error::BAD_BUFFER;
-  std::lock_guard<std::mutex> buffer_lock(buffer_lock_);
 
   uint64_t usage = descriptor.GetUsage();
   int format = GetImplDefinedFormat(usage, descriptor.GetFormat());
@@ -719,9 +746,14 @@ Error BufferManager::AllocateBuffer(const BufferDescriptor &descriptor, buffer_h
 
   UnmapAndReset(hnd);
 
+  // Only publication of the new handle needs the lock, all allocation work above is done
+  // without it so that a slow allocation does not stall lookups of other buffers
+  {
+    std::lock_guard<std::mutex> lock(GetShard(hnd).lock);
+    RegisterHandleLocked(hnd, data.ion_handle, e_data.ion_handle);
+  }
   *handle = hnd;
 
-  RegisterHandleLocked(hnd, data.ion_handle, e_data.ion_handle);
   ALOGD_IF(enable_logs, "Allocated buffer handle: %p id: %" PRIu64, hnd, hnd->id);
   if (enable_logs) {
     private_handle_t::Dump(hnd);
@@ -749,17 +781,32 @@ void BufferManager::BuffersDump() {
   }
   fs << "============================" << std::endl;
   fs << timeStamp << std::endl;
-  fs << "Total layers = " << handles_map_.size() << std::endl;
+  // The handle and its metadata mapping can go away once the shard lock is dropped, copy what is
+  // printed while it is held.
+  struct BufferDumpInfo {
+    std::string name;
+    int width;
+    int height;
+    unsigned int size;
+  };
+  std::vector<BufferDumpInfo> buffers;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (auto it : shard.handles_map) {
+      auto hnd = it.second->handle;
+      auto metadata = reinterpret_cast<MetaData_t *>(hnd->base_metadata);
+      buffers.push_back({metadata ? metadata->name : "No name", hnd->width, hnd->height,
+                         hnd->size});
+    }
+  }
+  fs << "Total layers = " << buffers.size() << std::endl;
   uint64_t totalAllocationSize = 0;
-  for (auto it : handles_map_) {
-    auto buf = it.second;
-    auto hnd = buf->handle;
-    auto metadata = reinterpret_cast<MetaData_t *>(hnd->base_metadata);
-    fs << std::setw(80) << "Client:" << (metadata ? metadata->name : "No name");
-    fs << std::setw(20) << "WxH:" << std::setw(4) << hnd->width << " x " << std::setw(4)
-       << hnd->height;
-    fs << std::setw(20) << "Size: " << std::setw(9) << hnd->size << std::endl;
-    totalAllocationSize += hnd->size;
+  for (auto &buf : buffers) {
+    fs << std::setw(80) << "Client:" << buf.name;
+    fs << std::setw(20) << "WxH:" << std::setw(4) << buf.width << " x " << std::setw(4)
+       << buf.height;
+    fs << std::setw(20) << "Size: " << std::setw(9) << buf.size << std::endl;
+    totalAllocationSize += buf.size;
   }
   fs << "Total allocation  = " << totalAllocationSize / 1024 << "KiB" << std::endl;
   file_dump_.position = fs.tellp();
@@ -770,46 +817,69 @@ void BufferManager::BuffersDump() {
 }
 
 Error BufferManager::Dump(std::ostringstream *os) {
-  std::lock_guard<std::mutex> buffer_lock(buffer_lock_);
-  for (auto it : handles_map_) {
-    auto buf = it.second;
-    auto hnd = buf->handle;
-    *os << "handle id: " << std::setw(4) << hnd->id;
-    *os << " fd: " << std::setw(3) << hnd->fd;
-    *os << " fd_meta: " << std::setw(3) << hnd->fd_metadata;
-    *os << " wxh: " << std::setw(4) << hnd->width << " x " << std::setw(4) << hnd->height;
-    *os << " uwxuh: " << std::setw(4) << hnd->unaligned_width << " x ";
-    *os << std::setw(4) << hnd->unaligned_height;
-    *os << " size: " << std::setw(9) << hnd->size;
+  // Copy what is printed under the shard locks, a handle can be freed as soon as its lock is
+  // dropped
+  struct HandleDumpInfo {
+    uint64_t id;
+    int fd;
+    int fd_metadata;
+    int width;
+    int height;
+    int unaligned_width;
+    int unaligned_height;
+    unsigned int size;
+    int flags;
+    uint64_t usage;
+    int format;
+  };
+  std::vector<HandleDumpInfo> handles;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (auto it : shard.handles_map) {
+      auto hnd = it.second->handle;
+      handles.push_back({hnd->id, hnd->fd, hnd->fd_metadata, hnd->width, hnd->height,
+                         hnd->unaligned_width, hnd->unaligned_height, hnd->size, hnd->flags,
+                         hnd->usage, hnd->format});
+    }
+  }
+  for (auto &hnd : handles) {
+    *os << "handle id: " << std::setw(4) << hnd.id;
+    *os << " fd: " << std::setw(3) << hnd.fd;
+    *os << " fd_meta: " << std::setw(3) << hnd.fd_metadata;
+    *os << " wxh: " << std::setw(4) << hnd.width << " x " << std::setw(4) << hnd.height;
+    *os << " uwxuh: " << std::setw(4) << hnd.unaligned_width << " x ";
+    *os << std::setw(4) << hnd.unaligned_height;
+    *os << " size: " << std::setw(9) << hnd.size;
     *os << std::hex << std::setfill('0');
     *os << " priv_flags: "
-        << "0x" << std::setw(8) << hnd->flags;
+        << "0x" << std::setw(8) << hnd.flags;
     *os << " usage: "
-        << "0x" << std::setw(8) << hnd->usage;
+        << "0x" << std::setw(8) << hnd.usage;
     // TODO(user): get format string from qdutils
     *os << " format: "
-        << "0x" << std::setw(8) << hnd->format;
+        << "0x" << std::setw(8) << hnd.format;
     *os << std::dec << std::setfill(' ') << std::endl;
   }
   return Error::NONE;
 }
 
-// Get list of private handles in handles_map_
+// Get list of private handles in the handle map
 Error BufferManager::GetAllHandles(std::vector<const private_handle_t *> *out_handle_list) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
-  if (handles_map_.empty()) {
-    return Error::NO_RESOURCES;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (auto handle : shard.handles_map) {
+      out_handle_list->push_back(handle.first);
+    }
   }
-  out_handle_list->reserve(handles_map_.size());
-  for (auto handle : handles_map_) {
-    out_handle_list->push_back(handle.first);
+  if (out_handle_list->empty()) {
+    return Error::NO_RESOURCES;
   }
   return Error::NONE;
 }
 
 Error BufferManager::GetReservedRegion(private_handle_t *handle, void **reserved_region,
                                        uint64_t *reserved_region_size) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   if (!handle)
     return Error::BAD_BUFFER;
 
@@ -829,7 +899,7 @@ Error BufferManager::GetReservedRegion(private_handle_t *handle, void **reserved
 Error BufferManager::GetCustomContentMdRegion(private_handle_t *handle,
                                             void **custom_content_md_region,
                                             uint64_t *custom_content_md_region_size) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   if (!handle)
     return Error::BAD_BUFFER;
 
@@ -848,7 +918,7 @@ Error BufferManager::GetCustomContentMdRegion(private_handle_t *handle,
 
 Error BufferManager::GetMetadataValue(private_handle_t *handle, int64_t metadatatype_value,
                                       void *param) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
   if (!handle)
     return Error::BAD_BUFFER;
   auto buf = GetBufferFromHandleLocked(handle);
@@ -897,11 +967,71 @@ static Error GetCustomMetadataHelper(void *custom_content_md_region_ptr,
 }
 #endif
 
+// Metadata types derived from the handle or written once at allocation time. PLANE_LAYOUTS is
+// not one of them, it follows QTI_LINEAR_FORMAT once a producer marks the buffer linear.
+static const int64_t kImmutableMetadataTypes[] = {
+    (int64_t)StandardMetadataType::BUFFER_ID,
+    (int64_t)StandardMetadataType::NAME,
+    (int64_t)StandardMetadataType::WIDTH,
+    (int64_t)StandardMetadataType::HEIGHT,
+    (int64_t)StandardMetadataType::LAYER_COUNT,
+    (int64_t)StandardMetadataType::PIXEL_FORMAT_REQUESTED,
+    (int64_t)StandardMetadataType::PIXEL_FORMAT_FOURCC,
+    (int64_t)StandardMetadataType::PIXEL_FORMAT_MODIFIER,
+    (int64_t)StandardMetadataType::USAGE,
+    (int64_t)StandardMetadataType::ALLOCATION_SIZE,
+    (int64_t)StandardMetadataType::PROTECTED_CONTENT,
+    (int64_t)StandardMetadataType::COMPRESSION,
+};
+
+static_assert(std::size(kImmutableMetadataTypes) == BufferManager::kImmutableMetadataCount,
+              "Buffer has one encoded slot per immutable metadata type");
+
+int BufferManager::GetImmutableMetadataIndex(int64_t metadatatype_value) {
+  auto it = std::find(std::begin(kImmutableMetadataTypes), std::end(kImmutableMetadataTypes),
+                      metadatatype_value);
+  if (it == std::end(kImmutableMetadataTypes)) {
+    return -1;
+  }
+  return INT(it - std::begin(kImmutableMetadataTypes));
+}
+
 Error BufferManager::GetMetadata(private_handle_t *handle, int64_t metadatatype_value,
                                  hidl_vec<uint8_t> *out) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
   if (!handle)
     return Error::BAD_BUFFER;
+
+  int index = GetImmutableMetadataIndex(metadatatype_value);
+  if (index < 0) {
+    std::lock_guard<std::mutex> lock(GetShard(handle).lock);
+    return GetMetadataLocked(handle, metadatatype_value, out);
+  }
+
+  // Only the handle lookup takes the shard lock. Each immutable type is encoded on its first
+  // query, concurrent first queries wait for that one encode, and later queries copy the
+  // published bytes without any lock
+  std::shared_ptr<Buffer> buf;
+  {
+    std::lock_guard<std::mutex> lock(GetShard(handle).lock);
+    buf = GetBufferFromHandleLocked(handle);
+  }
+  if (buf == nullptr)
+    return Error::BAD_BUFFER;
+
+  auto &slot = buf->immutable_metadata[index];
+  std::call_once(slot.once, [&] {
+    std::lock_guard<std::mutex> lock(GetShard(handle).lock);
+    slot.error = GetMetadataLocked(handle, metadatatype_value, &slot.value);
+  });
+  if (slot.error != Error::NONE)
+    return slot.error;
+
+  *out = slot.value;
+  return Error::NONE;
+}
+
+Error BufferManager::GetMetadataLocked(private_handle_t *handle, int64_t metadatatype_value,
+                                       hidl_vec<uint8_t> *out) {
   auto buf = GetBufferFromHandleLocked(handle);
   if (buf == nullptr)
     return Error::BAD_BUFFER;
@@ -1412,7 +1542,7 @@ Error BufferManager::GetMetadata(private_handle_t *handle, int64_t metadatatype_
 
 Error BufferManager::SetMetadata(private_handle_t *handle, int64_t metadatatype_value,
                                  hidl_vec<uint8_t> in) {
-  std::lock_guard<std::mutex> lock(buffer_lock_);
+  std::lock_guard<std::mutex> lock(GetShard(handle).lock);
 
   if (!handle)
     return Error::BAD_BUFFER;
@@ -1708,6 +1838,17 @@ Error BufferManager::SetMetadata(private_handle_t *handle, int64_t metadatatype_
           true;
     }
   }
+#else
+  // Getters only check the set flags under METADATA_V2. Without it, flag just the payloads that
+  // CopyMetaDataDelta skips when clear, as libqdMetaData does for the same types.
+  if (IsDeltaCopyTracked(metadatatype_value)) {
+    if (IS_VENDOR_METADATA_TYPE(metadatatype_value)) {
+      metadata->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(metadatatype_value)] = true;
+    } else {
+      metadata->isStandardMetadataSet[GET_STANDARD_METADATA_STATUS_INDEX(metadatatype_value)] =
+          true;
+    }
+  }
 #endif
 
   return Error::NONE;
@@ -26,6 +26,7 @@
 
 #include <pthread.h>
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -76,6 +77,19 @@ class BufferManager {
   // Creates a Buffer from the valid private handle and adds it to the map
   void RegisterHandleLocked(const private_handle_t *hnd, int ion_handle, int ion_handle_meta);
 
+  // Encodes one metadata type of a registered buffer. Caller must hold the handle's shard lock
+  Error GetMetadataLocked(private_handle_t *handle, int64_t metadatatype_value,
+                          hidl_vec<uint8_t> *out);
+
+  // Metadata types that are fixed at allocation and are served from a per buffer encoded copy
+  static const size_t kImmutableMetadataCount = 12;
+  // Returns the slot of an immutable metadata type, or -1 for types that can change
+  static int GetImmutableMetadataIndex(int64_t metadatatype_value);
+
+  // Dumps all buffers once the imported size crosses the current threshold.
+  // Must be called without any handle map shard lock held
+  void CheckAllocThreshold();
+
   // Wrapper structure over private handle
   // Values associated with the private handle
   // that do not need to go over IPC can be placed here
@@ -99,17 +113,37 @@ class BufferManager {
     void *reserved_region_ptr = nullptr;
     uint64_t custom_content_md_size = 0;
     void *custom_content_md_region_ptr = nullptr;
+    // Encoded immutable metadata, one slot per type. A slot is encoded on the first query of its
+    // type and never changes afterwards, so later queries copy it without taking any lock
+    struct EncodedMetadata {
+      std::once_flag once;
+      Error error = Error::NONE;
+      hidl_vec<uint8_t> value;
+    };
+    EncodedMetadata immutable_metadata[kImmutableMetadataCount];
   };
 
   Error FreeBuffer(std::shared_ptr<Buffer> buf);
 
+  // The handle map is split into shards, each guarded by its own lock, so that lookups of
+  // unrelated buffers do not serialize on one process wide mutex. Allocation and import work
+  // is done outside of the shard locks; only publication of the handle is synchronized.
+  static const size_t kHandleMapShards = 16;
+  struct HandleMapShard {
+    std::mutex lock;
+    std::unordered_map<const private_handle_t *, std::shared_ptr<Buffer>> handles_map = {};
+  };
+  HandleMapShard &GetShard(const private_handle_t *hnd);
+
   // Get the wrapper Buffer object from the handle, returns nullptr if handle is not found
+  // Caller must hold the lock of the handle's shard
   std::shared_ptr<Buffer> GetBufferFromHandleLocked(const private_handle_t *hnd);
   Allocator *allocator_ = NULL;
-  std::mutex buffer_lock_;
-  std::unordered_map<const private_handle_t *, std::shared_ptr<Buffer>> handles_map_ = {};
+  HandleMapShard shards_[kHandleMapShards];
   std::atomic<uint64_t> next_id_;
-  uint64_t allocated_ = 0;
+  // Size of the imported buffers, updated without any lock
+  std::atomic<uint64_t> allocated_ = {0};
+  std::mutex alloc_threshold_lock_;  // Guards kAllocThreshold and the dump it triggers
   uint64_t kAllocThreshold = (uint64_t)1*1024*1024*1024;
   uint64_t kMemoryOffset = 50*1024*1024;
   struct {
@@ -118,16 +118,17 @@ int DmaManager::AllocBuffer(AllocData *data) {
   }
 
   ATRACE_BEGIN("GrallocAllocation");
-  dma_dev_fd_ = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
+  // Keep the fd local, AllocBuffer may run concurrently for different buffers
+  int fd = buffer_allocator_.Alloc(data->heap_name, data->size, flags, data->align);
   ATRACE_END();
-  if (dma_dev_fd_ < 0) {
-    ALOGE("libdma alloc failed ion_fd %d size %d align %d heap_name %s flags %x", dma_dev_fd_,
+  if (fd < 0) {
+    ALOGE("libdma alloc failed ion_fd %d size %d align %d heap_name %s flags %x", fd,
           data->size, data->align, data->heap_name.c_str(), flags);
-    return dma_dev_fd_;
+    return fd;
   }
 
-  data->fd = dma_dev_fd_;
-  data->ion_handle = dma_dev_fd_;
+  data->fd = fd;
+  data->ion_handle = fd;
   ALOGD_IF(enable_logs_, "libdma: Allocated buffer size:%u fd:%d", data->size, data->fd);
 
   return 0;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GR_METADATA_COPY_H__
+#define __GR_METADATA_COPY_H__
+
+#include <QtiGrallocPriv.h>
+#include <gralloctypes/Gralloc4.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace gralloc {
+
+// Payload types whose set flag decides whether CopyMetaDataDelta copies them.
+inline bool IsDeltaCopyTracked(int64_t type) {
+  switch (type) {
+    case QTI_UBWC_CR_STATS_INFO:
+    case QTI_GRAPHICS_METADATA:
+    case QTI_CVP_METADATA:
+    case QTI_VIDEO_HISTOGRAM_STATS:
+    case QTI_COLOR_METADATA:
+      return true;
+    default:
+      return type == static_cast<int64_t>(::android::gralloc4::MetadataType_Smpte2094_40.value);
+  }
+}
+
+// Copies src over dst, leaving out the large payloads whose set flag is clear in src. The set
+// paths maintain the flags, so an unset payload holds no valid data in src either and dst keeps
+// its own stale bytes instead. Readers that consume payloads without checking the flags need
+// full_copy, which copies the whole struct as before.
+inline void CopyMetaDataDelta(const MetaData_t *src, MetaData_t *dst, bool full_copy) {
+  if (full_copy) {
+    *dst = *src;
+    return;
+  }
+
+  struct Range {
+    size_t offset;
+    size_t size;
+  };
+
+  bool dynamic_payload_set =
+      src->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(QTI_COLOR_METADATA)] ||
+      src->isStandardMetadataSet[GET_STANDARD_METADATA_STATUS_INDEX(
+          ::android::gralloc4::MetadataType_Smpte2094_40.value)];
+
+  Range skip[5];
+  int count = 0;
+  if (!src->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(QTI_UBWC_CR_STATS_INFO)]) {
+    skip[count++] = {offsetof(MetaData_t, ubwcCRStats), sizeof(src->ubwcCRStats)};
+  }
+  if (!src->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(QTI_GRAPHICS_METADATA)]) {
+    skip[count++] = {offsetof(MetaData_t, graphics_metadata), sizeof(src->graphics_metadata)};
+  }
+  if (!src->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(QTI_CVP_METADATA)]) {
+    skip[count++] = {offsetof(MetaData_t, cvpMetadata), sizeof(src->cvpMetadata)};
+  }
+  if (!src->isVendorMetadataSet[GET_VENDOR_METADATA_STATUS_INDEX(QTI_VIDEO_HISTOGRAM_STATS)]) {
+    skip[count++] = {offsetof(MetaData_t, video_histogram_stats),
+                     sizeof(src->video_histogram_stats)};
+  }
+  if (!dynamic_payload_set) {
+    skip[count++] = {offsetof(MetaData_t, color) +
+                         offsetof(ColorMetaData, dynamicMetaDataPayload),
+                     sizeof(src->color.dynamicMetaDataPayload)};
+  }
+
+  std::sort(skip, skip + count,
+            [](const Range &a, const Range &b) { return a.offset < b.offset; });
+
+  auto src_bytes = reinterpret_cast<const uint8_t *>(src);
+  auto dst_bytes = reinterpret_cast<uint8_t *>(dst);
+  size_t offset = 0;
+  for (int i = 0; i < count; i++) {
+    memcpy(dst_bytes + offset, src_bytes + offset, skip[i].offset - offset);
+    offset = skip[i].offset + skip[i].size;
+  }
+  memcpy(dst_bytes + offset, src_bytes + offset, sizeof(MetaData_t) - offset);
+}
+
+}  // namespace gralloc
+
+#endif  // __GR_METADATA_COPY_H__
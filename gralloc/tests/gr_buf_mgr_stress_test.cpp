@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../gr_buf_mgr.h"
+
+using namespace gralloc;
+using ::android::hardware::hidl_vec;
+
+namespace {
+
+const uint32_t kThreads = 8;
+const uint32_t kBuffersPerThread = 8;
+const uint32_t kIterations = 2000;
+const uint32_t kRounds = 100;
+
+private_handle_t *Allocate(BufferManager *buf_mgr, uint64_t id) {
+  BufferDescriptor descriptor(id);
+  descriptor.SetDimensions(64, 64);
+  descriptor.SetColorFormat(HAL_PIXEL_FORMAT_RGBA_8888);
+  descriptor.SetLayerCount(1);
+  descriptor.SetUsage(BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN);
+  buffer_handle_t handle = nullptr;
+  if (buf_mgr->AllocateBuffer(descriptor, &handle) != Error::NONE) {
+    return nullptr;
+  }
+  return const_cast<private_handle_t *>(reinterpret_cast<const private_handle_t *>(handle));
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Each thread works on its own buffers, as producers and consumers of unrelated queues do. With
+// the sharded handle map the threads only meet when their handles hash to the same shard.
+TEST(BufferManagerStressTest, RetainLockReleaseOwnBuffers) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  std::atomic<uint32_t> failures = {0};
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < kThreads; t++) {
+    threads.emplace_back([buf_mgr, t, &failures] {
+      std::vector<private_handle_t *> handles;
+      for (uint32_t i = 0; i < kBuffersPerThread; i++) {
+        private_handle_t *hnd = Allocate(buf_mgr, t * kBuffersPerThread + i + 1);
+        if (!hnd) {
+          failures++;
+          return;
+        }
+        handles.push_back(hnd);
+      }
+
+      for (uint32_t n = 0; n < kIterations; n++) {
+        private_handle_t *hnd = handles[n % kBuffersPerThread];
+        hidl_vec<uint8_t> out;
+        uint64_t usage = static_cast<uint64_t>(BufferUsage::CPU_WRITE_OFTEN);
+        if (buf_mgr->RetainBuffer(hnd) != Error::NONE ||
+            buf_mgr->LockBuffer(hnd, usage) != Error::NONE ||
+            buf_mgr->UnlockBuffer(hnd) != Error::NONE ||
+            buf_mgr->GetMetadata(hnd, QTI_ALIGNED_WIDTH_IN_PIXELS, &out) != Error::NONE ||
+            buf_mgr->ReleaseBuffer(hnd) != Error::NONE) {
+          failures++;
+        }
+      }
+
+      for (auto hnd : handles) {
+        if (buf_mgr->ReleaseBuffer(hnd) != Error::NONE) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double elapsed_ms = ElapsedMs(start);
+
+  EXPECT_EQ(failures.load(), 0u);
+  printf("%u threads x %u iterations of retain/lock/unlock/get/release: %.1f ms\n", kThreads,
+         kIterations, elapsed_ms);
+}
+
+// Allocation and free run outside of the shard locks, concurrent allocations must neither fail
+// nor hand out the same handle twice.
+TEST(BufferManagerStressTest, ConcurrentAllocateRelease) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  std::atomic<uint32_t> failures = {0};
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < kThreads; t++) {
+    threads.emplace_back([buf_mgr, t, &failures] {
+      for (uint32_t n = 0; n < kRounds; n++) {
+        private_handle_t *hnd = Allocate(buf_mgr, t * kRounds + n + 1);
+        if (!hnd || buf_mgr->IsBufferImported(hnd) != Error::NONE ||
+            buf_mgr->ReleaseBuffer(hnd) != Error::NONE) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double elapsed_ms = ElapsedMs(start);
+
+  EXPECT_EQ(failures.load(), 0u);
+  printf("%u threads x %u allocate/release: %.1f ms\n", kThreads, kRounds, elapsed_ms);
+}
+
+// Retains and releases racing on one buffer keep its reference count balanced.
+TEST(BufferManagerStressTest, ConcurrentRetainReleaseOfOneBuffer) {
+  BufferManager *buf_mgr = BufferManager::GetInstance();
+  private_handle_t *hnd = Allocate(buf_mgr, 1);
+  ASSERT_NE(hnd, nullptr);
+
+  std::atomic<uint32_t> failures = {0};
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kThreads; t++) {
+    threads.emplace_back([buf_mgr, hnd, &failures] {
+      for (uint32_t n = 0; n < kIterations; n++) {
+        if (buf_mgr->RetainBuffer(hnd) != Error::NONE ||
+            buf_mgr->ReleaseBuffer(hnd) != Error::NONE) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(failures.load(), 0u);
+  EXPECT_EQ(buf_mgr->IsBufferImported(hnd), Error::NONE);
+  EXPECT_EQ(buf_mgr->ReleaseBuffer(hnd), Error::NONE);
+}
+
+}  // namespace
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <QtiGralloc.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "../gr_buf_mgr.h"
+#include "../gr_metadata_copy.h"
+
+using namespace gralloc;
+using ::android::hardware::hidl_vec;
+using IMapper_4_0_Error = ::android::hardware::graphics::mapper::V4_0::Error;
+
+namespace {
+
+// Payloads are set through BufferManager::SetMetadata, the IMapper set path, on real buffers.
+class MetaDataCopyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    buf_mgr_ = BufferManager::GetInstance();
+    for (uint32_t i = 0; i < 2; i++) {
+      BufferDescriptor descriptor(i + 1);
+      descriptor.SetDimensions(64, 64);
+      descriptor.SetColorFormat(HAL_PIXEL_FORMAT_RGBA_8888);
+      descriptor.SetLayerCount(1);
+      descriptor.SetUsage(BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN);
+      buffer_handle_t handle = nullptr;
+      ASSERT_EQ(buf_mgr_->AllocateBuffer(descriptor, &handle), Error::NONE);
+      handles_[i] = const_cast<private_handle_t *>(
+          reinterpret_cast<const private_handle_t *>(handle));
+    }
+  }
+
+  void TearDown() override {
+    for (auto handle : handles_) {
+      if (handle) {
+        buf_mgr_->ReleaseBuffer(handle);
+      }
+    }
+  }
+
+  MetaData_t *GetMetaData(uint32_t index) {
+    return reinterpret_cast<MetaData_t *>(handles_[index]->base_metadata);
+  }
+
+  void Copy(bool full_copy) { CopyMetaDataDelta(GetMetaData(0), GetMetaData(1), full_copy); }
+
+  static hidl_vec<uint8_t> GraphicsPayload(uint8_t seed) {
+    hidl_vec<uint8_t> payload;
+    payload.resize(GRAPHICS_METADATA_SIZE_IN_BYTES);
+    for (size_t i = 0; i < payload.size(); i++) {
+      payload[i] = uint8_t(seed + i * 7);
+    }
+    return payload;
+  }
+
+  BufferManager *buf_mgr_ = nullptr;
+  private_handle_t *handles_[2] = {};
+};
+
+TEST_F(MetaDataCopyTest, GraphicsMetadataSetThroughMapperIsCopied) {
+  hidl_vec<uint8_t> payload = GraphicsPayload(3);
+  ASSERT_EQ(buf_mgr_->SetMetadata(handles_[0], QTI_GRAPHICS_METADATA, payload), Error::NONE);
+
+  Copy(false);
+
+  hidl_vec<uint8_t> out;
+  ASSERT_EQ(buf_mgr_->GetMetadata(handles_[1], QTI_GRAPHICS_METADATA, &out), Error::NONE);
+  ASSERT_EQ(out.size(), payload.size());
+  EXPECT_EQ(memcmp(out.data(), payload.data(), payload.size()), 0);
+}
+
+TEST_F(MetaDataCopyTest, HdrDynamicPayloadSetThroughMapperIsCopied) {
+  ColorMetaData color = {};
+  color.colorPrimaries = ColorPrimaries_BT2020;
+  color.transfer = Transfer_SMPTE_ST2084;
+  color.dynamicMetaDataValid = true;
+  color.dynamicMetaDataLen = 64;
+  for (uint32_t i = 0; i < color.dynamicMetaDataLen; i++) {
+    color.dynamicMetaDataPayload[i] = uint8_t(i + 1);
+  }
+  hidl_vec<uint8_t> in;
+  ASSERT_EQ(qtigralloc::encodeColorMetadata(color, &in), IMapper_4_0_Error::NONE);
+  ASSERT_EQ(buf_mgr_->SetMetadata(handles_[0], QTI_COLOR_METADATA, in), Error::NONE);
+
+  Copy(false);
+
+  const ColorMetaData &copied = GetMetaData(1)->color;
+  EXPECT_EQ(copied.colorPrimaries, ColorPrimaries_BT2020);
+  EXPECT_TRUE(copied.dynamicMetaDataValid);
+  ASSERT_EQ(copied.dynamicMetaDataLen, 64u);
+  EXPECT_EQ(memcmp(copied.dynamicMetaDataPayload, color.dynamicMetaDataPayload, 64), 0);
+}
+
+TEST_F(MetaDataCopyTest, UnsetPayloadKeepsDestination) {
+  // Only the destination holds graphics metadata, a delta copy from a source that never set it
+  // leaves it alone, a full copy does not.
+  hidl_vec<uint8_t> payload = GraphicsPayload(11);
+  ASSERT_EQ(buf_mgr_->SetMetadata(handles_[1], QTI_GRAPHICS_METADATA, payload), Error::NONE);
+
+  Copy(false);
+  hidl_vec<uint8_t> out;
+  ASSERT_EQ(buf_mgr_->GetMetadata(handles_[1], QTI_GRAPHICS_METADATA, &out), Error::NONE);
+  EXPECT_EQ(memcmp(out.data(), payload.data(), payload.size()), 0);
+
+  Copy(true);
+  ASSERT_EQ(buf_mgr_->GetMetadata(handles_[1], QTI_GRAPHICS_METADATA, &out), Error::NONE);
+  EXPECT_NE(memcmp(out.data(), payload.data(), payload.size()), 0);
+}
+
+}  // namespace
@@ -45,13 +45,23 @@ void QHDMIClient::binderDied(const wp<IBinder>& who __unused)
 void QHDMIClient::onHdmiHotplug(int connected)
 {
     ALOGD("%s: HDMI connected event connected: %d", __FUNCTION__, connected);
-    cec_hdmi_hotplug(mCtx, connected);
+    std::lock_guard<std::mutex> lock(mCtxLock);
+    if (mCtx)
+        cec_hdmi_hotplug(mCtx, connected);
 }
 
 void QHDMIClient::onCECMessageRecieved(char *msg, ssize_t len)
 {
     ALOGD_IF(DEBUG, "%s: CEC message received len: %zd", __FUNCTION__, len);
-    cec_receive_message(mCtx, msg, len);
+    std::lock_guard<std::mutex> lock(mCtxLock);
+    if (mCtx)
+        cec_receive_message(mCtx, msg, len);
+}
+
+void QHDMIClient::setCECContext(cec_context_t* ctx)
+{
+    std::lock_guard<std::mutex> lock(mCtxLock);
+    mCtx = ctx;
 }
 
 void QHDMIClient::registerClient(sp<QHDMIClient>& client)
@@ -30,6 +30,7 @@
 #include "IQHDMIClient.h"
 #include "qhdmi_cec.h"
 #include <IQService.h>
+#include <mutex>
 
 namespace qClient {
 
@@ -45,12 +46,15 @@ public:
 
     virtual void onCECMessageRecieved(char *msg, ssize_t len);
 
-    void setCECContext(qhdmicec::cec_context_t* ctx) { mCtx = ctx; }
+    // Events from the binder threads are dropped once the context is reset to NULL. Returns
+    // only after a callback using the previous context has finished.
+    void setCECContext(qhdmicec::cec_context_t* ctx);
 
     void registerClient(android::sp<QHDMIClient>& client);
 
 private:
-    qhdmicec::cec_context_t* mCtx;
+    std::mutex mCtxLock;
+    qhdmicec::cec_context_t* mCtx = NULL;
     android::sp<qService::IQService> mQService;
 
 };
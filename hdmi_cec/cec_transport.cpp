@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <future>
+
+#include "cec_transport.h"
+
+namespace qhdmicec {
+
+int CecTransport::open(const char *sysfs_path)
+{
+    close();
+
+    // Later changes arrive as hotplug events.
+    bool connected = false;
+    std::string path = std::string(sysfs_path) + "/connected";
+    int connected_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (connected_fd >= 0) {
+        char data[16] = {};
+        if (read(connected_fd, data, sizeof(data) - 1) > 0) {
+            connected = (atoi(data) > 0);
+        }
+        ::close(connected_fd);
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mWritePath = std::string(sysfs_path) + "/cec/wr_msg";
+    mConnected = connected;
+    mExit = false;
+    mWorker = std::thread(&CecTransport::workerLoop, this);
+    // A node which is not there yet is opened again by the next send.
+    return openWriteNodeLocked();
+}
+
+void CecTransport::close()
+{
+    std::deque<Request> pending;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mWorker.joinable()) {
+            return;
+        }
+        mExit = true;
+    }
+    mCondition.notify_all();
+    mWorker.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        pending.swap(mQueue);
+        if (mWriteFd >= 0) {
+            ::close(mWriteFd);
+            mWriteFd = -1;
+        }
+        mWritePath.clear();
+    }
+    for (auto &request : pending) {
+        request.done(-ECANCELED);
+    }
+}
+
+int CecTransport::openWriteNodeLocked()
+{
+    if (mWriteFd >= 0) {
+        return 0;
+    }
+    if (mWritePath.empty()) {
+        return -ENOTCONN;
+    }
+
+    mWriteFd = ::open(mWritePath.c_str(), O_WRONLY | O_CLOEXEC);
+    if (mWriteFd < 0) {
+        int err = -errno;
+        ALOGE("%s: Failed to open %s: %s", __FUNCTION__, mWritePath.c_str(), strerror(errno));
+        return err;
+    }
+    return 0;
+}
+
+bool CecTransport::isOpen()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return openWriteNodeLocked() == 0;
+}
+
+void CecTransport::setConnected(bool connected)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    mConnected = connected;
+}
+
+bool CecTransport::isConnected()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mConnected;
+}
+
+int CecTransport::send(const char *frame, size_t len, Completion done)
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mConnected) {
+            return -ENOTCONN;
+        }
+        int err = openWriteNodeLocked();
+        if (err) {
+            return err;
+        }
+        if (mQueue.size() >= kMaxQueuedFrames) {
+            return -EBUSY;
+        }
+        mQueue.push_back({std::string(frame, len), done});
+    }
+    mCondition.notify_one();
+    return 0;
+}
+
+int CecTransport::sendSync(const char *frame, size_t len)
+{
+    std::promise<int> result;
+    std::future<int> future = result.get_future();
+    int err = send(frame, len, [&result](int status) { result.set_value(status); });
+    if (err) {
+        return err;
+    }
+    return future.get();
+}
+
+ssize_t CecTransport::writeFrame(const char *frame, size_t len)
+{
+    // sysfs hands every write to the driver as a complete message, the offset is irrelevant.
+    ssize_t ret = pwrite(mWriteFd, frame, len, 0);
+    return (ret < 0) ? -errno : ret;
+}
+
+int CecTransport::transmit(const std::string &frame)
+{
+    int backoff_us = mInitialBackoffUs;
+    ssize_t err = 0;
+    // The HAL spec requires at least one retry of a busy line.
+    for (int attempt = 0; ; attempt++) {
+        err = writeFrame(frame.data(), frame.size());
+        if (err != -EAGAIN || attempt == kMaxBusyRetries) {
+            break;
+        }
+        ALOGD("%s: CEC line busy, retrying in %d us", __FUNCTION__, backoff_us);
+        std::unique_lock<std::mutex> lock(mLock);
+        if (mCondition.wait_for(lock, std::chrono::microseconds(backoff_us),
+                                [this] { return mExit; })) {
+            return -ECANCELED;
+        }
+        backoff_us *= 2;
+    }
+
+    return (err < 0) ? (int) err : 0;
+}
+
+void CecTransport::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCondition.wait(lock, [this] { return mExit || !mQueue.empty(); });
+        if (mExit) {
+            return;
+        }
+
+        Request request = std::move(mQueue.front());
+        mQueue.pop_front();
+        bool connected = mConnected;
+        lock.unlock();
+        // Frames queued before an unplug are dropped instead of waiting on a dead line.
+        request.done(connected ? transmit(request.frame) : -ENOTCONN);
+        lock.lock();
+    }
+}
+
+}; //namespace qhdmicec
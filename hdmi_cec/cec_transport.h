@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef CEC_TRANSPORT_H
+#define CEC_TRANSPORT_H
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace qhdmicec {
+
+// Sends CEC frames to the driver through cec/wr_msg. The sysfs node stays open for the lifetime
+// of the transport and the connection state is tracked from hotplug events, so a send costs one
+// write. Frames are queued to a worker thread which retries a busy line with exponential backoff
+// and reports the outcome to the completion callback: 0 on success or a negative errno, -ENXIO
+// for a NACK and -EAGAIN if the line stayed busy.
+class CecTransport {
+public:
+    typedef std::function<void(int result)> Completion;
+
+    static const size_t kMaxQueuedFrames = 16;
+    static const int kMaxBusyRetries = 4;
+    static const int kInitialBackoffUs = 2000;
+
+    virtual ~CecTransport() { close(); }
+
+    // Opens the CEC nodes below sysfs_path, reads the initial connection state and starts the
+    // worker. If cec/wr_msg fails to open, its error is returned and the node is opened again by
+    // the next send() or isOpen().
+    int open(const char *sysfs_path);
+    void close();
+    bool isOpen();
+
+    void setConnected(bool connected);
+    bool isConnected();
+    // Backoff before the first retry of a busy line, doubled for every further retry.
+    void setInitialBackoff(int backoff_us) { mInitialBackoffUs = backoff_us; }
+
+    // Queues a frame, done is called from the worker thread. Fails right away with -ENOTCONN
+    // when no sink is connected, the open error of cec/wr_msg when it still can not be opened
+    // and -EBUSY when the queue is full.
+    int send(const char *frame, size_t len, Completion done);
+    // Queues a frame and waits for its outcome.
+    int sendSync(const char *frame, size_t len);
+
+protected:
+    // Hands one frame to the driver, returns the bytes written or a negative errno.
+    virtual ssize_t writeFrame(const char *frame, size_t len);
+
+private:
+    struct Request {
+        std::string frame;
+        Completion done;
+    };
+
+    int openWriteNodeLocked();
+    void workerLoop();
+    int transmit(const std::string &frame);
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<Request> mQueue;
+    std::thread mWorker;
+    bool mExit = false;
+    bool mConnected = false;
+    std::string mWritePath;
+    int mWriteFd = -1;
+    int mInitialBackoffUs = kInitialBackoffUs;
+};
+
+}; //namespace qhdmicec
+#endif /* end of include guard: CEC_TRANSPORT_H */
@@ -38,6 +38,8 @@ namespace qClient {
 
 namespace qhdmicec {
 
+class CecTransport;
+
 #define SYSFS_BASE  "/sys/class/graphics/fb"
 #define MAX_PATH_LENGTH  128
 
@@ -65,6 +67,7 @@ struct cec_context_t {
     int version;
     uint32_t vendor_id;
     android::sp<qClient::QHDMIClient> disp_client;
+    CecTransport *transport;     // Sends messages to the driver
 };
 
 void cec_receive_message(cec_context_t *ctx, char *msg, ssize_t len);
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../cec_transport.h"
+
+using namespace qhdmicec;
+
+namespace {
+
+// Mimics the fb sysfs directory of the HDMI panel with regular files.
+class FakeSysfs {
+public:
+    FakeSysfs() {
+        char path[] = "/tmp/cec_sysfs_XXXXXX";
+        mRoot = mkdtemp(path);
+        mkdir((mRoot + "/cec").c_str(), 0700);
+        writeFile("/cec/wr_msg", "");
+    }
+
+    ~FakeSysfs() {
+        unlink((mRoot + "/cec/wr_msg").c_str());
+        unlink((mRoot + "/connected").c_str());
+        rmdir((mRoot + "/cec").c_str());
+        rmdir(mRoot.c_str());
+    }
+
+    void writeFile(const std::string &node, const std::string &data) {
+        FILE *fp = fopen((mRoot + node).c_str(), "w");
+        fputs(data.c_str(), fp);
+        fclose(fp);
+    }
+
+    std::string readFile(const std::string &node) {
+        std::string data;
+        FILE *fp = fopen((mRoot + node).c_str(), "r");
+        int c;
+        while ((c = fgetc(fp)) != EOF) {
+            data.push_back((char) c);
+        }
+        fclose(fp);
+        return data;
+    }
+
+    const char *root() const { return mRoot.c_str(); }
+
+private:
+    std::string mRoot;
+};
+
+// Fails the first writes with a scripted error before handing frames to the fake node.
+class ScriptedTransport : public CecTransport {
+public:
+    ~ScriptedTransport() { close(); }
+
+    void failWrites(int count, int err) {
+        mFailCount = count;
+        mFailErr = err;
+    }
+    int getWrites() const { return mWrites; }
+    const std::vector<std::chrono::steady_clock::time_point> &getTimes() const { return mTimes; }
+
+protected:
+    ssize_t writeFrame(const char *frame, size_t len) override {
+        mWrites++;
+        mTimes.push_back(std::chrono::steady_clock::now());
+        if (mFailCount > 0) {
+            mFailCount--;
+            return -mFailErr;
+        }
+        return CecTransport::writeFrame(frame, len);
+    }
+
+private:
+    int mFailCount = 0;
+    int mFailErr = 0;
+    std::atomic<int> mWrites{0};
+    std::vector<std::chrono::steady_clock::time_point> mTimes;
+};
+
+TEST(CecTransportTest, ConnectionState) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1\n");
+    CecTransport transport;
+    EXPECT_FALSE(transport.isOpen());
+    EXPECT_EQ(transport.sendSync("x", 1), -ENOTCONN);
+
+    ASSERT_EQ(transport.open(sysfs.root()), 0);
+    EXPECT_TRUE(transport.isOpen());
+    EXPECT_TRUE(transport.isConnected());
+
+    // The node is read once, hotplug events drive the state afterwards.
+    sysfs.writeFile("/connected", "0\n");
+    EXPECT_TRUE(transport.isConnected());
+    transport.setConnected(false);
+    EXPECT_EQ(transport.sendSync("x", 1), -ENOTCONN);
+
+    FakeSysfs missing;
+    unlink((std::string(missing.root()) + "/cec/wr_msg").c_str());
+    CecTransport broken;
+    EXPECT_EQ(broken.open(missing.root()), -ENOENT);
+}
+
+TEST(CecTransportTest, FramesReachTheDriverNode) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1");
+    CecTransport transport;
+    ASSERT_EQ(transport.open(sysfs.root()), 0);
+
+    EXPECT_EQ(transport.sendSync("\x04\x00\x36", 3), 0);
+    EXPECT_EQ(sysfs.readFile("/cec/wr_msg"), std::string("\x04\x00\x36", 3));
+    // Every frame is written at the start of the node through the same fd.
+    EXPECT_EQ(transport.sendSync("\x04\x0f", 2), 0);
+    EXPECT_EQ(sysfs.readFile("/cec/wr_msg"), std::string("\x04\x0f\x36", 3));
+}
+
+TEST(CecTransportTest, SendOpensTheNodeAgain) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1");
+    std::string node = std::string(sysfs.root()) + "/cec/wr_msg";
+    unlink(node.c_str());
+    CecTransport transport;
+    EXPECT_EQ(transport.open(sysfs.root()), -ENOENT);
+    EXPECT_FALSE(transport.isOpen());
+    EXPECT_EQ(transport.sendSync("x", 1), -ENOENT);
+
+    // The driver node shows up after the HAL was opened.
+    sysfs.writeFile("/cec/wr_msg", "");
+    EXPECT_EQ(transport.sendSync("\x04\x36", 2), 0);
+    EXPECT_EQ(sysfs.readFile("/cec/wr_msg"), std::string("\x04\x36", 2));
+    EXPECT_TRUE(transport.isOpen());
+}
+
+TEST(CecTransportTest, AsynchronousCompletion) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1");
+    ScriptedTransport transport;
+    ASSERT_EQ(transport.open(sysfs.root()), 0);
+
+    std::vector<std::promise<int>> results(3);
+    for (size_t i = 0; i < results.size(); i++) {
+        std::promise<int> *result = &results[i];
+        ASSERT_EQ(transport.send("m", 1, [result](int status) { result->set_value(status); }), 0);
+    }
+    for (auto &result : results) {
+        std::future<int> future = result.get_future();
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+        EXPECT_EQ(future.get(), 0);
+    }
+    EXPECT_EQ(transport.getWrites(), 3);
+}
+
+TEST(CecTransportTest, BusyLineBacksOff) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1");
+    ScriptedTransport transport;
+    transport.setInitialBackoff(1000);
+    ASSERT_EQ(transport.open(sysfs.root()), 0);
+
+    // Busy twice, then sent.
+    transport.failWrites(2, EAGAIN);
+    EXPECT_EQ(transport.sendSync("m", 1), 0);
+    ASSERT_EQ(transport.getWrites(), 3);
+    const auto &times = transport.getTimes();
+    EXPECT_GE(times[1] - times[0], std::chrono::microseconds(1000));
+    EXPECT_GE(times[2] - times[1], std::chrono::microseconds(2000));
+
+    // A line that stays busy is given up after the bounded number of retries.
+    transport.failWrites(100, EAGAIN);
+    EXPECT_EQ(transport.sendSync("m", 1), -EAGAIN);
+    EXPECT_EQ(transport.getWrites(), 3 + 1 + CecTransport::kMaxBusyRetries);
+
+    // A NACK is not retried.
+    transport.failWrites(1, ENXIO);
+    EXPECT_EQ(transport.sendSync("m", 1), -ENXIO);
+    EXPECT_EQ(transport.getWrites(), 3 + 1 + CecTransport::kMaxBusyRetries + 1);
+}
+
+TEST(CecTransportTest, QueueIsBoundedAndCancelledOnClose) {
+    FakeSysfs sysfs;
+    sysfs.writeFile("/connected", "1");
+    ScriptedTransport transport;
+    transport.setInitialBackoff(50000);
+    ASSERT_EQ(transport.open(sysfs.root()), 0);
+
+    // The first frame occupies the worker with backoff, the rest pile up.
+    transport.failWrites(100, EAGAIN);
+    std::vector<int> results;
+    std::mutex results_lock;
+    auto done = [&](int status) {
+        std::lock_guard<std::mutex> lock(results_lock);
+        results.push_back(status);
+    };
+    ASSERT_EQ(transport.send("m", 1, done), 0);
+    int queued = 1;
+    int rejected = 0;
+    // Wait for the worker to pick up the first frame.
+    while (transport.getWrites() == 0) {
+        usleep(1000);
+    }
+    for (size_t i = 0; i < CecTransport::kMaxQueuedFrames + 3; i++) {
+        if (transport.send("m", 1, done) == 0) {
+            queued++;
+        } else {
+            rejected++;
+        }
+    }
+    EXPECT_EQ(rejected, 3);
+
+    // Closing does not wait out the backoff of the frame in flight.
+    auto start = std::chrono::steady_clock::now();
+    transport.close();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+    EXPECT_EQ(results.size(), (size_t) queued);
+    int cancelled = 0;
+    for (int status : results) {
+        cancelled += (status == -ECANCELED);
+    }
+    EXPECT_EQ(cancelled, queued);
+}
+
+}  // namespace
@@ -173,8 +173,12 @@
 #define DISABLE_DYNAMIC_FPS                  DISPLAY_PROP("disable_dynamic_fps")
 #define ENABLE_QSYNC_IDLE                    DISPLAY_PROP("enable_qsync_idle")
 #define ENHANCE_IDLE_TIME                    DISPLAY_PROP("enhance_idle_time")
+#define ENABLE_ADAPTIVE_IDLE_TIMEOUT         DISPLAY_PROP("enable_adaptive_idle_timeout")
+#define ADAPTIVE_IDLE_POWER_BIAS             DISPLAY_PROP("adaptive_idle_power_bias")
 
 #define MMRM_FLOOR_CLK_VOTE                  DISPLAY_PROP("mmrm_floor_vote")
+#define ENABLE_QOS_PREDICTION                DISPLAY_PROP("enable_qos_prediction")
+#define MAX_DAMAGE_RECTS                     DISPLAY_PROP("max_damage_rects")
 
 // DPPS dynamic fps
 #define ENABLE_DPPS_DYNAMIC_FPS              DISPLAY_PROP("enable_dpps_dynamic_fps")
@@ -197,6 +201,7 @@
 #define DISABLE_AHARDWARE_BUFFER_PROP        GRALLOC_PROP("disable_ahardware_buffer")
 #define DISABLE_UBWC_PROP                    GRALLOC_PROP("disable_ubwc")
 #define ENABLE_LOGS_PROP                     GRALLOC_PROP("enable_logs")
+#define FULL_METADATA_COPY_PROP              GRALLOC_PROP("full_metadata_copy")
 #define SECURE_PREVIEW_BUFFER_FORMAT_PROP    GRALLOC_PROP("secure_preview_buffer_format")
 #define SECURE_PREVIEW_ONLY_PROP             GRALLOC_PROP("secure_preview_only")
 #define USE_DMA_BUF_HEAPS_PROP               GRALLOC_PROP("use_dma_buf_heaps")
@@ -220,6 +225,11 @@
 #define PRIORITIZE_CLIENT_CWB                DISPLAY_PROP("prioritize_client_cwb")
 #define TRANSIENT_FPS_CYCLE_COUNT            DISPLAY_PROP("transient_fps_cycle_count")
 #define FORCE_LM_TO_FB_CONFIG                DISPLAY_PROP("force_lm_to_fb_config")
+#define USE_CPU_BLIT_PROP                    DISPLAY_PROP("use_cpu_blit")
+#define ENABLE_CADENCE_REFRESH_RATE_PROP     DISPLAY_PROP("enable_cadence_refresh_rate")
+#define ENABLE_FRAME_COST_PERF_HINT          DISPLAY_PROP("enable_frame_cost_perf_hint")
+#define ENABLE_HW_INFO_SNAPSHOT_PROP         DISPLAY_PROP("enable_hw_info_snapshot")
+#define LAYER_STACK_TRACE_FRAMES_PROP       DISPLAY_PROP("layer_stack_trace_frames")
 
 // Add all other.properties above
 // End of property
@@ -33,7 +33,10 @@
 #include <errno.h>
 #include <gralloc_priv.h>
 #ifndef __QTI_NO_GRALLOC4__
+#include <cutils/properties.h>
+#include <display_properties.h>
 #include <gralloctypes/Gralloc4.h>
+#include <gr_metadata_copy.h>
 #endif
 #include <log/log.h>
 #include <string.h>
@@ -227,6 +230,16 @@ static void setGralloc4Array(MetaData_t *metadata, int32_t paramType, bool isSet
 #endif
 
 
+// Copies only the payloads marked as set in src unless a full struct copy is requested
+static void copyMetaDataStruct(const MetaData_t *src_data, MetaData_t *dst_data) {
+#ifndef __QTI_NO_GRALLOC4__
+    static const bool full_copy = property_get_bool(FULL_METADATA_COPY_PROP, 0);
+    gralloc::CopyMetaDataDelta(src_data, dst_data, full_copy);
+#else
+    *dst_data = *src_data;
+#endif
+}
+
 unsigned long getMetaDataSize() {
     return static_cast<unsigned long>(ROUND_UP_PAGESIZE(sizeof(MetaData_t)));
 }
@@ -582,7 +595,7 @@ int copyMetaData(struct private_handle_t *src, struct private_handle_t *dst) {
 
     MetaData_t *src_data = reinterpret_cast <MetaData_t *>(src->base_metadata);
     MetaData_t *dst_data = reinterpret_cast <MetaData_t *>(dst->base_metadata);
-    *dst_data = *src_data;
+    copyMetaDataStruct(src_data, dst_data);
     return 0;
 }
 
@@ -596,7 +609,7 @@ int copyMetaDataVaToHandle(MetaData_t *src_data, struct private_handle_t *dst) {
         return err;
 
     MetaData_t *dst_data = reinterpret_cast <MetaData_t *>(dst->base_metadata);
-    *dst_data = *src_data;
+    copyMetaDataStruct(src_data, dst_data);
     return 0;
 }
 
@@ -610,7 +623,7 @@ int copyMetaDataHandleToVa(struct private_handle_t *src, MetaData_t *dst_data) {
         return err;
 
     MetaData_t *src_data = reinterpret_cast <MetaData_t *>(src->base_metadata);
-    *dst_data = *src_data;
+    copyMetaDataStruct(src_data, dst_data);
     return 0;
 }
 
@@ -622,7 +635,7 @@ int copyMetaDataVaToVa(MetaData_t *src_data, MetaData_t *dst_data) {
     if (dst_data == nullptr)
         return err;
 
-    *dst_data = *src_data;
+    copyMetaDataStruct(src_data, dst_data);
     return 0;
 }
 
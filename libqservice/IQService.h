@@ -126,6 +126,8 @@ public:
       SET_JITTER_CONFIG = 58,                  // Watchdog TE Jitter Configuration
       RETRIEVE_DEMURATN_FILES = 59,            // Retrieve DemuraTn files from TVM
       SET_DEMURA_STATE = 60,                   // Enable/disable demura feature
+      GET_FRAME_LATENCY_STATS = 61,            // Get per-stage frame latency histograms
+      RESET_FRAME_LATENCY_STATS = 62,          // Reset per-stage frame latency histograms
       COMMAND_LIST_END = 400,
     };
 
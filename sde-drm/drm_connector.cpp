@@ -997,26 +997,20 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
   }
 
   SetSkipConnectorReload(false);  // Reset skip_connector_reload_ setting.
-  info->modes.clear();
   if (!drm_connector_->count_modes) {
     DRM_LOGW("Zero modes on connector %u.", conn_id);
+  } else if (!drm_connector_->modes) {
+    DLOGW("Connector %u not found.", conn_id);
+    info->modes.clear();
+    return 0;
   }
 
-  for (auto i = 0; i < drm_connector_->count_modes; i++) {
-    DRMModeInfo modes_item {};
-    if (!drm_connector_->modes) {
-      DLOGW("Connector %u not found.", conn_id);
-      return 0;
-    }
-    modes_item.mode = drm_connector_->modes[i];
-    info->modes.push_back(modes_item);
+  if (drm_connector_->connection != last_connection_) {
+    // Blobs are dropped on connect and disconnect and the kernel may recycle their ids, so a
+    // connection change invalidates everything parsed so far.
+    last_connection_ = drm_connector_->connection;
+    hotplug_epoch_++;
   }
-  info->mmWidth = drm_connector_->mmWidth;
-  info->mmHeight = drm_connector_->mmHeight;
-  info->type = drm_connector_->connector_type;
-  info->type_id = drm_connector_->connector_type_id;
-  info->is_connected = IsConnected();
-  info->is_reserved = GetStatus() == DRMStatus::BUSY ? true : false;
 
   drmModeObjectProperties *props =
       drmModeObjectGetProperties(fd_, drm_connector_->connector_id, DRM_MODE_OBJECT_CONNECTOR);
@@ -1025,72 +1019,118 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
     return -ENODEV;
   }
 
-  uint32_t index = UINT32_MAX;
+  uint64_t caps_blob_id = 0, hdr_blob_id = 0, mode_blob_id = 0, ext_hdr_blob_id = 0;
+  uint64_t edid_blob_id = 0, panel_id_blob_id = 0, topology_control = 0, colorspaces = 0;
+  GetPropertyValue(props, DRMProperty::CAPABILITIES, &caps_blob_id);
+  GetPropertyValue(props, DRMProperty::HDR_PROPERTIES, &hdr_blob_id);
+  GetPropertyValue(props, DRMProperty::MODE_PROPERTIES, &mode_blob_id);
+  GetPropertyValue(props, DRMProperty::EXT_HDR_PROPERTIES, &ext_hdr_blob_id);
+  GetPropertyValue(props, DRMProperty::EDID, &edid_blob_id);
+  GetPropertyValue(props, DRMProperty::DEMURA_PANEL_ID, &panel_id_blob_id);
+  GetPropertyValue(props, DRMProperty::TOPOLOGY_CONTROL, &topology_control);
+  GetPropertyValue(props, DRMProperty::SUPPORTED_COLORSPACES, &colorspaces);
+  drmModeFreeObjectProperties(props);
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->panel_hdr_prop);
+  // Blobs are immutable, so a blob whose id has not changed within an epoch is not parsed again.
+  InfoSnapshot &snapshot = info_snapshot_;
+  bool full_parse = !snapshot.valid || (snapshot.hotplug_epoch != hotplug_epoch_) ||
+                    (snapshot.caps_blob_id != caps_blob_id);
+  if (full_parse) {
+    snapshot = {};
+  }
+
+  snapshot.info.mmWidth = drm_connector_->mmWidth;
+  snapshot.info.mmHeight = drm_connector_->mmHeight;
+  snapshot.info.type = drm_connector_->connector_type;
+  snapshot.info.type_id = drm_connector_->connector_type_id;
+  snapshot.info.is_connected = IsConnected();
+  snapshot.info.is_reserved = GetStatus() == DRMStatus::BUSY ? true : false;
+  snapshot.info.topology_control = static_cast<uint32_t>(topology_control);
+  snapshot.info.supported_colorspaces = static_cast<uint32_t>(colorspaces);
+
+  if (full_parse || (snapshot.hdr_blob_id != hdr_blob_id)) {
+    snapshot.info.panel_hdr_prop = {};
+    if (hdr_blob_id) {
+      ParseCapabilities(hdr_blob_id, &snapshot.info.panel_hdr_prop);
+    }
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::CAPABILITIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::CAPABILITIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], info);
+  if (full_parse && caps_blob_id) {
+    ParseCapabilities(caps_blob_id, &snapshot.info);
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::MODE_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::MODE_PROPERTIES)));
-    if (index < props->count_props)
-      ParseModeProperties(props->prop_values[index], info);
+  std::vector<drmModeModeInfo> drm_modes(drm_connector_->modes,
+                                         drm_connector_->modes + drm_connector_->count_modes);
+  bool modes_changed = (drm_modes.size() != snapshot.drm_modes.size()) ||
+                       !std::equal(drm_modes.begin(), drm_modes.end(), snapshot.drm_modes.begin(),
+                                   [](const drmModeModeInfo &a, const drmModeModeInfo &b) {
+                                     return !memcmp(&a, &b, sizeof(a));
+                                   });
+  if (full_parse || modes_changed || (snapshot.mode_blob_id != mode_blob_id)) {
+    snapshot.info.modes.clear();
+    for (auto &mode : drm_modes) {
+      DRMModeInfo modes_item {};
+      modes_item.mode = mode;
+      snapshot.info.modes.push_back(modes_item);
+    }
+    if (mode_blob_id) {
+      ParseModeProperties(mode_blob_id, &snapshot.info);
+    }
+    snapshot.drm_modes = std::move(drm_modes);
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EXT_HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EXT_HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->ext_hdr_prop);
+  if (full_parse || (snapshot.ext_hdr_blob_id != ext_hdr_blob_id)) {
+    snapshot.info.ext_hdr_prop = {};
+    if (ext_hdr_blob_id) {
+      ParseCapabilities(ext_hdr_blob_id, &snapshot.info.ext_hdr_prop);
+    }
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::TOPOLOGY_CONTROL)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::TOPOLOGY_CONTROL)));
-    info->topology_control = props->prop_values[index];
-  }
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EDID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EDID)));
-    ParseCapabilities(props->prop_values[index], &info->edid);
+  if (full_parse || (snapshot.edid_blob_id != edid_blob_id)) {
+    snapshot.info.edid.clear();
+    if (edid_blob_id) {
+      ParseCapabilities(edid_blob_id, &snapshot.info.edid);
+    }
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::SUPPORTED_COLORSPACES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::SUPPORTED_COLORSPACES)));
-    info->supported_colorspaces = props->prop_values[index];
+  if (full_parse || (snapshot.panel_id_blob_id != panel_id_blob_id)) {
+    snapshot.info.panel_id = 0;
+    if (panel_id_blob_id) {
+      ParseCapabilities(panel_id_blob_id, &snapshot.info.panel_id);
+    }
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::DEMURA_PANEL_ID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::DEMURA_PANEL_ID)));
-    ParseCapabilities(props->prop_values[index], &info->panel_id);
-  }
+  snapshot.valid = true;
+  snapshot.hotplug_epoch = hotplug_epoch_;
+  snapshot.caps_blob_id = caps_blob_id;
+  snapshot.hdr_blob_id = hdr_blob_id;
+  snapshot.mode_blob_id = mode_blob_id;
+  snapshot.ext_hdr_blob_id = ext_hdr_blob_id;
+  snapshot.edid_blob_id = edid_blob_id;
+  snapshot.panel_id_blob_id = panel_id_blob_id;
 
-  drmModeFreeObjectProperties(props);
+  *info = snapshot.info;
 
   return 0;
 }
 
+bool DRMConnector::GetPropertyValue(drmModeObjectProperties *props, DRMProperty prop_enum,
+                                    uint64_t *value) {
+  if (!prop_mgr_.IsPropertyAvailable(prop_enum)) {
+    return false;
+  }
+
+  uint32_t prop_id = prop_mgr_.GetPropertyId(prop_enum);
+  for (uint32_t i = 0; i < props->count_props; i++) {
+    if (props->props[i] == prop_id) {
+      *value = props->prop_values[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void DRMConnector::InitAndParse(drmModeConnector *conn) {
   drm_connector_ = conn;
   ParseProperties();
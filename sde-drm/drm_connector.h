@@ -76,6 +76,7 @@
 #include <display/drm/sde_drm.h>
 #include <mutex>
 #include <set>
+#include <vector>
 #include "drm_pp_manager.h"
 
 #include "drm_utils.h"
@@ -110,6 +111,21 @@ class DRMConnector {
   void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id);
   void SetROI(drmModeAtomicReq *req, uint32_t obj_id, uint32_t num_roi,
               DRMRect *conn_rois);
+  bool GetPropertyValue(drmModeObjectProperties *props, DRMProperty prop_enum, uint64_t *value);
+
+  // Parsed connector info along with the blob ids and hotplug epoch it was parsed from.
+  struct InfoSnapshot {
+    bool valid = false;
+    uint32_t hotplug_epoch = 0;
+    uint64_t caps_blob_id = 0;
+    uint64_t hdr_blob_id = 0;
+    uint64_t mode_blob_id = 0;
+    uint64_t ext_hdr_blob_id = 0;
+    uint64_t edid_blob_id = 0;
+    uint64_t panel_id_blob_id = 0;
+    std::vector<drmModeModeInfo> drm_modes;
+    DRMConnectorInfo info {};
+  };
 
   int fd_ = -1;
   drmModeConnector *drm_connector_ = {};
@@ -118,6 +134,9 @@ class DRMConnector {
   DRMStatus status_ = DRMStatus::FREE;
   std::unique_ptr<DRMPPManager> pp_mgr_{};
   DRMJitterConfig jitter_cfg_ = {};
+  InfoSnapshot info_snapshot_ {};
+  uint32_t hotplug_epoch_ = 0;
+  int last_connection_ = -1;
 #ifdef SDE_MAX_ROI_V1
   sde_drm_roi_v1 roi_v1_ {};
 #endif
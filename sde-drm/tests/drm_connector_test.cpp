@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../drm_connector.h"
+
+using sde_drm::DRMConnector;
+using sde_drm::DRMConnectorInfo;
+using sde_drm::DRMTopology;
+
+namespace {
+
+const uint32_t kConnectorId = 40;
+const uint32_t kModes = 40;
+// Connector queries of a display from hotplug to its first frame: HWInfoDRM looks up the display
+// type, HWDeviceDRM::Init reads the connector and HWTVDRM reads it again to populate the modes.
+const uint32_t kQueriesPerHotplug = 3;
+const uint32_t kHotplugs = 200;
+
+// Stands in for the kernel side of a DP connector. Property ids are their index + 1, blob ids
+// are handed out anew whenever the blobs are created, as the driver does on hotplug.
+struct FakeDrm {
+  drmModeConnection connection = DRM_MODE_CONNECTED;
+  std::vector<drmModeModeInfo> modes;
+  std::vector<std::string> prop_names;
+  std::vector<uint64_t> prop_values;
+  std::map<std::string, std::string> blob_contents;
+  std::map<uint32_t, std::string> blobs;
+  uint32_t next_blob_id = 1000;
+  uint32_t blob_reads = 0;
+
+  uint32_t AddProperty(const std::string &name, uint64_t value) {
+    prop_names.push_back(name);
+    prop_values.push_back(value);
+    return static_cast<uint32_t>(prop_names.size());
+  }
+
+  void SetBlob(const std::string &name, const std::string &data) {
+    uint32_t blob_id = next_blob_id++;
+    blob_contents[name] = data;
+    blobs[blob_id] = data;
+    for (size_t i = 0; i < prop_names.size(); i++) {
+      if (prop_names[i] == name) {
+        blobs.erase(static_cast<uint32_t>(prop_values[i]));
+        prop_values[i] = blob_id;
+        return;
+      }
+    }
+    AddProperty(name, blob_id);
+  }
+
+  // The driver drops the blobs of a connector on disconnect.
+  void DropBlobs() {
+    for (size_t i = 0; i < prop_names.size(); i++) {
+      if (blob_contents.count(prop_names[i])) {
+        prop_values[i] = 0;
+      }
+    }
+    blobs.clear();
+  }
+
+  // Creates the blobs again with the same contents under new ids.
+  void CreateBlobs() {
+    std::map<std::string, std::string> contents = blob_contents;
+    for (auto &blob : contents) {
+      SetBlob(blob.first, blob.second);
+    }
+  }
+} fake_drm;
+
+std::string CapabilitiesBlob() {
+  return "display type=secondary\n"
+         "panel name=dp\n"
+         "panel mode=video\n"
+         "dfps support=false\n"
+         "pixel_formats=AB24 AR24 RA24 BA24 BG24 XB24 XR24 RX24 BX24 RG24 AB30 AR30 RA30 BA30 "
+         "XB30 XR30 RX30 BX30 AB24/5/1 RA24/5/1 XB24/5/1 RX24/5/1 AB30/5/3 XB30/5/3 NV12/5/1\n"
+         "maxlinewidth=2560\n"
+         "qsync support=true\n"
+         "max os brightness=255\n";
+}
+
+std::string ModePropertiesBlob() {
+  std::string blob;
+  for (uint32_t i = 0; i < kModes; i++) {
+    blob += "mode_name=" + std::string(fake_drm.modes[i].name) + "\n";
+    blob += (i % 2) ? "topology=sde_dualpipemerge\n" : "topology=sde_singlepipe\n";
+    blob += "bit_clk_rate=" + std::to_string(540000000 + i) + "\n";
+    blob += "mdp_transfer_time_us=" + std::to_string(8000 + i) + "\n";
+    blob += "allowed_mode_switch=1\n";
+    blob += "has_cwb_crop=0\n";
+  }
+  return blob;
+}
+
+void SetUpDisplayPort() {
+  fake_drm = {};
+  for (uint32_t i = 0; i < kModes; i++) {
+    drmModeModeInfo mode = {};
+    mode.hdisplay = static_cast<uint16_t>(1280 + 64 * i);
+    mode.vdisplay = static_cast<uint16_t>(720 + 36 * i);
+    mode.vrefresh = (i % 2) ? 30 : 60;
+    mode.clock = 148500 + i;
+    snprintf(mode.name, sizeof(mode.name), "%ux%u", mode.hdisplay, mode.vdisplay);
+    fake_drm.modes.push_back(mode);
+  }
+
+  fake_drm.AddProperty("CRTC_ID", 0);
+  fake_drm.AddProperty("topology_control", 0);
+  fake_drm.SetBlob("capabilities", CapabilitiesBlob());
+  fake_drm.SetBlob("mode_properties", ModePropertiesBlob());
+  fake_drm.SetBlob("EDID", std::string(256, '\x5a'));
+}
+
+drmModeConnector *NewConnector() {
+  drmModeConnector *conn = new drmModeConnector {};
+  conn->connector_id = kConnectorId;
+  conn->connector_type = DRM_MODE_CONNECTOR_DisplayPort;
+  conn->connector_type_id = 1;
+  conn->connection = fake_drm.connection;
+  conn->count_modes = static_cast<int>(fake_drm.modes.size());
+  conn->modes = new drmModeModeInfo[fake_drm.modes.size()];
+  memcpy(conn->modes, fake_drm.modes.data(), fake_drm.modes.size() * sizeof(drmModeModeInfo));
+  return conn;
+}
+
+// Disconnects and connects the display again, the client queries the disconnected state once.
+void Hotplug(DRMConnector *connector, DRMConnectorInfo *info) {
+  fake_drm.connection = DRM_MODE_DISCONNECTED;
+  fake_drm.DropBlobs();
+  connector->GetInfo(info);
+  fake_drm.connection = DRM_MODE_CONNECTED;
+  fake_drm.CreateBlobs();
+}
+
+double ElapsedUs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+extern "C" {
+
+drmModeConnectorPtr drmModeGetConnector(int, uint32_t connector_id) {
+  return (connector_id == kConnectorId) ? NewConnector() : nullptr;
+}
+
+void drmModeFreeConnector(drmModeConnectorPtr ptr) {
+  if (ptr) {
+    delete[] ptr->modes;
+    delete ptr;
+  }
+}
+
+drmModeObjectPropertiesPtr drmModeObjectGetProperties(int, uint32_t, uint32_t) {
+  drmModeObjectProperties *props = new drmModeObjectProperties {};
+  props->count_props = static_cast<uint32_t>(fake_drm.prop_names.size());
+  props->props = new uint32_t[props->count_props];
+  props->prop_values = new uint64_t[props->count_props];
+  for (uint32_t i = 0; i < props->count_props; i++) {
+    props->props[i] = i + 1;
+    props->prop_values[i] = fake_drm.prop_values[i];
+  }
+  return props;
+}
+
+void drmModeFreeObjectProperties(drmModeObjectPropertiesPtr ptr) {
+  if (ptr) {
+    delete[] ptr->props;
+    delete[] ptr->prop_values;
+    delete ptr;
+  }
+}
+
+drmModePropertyPtr drmModeGetProperty(int, uint32_t property_id) {
+  if (!property_id || property_id > fake_drm.prop_names.size()) {
+    return nullptr;
+  }
+  drmModePropertyRes *prop = new drmModePropertyRes {};
+  prop->prop_id = property_id;
+  snprintf(prop->name, sizeof(prop->name), "%s", fake_drm.prop_names[property_id - 1].c_str());
+  return prop;
+}
+
+void drmModeFreeProperty(drmModePropertyPtr ptr) {
+  delete ptr;
+}
+
+drmModePropertyBlobPtr drmModeGetPropertyBlob(int, uint32_t blob_id) {
+  auto it = fake_drm.blobs.find(blob_id);
+  if (it == fake_drm.blobs.end()) {
+    return nullptr;
+  }
+  fake_drm.blob_reads++;
+  drmModePropertyBlobRes *blob = new drmModePropertyBlobRes {};
+  blob->id = blob_id;
+  blob->length = static_cast<uint32_t>(it->second.size());
+  blob->data = new char[blob->length];
+  memcpy(blob->data, it->second.data(), blob->length);
+  return blob;
+}
+
+void drmModeFreePropertyBlob(drmModePropertyBlobPtr ptr) {
+  if (ptr) {
+    delete[] static_cast<char *>(ptr->data);
+    delete ptr;
+  }
+}
+
+drmModeResPtr drmModeGetResources(int) {
+  return nullptr;
+}
+
+void drmModeFreeResources(drmModeResPtr) {}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr, uint32_t, uint32_t, uint64_t) {
+  return 0;
+}
+
+int drmModeCreatePropertyBlob(int, const void *, size_t, uint32_t *id) {
+  *id = 0;
+  return 0;
+}
+
+int drmModeDestroyPropertyBlob(int, uint32_t) {
+  return 0;
+}
+
+int drmIoctl(int, unsigned long, void *) {
+  return 0;
+}
+
+}  // extern "C"
+
+namespace {
+
+void ExpectSameInfo(const DRMConnectorInfo &a, const DRMConnectorInfo &b) {
+  EXPECT_EQ(a.is_connected, b.is_connected);
+  EXPECT_EQ(a.panel_name, b.panel_name);
+  EXPECT_EQ(a.is_primary, b.is_primary);
+  EXPECT_EQ(a.max_linewidth, b.max_linewidth);
+  EXPECT_EQ(a.qsync_support, b.qsync_support);
+  EXPECT_EQ(a.formats_supported, b.formats_supported);
+  EXPECT_EQ(a.edid, b.edid);
+  ASSERT_EQ(a.modes.size(), b.modes.size());
+  for (size_t i = 0; i < a.modes.size(); i++) {
+    EXPECT_EQ(0, memcmp(&a.modes[i].mode, &b.modes[i].mode, sizeof(drmModeModeInfo)));
+    EXPECT_EQ(a.modes[i].default_bit_clk_rate, b.modes[i].default_bit_clk_rate);
+    EXPECT_EQ(a.modes[i].transfer_time_us, b.modes[i].transfer_time_us);
+    ASSERT_EQ(a.modes[i].sub_modes.size(), b.modes[i].sub_modes.size());
+    EXPECT_EQ(a.modes[i].sub_modes[0].topology, b.modes[i].sub_modes[0].topology);
+  }
+}
+
+// Queries within one hotplug are served from the snapshot and match a connector parsing the
+// blobs for the first time.
+TEST(DRMConnectorTest, CachedInfoMatchesFullParse) {
+  SetUpDisplayPort();
+  DRMConnector connector(-1);
+  connector.InitAndParse(NewConnector());
+
+  DRMConnectorInfo first = {};
+  ASSERT_EQ(connector.GetInfo(&first), 0);
+  uint32_t blob_reads = fake_drm.blob_reads;
+  DRMConnectorInfo cached = {};
+  ASSERT_EQ(connector.GetInfo(&cached), 0);
+  EXPECT_EQ(fake_drm.blob_reads, blob_reads);
+
+  ASSERT_EQ(first.modes.size(), kModes);
+  EXPECT_EQ(first.panel_name, "dp");
+  EXPECT_EQ(first.max_linewidth, 2560u);
+  EXPECT_EQ(first.edid.size(), 256u);
+  EXPECT_EQ(first.modes[1].sub_modes[0].topology, DRMTopology::DUAL_LM_MERGE);
+  ExpectSameInfo(first, cached);
+
+  DRMConnector fresh(-1);
+  fresh.InitAndParse(NewConnector());
+  DRMConnectorInfo parsed = {};
+  ASSERT_EQ(fresh.GetInfo(&parsed), 0);
+  ExpectSameInfo(parsed, cached);
+}
+
+// A blob replaced within the same hotplug, or the same contents under new ids after a hotplug,
+// are parsed again.
+TEST(DRMConnectorTest, NewBlobsAreParsedAgain) {
+  SetUpDisplayPort();
+  DRMConnector connector(-1);
+  connector.InitAndParse(NewConnector());
+
+  DRMConnectorInfo info = {};
+  ASSERT_EQ(connector.GetInfo(&info), 0);
+  fake_drm.SetBlob("capabilities", "display type=secondary\npanel name=dp2\n");
+  ASSERT_EQ(connector.GetInfo(&info), 0);
+  EXPECT_EQ(info.panel_name, "dp2");
+
+  Hotplug(&connector, &info);
+  EXPECT_FALSE(info.is_connected);
+  uint32_t blob_reads = fake_drm.blob_reads;
+  ASSERT_EQ(connector.GetInfo(&info), 0);
+  EXPECT_TRUE(info.is_connected);
+  EXPECT_GT(fake_drm.blob_reads, blob_reads);
+  EXPECT_EQ(info.modes.size(), kModes);
+}
+
+// Connector queries per hotplug. Without the snapshot every query parsed all blobs, which is
+// what creating the blobs again before each query reproduces here.
+TEST(DRMConnectorTest, BenchmarkHotplugQueries) {
+  SetUpDisplayPort();
+  DRMConnector connector(-1);
+  connector.InitAndParse(NewConnector());
+  DRMConnectorInfo info = {};
+  volatile size_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < kHotplugs; n++) {
+    Hotplug(&connector, &info);
+    for (uint32_t q = 0; q < kQueriesPerHotplug; q++) {
+      fake_drm.CreateBlobs();
+      connector.GetInfo(&info);
+      sink = sink + info.modes.size();
+    }
+  }
+  double parsed_us = ElapsedUs(start) / kHotplugs;
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < kHotplugs; n++) {
+    Hotplug(&connector, &info);
+    for (uint32_t q = 0; q < kQueriesPerHotplug; q++) {
+      connector.GetInfo(&info);
+      sink = sink + info.modes.size();
+    }
+  }
+  double cached_us = ElapsedUs(start) / kHotplugs;
+
+  EXPECT_EQ(info.modes.size(), kModes);
+  printf("%u modes, %u queries per hotplug: parse per query %.1f us, snapshot %.1f us\n", kModes,
+         kQueriesPerHotplug, parsed_us, cached_us);
+}
+
+}  // namespace
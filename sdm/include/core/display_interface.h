@@ -42,6 +42,7 @@
 
 #include <private/snapdragon_color_intf.h>
 #include <stdint.h>
+#include <functional>
 #include <string>
 #include <vector>
 #include <utility>
@@ -1042,11 +1043,19 @@ class DisplayInterface {
   */
   virtual DisplayError SetFrameTriggerMode(FrameTriggerMode mode) = 0;
 
+  /*
+   * Copies SDM's display and layer related state as programmed to driver. The returned function
+   * formats the copy into a dump string. It does not access the display and can be called after
+   * the caller released its display locks.
+  */
+  virtual std::function<std::string()> CollectDump() = 0;
+
   /*
    * Returns a string consisting of a dump of SDM's display and layer related state
-   * as programmed to driver
+   * as programmed to driver. Kept for existing clients, new callers that hold a display lock
+   * should use CollectDump() and format the dump after releasing it.
   */
-  virtual std::string Dump() = 0;
+  virtual std::string Dump() { return CollectDump()(); }
 
   /*! @brief Method to dynamically set DSI clock rate.
 
@@ -470,6 +470,10 @@ struct Layer {
   uint32_t frame_rate = 0;                         //!< Rate at which frames are being updated for
                                                    //!< this layer.
 
+  uint32_t cadence_rate = 0;                       //!< Frame rate detected from the buffer update
+                                                   //!< cadence of this layer. 0 if the cadence
+                                                   //!< is not stable.
+
   uint32_t solid_fill_color = 0;                   //!< TODO: Remove this field when fb support
                                                    //!  is deprecated.
                                                    //!< Solid color used to fill the layer when
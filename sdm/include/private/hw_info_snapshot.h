@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_INFO_SNAPSHOT_H__
+#define __HW_INFO_SNAPSHOT_H__
+
+#include <private/hw_info_types.h>
+#include <string>
+
+namespace sdm {
+
+// Identifies the hardware and software combination a snapshot was probed on. A snapshot is only
+// served when every field matches the running system.
+struct HWInfoSnapshotKey {
+  std::string kernel_build;  // uname release and version
+  std::string soc_id;        // soc0 id from sysfs
+  std::string module_build;  // vendor_dlkm fingerprint and display driver module srcversion
+  std::string panel_id;      // panel boot param string
+  std::string probe_config;  // debug properties that change what the probe reports
+
+  bool operator==(const HWInfoSnapshotKey &other) const {
+    return kernel_build == other.kernel_build && soc_id == other.soc_id &&
+           module_build == other.module_build && panel_id == other.panel_id &&
+           probe_config == other.probe_config;
+  }
+  bool operator!=(const HWInfoSnapshotKey &other) const { return !(*this == other); }
+};
+
+// Versioned on-disk copy of the probed HWResourceInfo. The boot dependent continuous splash
+// state (plane_to_connector, initial_demura_planes and the per pipe splash fields) is left out,
+// since it changes between boots on the same hardware and has to be read live.
+class HWInfoSnapshot {
+ public:
+  static void GetSystemKey(const std::string &vendor_dlkm_build, const std::string &panel_id,
+                           const std::string &probe_config, HWInfoSnapshotKey *key);
+  static void Serialize(const HWResourceInfo &hw_resource, std::string *payload);
+  static bool Deserialize(const std::string &payload, HWResourceInfo *hw_resource);
+  static DisplayError Load(const char *path, const HWInfoSnapshotKey &key,
+                           HWResourceInfo *hw_resource);
+  static DisplayError Store(const char *path, const HWInfoSnapshotKey &key,
+                            const HWResourceInfo &hw_resource);
+  static void Remove(const char *path);
+
+  static constexpr const char *kDefaultPath = "/data/vendor/display/hw_info_snapshot.bin";
+
+ private:
+  static const uint32_t kMagic = 0x53494853;  // "SHIS"
+  // Bump whenever HWResourceInfo or the encoding below changes.
+  static const uint32_t kVersion = 2;
+};
+
+}  // namespace sdm
+
+#endif  // __HW_INFO_SNAPSHOT_H__
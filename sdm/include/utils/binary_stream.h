@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __BINARY_STREAM_H__
+#define __BINARY_STREAM_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sdm {
+
+// Little helpers for the versioned on-disk formats of SDM. Values are stored raw in host byte
+// order, enums as uint32 and containers with a uint32 count; files are only ever read back on the
+// device class that wrote them.
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(std::string *out) : out_(out) {}
+
+  template <typename T>
+  void Put(T value) {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic values are encoded raw");
+    out_->append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+  void PutBool(bool value) { Put<uint8_t>(value ? 1 : 0); }
+  template <typename E>
+  void PutEnum(E value) { Put<uint32_t>(static_cast<uint32_t>(value)); }
+  void PutString(const std::string &value) {
+    Put<uint32_t>(static_cast<uint32_t>(value.size()));
+    out_->append(value);
+  }
+  template <typename E>
+  void PutEnumVector(const std::vector<E> &values) {
+    Put<uint32_t>(static_cast<uint32_t>(values.size()));
+    for (auto value : values) {
+      PutEnum(value);
+    }
+  }
+
+ private:
+  std::string *out_;
+};
+
+class BinaryReader {
+ public:
+  explicit BinaryReader(const std::string &in) : in_(in) {}
+
+  template <typename T>
+  bool Get(T *value) {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic values are encoded raw");
+    if (in_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    memcpy(value, in_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+  bool GetBool(bool *value) {
+    uint8_t raw = 0;
+    if (!Get(&raw) || raw > 1) {
+      return false;
+    }
+    *value = (raw == 1);
+    return true;
+  }
+  template <typename E>
+  bool GetEnum(E *value) {
+    uint32_t raw = 0;
+    if (!Get(&raw)) {
+      return false;
+    }
+    *value = static_cast<E>(raw);
+    return true;
+  }
+  bool GetString(std::string *value) {
+    uint32_t size = 0;
+    if (!Get(&size) || in_.size() - pos_ < size) {
+      return false;
+    }
+    value->assign(in_.data() + pos_, size);
+    pos_ += size;
+    return true;
+  }
+  bool GetCount(uint32_t *count, size_t min_element_size) {
+    // Reject counts that cannot fit in the remaining bytes before anything is allocated.
+    return Get(count) && (static_cast<uint64_t>(*count) * min_element_size <= in_.size() - pos_);
+  }
+  template <typename E>
+  bool GetEnumVector(std::vector<E> *values) {
+    uint32_t count = 0;
+    if (!GetCount(&count, sizeof(uint32_t))) {
+      return false;
+    }
+    values->resize(count);
+    for (auto &value : *values) {
+      if (!GetEnum(&value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool Done() const { return pos_ == in_.size(); }
+
+ private:
+  const std::string &in_;
+  size_t pos_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __BINARY_STREAM_H__
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CADENCE_DETECTOR_H__
+#define __CADENCE_DETECTOR_H__
+
+#include <stdint.h>
+
+namespace sdm {
+
+// Estimates the frame rate of content from the times at which its buffers change. A rate is
+// reported only once the cadence has been stable for a while, and is dropped as soon as the
+// content speeds up so that callers never pick a refresh rate below the content cadence.
+class CadenceDetector {
+ public:
+  // Records a buffer change at the given monotonic time.
+  void OnBufferUpdate(int64_t timestamp_ns);
+  // Returns the detected content frame rate, 0 when there is no stable cadence.
+  uint32_t GetRate() const { return locked_rate_; }
+  void Reset();
+
+ private:
+  static const uint32_t kWindowSize = 8;
+  static const uint32_t kLockCount = 4;
+  static const uint32_t kUnlockCount = 2;
+
+  uint32_t SnapToContentRate(int64_t interval_ns);
+
+  int64_t last_timestamp_ns_ = 0;
+  int64_t intervals_ns_[kWindowSize] = {};
+  uint32_t index_ = 0;
+  uint32_t count_ = 0;
+  uint32_t candidate_rate_ = 0;
+  uint32_t candidate_count_ = 0;
+  uint32_t unstable_count_ = 0;
+  uint32_t short_count_ = 0;
+  uint32_t locked_rate_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __CADENCE_DETECTOR_H__
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FRAME_LATENCY_STATS_H__
+#define __FRAME_LATENCY_STATS_H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace sdm {
+
+enum FrameLatencyStage {
+  kLatencyHwcValidate,   // HWCSession::CommitOrPrepare
+  kLatencyHwcPresent,    // HWCSession::PresentDisplay
+  kLatencyPrepare,       // DisplayBase::Prepare
+  kLatencyCompPrepare,   // CompManager::Prepare
+  kLatencyHwValidate,    // HWDeviceDRM::Validate
+  kLatencyHwCommit,      // HWDeviceDRM::Commit
+  kLatencyAsyncCommit,   // Frame committed on the DisplayBase commit thread
+  kLatencyStageMax,
+};
+
+// Log-linear histogram, four buckets per power of two. Recording is a handful of relaxed atomic
+// operations, so any thread may record without a lock while dump readers take a snapshot.
+class LatencyHistogram {
+ public:
+  void Record(uint64_t value);
+  void Reset();
+  uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t GetMean() const;
+  uint64_t GetMax() const { return max_.load(std::memory_order_relaxed); }
+  // Upper bound of the bucket holding the given percentile, within 19% of the true value
+  uint64_t GetPercentile(uint32_t percent) const;
+
+  static uint32_t GetBucket(uint64_t value);
+  static uint64_t GetBucketUpperBound(uint32_t bucket);
+
+ private:
+  static const uint32_t kSubBucketBits = 2;
+  static const uint32_t kBuckets = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+  std::atomic<uint64_t> buckets_[kBuckets] = {};
+  std::atomic<uint64_t> count_ = {0};
+  std::atomic<uint64_t> sum_ = {0};
+  std::atomic<uint64_t> max_ = {0};
+};
+
+// Always-on latency of the composition pipeline stages of one display, in microseconds, and the
+// number of strategies tried per frame. Each stage of a display is recorded from a single thread
+// in practice, so the atomics are uncontended.
+class FrameLatencyStats {
+ public:
+  // Returns the stats of the given SDM display id, created on first use. Returns nullptr only
+  // when more than kMaxDisplays ids have been seen.
+  static FrameLatencyStats *Get(int32_t display_id);
+  static std::string DumpAll();
+  static void ResetAll();
+
+  void Record(FrameLatencyStage stage, int64_t duration_ns);
+  void RecordStrategyCount(uint32_t count) { strategy_count_.Record(count); }
+  void Reset();
+  std::string Dump() const;
+
+ private:
+  static const int32_t kMaxDisplays = 16;
+  static const int32_t kInvalidId = -1;
+
+  static FrameLatencyStats *GetTable();
+
+  std::atomic<int32_t> display_id_ = {kInvalidId};
+  LatencyHistogram stages_[kLatencyStageMax];
+  LatencyHistogram strategy_count_;
+};
+
+// Records the time spent in its scope into a stage of the given stats, if any.
+class ScopedFrameLatency {
+ public:
+  ScopedFrameLatency(FrameLatencyStats *stats, FrameLatencyStage stage)
+    : stats_(stats), stage_(stage) {
+    if (stats_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedFrameLatency() {
+    if (stats_) {
+      auto duration = std::chrono::steady_clock::now() - start_;
+      stats_->Record(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+  }
+
+ private:
+  FrameLatencyStats *stats_;
+  FrameLatencyStage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace sdm
+
+#endif  // __FRAME_LATENCY_STATS_H__
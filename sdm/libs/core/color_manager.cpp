@@ -64,10 +64,14 @@
 */
 
 #include <dlfcn.h>
+#include <string.h>
 #include <private/color_interface.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
+#include <utils/utils.h>
 #include <algorithm>
+#include <memory>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -306,10 +310,17 @@ DisplayError ColorManagerProxy::ColorSVCRequestRoute(const PPDisplayAPIPayload &
                                                      PPDisplayAPIPayload *out_payload,
                                                      PPPendingParams *pending_action) {
   DisplayError ret = kErrorNone;
+  bool de_query = (pending_action->action == kGetDetailedEnhancerData);
 
   // On completion, dspp_features_ will be populated and mark dirty with all resolved dspp
   // feature list with paramaters being transformed into target requirement.
   ret = color_intf_->ColorSVCRequestRoute(in_payload, out_payload, &pp_features_, pending_action);
+  if (!de_query) {
+    // The request may have reprogrammed features the render assets own, convert them again on
+    // the next frame even if the HDR metadata did not change. Prepare polls for DE data every
+    // frame, that poll does not touch them.
+    render_assets_applied_ = false;
+  }
 
   if (!stc_intf_) {
     return ret;
@@ -364,6 +375,7 @@ DisplayError ColorManagerProxy::ApplyDefaultDisplayMode(void) {
 
   // On POR, will be invoked from prepare<> request once bootanimation is done.
   ret = color_intf_->ApplyDefaultDisplayMode(&pp_features_);
+  render_assets_applied_ = false;
 
   return ret;
 }
@@ -474,6 +486,7 @@ DisplayError ColorManagerProxy::ColorMgrGetModes(uint32_t *mode_cnt,
 }
 
 DisplayError ColorManagerProxy::ColorMgrSetMode(int32_t color_mode_id) {
+  render_assets_applied_ = false;
   return color_intf_->ColorIntfSetDisplayMode(&pp_features_, 0, color_mode_id);
 }
 
@@ -513,6 +526,8 @@ DisplayError ColorManagerProxy::ColorMgrSetColorTransform(uint32_t length,
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
     return kErrorUndefined;
   }
+  // The render assets STC computes next depend on the transform.
+  FlushRenderAssets();
 
   return kErrorNone;
 }
@@ -546,28 +561,30 @@ DisplayError ColorManagerProxy::Validate(DispLayerStack *disp_layer_stack) {
 
   bool valid_meta_data = false;
   bool update_meta_data = false;
-  Layer hdr_layer = {};
-  bool hdr_present = false;
+  const Layer *hdr_layer = nullptr;
 
   valid_meta_data = NeedsToneMap(disp_layer_stack->info.hw_layers);
   if (valid_meta_data) {
     if (disp_layer_stack->info.hdr_layer_info.in_hdr_mode &&
           disp_layer_stack->info.hdr_layer_info.operation == HWHDRLayerInfo::kSet) {
-      hdr_layer = *(disp_layer_stack->stack->layers.at(
-                                 UINT32(disp_layer_stack->info.hdr_layer_info.layer_index)));
-      hdr_present = true;
+      hdr_layer = disp_layer_stack->stack->layers.at(
+                                 UINT32(disp_layer_stack->info.hdr_layer_info.layer_index));
     }
 
-    if (hdr_present && hdr_layer.input_buffer.color_metadata.dynamicMetaDataValid &&
-        hdr_layer.input_buffer.color_metadata.dynamicMetaDataLen) {
+    if (hdr_layer && hdr_layer->input_buffer.color_metadata.dynamicMetaDataValid &&
+        hdr_layer->input_buffer.color_metadata.dynamicMetaDataLen) {
       update_meta_data = true;
-      meta_data_ = hdr_layer.input_buffer.color_metadata;
+      meta_data_ = hdr_layer->input_buffer.color_metadata;
     }
   }
 
+  if (needs_update_ || apply_mode_) {
+    // New mode or new STC assets, none of the cached render assets apply anymore.
+    FlushRenderAssets();
+  }
+
   if (needs_update_ || apply_mode_ || update_meta_data) {
     UpdateModeHwassets(cur_mode_id_, curr_mode_, update_meta_data, meta_data_);
-    DumpColorMetaData(meta_data_);
     apply_mode_ = false;
     needs_update_ = false;
   }
@@ -656,6 +673,7 @@ DisplayError ColorManagerProxy::NotifyDisplayCalibrationMode(bool in_calibration
     DLOGE("Failed to SetProperty, property = %d error = %d", payload.prop, ret);
     return kErrorUndefined;
   }
+  FlushRenderAssets();
 
   return kErrorNone;
 }
@@ -677,12 +695,13 @@ DisplayError ColorManagerProxy::ConvertToPPFeatures(const HwConfigOutputParams &
     return kErrorParameters;
   }
 
-  if (params.payload.empty()) {
-    return kErrorNone;
-  }
+  return ConvertToPPFeatures(params.payload, out_data);
+}
 
+DisplayError ColorManagerProxy::ConvertToPPFeatures(const std::vector<HwConfigPayload> &payload,
+                                                    PPFeaturesConfig *out_data) {
   DisplayError error = kErrorNone;
-  for (auto it = params.payload.begin(); it != params.payload.end(); it++) {
+  for (auto it = payload.begin(); it != payload.end(); it++) {
     error = color_intf_->ColorIntfConvertFeature(UINT32(display_id_), *it, out_data);
     if (error != kErrorNone) {
       DLOGE("Failed to convert %s feature to PPFeature : err %d", it->hw_asset.c_str(), error);
@@ -692,6 +711,70 @@ DisplayError ColorManagerProxy::ConvertToPPFeatures(const HwConfigOutputParams &
   return error;
 }
 
+uint64_t ColorManagerProxy::GetRenderAssetsKey(int32_t mode_id,
+                                               const snapdragoncolor::ColorMode &color_mode,
+                                               bool valid_meta_data,
+                                               const ColorMetaData &meta_data) {
+  // FNV-1a over the fields kScModeRenderIntent consumes. ColorMetaData is hashed field by field,
+  // its padding and the unused tail of the dynamic payload are not initialized by every client.
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](const void *data, size_t len) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+  };
+
+  mix(&mode_id, sizeof(mode_id));
+  mix(&color_mode.gamut, sizeof(color_mode.gamut));
+  mix(&color_mode.gamma, sizeof(color_mode.gamma));
+  mix(&color_mode.intent, sizeof(color_mode.intent));
+  mix(color_mode.intent_name.data(), color_mode.intent_name.size());
+  for (auto &hw_asset : color_mode.hw_assets) {
+    mix(hw_asset.data(), hw_asset.size());
+  }
+  mix(&valid_meta_data, sizeof(valid_meta_data));
+  if (!valid_meta_data) {
+    return hash;
+  }
+
+  const MasteringDisplay &mastering = meta_data.masteringDisplayInfo;
+  const ContentLightLevel &light_level = meta_data.contentLightLevel;
+  mix(&meta_data.colorPrimaries, sizeof(meta_data.colorPrimaries));
+  mix(&meta_data.range, sizeof(meta_data.range));
+  mix(&meta_data.transfer, sizeof(meta_data.transfer));
+  mix(&meta_data.matrixCoefficients, sizeof(meta_data.matrixCoefficients));
+  mix(&mastering.colorVolumeSEIEnabled, sizeof(mastering.colorVolumeSEIEnabled));
+  mix(&mastering.primaries, sizeof(mastering.primaries));
+  mix(&mastering.maxDisplayLuminance, sizeof(mastering.maxDisplayLuminance));
+  mix(&mastering.minDisplayLuminance, sizeof(mastering.minDisplayLuminance));
+  mix(&light_level.lightLevelSEIEnabled, sizeof(light_level.lightLevelSEIEnabled));
+  mix(&light_level.maxContentLightLevel, sizeof(light_level.maxContentLightLevel));
+  mix(&light_level.minPicAverageLightLevel, sizeof(light_level.minPicAverageLightLevel));
+  mix(&meta_data.dynamicMetaDataValid, sizeof(meta_data.dynamicMetaDataValid));
+  uint32_t dynamic_len = std::min(UINT32(meta_data.dynamicMetaDataLen),
+                                  UINT32(sizeof(meta_data.dynamicMetaDataPayload)));
+  mix(&dynamic_len, sizeof(dynamic_len));
+  mix(meta_data.dynamicMetaDataPayload, dynamic_len);
+
+  return hash;
+}
+
+ColorManagerProxy::RenderAssets *ColorManagerProxy::GetRenderAssets(uint64_t key) {
+  for (auto &assets : render_assets_) {
+    if (assets.key == key) {
+      assets.last_use = ++render_assets_use_;
+      return &assets;
+    }
+  }
+  return nullptr;
+}
+
+void ColorManagerProxy::FlushRenderAssets() {
+  render_assets_.clear();
+  render_assets_applied_ = false;
+}
+
 DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
                                   snapdragoncolor::ColorMode color_mode, bool valid_meta_data,
                                   const ColorMetaData &meta_data) {
@@ -699,38 +782,92 @@ DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
     return kErrorUndefined;
   }
 
+  uint64_t key = GetRenderAssetsKey(mode_id, color_mode, valid_meta_data, meta_data);
+  if (render_assets_applied_ && key == applied_render_assets_key_) {
+    // Same scene as the last frame, the PP features programmed for it are still current.
+    render_assets_hits_++;
+    return kErrorNone;
+  }
+
   DisplayError error = kErrorNone;
-  struct snapdragoncolor::ModeRenderInputParams mode_params = {};
-  struct snapdragoncolor::HwConfigOutputParams hw_params = {};
-  mode_params.valid_meta_data = valid_meta_data;
-  mode_params.meta_data = meta_data;
-  mode_params.color_mode = color_mode;
-  mode_params.mode_id = mode_id;
+  RenderAssets *assets = GetRenderAssets(key);
+  if (assets) {
+    render_assets_hits_++;
+  } else {
+    uint64_t start = GetSystemTimeInNs();
+    struct snapdragoncolor::ModeRenderInputParams mode_params = {};
+    struct snapdragoncolor::HwConfigOutputParams hw_params = {};
+    mode_params.valid_meta_data = valid_meta_data;
+    mode_params.meta_data = meta_data;
+    mode_params.color_mode = color_mode;
+    mode_params.mode_id = mode_id;
+
+    ScPayload in_data = {};
+    ScPayload out_data = {};
+    in_data.prop = kModeRenderInputParams;
+    in_data.len = sizeof(mode_params);
+    in_data.payload = reinterpret_cast<uint64_t>(&mode_params);
+
+    out_data.prop = kHwConfigPayloadParam;
+    out_data.len = sizeof(hw_params);
+    out_data.payload = reinterpret_cast<uint64_t>(&hw_params);
+    int result = stc_intf_->ProcessOps(kScModeRenderIntent, in_data, &out_data);
+    if (result) {
+      DLOGE("Failed to call ProcessOps, error = %d", result);
+      return kErrorUndefined;
+    }
+    DumpColorMetaData(meta_data);
 
-  ScPayload in_data = {};
-  ScPayload out_data = {};
-  in_data.prop = kModeRenderInputParams;
-  in_data.len = sizeof(mode_params);
-  in_data.payload = reinterpret_cast<uint64_t>(&mode_params);
+    if (render_assets_.size() >= kMaxRenderAssets) {
+      render_assets_.erase(std::min_element(render_assets_.begin(), render_assets_.end(),
+          [](const RenderAssets &a, const RenderAssets &b) { return a.last_use < b.last_use; }));
+    }
+    render_assets_.emplace_back();
+    assets = &render_assets_.back();
+    assets->key = key;
+    assets->last_use = ++render_assets_use_;
+    // STC may reuse its payload buffers on the next call, keep a copy of what it returned.
+    for (auto &hw_payload : hw_params.payload) {
+      assets->payload.emplace_back();
+      HwConfigPayload &copy = assets->payload.back();
+      copy.hw_asset = hw_payload.hw_asset;
+      copy.hw_payload_len = hw_payload.hw_payload_len;
+      if (hw_payload.hw_payload && hw_payload.hw_payload_len) {
+        std::shared_ptr<uint8_t> data(new uint8_t[hw_payload.hw_payload_len],
+                                      std::default_delete<uint8_t[]>());
+        memcpy(data.get(), hw_payload.hw_payload.get(), hw_payload.hw_payload_len);
+        copy.hw_payload = data;
+      }
+    }
 
-  out_data.prop = kHwConfigPayloadParam;
-  out_data.len = sizeof(hw_params);
-  out_data.payload = reinterpret_cast<uint64_t>(&hw_params);
-  int result = stc_intf_->ProcessOps(kScModeRenderIntent, in_data, &out_data);
-  if (result) {
-    DLOGE("Failed to call ProcessOps, error = %d", result);
-    return kErrorUndefined;
+    uint64_t time_ns = GetSystemTimeInNs() - start;
+    render_assets_misses_++;
+    render_assets_time_ns_ += time_ns;
+    render_assets_max_time_ns_ = std::max(render_assets_max_time_ns_, time_ns);
   }
 
-  error = ConvertToPPFeatures(hw_params, &pp_features_);
+  render_assets_applied_ = false;
+  error = ConvertToPPFeatures(assets->payload, &pp_features_);
   if (error != kErrorNone) {
     DLOGE("Failed to convert hw assets to PP features, error = %d", error);
     return kErrorUndefined;
   }
   pp_features_.MarkAsDirty();
+  render_assets_applied_ = true;
+  applied_render_assets_key_ = key;
   return error;
 }
 
+std::string ColorManagerProxy::Dump() {
+  std::ostringstream os;
+  uint64_t misses = render_assets_misses_;
+  os << "\nRender assets: cached " << render_assets_.size() << " hits " << render_assets_hits_
+     << " misses " << misses << " recompute us mean "
+     << (misses ? render_assets_time_ns_ / misses / 1000 : 0) << " max "
+     << render_assets_max_time_ns_ / 1000;
+  return os.str();
+}
+
 void ColorManagerProxy::DumpColorMetaData(const ColorMetaData &color_metadata) {
   DLOGI_IF(kTagResources, "Primaries = %d, Range = %d, Transfer = %d, Matrix Coeffs = %d",
            color_metadata.colorPrimaries, color_metadata.range, color_metadata.transfer,
@@ -802,6 +939,7 @@ DisplayError ColorManagerProxy::ColorMgrSetLtmPccConfig(void* pcc_input, size_t
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
     return kErrorUndefined;
   }
+  FlushRenderAssets();
   return kErrorNone;
 }
 
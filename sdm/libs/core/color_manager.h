@@ -159,6 +159,7 @@ class ColorManagerProxy {
   DisplayError NotifyDisplayCalibrationMode(bool in_calibration);
   DisplayError ColorMgrSetLtmPccConfig(void* pcc_input, size_t size);
   DisplayError ColorMgrSetSprIntf(std::shared_ptr<SPRIntf> spr_intf);
+  std::string Dump();
 
  protected:
   ColorManagerProxy() {}
@@ -177,10 +178,26 @@ class ColorManagerProxy {
                                         PPFeaturesConfig *out_data);
   typedef std::map<std::string, ConvertProc> ConvertTable;
 
+  // Render intent hw assets computed by STC for one mode and HDR metadata combination. HDR
+  // dynamic metadata usually stays the same for a whole scene, so the assets are reused instead
+  // of running kScModeRenderIntent for every frame that carries it.
+  struct RenderAssets {
+    uint64_t key = 0;
+    uint64_t last_use = 0;
+    std::vector<HwConfigPayload> payload;
+  };
+  static const uint32_t kMaxRenderAssets = 4;
+
   bool NeedAssetsUpdate();
   DisplayError UpdateModeHwassets(int32_t mode_id, snapdragoncolor::ColorMode color_mode,
                                   bool valid_meta_data, const ColorMetaData &meta_data);
   DisplayError ConvertToPPFeatures(const HwConfigOutputParams &params, PPFeaturesConfig *out_data);
+  DisplayError ConvertToPPFeatures(const std::vector<HwConfigPayload> &payload,
+                                   PPFeaturesConfig *out_data);
+  uint64_t GetRenderAssetsKey(int32_t mode_id, const snapdragoncolor::ColorMode &color_mode,
+                              bool valid_meta_data, const ColorMetaData &meta_data);
+  RenderAssets *GetRenderAssets(uint64_t key);
+  void FlushRenderAssets();
   void DumpColorMetaData(const ColorMetaData &color_metadata);
   bool HasNativeModeSupport();
   DisplayError ApplySwAssets();
@@ -200,6 +217,14 @@ class ColorManagerProxy {
   snapdragoncolor::ScPostBlendInterface *stc_intf_ = NULL;
   snapdragoncolor::ColorMode curr_mode_;
   bool needs_update_ = false;
+  std::vector<RenderAssets> render_assets_;
+  uint64_t render_assets_use_ = 0;
+  bool render_assets_applied_ = false;
+  uint64_t applied_render_assets_key_ = 0;
+  uint64_t render_assets_hits_ = 0;
+  uint64_t render_assets_misses_ = 0;
+  uint64_t render_assets_time_ns_ = 0;
+  uint64_t render_assets_max_time_ns_ = 0;
 };
 
 class ColorFeatureCheckingImpl : public FeatureInterface {
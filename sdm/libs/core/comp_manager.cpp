@@ -32,6 +32,7 @@
 #include <core/buffer_allocator.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
+#include <utils/utils.h>
 #include <set>
 #include <string>
 #include <vector>
@@ -75,6 +76,11 @@ DisplayError CompManager::Init(const HWResourceInfo &hw_res_info,
   buffer_allocator_ = buffer_allocator;
   extension_intf_ = extension_intf;
 
+  int value = 0;
+  Debug::Get()->GetProperty(ENABLE_QOS_PREDICTION, &value);
+  qos_prediction_ = (value == 1);
+  DLOGI("QoS prediction %s", qos_prediction_ ? "enabled" : "disabled");
+
   return error;
 }
 
@@ -166,6 +172,7 @@ DisplayError CompManager::RegisterDisplay(int32_t display_id, DisplayType type,
   display_comp_ctx->is_primary_panel = hw_panel_info.is_primary_panel;
   display_comp_ctx->display_id = display_id;
   display_comp_ctx->display_type = type;
+  display_comp_ctx->latency_stats = FrameLatencyStats::Get(display_id);
   display_comp_ctx->fb_config = fb_config;
   display_comp_ctx->dest_scaler_blocks_used = mixer_attributes.dest_scaler_blocks_used;
   *display_ctx = display_comp_ctx;
@@ -257,6 +264,9 @@ DisplayError CompManager::ReconfigureDisplay(Handle comp_handle,
     return error;
   }
 
+  // Learned demand does not carry over to a new mode.
+  display_comp_ctx->qos_predictor.Reset();
+
   error = resource_intf_->Perform(ResourceInterface::kCmdCheckEnforceSplit,
                                   display_comp_ctx->display_resource_ctx, display_attributes.fps);
   if (error != kErrorNone) {
@@ -378,12 +388,14 @@ DisplayError CompManager::Prepare(Handle display_ctx, DispLayerStack *disp_layer
                              reinterpret_cast<DisplayCompositionContext *>(display_ctx);
   Handle &display_resource_ctx = display_comp_ctx->display_resource_ctx;
   DisplayError error = kErrorUndefined;
+  ScopedFrameLatency latency(display_comp_ctx->latency_stats, kLatencyCompPrepare);
 
   PrepareStrategyConstraints(display_ctx, disp_layer_stack);
   // Select a composition strategy, and try to allocate resources for it.
   resource_intf_->Start(display_resource_ctx, disp_layer_stack->stack);
 
   bool exit = false;
+  uint32_t strategies_tried = 0;
   uint32_t &count = display_comp_ctx->remaining_strategies;
   for (; !exit && count > 0; count--) {
     error = display_comp_ctx->strategy->GetNextStrategy();
@@ -394,6 +406,7 @@ DisplayError CompManager::Prepare(Handle display_ctx, DispLayerStack *disp_layer
     }
 
     if (!exit) {
+      strategies_tried++;
       LayerFeedback updated_feedback(disp_layer_stack->info.app_layer_count);
       error = resource_intf_->Prepare(display_resource_ctx, disp_layer_stack, &updated_feedback);
       // Exit if successfully prepared resource, else try next strategy.
@@ -403,6 +416,10 @@ DisplayError CompManager::Prepare(Handle display_ctx, DispLayerStack *disp_layer
     }
   }
 
+  if (display_comp_ctx->latency_stats) {
+    display_comp_ctx->latency_stats->RecordStrategyCount(strategies_tried);
+  }
+
   if (error != kErrorNone) {
     resource_intf_->Stop(display_resource_ctx, disp_layer_stack);
     DLOGE("Composition strategies exhausted for display = %d-%d. (first frame = %s)",
@@ -435,6 +452,15 @@ DisplayError CompManager::PostPrepare(Handle display_ctx, DispLayerStack *disp_l
     return error;
   }
 
+  if (qos_prediction_) {
+    // Votes are only recomputed on validate, frames committed without one keep the vote.
+    HWLayersInfo &info = disp_layer_stack->info;
+    uint64_t scene = QosPredictor::GetSceneClass(info.hw_layers,
+                                                 display_comp_ctx->fb_config.x_pixels,
+                                                 display_comp_ctx->fb_config.y_pixels);
+    display_comp_ctx->qos_predictor.Predict(scene, &info.qos_data);
+  }
+
   return kErrorNone;
 }
 
@@ -449,6 +475,9 @@ DisplayError CompManager::Commit(Handle display_ctx, DispLayerStack *disp_layer_
   if (error != kErrorNone) {
     return error;
   }
+  if (qos_prediction_) {
+    display_comp_ctx->qos_predictor.Commit(GetSystemTimeInNs(), &disp_layer_stack->info.qos_data);
+  }
   if (secure_event_ == kTUITransitionStart) {
     return GetDefaultQosData(display_ctx, &disp_layer_stack->info.qos_data);
   }
@@ -674,6 +703,7 @@ bool CompManager::SetDisplayState(Handle display_ctx, DisplayState state,
   case kStateOff:
     Purge(display_ctx);
     powered_on_displays_.erase(display_comp_ctx->display_id);
+    display_comp_ctx->qos_predictor.ResetVote();
     break;
 
   case kStateOn:
@@ -685,6 +715,7 @@ bool CompManager::SetDisplayState(Handle display_ctx, DisplayState state,
 
   case kStateDozeSuspend:
     powered_on_displays_.erase(display_comp_ctx->display_id);
+    display_comp_ctx->qos_predictor.ResetVote();
     break;
 
   default:
@@ -941,6 +972,16 @@ std::string CompManager::Dump() {
   return resource_intf_->Dump();
 }
 
+std::string CompManager::DumpQosPrediction(Handle display_ctx) {
+  std::lock_guard<std::recursive_mutex> obj(comp_mgr_mutex_);
+  DisplayCompositionContext *display_comp_ctx =
+      reinterpret_cast<DisplayCompositionContext *>(display_ctx);
+  if (!qos_prediction_ || !display_comp_ctx) {
+    return "";
+  }
+  return display_comp_ctx->qos_predictor.Dump();
+}
+
 DppsControlInterface* CompManager::GetDppsControlIntf() {
   std::lock_guard<std::recursive_mutex> obj(comp_mgr_mutex_);
   return dpps_ctrl_intf_;
@@ -962,7 +1003,9 @@ void CompManager::SetDemuraStatusForDisplay(const int32_t &display_id, bool stat
 }
 
 bool CompManager::GetDemuraStatusForDisplay(const int32_t &display_id) {
-  return display_demura_status_[display_id];
+  std::lock_guard<std::recursive_mutex> obj(comp_mgr_mutex_);
+  auto it = display_demura_status_.find(display_id);
+  return (it != display_demura_status_.end()) && it->second;
 }
 
 DisplayError CompManager::CaptureCwb(Handle display_ctx, const LayerBuffer &output_buffer,
@@ -36,6 +36,7 @@
 #include <private/extension_interface.h>
 #include <private/hw_interface.h>
 #include <utils/locker.h>
+#include <utils/frame_latency_stats.h>
 #include <bitset>
 #include <set>
 #include <vector>
@@ -45,6 +46,7 @@
 
 #include "strategy.h"
 #include "resource_default.h"
+#include "qos_predictor.h"
 
 namespace sdm {
 
@@ -130,6 +132,7 @@ class CompManager : public CwbCallback {
   virtual void NotifyCwbDone(int32_t display_id, int32_t status, const LayerBuffer& buffer);
   virtual void TriggerRefresh(int32_t display_id);
   std::string Dump();
+  std::string DumpQosPrediction(Handle display_ctx);
   uint32_t GetMixerCount();
   uint32_t GetActiveDisplayCount();
   bool IsDisplayHWAvailable();
@@ -158,6 +161,8 @@ class CompManager : public CwbCallback {
     DisplayConfigVariableInfo fb_config = {};
     bool first_cycle_ = true;
     uint32_t dest_scaler_blocks_used = 0;
+    FrameLatencyStats *latency_stats = nullptr;
+    QosPredictor qos_predictor;
   };
 
   std::recursive_mutex comp_mgr_mutex_;
@@ -180,6 +185,7 @@ class CompManager : public CwbCallback {
   bool demura_enabled_ = false;
   std::map<int32_t /* display_id */, bool> display_demura_status_;
   SecureEvent secure_event_ = kSecureEventMax;
+  bool qos_prediction_ = false;
 };
 
 }  // namespace sdm
@@ -123,6 +123,7 @@ DisplayBase::~DisplayBase() {
 DisplayError DisplayBase::Init() {
   ClientLock lock(disp_mutex_);
   DisplayError error = kErrorNone;
+  latency_stats_ = FrameLatencyStats::Get(display_id_);
   hw_panel_info_ = HWPanelInfo();
   hw_intf_->GetHWPanelInfo(&hw_panel_info_);
   default_panel_mode_ = hw_panel_info_.mode;
@@ -228,6 +229,15 @@ DisplayError DisplayBase::Init() {
   if (Debug::Get()->GetProperty(ALLOW_TONEMAP_NATIVE, &prop) == kErrorNone) {
     allow_tonemap_native_ = (prop == 1);
   }
+  prop = 0;
+  if (Debug::Get()->GetProperty(LAYER_STACK_TRACE_FRAMES_PROP, &prop) == kErrorNone && prop > 0) {
+    std::string path = "/data/vendor/display/layer_stack_trace_" + std::to_string(display_id_) +
+                       ".bin";
+    layer_stack_trace_ = std::make_unique<LayerStackTraceWriter>();
+    if (layer_stack_trace_->Open(path.c_str(), UINT32(prop)) != kErrorNone) {
+      layer_stack_trace_ = nullptr;
+    }
+  }
 
   SetupPanelFeatureFactory();
 
@@ -837,6 +847,7 @@ void DisplayBase::EnableLlccDuringAodMode(LayerStack *layer_stack) {
 
 DisplayError DisplayBase::Prepare(LayerStack *layer_stack) {
   DTRACE_SCOPED();
+  ScopedFrameLatency latency(latency_stats_, kLatencyPrepare);
   ClientLock lock(disp_mutex_);
   DisplayError error = kErrorNone;
   needs_validate_ = true;
@@ -861,6 +872,10 @@ DisplayError DisplayBase::Prepare(LayerStack *layer_stack) {
     return error;
   }
 
+  if (layer_stack_trace_ && layer_stack_trace_->IsOpen()) {
+    TraceLayerStack(layer_stack);
+  }
+
   // This call in Prepare will return the cached value during PrePrepare()
   PrepareRC(layer_stack);
 
@@ -1095,6 +1110,26 @@ DisplayError DisplayBase::GetNoisePluginParams(LayerStack *layer_stack) {
   return ret ? kErrorUndefined : kErrorNone;
 }
 
+// Only encodes the layer stack, the trace is written to storage by the writer thread.
+void DisplayBase::TraceLayerStack(LayerStack *layer_stack) {
+  if (layer_stack_trace_->NeedsConfig(display_attributes_, hw_panel_info_, mixer_attributes_,
+                                      fb_config_)) {
+    LayerStackTraceConfig config;
+    config.display_id = display_id_;
+    config.display_type = display_type_;
+    config.display_attributes = display_attributes_;
+    config.panel_info = hw_panel_info_;
+    config.mixer_attributes = mixer_attributes_;
+    config.fb_config = fb_config_;
+    config.hw_resource = hw_resource_info_;
+    layer_stack_trace_->WriteConfig(config);
+  }
+
+  // Once the trace is complete or failed it stops accepting frames. The writer is kept until the
+  // display is destroyed, so Prepare never waits for the remaining records to be written.
+  layer_stack_trace_->WriteFrame(*layer_stack, static_cast<int64_t>(GetSystemTimeInNs()));
+}
+
 // Send layer stack to RC core to generate and configure the mask on HW.
 DisplayError DisplayBase::PrepareRC(LayerStack *layer_stack) {
   if (!rc_panel_feature_init_) {
@@ -1359,6 +1394,7 @@ DisplayError DisplayBase::CommitOrPrepare(LayerStack *layer_stack) {
 void DisplayBase::HandleAsyncCommit() {
   // Do not acquire mutexes here.
   // Perform hw commit here.
+  ScopedFrameLatency latency(latency_stats_, kLatencyAsyncCommit);
   PerformHwCommit(&disp_layer_stack_.info);
 }
 
@@ -2002,114 +2038,200 @@ DisplayError DisplayBase::SetMaxMixerStages(uint32_t max_mixer_stages) {
   return error;
 }
 
-void DisplayBase::AppendRCMaskData(std::ostringstream &os) {
-  uint32_t num_mask_layers = disp_layer_stack_.info.rc_layers_info.mask_layer_idx.size();
-  uint32_t num_rc_hw_layers = disp_layer_stack_.info.rc_layers_info.rc_hw_layer_idx.size();
-  if (num_mask_layers && rc_enable_prop_) {
-    os << "\nRC HW Mask Layer Idx: [";
-    for (uint32_t i = 0; i < num_rc_hw_layers; i++) {
-      os << disp_layer_stack_.info.rc_layers_info.rc_hw_layer_idx.at(i);
-      if (i < (num_rc_hw_layers - 1)) {
-        os << ", ";
-      }
+void DisplayBase::GetDumpState(DumpState *dump_state) {
+  HWLayersInfo &layer_info = disp_layer_stack_.info;
+
+  hw_intf_->GetNumDisplayAttributes(&dump_state->num_modes);
+  hw_intf_->GetActiveConfig(&dump_state->active_index);
+
+  dump_state->display_type = display_type_;
+  dump_state->draw_method = draw_method_;
+  dump_state->state = state_;
+  dump_state->vsync_enable = vsync_enable_;
+  dump_state->max_mixer_stages = max_mixer_stages_;
+  dump_state->noise_layer_info = layer_info.noise_layer_info;
+  dump_state->panel_info = hw_panel_info_;
+  dump_state->display_attributes = display_attributes_;
+  dump_state->mixer_attributes = mixer_attributes_;
+
+  uint32_t num_hw_layers = UINT32(layer_info.hw_layers.size());
+  if (num_hw_layers == 0) {
+    return;
+  }
+
+  std::shared_ptr<LayerBuffer> out_buffer = layer_info.output_buffer;
+  if (out_buffer) {
+    dump_state->has_output_buffer = true;
+    dump_state->output_format = out_buffer->format;
+    dump_state->output_width = out_buffer->width;
+    dump_state->output_height = out_buffer->height;
+  }
+  dump_state->left_frame_roi = layer_info.left_frame_roi;
+  dump_state->right_frame_roi = layer_info.right_frame_roi;
+  dump_state->partial_fb_roi = layer_info.partial_fb_roi;
+  if (layer_info.rc_layers_info.mask_layer_idx.size() && rc_enable_prop_) {
+    dump_state->rc_hw_layer_idx = layer_info.rc_layers_info.rc_hw_layer_idx;
+    dump_state->rc_mask_layer_idx = layer_info.rc_layers_info.mask_layer_idx;
+  }
+
+  dump_state->layers.resize(num_hw_layers);
+  for (uint32_t i = 0; i < num_hw_layers; i++) {
+    DumpLayer &dump_layer = dump_state->layers[i];
+    Layer &hw_layer = layer_info.hw_layers.at(i);
+    HWLayerConfig &layer_config = layer_info.config[i];
+    HWRotatorSession &hw_rotator_session = layer_config.hw_rotator_session;
+    ColorMetaData &color_metadata = hw_layer.input_buffer.color_metadata;
+
+    dump_layer.index = layer_info.index.at(i);
+    dump_layer.composition = hw_layer.composition;
+    dump_layer.flags = hw_layer.flags.flags;
+    dump_layer.format = hw_layer.input_buffer.format;
+    dump_layer.width = hw_layer.input_buffer.width;
+    dump_layer.height = hw_layer.input_buffer.height;
+    dump_layer.color_primaries = INT32(color_metadata.colorPrimaries);
+    dump_layer.range = INT32(color_metadata.range);
+    dump_layer.transfer = INT32(color_metadata.transfer);
+    dump_layer.use_inline_rot = layer_config.use_inline_rot;
+    dump_layer.rot_block_count = std::min(hw_rotator_session.hw_block_count,
+                                          UINT32(kMaxRotatePerLayer));
+    for (uint32_t count = 0; count < dump_layer.rot_block_count; count++) {
+      dump_layer.rot_src_roi[count] = hw_rotator_session.hw_rotate_info[count].src_roi;
+      dump_layer.rot_dst_roi[count] = hw_rotator_session.hw_rotate_info[count].dst_roi;
+    }
+    dump_layer.rot_format = hw_rotator_session.output_buffer.format;
+    dump_layer.rot_width = hw_rotator_session.output_buffer.width;
+    dump_layer.rot_height = hw_rotator_session.output_buffer.height;
+    dump_layer.use_solidfill_stage = layer_config.use_solidfill_stage;
+    dump_layer.solidfill_roi = layer_config.hw_solidfill_stage.roi;
+    dump_layer.solidfill_z_order = layer_config.hw_solidfill_stage.z_order;
+
+    for (uint32_t count = 0; count < 2; count++) {
+      HWPipeInfo &pipe = (count == 0) ? layer_config.left_pipe : layer_config.right_pipe;
+      DumpPipe &dump_pipe = dump_layer.pipes[count];
+      dump_pipe.valid = pipe.valid;
+      dump_pipe.pipe_id = pipe.pipe_id;
+      dump_pipe.src_roi = pipe.src_roi;
+      dump_pipe.dst_roi = pipe.dst_roi;
+      dump_pipe.z_order = pipe.z_order;
+      dump_pipe.flags = pipe.flags;
+      dump_pipe.horizontal_decimation = pipe.horizontal_decimation;
+      dump_pipe.vertical_decimation = pipe.vertical_decimation;
     }
-    os << "] of [";
-    for (uint32_t i = 0; i < num_mask_layers; i++) {
-      os << disp_layer_stack_.info.rc_layers_info.mask_layer_idx.at(i);
-      if (i < (num_mask_layers - 1)) {
-        os << ", ";
-      }
+  }
+}
+
+std::function<std::string()> DisplayBase::CollectDump() {
+  DumpState dump_state;
+
+  {
+    ClientLock lock(disp_mutex_);
+    GetDumpState(&dump_state);
+    dump_state.current_color_mode = current_color_mode_;
+    for (auto &it : color_mode_map_) {
+      dump_state.color_mode_ids[it.first] = it.second->id;
+    }
+    dump_state.color_mode_attrs = color_mode_attr_map_;
+    if (color_mgr_) {
+      dump_state.color_manager = color_mgr_->Dump();
     }
-    os << "]";
   }
+
+  // Guarded by the comp manager lock, no need to hold off commits for it.
+  dump_state.qos_prediction = comp_manager_->DumpQosPrediction(display_comp_ctx_);
+
+  return [dump_state = std::move(dump_state)]() { return FormatDump(dump_state); };
 }
 
-std::string DisplayBase::Dump() {
-  ClientLock lock(disp_mutex_);
-  HWDisplayAttributes attrib;
-  uint32_t active_index = 0;
-  uint32_t num_modes = 0;
+std::string DisplayBase::FormatDump(const DumpState &dump_state) {
+  const HWPanelInfo &panel_info = dump_state.panel_info;
+  const HWDisplayAttributes &display_attributes = dump_state.display_attributes;
   std::ostringstream os;
 
-  hw_intf_->GetNumDisplayAttributes(&num_modes);
-  hw_intf_->GetActiveConfig(&active_index);
-  hw_intf_->GetDisplayAttributes(active_index, &attrib);
-
-  os << "device type:" << display_type_;
-  os << " DrawMethod: " << draw_method_;
-  os << "\nstate: " << state_ << " vsync on: " << vsync_enable_
-     << " max. mixer stages: " << max_mixer_stages_;
-  if (disp_layer_stack_.info.noise_layer_info.enable) {
-    os << "\nNoise z-orders: [" << disp_layer_stack_.info.noise_layer_info.zpos_noise << "," <<
-        disp_layer_stack_.info.noise_layer_info.zpos_attn << "]";
+  os << "device type:" << dump_state.display_type;
+  os << " DrawMethod: " << dump_state.draw_method;
+  os << "\nstate: " << dump_state.state << " vsync on: " << dump_state.vsync_enable
+     << " max. mixer stages: " << dump_state.max_mixer_stages;
+  if (dump_state.noise_layer_info.enable) {
+    os << "\nNoise z-orders: [" << dump_state.noise_layer_info.zpos_noise << "," <<
+        dump_state.noise_layer_info.zpos_attn << "]";
   }
-  os << "\nnum configs: " << num_modes << " active config index: " << active_index;
+  os << "\nnum configs: " << dump_state.num_modes << " active config index: "
+     << dump_state.active_index;
   os << "\nDisplay Attributes:";
-  os << "\n Mode:" << (hw_panel_info_.mode == kModeVideo ? "Video" : "Command");
+  os << "\n Mode:" << (panel_info.mode == kModeVideo ? "Video" : "Command");
   os << std::boolalpha;
-  os << " Primary:" << hw_panel_info_.is_primary_panel;
-  os << " DynFPS:" << hw_panel_info_.dynamic_fps;
-  os << "\n HDR Panel:" << hw_panel_info_.hdr_enabled;
-  os << " QSync:" << hw_panel_info_.qsync_support;
-  os << " DynBitclk:" << hw_panel_info_.dyn_bitclk_support;
-  os << "\n Left Split:" << hw_panel_info_.split_info.left_split
-     << " Right Split:" << hw_panel_info_.split_info.right_split;
-  os << "\n PartialUpdate:" << hw_panel_info_.partial_update;
-  if (hw_panel_info_.partial_update) {
-    os << "\n ROI Min w:" << hw_panel_info_.min_roi_width;
-    os << " Min h:" << hw_panel_info_.min_roi_height;
-    os << " NeedsMerge: " << hw_panel_info_.needs_roi_merge;
-    os << " Alignment: l:" << hw_panel_info_.left_align << " w:" << hw_panel_info_.width_align;
-    os << " t:" << hw_panel_info_.top_align << " b:" << hw_panel_info_.height_align;
-  }
-  os << "\n FPS min:" << hw_panel_info_.min_fps << " max:" << hw_panel_info_.max_fps
-     << " cur:" << display_attributes_.fps;
-  os << " TransferTime: " << hw_panel_info_.transfer_time_us << "us";
-  os << " Min TransferTime: " << hw_panel_info_.transfer_time_us_min << "us";
-  os << " Max TransferTime: " << hw_panel_info_.transfer_time_us_max << "us";
-  os << " MaxBrightness:" << hw_panel_info_.panel_max_brightness;
-  os << "\n Display WxH: " << display_attributes_.x_pixels << "x" << display_attributes_.y_pixels;
-  os << " MixerWxH: " << mixer_attributes_.width << "x" << mixer_attributes_.height;
-  os << " DPI: " << display_attributes_.x_dpi << "x" << display_attributes_.y_dpi;
-  os << " LM_Split: " << display_attributes_.is_device_split;
-  os << "\n vsync_period " << display_attributes_.vsync_period_ns;
-  os << " v_back_porch: " << display_attributes_.v_back_porch;
-  os << " v_front_porch: " << display_attributes_.v_front_porch;
-  os << " v_pulse_width: " << display_attributes_.v_pulse_width;
-  os << "\n v_total: " << display_attributes_.v_total;
-  os << " h_total: " << display_attributes_.h_total;
-  os << " clk: " << display_attributes_.clock_khz;
-  os << " Topology: " << display_attributes_.topology;
+  os << " Primary:" << panel_info.is_primary_panel;
+  os << " DynFPS:" << panel_info.dynamic_fps;
+  os << "\n HDR Panel:" << panel_info.hdr_enabled;
+  os << " QSync:" << panel_info.qsync_support;
+  os << " DynBitclk:" << panel_info.dyn_bitclk_support;
+  os << "\n Left Split:" << panel_info.split_info.left_split
+     << " Right Split:" << panel_info.split_info.right_split;
+  os << "\n PartialUpdate:" << panel_info.partial_update;
+  if (panel_info.partial_update) {
+    os << "\n ROI Min w:" << panel_info.min_roi_width;
+    os << " Min h:" << panel_info.min_roi_height;
+    os << " NeedsMerge: " << panel_info.needs_roi_merge;
+    os << " Alignment: l:" << panel_info.left_align << " w:" << panel_info.width_align;
+    os << " t:" << panel_info.top_align << " b:" << panel_info.height_align;
+  }
+  os << "\n FPS min:" << panel_info.min_fps << " max:" << panel_info.max_fps
+     << " cur:" << display_attributes.fps;
+  os << " TransferTime: " << panel_info.transfer_time_us << "us";
+  os << " Min TransferTime: " << panel_info.transfer_time_us_min << "us";
+  os << " Max TransferTime: " << panel_info.transfer_time_us_max << "us";
+  os << " MaxBrightness:" << panel_info.panel_max_brightness;
+  os << "\n Display WxH: " << display_attributes.x_pixels << "x" << display_attributes.y_pixels;
+  os << " MixerWxH: " << dump_state.mixer_attributes.width << "x"
+     << dump_state.mixer_attributes.height;
+  os << " DPI: " << display_attributes.x_dpi << "x" << display_attributes.y_dpi;
+  os << " LM_Split: " << display_attributes.is_device_split;
+  os << "\n vsync_period " << display_attributes.vsync_period_ns;
+  os << " v_back_porch: " << display_attributes.v_back_porch;
+  os << " v_front_porch: " << display_attributes.v_front_porch;
+  os << " v_pulse_width: " << display_attributes.v_pulse_width;
+  os << "\n v_total: " << display_attributes.v_total;
+  os << " h_total: " << display_attributes.h_total;
+  os << " clk: " << display_attributes.clock_khz;
+  os << " Topology: " << display_attributes.topology;
   os << std::noboolalpha;
 
-  os << "\nCurrent Color Mode: " << current_color_mode_.c_str();
+  os << "\nCurrent Color Mode: " << dump_state.current_color_mode.c_str();
   os << "\nAvailable Color Modes:\n";
-  for (auto it : color_mode_map_) {
-    os << "  " << it.first << " " << std::setw(35 - INT(it.first.length())) <<
-       it.second->id;
+  for (auto &it : dump_state.color_mode_ids) {
+    os << "  " << it.first << " " << std::setw(35 - INT(it.first.length())) << it.second;
     os << " ";
-    for (auto attr_it : color_mode_attr_map_[it.first]) {
-      os << std::right << " " << attr_it.first << ": " << attr_it.second;
+    auto attrs = dump_state.color_mode_attrs.find(it.first);
+    if (attrs != dump_state.color_mode_attrs.end()) {
+      for (auto &attr_it : attrs->second) {
+        os << std::right << " " << attr_it.first << ": " << attr_it.second;
+      }
     }
     os << "\n";
   }
+  os << dump_state.color_manager;
+  os << dump_state.qos_prediction;
+
+  if (FormatLayers(dump_state, os)) {
+    os << "\n";
+  }
 
-  uint32_t num_hw_layers = UINT32(disp_layer_stack_.info.hw_layers.size());
+  return os.str();
+}
 
-  if (num_hw_layers == 0) {
+bool DisplayBase::FormatLayers(const DumpState &dump_state, std::ostringstream &os) {
+  if (dump_state.layers.empty()) {
     os << "\nNo hardware layers programmed";
-    return os.str();
+    return false;
   }
 
-  std::shared_ptr<LayerBuffer> out_buffer = disp_layer_stack_.info.output_buffer;
-  if (out_buffer) {
-    os << "\n Output buffer res: " << out_buffer->width << "x" << out_buffer->height
-       << " format: " << GetFormatString(out_buffer->format);
+  if (dump_state.has_output_buffer) {
+    os << "\n Output buffer res: " << dump_state.output_width << "x" << dump_state.output_height
+       << " format: " << GetFormatString(dump_state.output_format);
   }
-  HWLayersInfo &layer_info = disp_layer_stack_.info;
-  for (uint32_t i = 0; i < layer_info.left_frame_roi.size(); i++) {
-    LayerRect &l_roi = layer_info.left_frame_roi.at(i);
-    LayerRect &r_roi = layer_info.right_frame_roi.at(i);
+  for (uint32_t i = 0; i < dump_state.left_frame_roi.size(); i++) {
+    const LayerRect &l_roi = dump_state.left_frame_roi.at(i);
+    const LayerRect &r_roi = dump_state.right_frame_roi.at(i);
 
     os << "\nROI(LTRB)#" << i << " LEFT(" << INT(l_roi.left) << " " << INT(l_roi.top) << " " <<
       INT(l_roi.right) << " " << INT(l_roi.bottom) << ")";
@@ -2119,13 +2241,31 @@ std::string DisplayBase::Dump() {
     }
   }
 
-  LayerRect &fb_roi = layer_info.partial_fb_roi;
+  const LayerRect &fb_roi = dump_state.partial_fb_roi;
   if (IsValid(fb_roi)) {
     os << "\nPartial FB ROI(LTRB):(" << INT(fb_roi.left) << " " << INT(fb_roi.top) << " " <<
       INT(fb_roi.right) << " " << INT(fb_roi.bottom) << ")";
   }
 
-  AppendRCMaskData(os);
+  uint32_t num_mask_layers = UINT32(dump_state.rc_mask_layer_idx.size());
+  uint32_t num_rc_hw_layers = UINT32(dump_state.rc_hw_layer_idx.size());
+  if (num_mask_layers) {
+    os << "\nRC HW Mask Layer Idx: [";
+    for (uint32_t i = 0; i < num_rc_hw_layers; i++) {
+      os << dump_state.rc_hw_layer_idx.at(i);
+      if (i < (num_rc_hw_layers - 1)) {
+        os << ", ";
+      }
+    }
+    os << "] of [";
+    for (uint32_t i = 0; i < num_mask_layers; i++) {
+      os << dump_state.rc_mask_layer_idx.at(i);
+      if (i < (num_mask_layers - 1)) {
+        os << ", ";
+      }
+    }
+    os << "]";
+  }
 
   const char *header  = "\n| Idx |   Comp Type   |   Split   | Pipe |    W x H    |          Format          |  Src Rect (L T R B) |  Dst Rect (L T R B) |  Z | Pipe Flags | Deci(HxV) | CS | Rng | Tr |";  //NOLINT
   const char *newline = "\n|-----|---------------|-----------|------|-------------|--------------------------|---------------------|---------------------|----|------------|-----------|----|-----|----|";  //NOLINT
@@ -2136,34 +2276,28 @@ std::string DisplayBase::Dump() {
   os << header;
   os << newline;
 
-  for (uint32_t i = 0; i < num_hw_layers; i++) {
-    uint32_t layer_index = disp_layer_stack_.info.index.at(i);
-    // hw-layer from hw layers info
-    Layer &hw_layer = disp_layer_stack_.info.hw_layers.at(i);
-    LayerBuffer *input_buffer = &hw_layer.input_buffer;
-    HWLayerConfig &layer_config = disp_layer_stack_.info.config[i];
-    HWRotatorSession &hw_rotator_session = layer_config.hw_rotator_session;
-
-    const char *comp_type = GetCompositionName(hw_layer.composition);
-    const char *buffer_format = GetFormatString(input_buffer->format);
+  for (const DumpLayer &dump_layer : dump_state.layers) {
+    uint32_t width = dump_layer.width;
+    uint32_t height = dump_layer.height;
+    const char *comp_type = GetCompositionName(dump_layer.composition);
+    const char *buffer_format = GetFormatString(dump_layer.format);
     const char *pipe_split[2] = { "Pipe-1", "Pipe-2" };
     const char *rot_pipe[2] = { "Rot-inl-1", "Rot-inl-2" };
     char idx[8];
 
-    snprintf(idx, sizeof(idx), "%d", layer_index);
+    snprintf(idx, sizeof(idx), "%d", dump_layer.index);
 
-    for (uint32_t count = 0; count < hw_rotator_session.hw_block_count; count++) {
+    for (uint32_t count = 0; count < dump_layer.rot_block_count; count++) {
       char row[1024];
-      HWRotateInfo &rotate = hw_rotator_session.hw_rotate_info[count];
-      LayerRect &src_roi = rotate.src_roi;
-      LayerRect &dst_roi = rotate.dst_roi;
+      const LayerRect &src_roi = dump_layer.rot_src_roi[count];
+      const LayerRect &dst_roi = dump_layer.rot_dst_roi[count];
       char rot[12] = { 0 };
 
-      snprintf(rot, sizeof(rot), "Rot-%s-%d", layer_config.use_inline_rot ?
+      snprintf(rot, sizeof(rot), "Rot-%s-%d", dump_layer.use_inline_rot ?
                "inl" : "off", count + 1);
 
       snprintf(row, sizeof(row), format, idx, comp_type, rot,
-               0, input_buffer->width, input_buffer->height, buffer_format,
+               0, width, height, buffer_format,
                INT(src_roi.left), INT(src_roi.top), INT(src_roi.right), INT(src_roi.bottom),
                INT(dst_roi.left), INT(dst_roi.top), INT(dst_roi.right), INT(dst_roi.bottom),
                "-", "-    ", "-    ", "-", "-", "-");
@@ -2173,13 +2307,14 @@ std::string DisplayBase::Dump() {
       comp_type = "";
     }
 
-    if (hw_rotator_session.hw_block_count > 0) {
-      input_buffer = &hw_rotator_session.output_buffer;
-      buffer_format = GetFormatString(input_buffer->format);
+    if (dump_layer.rot_block_count > 0) {
+      width = dump_layer.rot_width;
+      height = dump_layer.rot_height;
+      buffer_format = GetFormatString(dump_layer.rot_format);
     }
 
-    if (layer_config.use_solidfill_stage) {
-      LayerRect src_roi = layer_config.hw_solidfill_stage.roi;
+    if (dump_layer.use_solidfill_stage) {
+      const LayerRect &src_roi = dump_layer.solidfill_roi;
       const char *decimation = "";
       char flags[16] = { 0 };
       char z_order[8] = { 0 };
@@ -2188,8 +2323,8 @@ std::string DisplayBase::Dump() {
       const char *transfer = "";
       char row[1024] = { 0 };
 
-      snprintf(z_order, sizeof(z_order), "%d", layer_config.hw_solidfill_stage.z_order);
-      snprintf(flags, sizeof(flags), "0x%08x", hw_layer.flags.flags);
+      snprintf(z_order, sizeof(z_order), "%d", dump_layer.solidfill_z_order);
+      snprintf(flags, sizeof(flags), "0x%08x", dump_layer.flags);
       snprintf(row, sizeof(row), format, idx, comp_type, pipe_split[0],
                0, INT(src_roi.right), INT(src_roi.bottom),
                buffer_format, INT(src_roi.left), INT(src_roi.top),
@@ -2207,29 +2342,28 @@ std::string DisplayBase::Dump() {
       char color_primary[8] = { 0 };
       char range[8] = { 0 };
       char transfer[8] = { 0 };
-      bool rot = layer_config.use_inline_rot;
+      bool rot = dump_layer.use_inline_rot;
 
-      HWPipeInfo &pipe = (count == 0) ? layer_config.left_pipe : layer_config.right_pipe;
+      const DumpPipe &pipe = dump_layer.pipes[count];
 
       if (!pipe.valid) {
         continue;
       }
 
-      LayerRect src_roi = pipe.src_roi;
-      LayerRect &dst_roi = pipe.dst_roi;
+      const LayerRect &src_roi = pipe.src_roi;
+      const LayerRect &dst_roi = pipe.dst_roi;
 
       snprintf(z_order, sizeof(z_order), "%d", pipe.z_order);
       snprintf(flags, sizeof(flags), "0x%08x", pipe.flags);
       snprintf(decimation, sizeof(decimation), "%3d x %3d", pipe.horizontal_decimation,
                pipe.vertical_decimation);
-      ColorMetaData &color_metadata = hw_layer.input_buffer.color_metadata;
-      snprintf(color_primary, sizeof(color_primary), "%d", color_metadata.colorPrimaries);
-      snprintf(range, sizeof(range), "%d", color_metadata.range);
-      snprintf(transfer, sizeof(transfer), "%d", color_metadata.transfer);
+      snprintf(color_primary, sizeof(color_primary), "%d", dump_layer.color_primaries);
+      snprintf(range, sizeof(range), "%d", dump_layer.range);
+      snprintf(transfer, sizeof(transfer), "%d", dump_layer.transfer);
 
       char row[1024];
       snprintf(row, sizeof(row), format, idx, comp_type, rot ? rot_pipe[count] : pipe_split[count],
-               pipe.pipe_id, input_buffer->width, input_buffer->height,
+               pipe.pipe_id, width, height,
                buffer_format, INT(src_roi.left), INT(src_roi.top),
                INT(src_roi.right), INT(src_roi.bottom), INT(dst_roi.left),
                INT(dst_roi.top), INT(dst_roi.right), INT(dst_roi.bottom),
@@ -2242,9 +2376,9 @@ std::string DisplayBase::Dump() {
     }
   }
 
-  os << newline << "\n";
+  os << newline;
 
-  return os.str();
+  return true;
 }
 
 DisplayError DisplayBase::ColorSVCRequestRoute(const PPDisplayAPIPayload &in_payload,
@@ -2616,7 +2750,12 @@ DisplayError DisplayBase::SetCursorPosition(int x, int y) {
   DisplayError error = comp_manager_->ValidateAndSetCursorPosition(display_comp_ctx_,
                                                                    &disp_layer_stack_, x, y);
   if (error == kErrorNone) {
-    return hw_intf_->SetCursorPosition(&disp_layer_stack_.info, x, y);
+    error = hw_intf_->SetCursorPosition(&disp_layer_stack_.info, x, y);
+  }
+
+  if (error != kErrorNone) {
+    // The position is picked up by the next frame.
+    DLOGV_IF(kTagDisplay, "Cursor at %d, %d not moved asynchronously, error %d", x, y, error);
   }
 
   return kErrorNone;
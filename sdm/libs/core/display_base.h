@@ -44,17 +44,20 @@
 #include <private/noise_plugin_dbg.h>
 #include <private/hw_interface.h>
 #include <private/hw_events_interface.h>
+#include <utils/frame_latency_stats.h>
 
 #include <limits.h>
 #include <map>
 #include <mutex>
 #include <thread>
 #include <condition_variable>  // NOLINT
+#include <functional>
 #include <string>
 #include <vector>
 
 #include "comp_manager.h"
 #include "color_manager.h"
+#include "layer_stack_trace.h"
 
 #define GET_PANEL_FEATURE_FACTORY "GetPanelFeatureFactoryIntf"
 #define GET_DEMURATN_FACTORY "GetDemuraTnCoreUvmFactoryIntf"
@@ -185,8 +188,7 @@ class DisplayBase : public DisplayInterface, public CompManagerEventHandler {
     return kErrorNotSupported;
   }
   virtual DisplayError SetQSyncMode(QSyncMode qsync_mode) { return kErrorNotSupported; }
-  virtual void AppendRCMaskData(std::ostringstream &os);
-  virtual std::string Dump();
+  virtual std::function<std::string()> CollectDump();
   virtual DisplayError InitializeColorModes();
   virtual DisplayError ControlIdlePowerCollapse(bool enable, bool synchronous) {
     return kErrorNotSupported;
@@ -288,6 +290,77 @@ class DisplayBase : public DisplayInterface, public CompManagerEventHandler {
     DisplayMutex &disp_mutex_;
   };
 
+  // Dump state is copied under disp_mutex_ and formatted after it is released, so that a dumpsys
+  // does not hold off the next commit.
+  struct DumpPipe {
+    bool valid = false;
+    uint32_t pipe_id = 0;
+    LayerRect src_roi = {};
+    LayerRect dst_roi = {};
+    uint32_t z_order = 0;
+    uint32_t flags = 0;
+    uint8_t horizontal_decimation = 0;
+    uint8_t vertical_decimation = 0;
+  };
+
+  struct DumpLayer {
+    uint32_t index = 0;
+    LayerComposition composition = kCompositionGPU;
+    uint32_t flags = 0;
+    LayerBufferFormat format = kFormatARGB8888;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int32_t color_primaries = 0;
+    int32_t range = 0;
+    int32_t transfer = 0;
+    bool use_inline_rot = false;
+    uint32_t rot_block_count = 0;
+    LayerRect rot_src_roi[kMaxRotatePerLayer] = {};
+    LayerRect rot_dst_roi[kMaxRotatePerLayer] = {};
+    LayerBufferFormat rot_format = kFormatARGB8888;  // Rotator output, fed to the pipes
+    uint32_t rot_width = 0;
+    uint32_t rot_height = 0;
+    bool use_solidfill_stage = false;
+    LayerRect solidfill_roi = {};
+    uint32_t solidfill_z_order = 0;
+    DumpPipe pipes[2] = {};
+  };
+
+  struct DumpState {
+    DisplayType display_type = kDisplayTypeMax;
+    DisplayDrawMethod draw_method = kDrawDefault;
+    DisplayState state = kStateOff;
+    bool vsync_enable = false;
+    uint32_t max_mixer_stages = 0;
+    NoiseLayerConfig noise_layer_info = {};
+    uint32_t num_modes = 0;
+    uint32_t active_index = 0;
+    HWPanelInfo panel_info = {};
+    HWDisplayAttributes display_attributes = {};
+    HWMixerAttributes mixer_attributes = {};
+    std::string current_color_mode;
+    std::map<std::string, int32_t> color_mode_ids;
+    std::map<std::string, AttrVal> color_mode_attrs;
+    std::string color_manager;
+    std::string qos_prediction;
+    bool has_output_buffer = false;
+    LayerBufferFormat output_format = kFormatARGB8888;
+    uint32_t output_width = 0;
+    uint32_t output_height = 0;
+    std::vector<LayerRect> left_frame_roi;
+    std::vector<LayerRect> right_frame_roi;
+    LayerRect partial_fb_roi = {};
+    std::vector<uint32_t> rc_hw_layer_idx;
+    std::vector<uint32_t> rc_mask_layer_idx;
+    std::vector<DumpLayer> layers;
+  };
+
+  // Copies the state shared by all display types. Called with disp_mutex_ held.
+  void GetDumpState(DumpState *dump_state);
+  static std::string FormatDump(const DumpState &dump_state);
+  // Formats the frame ROIs and the hw layer table, returns false if no hw layers are programmed.
+  static bool FormatLayers(const DumpState &dump_state, std::ostringstream &os);
+
   const char *kBt2020Pq = "bt2020_pq";
   const char *kBt2020Hlg = "bt2020_hlg";
   const char *kDisplayBt2020 = "display_bt2020";
@@ -341,6 +414,7 @@ class DisplayBase : public DisplayInterface, public CompManagerEventHandler {
   DisplayError NoiseInit();
   DisplayError HandleNoiseLayer(LayerStack *layer_stack);
   void PrepareForAsyncTransition();
+  void TraceLayerStack(LayerStack *layer_stack);
   virtual void IdleTimeout() {}
   std::chrono::system_clock::time_point WaitUntil();
   virtual void Abort();
@@ -348,6 +422,8 @@ class DisplayBase : public DisplayInterface, public CompManagerEventHandler {
   DisplayMutex disp_mutex_;
   std::thread commit_thread_;
   int32_t display_id_ = -1;
+  FrameLatencyStats *latency_stats_ = nullptr;
+  std::unique_ptr<LayerStackTraceWriter> layer_stack_trace_ = nullptr;
   DisplayType display_type_;
   DisplayEventHandler *event_handler_ = NULL;
   HWDeviceType hw_device_type_;
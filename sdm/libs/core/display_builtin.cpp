@@ -53,6 +53,9 @@
 
 namespace sdm {
 
+// The adaptive idle timeout stays within [timeout / 2, timeout * 8] of the client timeout.
+static const uint32_t kAdaptiveIdleMaxScale = 8;
+
 DisplayBuiltIn::DisplayBuiltIn(DisplayEventHandler *event_handler, HWInfoInterface *hw_info_intf,
                                BufferAllocator *buffer_allocator, CompManager *comp_manager,
                                std::shared_ptr<IPCIntf> ipc_intf)
@@ -67,6 +70,10 @@ DisplayBuiltIn::DisplayBuiltIn(int32_t display_id, DisplayEventHandler *event_ha
                 hw_info_intf), ipc_intf_(ipc_intf) {}
 
 DisplayBuiltIn::~DisplayBuiltIn() {
+  // Deinit is skipped when Init fails, the panel feature thread must not outlive the display.
+  if (panel_feature_thread_.joinable()) {
+    panel_feature_thread_.join();
+  }
 }
 
 static uint64_t GetTimeInMs(struct timespec ts) {
@@ -75,6 +82,7 @@ static uint64_t GetTimeInMs(struct timespec ts) {
 
 DisplayError DisplayBuiltIn::Init() {
   ClientLock lock(disp_mutex_);
+  uint64_t init_start_ns = GetSystemTimeInNs();
 
   DisplayError error = HWInterface::Create(display_id_, kBuiltIn, hw_info_intf_,
                                            buffer_allocator_, &hw_intf_);
@@ -128,6 +136,7 @@ DisplayError DisplayBuiltIn::Init() {
     DisplayBase::Deinit();
     HWInterface::Destroy(hw_intf_);
     DLOGE("Failed to create hardware events interface on. Error = %d", error);
+    return error;
   }
 
   current_refresh_rate_ = hw_panel_info_.max_fps;
@@ -153,25 +162,12 @@ DisplayError DisplayBuiltIn::Init() {
     }
     DLOGI("RC feature %s.", rc_enable_prop_ ? "enabled" : "disabled");
 
-    if ((error = SetupSPR()) != kErrorNone) {
-      DLOGE("SPR Failed to initialize. Error = %d", error);
-      DisplayBase::Deinit();
-      HWInterface::Destroy(hw_intf_);
-      HWEventsInterface::Destroy(hw_events_intf_);
-      return error;
-    }
-
-    if ((error = HandleSPR()) != kErrorNone) {
-      DLOGE("Failed to get SPR status. Error = %d", error);
-      DisplayBase::Deinit();
-      HWInterface::Destroy(hw_intf_);
-      HWEventsInterface::Destroy(hw_events_intf_);
-      return error;
-    }
-
-    SetupDemuraT0AndTn();
+    // SPR and demura load calibration data and allocate the correction buffer, bring them up in
+    // the background. Frames are composed without correction until they are ready.
+    panel_feature_thread_ = std::thread(&DisplayBuiltIn::SetupPanelFeatures, this);
   } else {
     DLOGW("Skipping Panel Feature Setups!");
+    panel_features_ready_ = true;
   }
   value = 0;
   DebugHandler::Get()->GetProperty(DISABLE_DYNAMIC_FPS, &value);
@@ -193,6 +189,18 @@ DisplayError DisplayBuiltIn::Init() {
   DebugHandler::Get()->GetProperty(ENHANCE_IDLE_TIME, &value);
   enhance_idle_time_ = (value == 1);
 
+  value = 0;
+  DebugHandler::Get()->GetProperty(ENABLE_ADAPTIVE_IDLE_TIMEOUT, &value);
+  adaptive_idle_timeout_ = (value == 1);
+  if (adaptive_idle_timeout_) {
+    IdleGovernorConfig config = {};
+    value = 50;
+    DebugHandler::Get()->GetProperty(ADAPTIVE_IDLE_POWER_BIAS, &value);
+    config.power_bias = UINT32(std::max(value, 0));
+    idle_governor_.Configure(config);
+    DLOGI("Adaptive idle timeout enabled, power bias %u", config.power_bias);
+  }
+
   value = 0;
   DebugHandler::Get()->GetProperty(ENABLE_DPPS_DYNAMIC_FPS, &value);
   enable_dpps_dyn_fps_ = (value == 1);
@@ -218,10 +226,17 @@ DisplayError DisplayBuiltIn::Init() {
   NoiseInit();
   InitCWBBuffer();
 
+  DLOGI("Display %d-%d initialized in %" PRIu64 " us", display_id_, display_type_,
+        (GetSystemTimeInNs() - init_start_ns) / 1000);
+
   return error;
 }
 
 DisplayError DisplayBuiltIn::Deinit() {
+  if (panel_feature_thread_.joinable()) {
+    panel_feature_thread_.join();
+  }
+
   {
     ClientLock lock(disp_mutex_);
 
@@ -259,6 +274,7 @@ DisplayError DisplayBuiltIn::PrePrepare(LayerStack *layer_stack) {
   uint32_t display_width = display_attributes_.x_pixels;
   uint32_t display_height = display_attributes_.y_pixels;
 
+  ApplyPanelFeatures();
   DisplayError error = HandleDemuraLayer(layer_stack);
   if (error != kErrorNone) {
     return error;
@@ -293,7 +309,7 @@ DisplayError DisplayBuiltIn::PrePrepare(LayerStack *layer_stack) {
 }
 
 DisplayError DisplayBuiltIn::HandleSPR() {
-  if (spr_) {
+  if (PanelFeaturesReady() && spr_) {
     GenericPayload out;
     uint32_t *enable = nullptr;
     int ret = out.CreatePayload<uint32_t>(enable);
@@ -477,27 +493,63 @@ DisplayError DisplayBuiltIn::SetupSPR() {
     SPRInputConfig spr_cfg;
     spr_cfg.panel_name = std::string(hw_panel_info_.panel_name);
     spr_cfg.spr_bypassed = (spr_bypass_prop_value) ? true : false;
-    spr_ = pf_factory_->CreateSPRIntf(spr_cfg, prop_intf_);
+    auto spr = pf_factory_->CreateSPRIntf(spr_cfg, prop_intf_);
 
-    if (spr_ == nullptr) {
+    if (spr == nullptr) {
       DLOGE("Failed to create SPR interface");
       return kErrorResources;
     }
 
-    if (spr_->Init() != 0) {
+    if (spr->Init() != 0) {
       DLOGE("Failed to initialize SPR");
       return kErrorResources;
     }
 
+    // Only an initialized SPR is published, frame paths still wait for PanelFeaturesReady().
+    spr_ = spr;
     spr_bypassed_ = spr_cfg.spr_bypassed;
-    if (color_mgr_) {
-      color_mgr_->ColorMgrSetSprIntf(spr_);
-    }
   }
 
   return kErrorNone;
 }
 
+void DisplayBuiltIn::SetupPanelFeatures() {
+  uint64_t start_ns = GetSystemTimeInNs();
+
+  DisplayError error = SetupSPR();
+  if (error != kErrorNone) {
+    // Non-fatal, the display keeps running without SPR.
+    DLOGE("SPR Failed to initialize. Error = %d", error);
+  }
+
+  SetupDemuraT0AndTn();
+
+  DLOGI("Panel features ready on display %d-%d in %" PRIu64 " us", display_id_, display_type_,
+        (GetSystemTimeInNs() - start_ns) / 1000);
+  panel_features_ready_.store(true, std::memory_order_release);
+  event_handler_->Refresh();
+}
+
+void DisplayBuiltIn::ApplyPanelFeatures() {
+  if (panel_features_applied_ || !PanelFeaturesReady()) {
+    return;
+  }
+
+  panel_features_applied_ = true;
+  if (!spr_) {
+    return;
+  }
+
+  if (color_mgr_) {
+    color_mgr_->ColorMgrSetSprIntf(spr_);
+  }
+  if (HandleSPR() != kErrorNone) {
+    DLOGE("Failed to get SPR status on display %d-%d", display_id_, display_type_);
+  }
+  // SPR changes the topology of the next frame.
+  needs_validate_ = true;
+}
+
 DisplayError DisplayBuiltIn::SetupDemura() {
   DemuraInputConfig input_cfg;
   input_cfg.secure_session = false;  // TODO(user): Integrate with secure solution
@@ -506,7 +558,10 @@ DisplayError DisplayBuiltIn::SetupDemura() {
   input_cfg.brightness_path = brightness_base+"brightness";
 
   FetchResourceList frl;
-  comp_manager_->GetDemuraFetchResources(display_comp_ctx_, &frl);
+  {
+    ClientLock lock(disp_mutex_);
+    comp_manager_->GetDemuraFetchResources(display_comp_ctx_, &frl);
+  }
   for (auto &fr : frl) {
     int i = std::get<1>(fr);  // fetch resource index
     input_cfg.resources.set(i);
@@ -568,12 +623,17 @@ DisplayError DisplayBuiltIn::SetupDemura() {
     return kErrorUndefined;
   }
 
-  if (SetDemuraIntfStatus(true)) {
-    return kErrorUndefined;
-  }
+  {
+    // Runs on the panel feature thread, comp manager and demura state belong to the display
+    // thread.
+    ClientLock lock(disp_mutex_);
+    if (SetDemuraIntfStatus(true)) {
+      return kErrorUndefined;
+    }
 
-  comp_manager_->SetDemuraStatusForDisplay(display_id_, true);
-  demura_intended_ = true;
+    comp_manager_->SetDemuraStatusForDisplay(display_id_, true);
+    demura_intended_ = true;
+  }
   DLOGI("Enabled Demura Core!");
 
 #ifndef TRUSTED_VM
@@ -686,8 +746,7 @@ DisplayError DisplayBuiltIn::SetupDemuraT0AndTn() {
   bool demura_allowed = false, demuratn_allowed = false;
 
   if (!comp_manager_->GetDemuraStatus()) {
-    comp_manager_->FreeDemuraFetchResources(display_id_);
-    comp_manager_->SetDemuraStatusForDisplay(display_id_, false);
+    DisableDemura();
     return kErrorNone;
   }
 
@@ -708,8 +767,7 @@ DisplayError DisplayBuiltIn::SetupDemuraT0AndTn() {
   }
 
   if (value > 0) {
-    comp_manager_->FreeDemuraFetchResources(display_id_);
-    comp_manager_->SetDemuraStatusForDisplay(display_id_, false);
+    DisableDemura();
     return kErrorNone;
   } else if (value < 0) {
     return kErrorUndefined;
@@ -797,11 +855,7 @@ DisplayError DisplayBuiltIn::SetupDemuraT0AndTn() {
       // Non-fatal but not expected, log error
       DLOGE("Demura failed to initialize on display %d-%d, Error = %d", display_id_, display_type_,
             error);
-      comp_manager_->FreeDemuraFetchResources(display_id_);
-      comp_manager_->SetDemuraStatusForDisplay(display_id_, false);
-      if (demura_) {
-        SetDemuraIntfStatus(false);
-      }
+      DisableDemura();
     } else if (demuratn_allowed && demuratn_factory_) {
       error = SetupDemuraTn();
       if (error != kErrorNone) {
@@ -812,6 +866,15 @@ DisplayError DisplayBuiltIn::SetupDemuraT0AndTn() {
   return kErrorNone;
 }
 
+void DisplayBuiltIn::DisableDemura() {
+  ClientLock lock(disp_mutex_);
+  comp_manager_->FreeDemuraFetchResources(display_id_);
+  comp_manager_->SetDemuraStatusForDisplay(display_id_, false);
+  if (demura_) {
+    SetDemuraIntfStatus(false);
+  }
+}
+
 DisplayError DisplayBuiltIn::SetupDemuraTn() {
   int ret = 0;
 
@@ -908,6 +971,11 @@ DisplayError DisplayBuiltIn::RetrieveDemuraTnFiles() {
   int ret = 0;
   GenericPayload payload;
 
+  if (!PanelFeaturesReady()) {
+    DLOGW("Panel features are not ready on display %d-%d", display_id_, display_type_);
+    return kErrorNotSupported;
+  }
+
   if (!demuratn_ || !demuratn_enabled_) {
     DLOGE("demuratn_ %pK demuratn_enabled_ %d", demuratn_.get(), demuratn_enabled_);
     return kErrorUndefined;
@@ -962,6 +1030,9 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
     validated_ = false;
     deferred_config_.Clear();
   }
+  if (!deferred_config_.IsDeferredState()) {
+    fps_transition_pending_ = false;
+  }
 
   clock_gettime(CLOCK_MONOTONIC, &idle_timer_start_);
   int idle_time_ms = disp_layer_stack_.info.set_idle_time_ms;
@@ -986,11 +1057,14 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
   }
   dpps_info_.Init(this, hw_panel_info_.panel_name, this);
 
-  if (demuratn_)
+  if (PanelFeaturesReady() && demuratn_)
     EnableDemuraTn(true);
 
   HandleQsyncPostCommit();
 
+  if (adaptive_idle_timeout_) {
+    UpdateIdleGovernor();
+  }
   handle_idle_timeout_ = false;
 
   pending_commit_ = false;
@@ -1061,7 +1135,7 @@ DisplayError DisplayBuiltIn::SetDisplayState(DisplayState state, bool teardown,
   }
 
   // Must go in NullCommit
-  if (demura_intended_ && demura_dynamic_enabled_ &&
+  if (PanelFeaturesReady() && demura_intended_ && demura_dynamic_enabled_ &&
       comp_manager_->GetDemuraStatusForDisplay(display_id_) && (state == kStateOff)) {
     comp_manager_->SetDemuraStatusForDisplay(display_id_, false);
     SetDemuraIntfStatus(false);
@@ -1087,6 +1161,8 @@ DisplayError DisplayBuiltIn::SetDisplayState(DisplayState state, bool teardown,
     if (qsync_mode_ != kQSyncModeNone) {
       needs_avr_update_ = true;
     }
+    // Time spent off is not a gap between updates.
+    last_update_ns_ = 0;
   }
 
   if (pending_power_state_ != kPowerStateNone) {
@@ -1094,7 +1170,7 @@ DisplayError DisplayBuiltIn::SetDisplayState(DisplayState state, bool teardown,
   }
 
   // Must only happen after NullCommit and get applied in next frame
-  if (demura_intended_ && demura_dynamic_enabled_ &&
+  if (PanelFeaturesReady() && demura_intended_ && demura_dynamic_enabled_ &&
       !comp_manager_->GetDemuraStatusForDisplay(display_id_) &&
       (state == kStateOn || state == kStateDoze)) {
     comp_manager_->SetDemuraStatusForDisplay(display_id_, true);
@@ -1106,6 +1182,16 @@ DisplayError DisplayBuiltIn::SetDisplayState(DisplayState state, bool teardown,
 
 void DisplayBuiltIn::SetIdleTimeoutMs(uint32_t active_ms, uint32_t inactive_ms) {
   ClientLock lock(disp_mutex_);
+  if (adaptive_idle_timeout_) {
+    // The client timeout is the starting point of the governor and bounds its choices.
+    IdleGovernorConfig config = idle_governor_.GetConfig();
+    config.default_timeout_ms = active_ms;
+    config.min_timeout_ms = active_ms / 2;
+    config.max_timeout_ms = active_ms * kAdaptiveIdleMaxScale;
+    idle_governor_.Configure(config);
+    idle_inactive_ms_ = inactive_ms;
+    last_update_ns_ = 0;
+  }
   comp_manager_->SetIdleTimeoutMs(display_comp_ctx_, active_ms, inactive_ms);
   validated_ = false;
   handle_idle_timeout_ = false;
@@ -1253,6 +1339,7 @@ DisplayError DisplayBuiltIn::SetRefreshRate(uint32_t refresh_rate, bool final_ra
       handle_idle_timeout_ = false;
       return error;
     }
+    fps_transition_pending_ = true;
 
     error = comp_manager_->CheckEnforceSplit(display_comp_ctx_, refresh_rate);
     if (error != kErrorNone) {
@@ -1690,229 +1777,113 @@ DisplayError DisplayBuiltIn::NotifyDisplayCalibrationMode(bool in_calibration) {
   return ret;
 }
 
-std::string DisplayBuiltIn::Dump() {
-  ClientLock lock(disp_mutex_);
-  HWDisplayAttributes attrib;
-  uint32_t active_index = 0;
-  uint32_t num_modes = 0;
+std::function<std::string()> DisplayBuiltIn::CollectDump() {
+  BuiltInDumpState dump_state;
+
+  {
+    ClientLock lock(disp_mutex_);
+    GetDumpState(&dump_state);
+    dump_state.qsync_mode = active_qsync_mode_;
+    dump_state.color_mode = current_color_mode_;
+    dump_state.adaptive_idle_timeout = adaptive_idle_timeout_;
+    if (adaptive_idle_timeout_) {
+      dump_state.idle_governor = idle_governor_;
+    }
+    if (color_mgr_) {
+      dump_state.color_manager = color_mgr_->Dump();
+    }
+  }
+
+  // Guarded by the comp manager lock, no need to hold off commits for it.
+  dump_state.qos_prediction = comp_manager_->DumpQosPrediction(display_comp_ctx_);
+  if (!dump_state.layers.empty()) {
+    dump_state.resources = comp_manager_->Dump();
+  }
+
+  return [dump_state = std::move(dump_state)]() { return FormatDump(dump_state); };
+}
+
+std::string DisplayBuiltIn::FormatDump(const BuiltInDumpState &dump_state) {
+  const HWPanelInfo &panel_info = dump_state.panel_info;
+  const HWDisplayAttributes &display_attributes = dump_state.display_attributes;
   std::ostringstream os;
   char capabilities[16];
 
-  hw_intf_->GetNumDisplayAttributes(&num_modes);
-  hw_intf_->GetActiveConfig(&active_index);
-  hw_intf_->GetDisplayAttributes(active_index, &attrib);
-
-  os << "device type:" << display_type_;
-  os << " DrawMethod: " << draw_method_;
-  os << "\nstate: " << state_ << " vsync on: " << vsync_enable_
-     << " max. mixer stages: " << max_mixer_stages_;
-  if (disp_layer_stack_.info.noise_layer_info.enable) {
-    os << "\nNoise z-orders: [" << disp_layer_stack_.info.noise_layer_info.zpos_noise << "," <<
-        disp_layer_stack_.info.noise_layer_info.zpos_attn << "]";
+  os << "device type:" << dump_state.display_type;
+  os << " DrawMethod: " << dump_state.draw_method;
+  os << "\nstate: " << dump_state.state << " vsync on: " << dump_state.vsync_enable
+     << " max. mixer stages: " << dump_state.max_mixer_stages;
+  if (dump_state.noise_layer_info.enable) {
+    os << "\nNoise z-orders: [" << dump_state.noise_layer_info.zpos_noise << "," <<
+        dump_state.noise_layer_info.zpos_attn << "]";
   }
-  os << "\nnum configs: " << num_modes << " active config index: " << active_index;
+  os << "\nnum configs: " << dump_state.num_modes << " active config index: "
+     << dump_state.active_index;
   os << "\nDisplay Attributes:";
-  os << "\n Mode:" << (hw_panel_info_.mode == kModeVideo ? "Video" : "Command");
+  os << "\n Mode:" << (panel_info.mode == kModeVideo ? "Video" : "Command");
   os << std::boolalpha;
-  os << " Primary:" << hw_panel_info_.is_primary_panel;
-  os << " DynFPS:" << hw_panel_info_.dynamic_fps;
-  os << "\n HDR Panel:" << hw_panel_info_.hdr_enabled;
-  os << " QSync:" << hw_panel_info_.qsync_support;
-  os << " DynBitclk:" << hw_panel_info_.dyn_bitclk_support;
-  os << "\n Left Split:" << hw_panel_info_.split_info.left_split
-     << " Right Split:" << hw_panel_info_.split_info.right_split;
-  os << "\n PartialUpdate:" << hw_panel_info_.partial_update;
-  if (hw_panel_info_.partial_update) {
-    os << "\n ROI Min w:" << hw_panel_info_.min_roi_width;
-    os << " Min h:" << hw_panel_info_.min_roi_height;
-    os << " NeedsMerge: " << hw_panel_info_.needs_roi_merge;
-    os << " Alignment: l:" << hw_panel_info_.left_align << " w:" << hw_panel_info_.width_align;
-    os << " t:" << hw_panel_info_.top_align << " b:" << hw_panel_info_.height_align;
-  }
-  os << "\n FPS min:" << hw_panel_info_.min_fps << " max:" << hw_panel_info_.max_fps
-     << " cur:" << display_attributes_.fps;
-  os << " TransferTime: " << hw_panel_info_.transfer_time_us << "us";
-  os << " Min TransferTime: " << hw_panel_info_.transfer_time_us_min << "us";
-  os << " Max TransferTime: " << hw_panel_info_.transfer_time_us_max << "us";
-  os << " AllowedModeSwitch: " << hw_panel_info_.allowed_mode_switch;
+  os << " Primary:" << panel_info.is_primary_panel;
+  os << " DynFPS:" << panel_info.dynamic_fps;
+  os << "\n HDR Panel:" << panel_info.hdr_enabled;
+  os << " QSync:" << panel_info.qsync_support;
+  os << " DynBitclk:" << panel_info.dyn_bitclk_support;
+  os << "\n Left Split:" << panel_info.split_info.left_split
+     << " Right Split:" << panel_info.split_info.right_split;
+  os << "\n PartialUpdate:" << panel_info.partial_update;
+  if (panel_info.partial_update) {
+    os << "\n ROI Min w:" << panel_info.min_roi_width;
+    os << " Min h:" << panel_info.min_roi_height;
+    os << " NeedsMerge: " << panel_info.needs_roi_merge;
+    os << " Alignment: l:" << panel_info.left_align << " w:" << panel_info.width_align;
+    os << " t:" << panel_info.top_align << " b:" << panel_info.height_align;
+  }
+  os << "\n FPS min:" << panel_info.min_fps << " max:" << panel_info.max_fps
+     << " cur:" << display_attributes.fps;
+  os << " TransferTime: " << panel_info.transfer_time_us << "us";
+  os << " Min TransferTime: " << panel_info.transfer_time_us_min << "us";
+  os << " Max TransferTime: " << panel_info.transfer_time_us_max << "us";
+  os << " AllowedModeSwitch: " << panel_info.allowed_mode_switch;
   os << " PanelModeCaps: ";
-  snprintf(capabilities, sizeof(capabilities), "0x%x", hw_panel_info_.panel_mode_caps);
+  snprintf(capabilities, sizeof(capabilities), "0x%x", panel_info.panel_mode_caps);
   os << capabilities;
-  os << " MaxBrightness:" << hw_panel_info_.panel_max_brightness;
-  os << "\n Display WxH: " << display_attributes_.x_pixels << "x" << display_attributes_.y_pixels;
-  os << " MixerWxH: " << mixer_attributes_.width << "x" << mixer_attributes_.height;
-  os << " DPI: " << display_attributes_.x_dpi << "x" << display_attributes_.y_dpi;
-  os << " LM_Split: " << display_attributes_.is_device_split;
-  os << "\n vsync_period " << display_attributes_.vsync_period_ns;
-  os << " v_back_porch: " << display_attributes_.v_back_porch;
-  os << " v_front_porch: " << display_attributes_.v_front_porch;
-  os << " v_pulse_width: " << display_attributes_.v_pulse_width;
-  os << "\n v_total: " << display_attributes_.v_total;
-  os << " h_total: " << display_attributes_.h_total;
-  os << " clk: " << display_attributes_.clock_khz;
-  os << " Topology: " << display_attributes_.topology;
-  os << " Qsync mode: " << active_qsync_mode_;
+  os << " MaxBrightness:" << panel_info.panel_max_brightness;
+  os << "\n Display WxH: " << display_attributes.x_pixels << "x" << display_attributes.y_pixels;
+  os << " MixerWxH: " << dump_state.mixer_attributes.width << "x"
+     << dump_state.mixer_attributes.height;
+  os << " DPI: " << display_attributes.x_dpi << "x" << display_attributes.y_dpi;
+  os << " LM_Split: " << display_attributes.is_device_split;
+  os << "\n vsync_period " << display_attributes.vsync_period_ns;
+  os << " v_back_porch: " << display_attributes.v_back_porch;
+  os << " v_front_porch: " << display_attributes.v_front_porch;
+  os << " v_pulse_width: " << display_attributes.v_pulse_width;
+  os << "\n v_total: " << display_attributes.v_total;
+  os << " h_total: " << display_attributes.h_total;
+  os << " clk: " << display_attributes.clock_khz;
+  os << " Topology: " << display_attributes.topology;
+  os << " Qsync mode: " << dump_state.qsync_mode;
   os << std::noboolalpha;
 
+  const snapdragoncolor::ColorMode &color_mode = dump_state.color_mode;
   DynamicRangeType curr_dynamic_range = kSdrType;
-  if (std::find(current_color_mode_.hw_assets.begin(), current_color_mode_.hw_assets.end(),
-                snapdragoncolor::kPbHdrBlob) != current_color_mode_.hw_assets.end()) {
+  if (std::find(color_mode.hw_assets.begin(), color_mode.hw_assets.end(),
+                snapdragoncolor::kPbHdrBlob) != color_mode.hw_assets.end()) {
     curr_dynamic_range = kHdrType;
   }
-  os << "\nCurrent Color Mode: gamut " << current_color_mode_.gamut << " gamma "
-     << current_color_mode_.gamma << " intent " << current_color_mode_.intent << " Dynamice_range"
+  os << "\nCurrent Color Mode: gamut " << color_mode.gamut << " gamma "
+     << color_mode.gamma << " intent " << color_mode.intent << " Dynamice_range"
      << (curr_dynamic_range == kSdrType ? " SDR" : " HDR");
+  os << dump_state.color_manager;
+  os << dump_state.qos_prediction;
 
-  uint32_t num_hw_layers = UINT32(disp_layer_stack_.info.hw_layers.size());
-
-  if (num_hw_layers == 0) {
-    os << "\nNo hardware layers programmed";
+  if (!FormatLayers(dump_state, os)) {
     return os.str();
   }
 
-  std::shared_ptr<LayerBuffer> out_buffer = disp_layer_stack_.info.output_buffer;
-  if (out_buffer) {
-    os << "\n Output buffer res: " << out_buffer->width << "x" << out_buffer->height
-       << " format: " << GetFormatString(out_buffer->format);
+  if (dump_state.adaptive_idle_timeout) {
+    os << dump_state.idle_governor.Dump();
   }
-  HWLayersInfo &layer_info = disp_layer_stack_.info;
-  for (uint32_t i = 0; i < layer_info.left_frame_roi.size(); i++) {
-    LayerRect &l_roi = layer_info.left_frame_roi.at(i);
-    LayerRect &r_roi = layer_info.right_frame_roi.at(i);
-
-    os << "\nROI(LTRB)#" << i << " LEFT(" << INT(l_roi.left) << " " << INT(l_roi.top) << " " <<
-      INT(l_roi.right) << " " << INT(l_roi.bottom) << ")";
-    if (IsValid(r_roi)) {
-    os << " RIGHT(" << INT(r_roi.left) << " " << INT(r_roi.top) << " " << INT(r_roi.right) << " "
-      << INT(r_roi.bottom) << ")";
-    }
-  }
-
-  LayerRect &fb_roi = layer_info.partial_fb_roi;
-  if (IsValid(fb_roi)) {
-    os << "\nPartial FB ROI(LTRB):(" << INT(fb_roi.left) << " " << INT(fb_roi.top) << " " <<
-      INT(fb_roi.right) << " " << INT(fb_roi.bottom) << ")";
-  }
-
-  AppendRCMaskData(os);
-
-  const char *header  = "\n| Idx |   Comp Type   |   Split   | Pipe |    W x H    |          Format          |  Src Rect (L T R B) |  Dst Rect (L T R B) |  Z | Pipe Flags | Deci(HxV) | CS | Rng | Tr |";  //NOLINT
-  const char *newline = "\n|-----|---------------|-----------|------|-------------|--------------------------|---------------------|---------------------|----|------------|-----------|----|-----|----|";  //NOLINT
-  const char *format  = "\n| %3s | %13s | %9s | %4d | %4d x %4d | %24s | %4d %4d %4d %4d | %4d %4d %4d %4d | %2s | %10s | %9s | %2s | %3s | %2s |";  //NOLINT
-
+  os << dump_state.resources;
   os << "\n";
-  os << newline;
-  os << header;
-  os << newline;
-
-  for (uint32_t i = 0; i < num_hw_layers; i++) {
-    uint32_t layer_index = disp_layer_stack_.info.index.at(i);
-    // hw-layer from hw layers info
-    Layer &hw_layer = disp_layer_stack_.info.hw_layers.at(i);
-    LayerBuffer *input_buffer = &hw_layer.input_buffer;
-    HWLayerConfig &layer_config = disp_layer_stack_.info.config[i];
-    HWRotatorSession &hw_rotator_session = layer_config.hw_rotator_session;
-
-    const char *comp_type = GetCompositionName(hw_layer.composition);
-    const char *buffer_format = GetFormatString(input_buffer->format);
-    const char *pipe_split[2] = { "Pipe-1", "Pipe-2" };
-    const char *rot_pipe[2] = { "Rot-inl-1", "Rot-inl-2" };
-    char idx[8];
-
-    snprintf(idx, sizeof(idx), "%d", layer_index);
-
-    for (uint32_t count = 0; count < hw_rotator_session.hw_block_count; count++) {
-      char row[1024];
-      HWRotateInfo &rotate = hw_rotator_session.hw_rotate_info[count];
-      LayerRect &src_roi = rotate.src_roi;
-      LayerRect &dst_roi = rotate.dst_roi;
-      char rot[12] = { 0 };
-
-      snprintf(rot, sizeof(rot), "Rot-%s-%d", layer_config.use_inline_rot ?
-               "inl" : "off", count + 1);
-
-      snprintf(row, sizeof(row), format, idx, comp_type, rot,
-               0, input_buffer->width, input_buffer->height, buffer_format,
-               INT(src_roi.left), INT(src_roi.top), INT(src_roi.right), INT(src_roi.bottom),
-               INT(dst_roi.left), INT(dst_roi.top), INT(dst_roi.right), INT(dst_roi.bottom),
-               "-", "-    ", "-    ", "-", "-", "-");
-      os << row;
-      // print the below only once per layer block, fill with spaces for rest.
-      idx[0] = 0;
-      comp_type = "";
-    }
-
-    if (hw_rotator_session.hw_block_count > 0) {
-      input_buffer = &hw_rotator_session.output_buffer;
-      buffer_format = GetFormatString(input_buffer->format);
-    }
-
-    if (layer_config.use_solidfill_stage) {
-      LayerRect src_roi = layer_config.hw_solidfill_stage.roi;
-      const char *decimation = "";
-      char flags[16] = { 0 };
-      char z_order[8] = { 0 };
-      const char *color_primary = "";
-      const char *range = "";
-      const char *transfer = "";
-      char row[1024] = { 0 };
-
-      snprintf(z_order, sizeof(z_order), "%d", layer_config.hw_solidfill_stage.z_order);
-      snprintf(flags, sizeof(flags), "0x%08x", hw_layer.flags.flags);
-      snprintf(row, sizeof(row), format, idx, comp_type, pipe_split[0],
-               0, INT(src_roi.right), INT(src_roi.bottom),
-               buffer_format, INT(src_roi.left), INT(src_roi.top),
-               INT(src_roi.right), INT(src_roi.bottom), INT(src_roi.left),
-               INT(src_roi.top), INT(src_roi.right), INT(src_roi.bottom),
-               z_order, flags, decimation, color_primary, range, transfer);
-      os << row;
-      continue;
-    }
-
-    for (uint32_t count = 0; count < 2; count++) {
-      char decimation[16] = { 0 };
-      char flags[16] = { 0 };
-      char z_order[8] = { 0 };
-      char color_primary[8] = { 0 };
-      char range[8] = { 0 };
-      char transfer[8] = { 0 };
-      bool rot = layer_config.use_inline_rot;
-
-      HWPipeInfo &pipe = (count == 0) ? layer_config.left_pipe : layer_config.right_pipe;
-
-      if (!pipe.valid) {
-        continue;
-      }
-
-      LayerRect src_roi = pipe.src_roi;
-      LayerRect &dst_roi = pipe.dst_roi;
-
-      snprintf(z_order, sizeof(z_order), "%d", pipe.z_order);
-      snprintf(flags, sizeof(flags), "0x%08x", pipe.flags);
-      snprintf(decimation, sizeof(decimation), "%3d x %3d", pipe.horizontal_decimation,
-               pipe.vertical_decimation);
-      ColorMetaData &color_metadata = hw_layer.input_buffer.color_metadata;
-      snprintf(color_primary, sizeof(color_primary), "%d", color_metadata.colorPrimaries);
-      snprintf(range, sizeof(range), "%d", color_metadata.range);
-      snprintf(transfer, sizeof(transfer), "%d", color_metadata.transfer);
-
-      char row[1024];
-      snprintf(row, sizeof(row), format, idx, comp_type, rot ? rot_pipe[count] : pipe_split[count],
-               pipe.pipe_id, input_buffer->width, input_buffer->height,
-               buffer_format, INT(src_roi.left), INT(src_roi.top),
-               INT(src_roi.right), INT(src_roi.bottom), INT(dst_roi.left),
-               INT(dst_roi.top), INT(dst_roi.right), INT(dst_roi.bottom),
-               z_order, flags, decimation, color_primary, range, transfer);
-
-      os << row;
-      // print the below only once per layer block, fill with spaces for rest.
-      idx[0] = 0;
-      comp_type = "";
-    }
-  }
-
-  os << comp_manager_->Dump();
-  os << newline << "\n";
 
   return os.str();
 }
@@ -2239,7 +2210,7 @@ DisplayError DisplayBuiltIn::HandleDemuraLayer(LayerStack *layer_stack) {
   std::vector<Layer *> &layers = layer_stack->layers;
   HWLayersInfo &hw_layers_info = disp_layer_stack_.info;
 
-  if (comp_manager_->GetDemuraStatus() &&
+  if (PanelFeaturesReady() && comp_manager_->GetDemuraStatus() &&
       comp_manager_->GetDemuraStatusForDisplay(display_id_) &&
       demura_layer_.input_buffer.planes[0].fd > 0) {
     if (hw_layers_info.demura_target_index == -1) {
@@ -2679,7 +2650,7 @@ DisplayError DisplayBuiltIn::HandleSecureEvent(SecureEvent secure_event, bool *n
 
   if (secure_event == kTUITransitionEnd) {
     // enable demura after TUI transition end
-    if (demura_) {
+    if (PanelFeaturesReady() && demura_) {
       SetDemuraIntfStatus(true);
     }
   }
@@ -2690,7 +2661,7 @@ DisplayError DisplayBuiltIn::HandleSecureEvent(SecureEvent secure_event, bool *n
 DisplayError DisplayBuiltIn::PostHandleSecureEvent(SecureEvent secure_event) {
   ClientLock lock(disp_mutex_);
   if (secure_event == kTUITransitionStart) {
-    if (vm_cb_intf_) {
+    if (PanelFeaturesReady() && vm_cb_intf_) {
       vm_cb_intf_->ExportHFCBuffer();
     }
     if (!pending_brightness_) {
@@ -2706,13 +2677,13 @@ DisplayError DisplayBuiltIn::PostHandleSecureEvent(SecureEvent secure_event) {
 
     if (secure_event == kTUITransitionStart) {
       //  disable demura before TUI transition start
-      if (demura_) {
+      if (PanelFeaturesReady() && demura_) {
         SetDemuraIntfStatus(false);
       }
     }
   }
   if (secure_event == kTUITransitionEnd) {
-    if (vm_cb_intf_) {
+    if (PanelFeaturesReady() && vm_cb_intf_) {
       vm_cb_intf_->FreeExportBuffer();
     }
   }
@@ -2975,6 +2946,7 @@ DisplayError DisplayBuiltIn::ChangeFps() {
       }
       return error;
     }
+    fps_transition_pending_ = true;
 
     error = comp_manager_->CheckEnforceSplit(display_comp_ctx_, refresh_rate);
     if (error != kErrorNone) {
@@ -2995,6 +2967,30 @@ DisplayError DisplayBuiltIn::ChangeFps() {
   return ReconfigureDisplay();
 }
 
+void DisplayBuiltIn::UpdateIdleGovernor() {
+  // The idle fallback frame is not a content update. Command mode panels have no idle timer.
+  if (handle_idle_timeout_ || hw_panel_info_.mode != kModeVideo ||
+      !idle_governor_.GetConfig().default_timeout_ms) {
+    return;
+  }
+
+  uint64_t now_ns = GetSystemTimeInNs();
+  uint64_t last_ns = last_update_ns_;
+  last_update_ns_ = now_ns;
+  if (!last_ns) {
+    return;
+  }
+
+  uint64_t gap_ms = (now_ns - last_ns) / 1000000;
+  if (idle_governor_.AddFrameGap(UINT32(std::min(gap_ms, UINT64(UINT32_MAX))))) {
+    DLOGI_IF(kTagDisplay, "Idle timeout %u ms on display %d-%d", idle_governor_.GetTimeoutMs(),
+             display_id_, display_type_);
+    // Picked up by the strategy on the next validated frame.
+    comp_manager_->SetIdleTimeoutMs(display_comp_ctx_, idle_governor_.GetTimeoutMs(),
+                                    idle_inactive_ms_);
+  }
+}
+
 bool DisplayBuiltIn::IdleFallbackLowerFps(bool idle_screen) {
   if (!enhance_idle_time_) {
     return (disp_layer_stack_.info.lower_fps);
@@ -3050,10 +3046,21 @@ uint32_t DisplayBuiltIn::CalculateMetaDataRefreshRate() {
   uint32_t min_refresh_rate = 0;
   GetRefreshRateRange(&min_refresh_rate, &max_refresh_rate);
 
+  // Presents around a refresh rate switch are paced by the switch, not by the content
+  bool use_cadence = !fps_transition_pending_ && !deferred_config_.IsDeferredState();
+
   for (uint i = 0; i < layer_stack->layers.size(); i++) {
     auto layer = layer_stack->layers.at(i);
-    if (layer->flags.has_metadata_refresh_rate && layer->frame_rate > metadata_refresh_rate) {
-      metadata_refresh_rate = SanitizeRefreshRate(layer->frame_rate, max_refresh_rate,
+    uint32_t layer_refresh_rate = 0;
+    if (layer->flags.has_metadata_refresh_rate) {
+      layer_refresh_rate = layer->frame_rate;
+    } else if (use_cadence && layer->flags.updating && layer->input_buffer.flags.video) {
+      // Without explicit metadata, use the cadence video is being presented at. UI layers
+      // follow input and animations, their cadence says nothing about the content rate.
+      layer_refresh_rate = layer->cadence_rate;
+    }
+    if (layer_refresh_rate > metadata_refresh_rate) {
+      metadata_refresh_rate = SanitizeRefreshRate(layer_refresh_rate, max_refresh_rate,
                                                   min_refresh_rate);
     }
   }
@@ -3080,7 +3087,7 @@ uint32_t DisplayBuiltIn::SanitizeRefreshRate(uint32_t req_refresh_rate, uint32_t
 DisplayError DisplayBuiltIn::SetDemuraState(int state) {
   int ret = 0;
 
-  if (!demura_intended_) {
+  if (!PanelFeaturesReady() || !demura_intended_) {
     DLOGW("Demura has not enabled");
     return kErrorNone;
   }
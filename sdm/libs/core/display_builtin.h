@@ -44,11 +44,14 @@
 #include <private/panel_feature_property_intf.h>
 #include <private/panel_feature_factory_intf.h>
 #include <private/hw_events_interface.h>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "display_base.h"
 #include "drm_interface.h"
+#include "idle_governor.h"
 
 namespace sdm {
 
@@ -176,8 +179,8 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DisplayError GetStcColorModes(snapdragoncolor::ColorModeList *mode_list) override;
   DisplayError SetStcColorMode(const snapdragoncolor::ColorMode &color_mode) override;
   DisplayError NotifyDisplayCalibrationMode(bool in_calibration) override;
-  bool HasDemura() override { return demura_intended_; }
-  std::string Dump() override;
+  bool HasDemura() override { return PanelFeaturesReady() && demura_intended_; }
+  std::function<std::string()> CollectDump() override;
   DisplayError GetConfig(DisplayConfigFixedInfo *fixed_info) override;
   DisplayError PrePrepare(LayerStack *layer_stack) override;
   DisplayError SetAlternateDisplayConfig(uint32_t *alt_config) override;
@@ -224,6 +227,15 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DisplayError GetQsyncFps(uint32_t *qsync_fps) override;
 
  private:
+  struct BuiltInDumpState : DumpState {
+    QSyncMode qsync_mode = kQSyncModeNone;
+    snapdragoncolor::ColorMode color_mode = {};
+    bool adaptive_idle_timeout = false;
+    IdleGovernor idle_governor;
+    std::string resources;
+  };
+
+  static std::string FormatDump(const BuiltInDumpState &dump_state);
   bool CanCompareFrameROI(LayerStack *layer_stack);
   bool CanSkipDisplayPrepare(LayerStack *layer_stack);
   HWAVRModes GetAvrMode(QSyncMode mode);
@@ -232,11 +244,16 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   void GetFpsConfig(HWDisplayAttributes *display_attributes, HWPanelInfo *panel_info);
   PrimariesTransfer GetBlendSpaceFromStcColorMode(const snapdragoncolor::ColorMode &color_mode);
   DisplayError SetupSPR();
+  void SetupPanelFeatures();
+  void ApplyPanelFeatures();
+  // SPR and demura members are owned by the bring-up thread until this returns true.
+  bool PanelFeaturesReady() { return panel_features_ready_.load(std::memory_order_acquire); }
   DisplayError SetupDemura();
   DisplayError SetupDemuraLayer();
   DisplayError SetupDemuraTn();
   DisplayError EnableDemuraTn(bool enable);
   DisplayError SetupDemuraT0AndTn();
+  void DisableDemura();
   DisplayError BuildLayerStackStats(LayerStack *layer_stack) override;
   void UpdateDisplayModeParams();
   void HandleQsyncPostCommit();
@@ -254,6 +271,7 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DisplayError HandleDemuraLayer(LayerStack *layer_stack);
   void NotifyDppsHdrPresent(LayerStack *layer_stack);
   bool IdleFallbackLowerFps(bool idle_screen);
+  void UpdateIdleGovernor();
 
   const uint32_t kPuTimeOutMs = 1000;
   std::vector<HWEvent> event_list_;
@@ -282,10 +300,14 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   sde_drm::DppsFeaturePayload histogramIRQ;
   void initColorSamplingState();
   DeferFpsConfig deferred_config_ = {};
+  bool fps_transition_pending_ = false;  // A new refresh rate is programmed but not committed
   snapdragoncolor::ColorMode current_color_mode_ = {};
   snapdragoncolor::ColorModeList stc_color_modes_ = {};
 
   std::shared_ptr<SPRIntf> spr_ = nullptr;
+  std::thread panel_feature_thread_;
+  std::atomic<bool> panel_features_ready_{false};
+  bool panel_features_applied_ = false;
   bool needs_validate_on_pu_enable_ = false;
   bool enable_qsync_idle_ = false;
   bool pending_vsync_enable_ = false;
@@ -294,6 +316,10 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   bool enhance_idle_time_ = false;
   int idle_time_ms_ = 0;
   struct timespec idle_timer_start_;
+  bool adaptive_idle_timeout_ = false;
+  IdleGovernor idle_governor_;
+  uint32_t idle_inactive_ms_ = 0;
+  uint64_t last_update_ns_ = 0;  // Commit time of the last frame with content updates
   std::shared_ptr<DemuraIntf> demura_ = nullptr;
   bool demuratn_enabled_ = false;
   std::shared_ptr<DemuraTnCoreUvmIntf> demuratn_ = nullptr;
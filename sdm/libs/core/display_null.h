@@ -69,7 +69,7 @@ class DisplayNull : public DisplayInterface {
   virtual DisplayError GetDisplayIdentificationData(uint8_t *out_port, uint32_t *out_data_size,
                                                     uint8_t *out_data);
   virtual bool CheckResourceState(bool *res_exhausted) { return false; }
-  virtual string Dump() { return ""; }
+  virtual std::function<string()> CollectDump() { return [] { return string(); }; }
   virtual bool IsSupportSsppTonemap() { return false; }
   virtual bool GameEnhanceSupported() { return false; }
   virtual bool HasDemura() { return false; }
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "idle_governor.h"
+
+namespace sdm {
+
+const uint32_t IdleGovernor::kNumBuckets;
+const uint32_t IdleGovernor::kUpdateFrames;
+
+// Bucket i starts at kFirstEdgeMs * 2^(i / kBucketsPerOctave), the histogram spans 8 ms to 8 s.
+static const double kFirstEdgeMs = 8.0;
+static const double kBucketsPerOctave = 4.0;
+// Weight kept at every update, old gaps fade out over a few hundred frames.
+static const double kDecay = 0.75;
+
+static uint32_t GetBucketEdge(uint32_t bucket) {
+  return static_cast<uint32_t>(kFirstEdgeMs * pow(2.0, bucket / kBucketsPerOctave) + 0.5);
+}
+
+void IdleGovernor::Configure(const IdleGovernorConfig &config) {
+  config_ = config;
+  config_.max_timeout_ms = std::max(config_.max_timeout_ms, config_.min_timeout_ms);
+  config_.power_bias = std::min(config_.power_bias, 100u);
+  timeout_ms_ = config_.default_timeout_ms;
+  std::fill(weights_, weights_ + kNumBuckets + 1, 0.0);
+  std::fill(gap_sums_, gap_sums_ + kNumBuckets + 1, 0.0);
+  pending_frames_ = 0;
+  total_gaps_ = 0;
+  updates_ = 0;
+  cost_ = 0.0;
+}
+
+uint32_t IdleGovernor::GetBucket(uint32_t gap_ms) {
+  if (gap_ms < kFirstEdgeMs) {
+    return 0;
+  }
+  double bucket = floor(kBucketsPerOctave * log2(gap_ms / kFirstEdgeMs));
+  return std::min(static_cast<uint32_t>(bucket), kNumBuckets);
+}
+
+bool IdleGovernor::AddFrameGap(uint32_t gap_ms) {
+  uint32_t bucket = GetBucket(gap_ms);
+  weights_[bucket] += 1.0;
+  gap_sums_[bucket] += gap_ms;
+  total_gaps_++;
+
+  if (++pending_frames_ < kUpdateFrames) {
+    return false;
+  }
+
+  pending_frames_ = 0;
+  updates_++;
+  uint32_t timeout_ms = ChooseTimeout(&cost_);
+  for (uint32_t i = 0; i <= kNumBuckets; i++) {
+    weights_[i] *= kDecay;
+    gap_sums_[i] *= kDecay;
+  }
+
+  if (timeout_ms == timeout_ms_) {
+    return false;
+  }
+  timeout_ms_ = timeout_ms;
+  return true;
+}
+
+double IdleGovernor::GetCost(uint32_t timeout_ms) const {
+  double total = 0.0;
+  double churn = 0.0;
+  double full_power_ms = 0.0;
+
+  for (uint32_t i = 0; i <= kNumBuckets; i++) {
+    if (weights_[i] <= 0.0) {
+      continue;
+    }
+    total += weights_[i];
+    double gap_ms = gap_sums_[i] / weights_[i];
+    if (gap_ms <= timeout_ms) {
+      continue;
+    }
+    full_power_ms += weights_[i] * timeout_ms;
+    if (gap_ms - timeout_ms < config_.churn_window_ms) {
+      churn += weights_[i];
+    }
+  }
+
+  if (total <= 0.0 || !config_.max_timeout_ms) {
+    return 0.0;
+  }
+
+  double power_bias = config_.power_bias / 100.0;
+  return (1.0 - power_bias) * churn / total +
+         power_bias * full_power_ms / (total * config_.max_timeout_ms);
+}
+
+uint32_t IdleGovernor::ChooseTimeout(double *cost) const {
+  // Candidates are the bucket edges within the bounds, ties go to the shorter timeout.
+  uint32_t best_ms = config_.min_timeout_ms;
+  double best_cost = GetCost(best_ms);
+  for (uint32_t i = 0; i <= kNumBuckets; i++) {
+    uint32_t edge_ms = GetBucketEdge(i);
+    if (edge_ms <= config_.min_timeout_ms) {
+      continue;
+    }
+    edge_ms = std::min(edge_ms, config_.max_timeout_ms);
+    double edge_cost = GetCost(edge_ms);
+    if (edge_cost < best_cost) {
+      best_cost = edge_cost;
+      best_ms = edge_ms;
+    }
+    if (edge_ms == config_.max_timeout_ms) {
+      break;
+    }
+  }
+
+  *cost = best_cost;
+  return best_ms;
+}
+
+std::string IdleGovernor::Dump() const {
+  std::ostringstream os;
+  os << "\nAdaptive idle timeout: " << timeout_ms_ << " ms";
+  os << " bounds: [" << config_.min_timeout_ms << ", " << config_.max_timeout_ms << "] ms";
+  os << " power bias: " << config_.power_bias << " gaps: " << total_gaps_;
+  os << " updates: " << updates_ << " cost: " << cost_;
+  os << "\n Gap histogram (ms:weight):";
+  for (uint32_t i = 0; i <= kNumBuckets; i++) {
+    if (weights_[i] >= 0.01) {
+      char entry[32];
+      snprintf(entry, sizeof(entry), " %u:%.2f", GetBucketEdge(i), weights_[i]);
+      os << entry;
+    }
+  }
+  return os.str();
+}
+
+}  // namespace sdm
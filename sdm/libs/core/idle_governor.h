@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __IDLE_GOVERNOR_H__
+#define __IDLE_GOVERNOR_H__
+
+#include <stdint.h>
+
+#include <string>
+
+namespace sdm {
+
+struct IdleGovernorConfig {
+  uint32_t default_timeout_ms = 0;  // Used until enough gaps have been seen
+  uint32_t min_timeout_ms = 0;
+  uint32_t max_timeout_ms = 0;
+  uint32_t power_bias = 50;         // 0: avoid fallback churn at any power cost, 100: idle asap
+  uint32_t churn_window_ms = 1000;  // Idle periods shorter than this count as churn
+};
+
+// Picks the idle timeout of a display from the distribution of gaps between frames with content
+// updates. Gaps are kept in a decaying histogram of log spaced buckets. For a candidate timeout T
+// every gap longer than T drops the display to idle fallback after T ms at full power, and if the
+// next frame follows within the churn window the drop is churn: a composition switch to idle and
+// straight back. The timeout with the lowest power bias weighted sum of churn rate and full power
+// time spent before idling is chosen.
+class IdleGovernor {
+ public:
+  static const uint32_t kNumBuckets = 40;
+  static const uint32_t kUpdateFrames = 30;
+
+  void Configure(const IdleGovernorConfig &config);
+  // Records the gap in ms between two frames with content updates. Returns true if the timeout
+  // changed.
+  bool AddFrameGap(uint32_t gap_ms);
+  uint32_t GetTimeoutMs() const { return timeout_ms_; }
+  const IdleGovernorConfig &GetConfig() const { return config_; }
+  // Expected cost of a timeout under the current histogram, lower is better.
+  double GetCost(uint32_t timeout_ms) const;
+  std::string Dump() const;
+
+ private:
+  static uint32_t GetBucket(uint32_t gap_ms);
+  uint32_t ChooseTimeout(double *cost) const;
+
+  IdleGovernorConfig config_ = {};
+  uint32_t timeout_ms_ = 0;
+  double weights_[kNumBuckets + 1] = {};   // Last bucket collects gaps beyond the histogram
+  double gap_sums_[kNumBuckets + 1] = {};  // Decayed sum of the gaps in each bucket
+  uint32_t pending_frames_ = 0;
+  uint64_t total_gaps_ = 0;
+  uint32_t updates_ = 0;
+  double cost_ = 0.0;
+};
+
+}  // namespace sdm
+
+#endif  // __IDLE_GOVERNOR_H__
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+// Replays a layer stack trace captured by DisplayBase (see LAYER_STACK_TRACE_FRAMES_PROP) through
+// CompManager, Strategy and the resource manager, with the driver validate replaced by a check
+// against the traced HWResourceInfo. Reports the composition chosen for every frame, the GPU
+// fallback rate and the CPU time spent per frame, so strategy changes can be compared offline.
+
+#include <private/extension_interface.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/frame_latency_stats.h>
+#include <utils/sys.h>
+
+#include <iostream>
+#include <string>
+
+#include "comp_manager.h"
+#include "layer_stack_trace.h"
+
+using namespace sdm;
+
+namespace {
+
+class ReplayEventHandler : public CompManagerEventHandler {
+ public:
+  void NotifyCwbDone(int32_t status, const LayerBuffer &buffer) override {}
+  void Refresh() override {}
+};
+
+struct ReplaySummary {
+  uint32_t frames = 0;
+  uint32_t gpu_fallbacks = 0;
+  uint32_t failures = 0;
+  LatencyHistogram cpu_time_us;
+};
+
+void ShowUsage(const char *progname) {
+  std::cout << "Usage: " << progname << " [-e] [-q] trace\n"
+            << "Replay a layer stack trace through the SDM composition strategies.\n\n"
+            << "\tOptions:\n"
+            << "\t-e      load " << EXTENSION_LIBRARY_NAME << " for the strategy and resources\n"
+            << "\t-q      only print the summary\n";
+}
+
+uint64_t GetThreadCpuTimeNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return UINT64(ts.tv_sec) * 1000000000ull + UINT64(ts.tv_nsec);
+}
+
+// Stands in for HWInterface::Validate, which is the only driver call of the prepare loop. Rejects
+// what the traced hardware could never stage; bandwidth and clock limits are not modelled.
+DisplayError StubValidate(const HWResourceInfo &hw_resource, const HWLayersInfo &info) {
+  if (info.hw_layers.size() > hw_resource.num_blending_stages) {
+    return kErrorResources;
+  }
+
+  return kErrorNone;
+}
+
+// Mirrors DisplayBase::BuildLayerStackStats for the fields the strategies consume.
+DisplayError BuildLayerStackStats(LayerStack *stack, DispLayerStack *disp_layer_stack) {
+  HWLayersInfo &info = disp_layer_stack->info;
+  info.app_layer_count = 0;
+  info.gpu_target_index = -1;
+  info.stitch_target_index = -1;
+  info.noise_layer_index = -1;
+  disp_layer_stack->stack = stack;
+  info.flags = stack->flags;
+  info.blend_cs = stack->blend_cs;
+
+  int index = 0;
+  for (auto layer : stack->layers) {
+    layer->buffer_map = std::make_shared<LayerBufferMap>();
+    if (layer->composition == kCompositionGPUTarget) {
+      info.gpu_target_index = info.app_layer_count;
+    } else if (layer->composition == kCompositionStitchTarget) {
+      info.stitch_target_index = index;
+    } else if (!layer->flags.is_noise) {
+      info.app_layer_count++;
+    }
+    if (layer->flags.is_game) {
+      info.game_present = true;
+    }
+    index++;
+  }
+
+  return info.app_layer_count ? kErrorNone : kErrorNoAppLayers;
+}
+
+class Replayer {
+ public:
+  ~Replayer();
+  DisplayError Init(bool use_extension);
+  DisplayError Configure(const LayerStackTraceConfig &config);
+  DisplayError Replay(LayerStackTraceFrame *frame, bool quiet);
+  const ReplaySummary &GetSummary() const { return summary_; }
+  int32_t GetDisplayId() const { return config_.display_id; }
+
+ private:
+  DynLib extension_lib_;
+  ExtensionInterface *extension_intf_ = nullptr;
+  DestroyExtensionInterface destroy_extension_intf_ = nullptr;
+  CompManager comp_manager_;
+  bool comp_manager_ready_ = false;
+  Handle display_ctx_ = nullptr;
+  ReplayEventHandler event_handler_;
+  LayerStackTraceConfig config_ = {};
+  DispLayerStack disp_layer_stack_ = {};
+  ReplaySummary summary_;
+};
+
+Replayer::~Replayer() {
+  if (display_ctx_) {
+    comp_manager_.UnregisterDisplay(display_ctx_);
+  }
+  if (comp_manager_ready_) {
+    comp_manager_.Deinit();
+  }
+  if (extension_intf_) {
+    destroy_extension_intf_(extension_intf_);
+  }
+}
+
+DisplayError Replayer::Init(bool use_extension) {
+  if (!use_extension) {
+    return kErrorNone;
+  }
+
+  CreateExtensionInterface create_extension_intf = nullptr;
+  if (!extension_lib_.Open(EXTENSION_LIBRARY_NAME) ||
+      !extension_lib_.Sym(CREATE_EXTENSION_INTERFACE_NAME,
+                          reinterpret_cast<void **>(&create_extension_intf)) ||
+      !extension_lib_.Sym(DESTROY_EXTENSION_INTERFACE_NAME,
+                          reinterpret_cast<void **>(&destroy_extension_intf_))) {
+    std::cerr << "Unable to load " << EXTENSION_LIBRARY_NAME << ": " << extension_lib_.Error()
+              << "\n";
+    return kErrorUndefined;
+  }
+
+  return create_extension_intf(EXTENSION_VERSION_TAG, &extension_intf_);
+}
+
+DisplayError Replayer::Configure(const LayerStackTraceConfig &config) {
+  DisplayError error = kErrorNone;
+  HWQosData qos_data = {};
+
+  if (!comp_manager_ready_) {
+    // Buffer allocator and socket handler are only used by the extension for features a replay
+    // does not exercise.
+    error = comp_manager_.Init(config.hw_resource, extension_intf_, nullptr, nullptr);
+    if (error != kErrorNone) {
+      return error;
+    }
+    comp_manager_ready_ = true;
+  }
+
+  if (display_ctx_) {
+    error = comp_manager_.ReconfigureDisplay(display_ctx_, config.display_attributes,
+                                             config.panel_info, config.mixer_attributes,
+                                             config.fb_config, &qos_data);
+  } else {
+    error = comp_manager_.RegisterDisplay(config.display_id, config.display_type,
+                                          config.display_attributes, config.panel_info,
+                                          config.mixer_attributes, config.fb_config,
+                                          &display_ctx_, &qos_data, &event_handler_);
+    if (error == kErrorNone) {
+      comp_manager_.SetMaxMixerStages(display_ctx_, config.hw_resource.num_blending_stages);
+    }
+  }
+
+  config_ = config;
+  return error;
+}
+
+DisplayError Replayer::Replay(LayerStackTraceFrame *frame, bool quiet) {
+  if (!display_ctx_) {
+    return kErrorNotSupported;
+  }
+
+  LayerStack *stack = &frame->stack;
+  uint64_t start = GetThreadCpuTimeNs();
+  DisplayError error = BuildLayerStackStats(stack, &disp_layer_stack_);
+  uint32_t attempts = 0;
+
+  if (error == kErrorNone) {
+    stack->needs_validate = true;
+    error = comp_manager_.PrePrepare(display_ctx_, &disp_layer_stack_);
+  }
+
+  if (error == kErrorNone) {
+    disp_layer_stack_.info.updates_mask.set(kUpdateResources);
+    comp_manager_.GenerateROI(display_ctx_, &disp_layer_stack_);
+    while (true) {
+      attempts++;
+      error = comp_manager_.Prepare(display_ctx_, &disp_layer_stack_);
+      if (error != kErrorNone) {
+        break;
+      }
+      if (!disp_layer_stack_.info.do_hw_validate ||
+          StubValidate(config_.hw_resource, disp_layer_stack_.info) == kErrorNone) {
+        break;
+      }
+    }
+    comp_manager_.PostPrepare(display_ctx_, &disp_layer_stack_);
+  }
+
+  if (error == kErrorNone) {
+    comp_manager_.Commit(display_ctx_, &disp_layer_stack_);
+    comp_manager_.PostCommit(display_ctx_, &disp_layer_stack_);
+  }
+
+  uint64_t cpu_time_us = (GetThreadCpuTimeNs() - start) / 1000;
+
+  uint32_t sde_layers = 0;
+  uint32_t gpu_layers = 0;
+  for (uint32_t i = 0; i < disp_layer_stack_.info.app_layer_count; i++) {
+    LayerComposition composition = stack->layers.at(i)->composition;
+    if (composition == kCompositionGPU) {
+      gpu_layers++;
+    } else if (composition != kCompositionGPUTarget) {
+      sde_layers++;
+    }
+  }
+  bool gpu_fallback = (error == kErrorNone) && !sde_layers && gpu_layers;
+
+  summary_.frames++;
+  summary_.failures += (error != kErrorNone);
+  summary_.gpu_fallbacks += gpu_fallback;
+  summary_.cpu_time_us.Record(cpu_time_us);
+
+  if (!quiet) {
+    std::cout << "frame " << summary_.frames << " ts " << frame->timestamp_ns
+              << " layers " << stack->layers.size() << " sde " << sde_layers << " gpu "
+              << gpu_layers << " hw_layers " << disp_layer_stack_.info.hw_layers.size()
+              << " attempts " << attempts << " cpu_us " << cpu_time_us
+              << (gpu_fallback ? " gpu_fallback" : "")
+              << (error != kErrorNone ? " error " + std::to_string(error) : "") << "\n";
+  }
+
+  return error;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool use_extension = false;
+  bool quiet = false;
+  int c;
+  while ((c = getopt(argc, argv, "eqh")) != -1) {
+    switch (c) {
+      case 'e':
+        use_extension = true;
+        break;
+      case 'q':
+        quiet = true;
+        break;
+      default:
+      case 'h':
+        ShowUsage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+  }
+
+  if (optind >= argc) {
+    ShowUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  LayerStackTraceReader reader;
+  if (reader.Open(argv[optind]) != kErrorNone) {
+    std::cerr << "Unable to open trace " << argv[optind] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Replayer replayer;
+  if (replayer.Init(use_extension) != kErrorNone) {
+    return EXIT_FAILURE;
+  }
+
+  LayerStackTraceConfig config;
+  LayerStackTraceFrame frame;
+  LayerStackTraceReader::Result result;
+  while ((result = reader.Next(&config, &frame)) != LayerStackTraceReader::kResultEnd) {
+    if (result == LayerStackTraceReader::kResultError) {
+      std::cerr << "Corrupt trace after " << replayer.GetSummary().frames << " frames\n";
+      break;
+    }
+    if (result == LayerStackTraceReader::kResultConfig) {
+      if (replayer.Configure(config) != kErrorNone) {
+        std::cerr << "Unable to configure display " << config.display_id << "\n";
+        return EXIT_FAILURE;
+      }
+      continue;
+    }
+    replayer.Replay(&frame, quiet);
+  }
+
+  const ReplaySummary &summary = replayer.GetSummary();
+  const LatencyHistogram &cpu_time = summary.cpu_time_us;
+  std::cout << "frames " << summary.frames << " failures " << summary.failures
+            << " gpu_fallbacks " << summary.gpu_fallbacks << " ("
+            << (summary.frames ? (100.0 * summary.gpu_fallbacks / summary.frames) : 0.0)
+            << "%)\n"
+            << "cpu_us mean " << cpu_time.GetMean() << " p50 " << cpu_time.GetPercentile(50)
+            << " p90 " << cpu_time.GetPercentile(90) << " p99 " << cpu_time.GetPercentile(99)
+            << " max " << cpu_time.GetMax() << "\n";
+
+  FrameLatencyStats *stats = FrameLatencyStats::Get(replayer.GetDisplayId());
+  if (stats) {
+    std::cout << stats->Dump();
+  }
+
+  return (summary.failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
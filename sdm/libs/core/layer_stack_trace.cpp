@@ -0,0 +1,537 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <private/hw_info_snapshot.h>
+#include <string.h>
+#include <utils/binary_stream.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <string>
+#include <vector>
+
+#include "layer_stack_trace.h"
+
+#define __CLASS__ "LayerStackTrace"
+
+namespace sdm {
+
+namespace {
+
+// Records larger than this are treated as corrupt rather than allocated.
+const uint32_t kMaxRecordSize = 16 << 20;
+
+void PutRect(BinaryWriter *w, const LayerRect &rect) {
+  w->Put(rect.left);
+  w->Put(rect.top);
+  w->Put(rect.right);
+  w->Put(rect.bottom);
+}
+
+bool GetRect(BinaryReader *r, LayerRect *rect) {
+  return r->Get(&rect->left) && r->Get(&rect->top) && r->Get(&rect->right) &&
+         r->Get(&rect->bottom);
+}
+
+void PutRects(BinaryWriter *w, const std::vector<LayerRect> &rects) {
+  w->Put<uint32_t>(UINT32(rects.size()));
+  for (auto &rect : rects) {
+    PutRect(w, rect);
+  }
+}
+
+bool GetRects(BinaryReader *r, std::vector<LayerRect> *rects) {
+  uint32_t count = 0;
+  if (!r->GetCount(&count, 4 * sizeof(float))) {
+    return false;
+  }
+  rects->resize(count);
+  for (auto &rect : *rects) {
+    if (!GetRect(r, &rect)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PutLayer(BinaryWriter *w, const Layer &layer) {
+  const LayerBuffer &buffer = layer.input_buffer;
+  w->Put(buffer.width);
+  w->Put(buffer.height);
+  w->Put(buffer.unaligned_width);
+  w->Put(buffer.unaligned_height);
+  w->Put(buffer.size);
+  w->PutEnum(buffer.format);
+  w->PutEnum(buffer.color_metadata.colorPrimaries);
+  w->PutEnum(buffer.color_metadata.range);
+  w->PutEnum(buffer.color_metadata.transfer);
+  w->PutEnum(buffer.color_metadata.matrixCoefficients);
+  w->PutEnum(buffer.igc);
+  w->Put(buffer.flags.flags);
+  w->Put(buffer.buffer_id);
+  w->Put(buffer.usage);
+
+  w->PutEnum(layer.composition);
+  PutRect(w, layer.src_rect);
+  PutRect(w, layer.dst_rect);
+  PutRect(w, layer.stitch_info.dst_rect);
+  PutRect(w, layer.stitch_info.slice_rect);
+  PutRects(w, layer.visible_regions);
+  PutRects(w, layer.dirty_regions);
+  w->PutEnum(layer.blending);
+  w->Put(layer.transform.rotation);
+  w->PutBool(layer.transform.flip_horizontal);
+  w->PutBool(layer.transform.flip_vertical);
+  w->Put(layer.plane_alpha);
+  w->Put(layer.frame_rate);
+  w->Put(layer.cadence_rate);
+  w->Put(layer.solid_fill_color);
+  w->Put(layer.flags.flags);
+  w->Put(layer.solid_fill_info.bit_depth);
+  w->Put(layer.solid_fill_info.red);
+  w->Put(layer.solid_fill_info.green);
+  w->Put(layer.solid_fill_info.blue);
+  w->Put(layer.solid_fill_info.alpha);
+  w->Put<uint64_t>(layer.update_mask.to_ullong());
+  w->Put(layer.geometry_changes);
+  w->Put(layer.layer_id);
+  w->PutString(layer.layer_name);
+}
+
+bool GetLayer(BinaryReader *r, Layer *layer) {
+  LayerBuffer &buffer = layer->input_buffer;
+  uint64_t update_mask = 0;
+  bool ok = r->Get(&buffer.width) && r->Get(&buffer.height) && r->Get(&buffer.unaligned_width) &&
+            r->Get(&buffer.unaligned_height) && r->Get(&buffer.size) &&
+            r->GetEnum(&buffer.format) && r->GetEnum(&buffer.color_metadata.colorPrimaries) &&
+            r->GetEnum(&buffer.color_metadata.range) &&
+            r->GetEnum(&buffer.color_metadata.transfer) &&
+            r->GetEnum(&buffer.color_metadata.matrixCoefficients) && r->GetEnum(&buffer.igc) &&
+            r->Get(&buffer.flags.flags) && r->Get(&buffer.buffer_id) && r->Get(&buffer.usage) &&
+            r->GetEnum(&layer->composition) && GetRect(r, &layer->src_rect) &&
+            GetRect(r, &layer->dst_rect) && GetRect(r, &layer->stitch_info.dst_rect) &&
+            GetRect(r, &layer->stitch_info.slice_rect) && GetRects(r, &layer->visible_regions) &&
+            GetRects(r, &layer->dirty_regions) && r->GetEnum(&layer->blending) &&
+            r->Get(&layer->transform.rotation) &&
+            r->GetBool(&layer->transform.flip_horizontal) &&
+            r->GetBool(&layer->transform.flip_vertical) && r->Get(&layer->plane_alpha) &&
+            r->Get(&layer->frame_rate) && r->Get(&layer->cadence_rate) &&
+            r->Get(&layer->solid_fill_color) && r->Get(&layer->flags.flags) &&
+            r->Get(&layer->solid_fill_info.bit_depth) && r->Get(&layer->solid_fill_info.red) &&
+            r->Get(&layer->solid_fill_info.green) && r->Get(&layer->solid_fill_info.blue) &&
+            r->Get(&layer->solid_fill_info.alpha) && r->Get(&update_mask) &&
+            r->Get(&layer->geometry_changes) && r->Get(&layer->layer_id) &&
+            r->GetString(&layer->layer_name);
+  layer->update_mask = std::bitset<kLayerUpdateMax>(update_mask);
+  return ok;
+}
+
+}  // namespace
+
+void LayerStackTrace::EncodeConfig(const LayerStackTraceConfig &config, std::string *payload) {
+  payload->clear();
+  BinaryWriter w(payload);
+
+  w.Put(config.display_id);
+  w.PutEnum(config.display_type);
+
+  const HWDisplayAttributes &attr = config.display_attributes;
+  w.Put(attr.x_pixels);
+  w.Put(attr.y_pixels);
+  w.Put(attr.h_total);
+  w.Put(attr.v_total);
+  w.Put(attr.x_dpi);
+  w.Put(attr.y_dpi);
+  w.PutBool(attr.is_yuv);
+  w.PutBool(attr.smart_panel);
+  w.Put(attr.fps);
+  w.Put(attr.vsync_period_ns);
+  w.PutBool(attr.is_device_split);
+  w.Put(attr.v_front_porch);
+  w.Put(attr.v_back_porch);
+  w.Put(attr.v_pulse_width);
+  w.Put(attr.clock_khz);
+  w.PutEnum(attr.topology);
+  w.Put(attr.topology_num_split);
+
+  const HWPanelInfo &panel = config.panel_info;
+  w.PutEnum(panel.port);
+  w.PutEnum(panel.mode);
+  w.PutBool(panel.partial_update);
+  w.Put(panel.left_align);
+  w.Put(panel.width_align);
+  w.Put(panel.top_align);
+  w.Put(panel.height_align);
+  w.Put(panel.min_roi_width);
+  w.Put(panel.min_roi_height);
+  w.PutBool(panel.needs_roi_merge);
+  w.PutBool(panel.dynamic_fps);
+  w.PutBool(panel.dfps_porch_mode);
+  w.PutBool(panel.ping_pong_split);
+  w.Put(panel.min_fps);
+  w.Put(panel.max_fps);
+  w.PutBool(panel.is_primary_panel);
+  w.PutBool(panel.is_pluggable);
+  w.Put(panel.split_info.left_split);
+  w.Put(panel.split_info.right_split);
+  w.Put(panel.left_roi_count);
+  w.Put(panel.right_roi_count);
+  w.PutBool(panel.hdr_enabled);
+  w.PutBool(panel.hdr_plus_enabled);
+  w.Put(panel.peak_luminance);
+  w.Put(panel.average_luminance);
+  w.Put(panel.blackness_level);
+  w.PutBool(panel.panel_orientation.rotation);
+  w.PutBool(panel.panel_orientation.flip_horizontal);
+  w.PutBool(panel.panel_orientation.flip_vertical);
+  w.Put(panel.transfer_time_us);
+  w.Put(panel.transfer_time_us_min);
+  w.Put(panel.transfer_time_us_max);
+  w.Put(panel.allowed_mode_switch);
+  w.Put(panel.panel_mode_caps);
+  w.PutBool(panel.qsync_support);
+
+  const HWMixerAttributes &mixer = config.mixer_attributes;
+  w.Put(mixer.width);
+  w.Put(mixer.height);
+  w.Put(mixer.split_left);
+  w.PutEnum(mixer.split_type);
+  w.PutEnum(mixer.output_format);
+  w.Put(mixer.dest_scaler_blocks_used);
+
+  const DisplayConfigVariableInfo &fb = config.fb_config;
+  w.Put(fb.x_pixels);
+  w.Put(fb.y_pixels);
+  w.Put(fb.h_total);
+  w.Put(fb.v_total);
+  w.Put(fb.x_dpi);
+  w.Put(fb.y_dpi);
+  w.PutBool(fb.is_yuv);
+  w.PutBool(fb.smart_panel);
+  w.Put(fb.fps);
+  w.Put(fb.vsync_period_ns);
+
+  std::string hw_resource;
+  HWInfoSnapshot::Serialize(config.hw_resource, &hw_resource);
+  w.PutString(hw_resource);
+}
+
+bool LayerStackTrace::DecodeConfig(const std::string &payload, LayerStackTraceConfig *out) {
+  BinaryReader r(payload);
+  LayerStackTraceConfig config;
+
+  HWDisplayAttributes &attr = config.display_attributes;
+  bool ok = r.Get(&config.display_id) && r.GetEnum(&config.display_type) &&
+            r.Get(&attr.x_pixels) && r.Get(&attr.y_pixels) && r.Get(&attr.h_total) &&
+            r.Get(&attr.v_total) && r.Get(&attr.x_dpi) && r.Get(&attr.y_dpi) &&
+            r.GetBool(&attr.is_yuv) && r.GetBool(&attr.smart_panel) && r.Get(&attr.fps) &&
+            r.Get(&attr.vsync_period_ns) && r.GetBool(&attr.is_device_split) &&
+            r.Get(&attr.v_front_porch) && r.Get(&attr.v_back_porch) &&
+            r.Get(&attr.v_pulse_width) && r.Get(&attr.clock_khz) && r.GetEnum(&attr.topology) &&
+            r.Get(&attr.topology_num_split);
+
+  HWPanelInfo &panel = config.panel_info;
+  ok = ok && r.GetEnum(&panel.port) && r.GetEnum(&panel.mode) &&
+       r.GetBool(&panel.partial_update) && r.Get(&panel.left_align) &&
+       r.Get(&panel.width_align) && r.Get(&panel.top_align) && r.Get(&panel.height_align) &&
+       r.Get(&panel.min_roi_width) && r.Get(&panel.min_roi_height) &&
+       r.GetBool(&panel.needs_roi_merge) && r.GetBool(&panel.dynamic_fps) &&
+       r.GetBool(&panel.dfps_porch_mode) && r.GetBool(&panel.ping_pong_split) &&
+       r.Get(&panel.min_fps) && r.Get(&panel.max_fps) && r.GetBool(&panel.is_primary_panel) &&
+       r.GetBool(&panel.is_pluggable) && r.Get(&panel.split_info.left_split) &&
+       r.Get(&panel.split_info.right_split) && r.Get(&panel.left_roi_count) &&
+       r.Get(&panel.right_roi_count) && r.GetBool(&panel.hdr_enabled) &&
+       r.GetBool(&panel.hdr_plus_enabled) && r.Get(&panel.peak_luminance) &&
+       r.Get(&panel.average_luminance) && r.Get(&panel.blackness_level) &&
+       r.GetBool(&panel.panel_orientation.rotation) &&
+       r.GetBool(&panel.panel_orientation.flip_horizontal) &&
+       r.GetBool(&panel.panel_orientation.flip_vertical) && r.Get(&panel.transfer_time_us) &&
+       r.Get(&panel.transfer_time_us_min) && r.Get(&panel.transfer_time_us_max) &&
+       r.Get(&panel.allowed_mode_switch) && r.Get(&panel.panel_mode_caps) &&
+       r.GetBool(&panel.qsync_support);
+
+  HWMixerAttributes &mixer = config.mixer_attributes;
+  ok = ok && r.Get(&mixer.width) && r.Get(&mixer.height) && r.Get(&mixer.split_left) &&
+       r.GetEnum(&mixer.split_type) && r.GetEnum(&mixer.output_format) &&
+       r.Get(&mixer.dest_scaler_blocks_used);
+
+  DisplayConfigVariableInfo &fb = config.fb_config;
+  ok = ok && r.Get(&fb.x_pixels) && r.Get(&fb.y_pixels) && r.Get(&fb.h_total) &&
+       r.Get(&fb.v_total) && r.Get(&fb.x_dpi) && r.Get(&fb.y_dpi) && r.GetBool(&fb.is_yuv) &&
+       r.GetBool(&fb.smart_panel) && r.Get(&fb.fps) && r.Get(&fb.vsync_period_ns);
+
+  std::string hw_resource;
+  ok = ok && r.GetString(&hw_resource) && r.Done() &&
+       HWInfoSnapshot::Deserialize(hw_resource, &config.hw_resource);
+  if (!ok) {
+    return false;
+  }
+
+  *out = std::move(config);
+  return true;
+}
+
+void LayerStackTrace::EncodeFrame(const LayerStack &stack, int64_t timestamp_ns,
+                                  std::string *payload) {
+  payload->clear();
+  BinaryWriter w(payload);
+
+  w.Put(timestamp_ns);
+  w.Put(stack.flags.flags);
+  w.PutEnum(stack.blend_cs.primaries);
+  w.PutEnum(stack.blend_cs.transfer);
+  w.PutBool(stack.block_on_fb);
+  w.PutBool(stack.needs_validate);
+  w.PutBool(stack.solid_fill_enabled);
+  w.PutBool(stack.validate_only);
+  w.PutBool(stack.client_incompatible);
+  w.Put(stack.force_refresh_rate);
+
+  w.Put<uint32_t>(UINT32(stack.layers.size()));
+  for (auto layer : stack.layers) {
+    PutLayer(&w, *layer);
+  }
+}
+
+bool LayerStackTrace::DecodeFrame(const std::string &payload, LayerStackTraceFrame *frame) {
+  BinaryReader r(payload);
+  LayerStack &stack = frame->stack;
+  uint32_t count = 0;
+
+  stack = LayerStack();
+  frame->layers.clear();
+  bool ok = r.Get(&frame->timestamp_ns) && r.Get(&stack.flags.flags) &&
+            r.GetEnum(&stack.blend_cs.primaries) && r.GetEnum(&stack.blend_cs.transfer) &&
+            r.GetBool(&stack.block_on_fb) && r.GetBool(&stack.needs_validate) &&
+            r.GetBool(&stack.solid_fill_enabled) && r.GetBool(&stack.validate_only) &&
+            r.GetBool(&stack.client_incompatible) && r.Get(&stack.force_refresh_rate) &&
+            r.GetCount(&count, sizeof(uint32_t));
+  if (!ok) {
+    return false;
+  }
+
+  frame->layers.resize(count);
+  for (auto &layer : frame->layers) {
+    if (!GetLayer(&r, &layer)) {
+      return false;
+    }
+    stack.layers.push_back(&layer);
+  }
+
+  return r.Done();
+}
+
+DisplayError LayerStackTraceWriter::Open(const char *path, uint32_t max_frames) {
+  Close();
+
+  fp_ = fopen(path, "wb");
+  if (!fp_) {
+    DLOGW("Failed to open %s, error = %s", path, strerror(errno));
+    return kErrorFileDescriptor;
+  }
+
+  uint32_t header[] = { LayerStackTrace::kMagic, LayerStackTrace::kVersion };
+  if (fwrite(header, sizeof(header), 1, fp_) != 1) {
+    fclose(fp_);
+    fp_ = nullptr;
+    return kErrorUndefined;
+  }
+
+  max_frames_ = max_frames;
+  frame_count_ = 0;
+  has_config_ = false;
+  stop_ = false;
+  write_failed_ = false;
+  accepting_ = true;
+  writer_thread_ = std::thread(&LayerStackTraceWriter::WriterThread, this);
+  DLOGI("Tracing %u frames to %s", max_frames, path);
+
+  return kErrorNone;
+}
+
+void LayerStackTraceWriter::Close() {
+  accepting_ = false;
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  writer_thread_.join();
+  fp_ = nullptr;
+  DLOGI("Trace closed after %u frames", frame_count_);
+}
+
+bool LayerStackTraceWriter::NeedsConfig(const HWDisplayAttributes &display_attributes,
+                                        const HWPanelInfo &panel_info,
+                                        const HWMixerAttributes &mixer_attributes,
+                                        const DisplayConfigVariableInfo &fb_config) {
+  return !has_config_ || config_.display_attributes != display_attributes ||
+         config_.panel_info != panel_info || config_.mixer_attributes != mixer_attributes ||
+         !(config_.fb_config == fb_config);
+}
+
+DisplayError LayerStackTraceWriter::WriteConfig(const LayerStackTraceConfig &config) {
+  if (!IsOpen()) {
+    return kErrorNotSupported;
+  }
+
+  std::string payload = TakePayload();
+  LayerStackTrace::EncodeConfig(config, &payload);
+  DisplayError error = QueueRecord(LayerStackTrace::kRecordConfig, &payload);
+  if (error == kErrorNone) {
+    config_ = config;
+    has_config_ = true;
+  }
+
+  return error;
+}
+
+DisplayError LayerStackTraceWriter::WriteFrame(const LayerStack &stack, int64_t timestamp_ns) {
+  if (!IsOpen() || !has_config_) {
+    return kErrorNotSupported;
+  }
+
+  std::string payload = TakePayload();
+  LayerStackTrace::EncodeFrame(stack, timestamp_ns, &payload);
+  DisplayError error = QueueRecord(LayerStackTrace::kRecordFrame, &payload);
+  if (error == kErrorNone && ++frame_count_ >= max_frames_) {
+    // The writer thread finishes the queued records and closes the file.
+    accepting_ = false;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+  }
+
+  return error;
+}
+
+std::string LayerStackTraceWriter::TakePayload() {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (free_payloads_.empty()) {
+    return std::string();
+  }
+
+  std::string payload = std::move(free_payloads_.back());
+  free_payloads_.pop_back();
+  return payload;
+}
+
+DisplayError LayerStackTraceWriter::QueueRecord(LayerStackTrace::RecordType type,
+                                                std::string *payload) {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (pending_.size() >= kMaxPendingRecords) {
+      DLOGW("Trace storage is %zu records behind, stopping the trace", pending_.size());
+      accepting_ = false;
+      stop_ = true;
+    } else {
+      pending_.push_back(Record());
+      pending_.back().type = type;
+      pending_.back().payload = std::move(*payload);
+    }
+  }
+  cv_.notify_one();
+
+  return accepting_ ? kErrorNone : kErrorUndefined;
+}
+
+void LayerStackTraceWriter::WriterThread() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+
+    Record record = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    uint32_t header[] = { record.type, UINT32(record.payload.size()) };
+    bool written = (fwrite(header, sizeof(header), 1, fp_) == 1) &&
+                   (fwrite(record.payload.data(), 1, record.payload.size(), fp_) ==
+                    record.payload.size());
+    lock.lock();
+
+    if (!written) {
+      DLOGW("Trace write failed, error = %s", strerror(errno));
+      write_failed_ = true;
+      pending_.clear();
+      break;
+    }
+    if (free_payloads_.size() < kMaxPendingRecords) {
+      free_payloads_.push_back(std::move(record.payload));
+    }
+  }
+  lock.unlock();
+
+  fclose(fp_);
+}
+
+DisplayError LayerStackTraceReader::Open(const char *path) {
+  Close();
+
+  fp_ = fopen(path, "rb");
+  if (!fp_) {
+    DLOGW("Failed to open %s, error = %s", path, strerror(errno));
+    return kErrorFileDescriptor;
+  }
+
+  uint32_t header[2] = {};
+  if (fread(header, sizeof(header), 1, fp_) != 1 || header[0] != LayerStackTrace::kMagic ||
+      header[1] != LayerStackTrace::kVersion) {
+    DLOGW("%s is not a version %u layer stack trace", path, LayerStackTrace::kVersion);
+    Close();
+    return kErrorVersion;
+  }
+
+  return kErrorNone;
+}
+
+void LayerStackTraceReader::Close() {
+  if (fp_) {
+    fclose(fp_);
+    fp_ = nullptr;
+  }
+}
+
+LayerStackTraceReader::Result LayerStackTraceReader::Next(LayerStackTraceConfig *config,
+                                                          LayerStackTraceFrame *frame) {
+  if (!fp_) {
+    return kResultError;
+  }
+
+  uint32_t header[2] = {};
+  size_t read = fread(header, 1, sizeof(header), fp_);
+  if (read == 0 && feof(fp_)) {
+    return kResultEnd;
+  }
+  if (read != sizeof(header) || header[1] > kMaxRecordSize) {
+    return kResultError;
+  }
+
+  payload_.resize(header[1]);
+  if (fread(&payload_[0], 1, payload_.size(), fp_) != payload_.size()) {
+    // A trace cut short by a crash or reboot ends with a partial record.
+    return kResultEnd;
+  }
+
+  switch (header[0]) {
+    case LayerStackTrace::kRecordConfig:
+      return LayerStackTrace::DecodeConfig(payload_, config) ? kResultConfig : kResultError;
+    case LayerStackTrace::kRecordFrame:
+      return LayerStackTrace::DecodeFrame(payload_, frame) ? kResultFrame : kResultError;
+    default:
+      return kResultError;
+  }
+}
+
+}  // namespace sdm
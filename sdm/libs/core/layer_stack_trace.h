@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __LAYER_STACK_TRACE_H__
+#define __LAYER_STACK_TRACE_H__
+
+#include <core/display_interface.h>
+#include <core/layer_stack.h>
+#include <private/hw_info_types.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace sdm {
+
+// Display setup the frames of a trace were composed against, enough to register the display
+// with a CompManager offline.
+struct LayerStackTraceConfig {
+  int32_t display_id = -1;
+  DisplayType display_type = kBuiltIn;
+  HWDisplayAttributes display_attributes = {};
+  HWPanelInfo panel_info = {};
+  HWMixerAttributes mixer_attributes = {};
+  DisplayConfigVariableInfo fb_config = {};
+  HWResourceInfo hw_resource = {};
+};
+
+// A layer stack as handed to DisplayBase::Prepare. The frame owns its layers and stack.layers
+// points into them, so a frame must not be copied once decoded.
+struct LayerStackTraceFrame {
+  int64_t timestamp_ns = 0;
+  std::vector<Layer> layers;
+  LayerStack stack;
+};
+
+// Compact binary trace of layer stacks: a file header followed by config and frame records.
+// A config record precedes the frames composed against it and is repeated on reconfiguration.
+// Only the client inputs that drive strategy and resource selection are kept; buffer contents,
+// fences and SDM outputs are not.
+class LayerStackTrace {
+ public:
+  enum RecordType : uint32_t {
+    kRecordConfig = 1,
+    kRecordFrame = 2,
+  };
+
+  static void EncodeConfig(const LayerStackTraceConfig &config, std::string *payload);
+  static bool DecodeConfig(const std::string &payload, LayerStackTraceConfig *config);
+  static void EncodeFrame(const LayerStack &stack, int64_t timestamp_ns, std::string *payload);
+  static bool DecodeFrame(const std::string &payload, LayerStackTraceFrame *frame);
+
+  static const uint32_t kMagic = 0x54534c53;  // "SLST"
+  // Bump whenever the encoding of any record changes.
+  static const uint32_t kVersion = 1;
+};
+
+// Records are encoded by the caller and written by a writer thread, so the caller never waits on
+// storage. If storage falls kMaxPendingRecords behind, the trace stops rather than block.
+class LayerStackTraceWriter {
+ public:
+  ~LayerStackTraceWriter() { Close(); }
+
+  // Starts a trace that stops accepting frames after max_frames frames.
+  DisplayError Open(const char *path, uint32_t max_frames);
+  // Waits for the queued records to be written and closes the file.
+  void Close();
+  // Returns true while the trace accepts records.
+  bool IsOpen() const { return accepting_ && !write_failed_; }
+  // Returns true if the given setup differs from the last config written.
+  bool NeedsConfig(const HWDisplayAttributes &display_attributes, const HWPanelInfo &panel_info,
+                   const HWMixerAttributes &mixer_attributes,
+                   const DisplayConfigVariableInfo &fb_config);
+  DisplayError WriteConfig(const LayerStackTraceConfig &config);
+  DisplayError WriteFrame(const LayerStack &stack, int64_t timestamp_ns);
+  uint32_t GetFrameCount() const { return frame_count_; }
+
+ private:
+  struct Record {
+    LayerStackTrace::RecordType type = LayerStackTrace::kRecordFrame;
+    std::string payload;
+  };
+
+  static const size_t kMaxPendingRecords = 64;
+
+  std::string TakePayload();
+  DisplayError QueueRecord(LayerStackTrace::RecordType type, std::string *payload);
+  void WriterThread();
+
+  FILE *fp_ = nullptr;
+  bool accepting_ = false;
+  uint32_t max_frames_ = 0;
+  uint32_t frame_count_ = 0;
+  bool has_config_ = false;
+  LayerStackTraceConfig config_ = {};
+  std::thread writer_thread_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::deque<Record> pending_;  // Guarded by lock_
+  // Written payloads, reused to avoid per frame allocations. Guarded by lock_.
+  std::vector<std::string> free_payloads_;
+  bool stop_ = false;  // Guarded by lock_
+  std::atomic<bool> write_failed_ = {false};
+};
+
+class LayerStackTraceReader {
+ public:
+  enum Result {
+    kResultEnd,
+    kResultConfig,
+    kResultFrame,
+    kResultError,
+  };
+
+  ~LayerStackTraceReader() { Close(); }
+
+  DisplayError Open(const char *path);
+  void Close();
+  // Decodes the next record into config or frame and returns which one it was.
+  Result Next(LayerStackTraceConfig *config, LayerStackTraceFrame *frame);
+
+ private:
+  FILE *fp_ = nullptr;
+  std::string payload_;
+};
+
+}  // namespace sdm
+
+#endif  // __LAYER_STACK_TRACE_H__
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "qos_predictor.h"
+
+namespace sdm {
+
+const uint32_t QosPredictor::kMaxScenes;
+const uint32_t QosPredictor::kRelaxFrames;
+const uint64_t QosPredictor::kRelaxTimeNs;
+
+// Share of the demand drop a scene forgets per frame, its peak fades over a few dozen frames.
+static const uint32_t kDemandDecayShift = 3;
+
+static void MaxQos(const HWQosData &qos_data, HWQosData *max) {
+  max->valid = max->valid || qos_data.valid;
+  max->core_ab_bps = std::max(max->core_ab_bps, qos_data.core_ab_bps);
+  max->core_ib_bps = std::max(max->core_ib_bps, qos_data.core_ib_bps);
+  max->llcc_ab_bps = std::max(max->llcc_ab_bps, qos_data.llcc_ab_bps);
+  max->llcc_ib_bps = std::max(max->llcc_ib_bps, qos_data.llcc_ib_bps);
+  max->dram_ab_bps = std::max(max->dram_ab_bps, qos_data.dram_ab_bps);
+  max->dram_ib_bps = std::max(max->dram_ib_bps, qos_data.dram_ib_bps);
+  max->rot_prefill_bw_bps = std::max(max->rot_prefill_bw_bps, qos_data.rot_prefill_bw_bps);
+  max->clock_hz = std::max(max->clock_hz, qos_data.clock_hz);
+  max->rot_clock_hz = std::max(max->rot_clock_hz, qos_data.rot_clock_hz);
+}
+
+// Returns true if qos_data votes at least as high as other on every path.
+static bool Covers(const HWQosData &qos_data, const HWQosData &other) {
+  return qos_data.core_ab_bps >= other.core_ab_bps && qos_data.core_ib_bps >= other.core_ib_bps &&
+         qos_data.llcc_ab_bps >= other.llcc_ab_bps && qos_data.llcc_ib_bps >= other.llcc_ib_bps &&
+         qos_data.dram_ab_bps >= other.dram_ab_bps && qos_data.dram_ib_bps >= other.dram_ib_bps &&
+         qos_data.rot_prefill_bw_bps >= other.rot_prefill_bw_bps &&
+         qos_data.clock_hz >= other.clock_hz && qos_data.rot_clock_hz >= other.rot_clock_hz;
+}
+
+template <class T>
+static void DecayTo(T demand, T *learned) {
+  if (demand >= *learned) {
+    *learned = demand;
+  } else {
+    *learned -= (*learned - demand) >> kDemandDecayShift;
+  }
+}
+
+uint64_t QosPredictor::GetSceneClass(const std::vector<Layer> &layers, uint32_t width,
+                                     uint32_t height) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](uint32_t value) {
+    for (uint32_t i = 0; i < sizeof(value); i++) {
+      hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 0x100000001b3ULL;
+    }
+  };
+
+  float display_area = std::max(FLOAT(width) * FLOAT(height), 1.0f);
+  mix(UINT32(layers.size()));
+  for (auto &layer : layers) {
+    const LayerBuffer &buffer = layer.input_buffer;
+    float src_area = (layer.src_rect.right - layer.src_rect.left) *
+                     (layer.src_rect.bottom - layer.src_rect.top);
+    float dst_area = (layer.dst_rect.right - layer.dst_rect.left) *
+                     (layer.dst_rect.bottom - layer.dst_rect.top);
+    // Screen area in sixteenths, area scale factor in log2 steps from 1/64x to 64x.
+    uint32_t area = UINT32(std::min(16.0f, 16.0f * dst_area / display_area));
+    int32_t scale = 0;
+    if (src_area > 0.0f && dst_area > 0.0f) {
+      scale = std::max(-6, std::min(6, INT32(lroundf(log2f(src_area / dst_area)))));
+    }
+    bool hdr = (buffer.color_metadata.transfer == Transfer_SMPTE_ST2084) ||
+               (buffer.color_metadata.transfer == Transfer_HLG);
+    bool rot90 = (INT32(layer.transform.rotation) % 180) == 90;
+
+    mix(UINT32(layer.composition));
+    mix(UINT32(buffer.format));
+    mix(UINT32(hdr) | (UINT32(rot90) << 1));
+    mix(area);
+    mix(UINT32(scale));
+  }
+
+  return hash;
+}
+
+QosPredictor::Scene *QosPredictor::FindScene(uint64_t key) {
+  for (auto &scene : scenes_) {
+    if (scene.key == key) {
+      return &scene;
+    }
+  }
+  return nullptr;
+}
+
+void QosPredictor::LearnDemand(uint64_t key, const HWQosData &demand) {
+  Scene *scene = FindScene(key);
+  if (!scene) {
+    if (scenes_.size() < kMaxScenes) {
+      scenes_.push_back({});
+      scene = &scenes_.back();
+    } else {
+      scene = &*std::min_element(scenes_.begin(), scenes_.end(),
+                                 [](const Scene &a, const Scene &b) {
+                                   return a.last_use < b.last_use;
+                                 });
+    }
+    scene->key = key;
+    scene->demand = demand;
+  }
+  scene->last_use = stats_.frames;
+
+  HWQosData &learned = scene->demand;
+  DecayTo(demand.core_ab_bps, &learned.core_ab_bps);
+  DecayTo(demand.core_ib_bps, &learned.core_ib_bps);
+  DecayTo(demand.llcc_ab_bps, &learned.llcc_ab_bps);
+  DecayTo(demand.llcc_ib_bps, &learned.llcc_ib_bps);
+  DecayTo(demand.dram_ab_bps, &learned.dram_ab_bps);
+  DecayTo(demand.dram_ib_bps, &learned.dram_ib_bps);
+  DecayTo(demand.rot_prefill_bw_bps, &learned.rot_prefill_bw_bps);
+  DecayTo(demand.clock_hz, &learned.clock_hz);
+  DecayTo(demand.rot_clock_hz, &learned.rot_clock_hz);
+}
+
+void QosPredictor::Predict(uint64_t scene, HWQosData *qos_data) {
+  if (!qos_data->valid) {
+    return;
+  }
+
+  stats_.frames++;
+  scene_ = scene;
+  HWQosData demand = *qos_data;
+  HWQosData target = demand;
+  Scene *history = FindScene(scene);
+  if (history && !Covers(demand, history->demand)) {
+    MaxQos(history->demand, &target);
+    stats_.predicted++;
+  }
+
+  if (!vote_.valid || !Covers(vote_, target)) {
+    MaxQos(target, &vote_);
+    relax_frames_ = 0;
+    hold_start_ns_ = 0;
+  } else if (++relax_frames_ >= kRelaxFrames) {
+    vote_ = target;
+    relax_frames_ = 0;
+    hold_start_ns_ = 0;
+  }
+  if (!Covers(target, vote_)) {
+    stats_.held++;
+  }
+
+  LearnDemand(scene, demand);
+  target_ = target;
+  predicted_ = true;
+  *qos_data = vote_;
+}
+
+void QosPredictor::Commit(uint64_t now_ns, HWQosData *qos_data) {
+  bool predicted = predicted_;
+  predicted_ = false;
+  if (!vote_.valid || !qos_data->valid || Covers(target_, vote_)) {
+    hold_start_ns_ = 0;
+    return;
+  }
+
+  if (!hold_start_ns_) {
+    hold_start_ns_ = now_ns;
+  }
+  // Validated frames were already counted by Predict.
+  if (!predicted) {
+    relax_frames_++;
+  }
+  if (relax_frames_ < kRelaxFrames && (now_ns - hold_start_ns_) < kRelaxTimeNs) {
+    return;
+  }
+
+  vote_ = target_;
+  relax_frames_ = 0;
+  hold_start_ns_ = 0;
+  *qos_data = vote_;
+}
+
+void QosPredictor::ResetVote() {
+  vote_ = {};
+  target_ = {};
+  relax_frames_ = 0;
+  hold_start_ns_ = 0;
+  predicted_ = false;
+}
+
+void QosPredictor::Reset() {
+  ResetVote();
+  scenes_.clear();
+  scene_ = 0;
+}
+
+std::string QosPredictor::Dump() const {
+  std::ostringstream os;
+  os << "\nQoS prediction: scenes: " << scenes_.size() << " frames: " << stats_.frames;
+  os << " predicted: " << stats_.predicted << " held: " << stats_.held;
+  os << " relax: " << relax_frames_ << "/" << kRelaxFrames;
+  os << "\n Scene: " << std::hex << scene_ << std::dec << " vote: clk " << vote_.clock_hz;
+  os << " core " << vote_.core_ab_bps << "/" << vote_.core_ib_bps;
+  os << " llcc " << vote_.llcc_ab_bps << "/" << vote_.llcc_ib_bps;
+  os << " dram " << vote_.dram_ab_bps << "/" << vote_.dram_ib_bps;
+  return os.str();
+}
+
+}  // namespace sdm
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __QOS_PREDICTOR_H__
+#define __QOS_PREDICTOR_H__
+
+#include <core/layer_stack.h>
+#include <private/hw_info_types.h>
+
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+// Predicts the bandwidth and clock votes of a display from the history of its scenes. The vote the
+// resource manager computes for a frame only reflects that frame, so the first frame of a heavy
+// scene, e.g. a full screen scaled video or HDR layer, is committed before the vote has caught up
+// with the scene. The predictor remembers the demand of recently seen scene classes and raises
+// the vote of a frame to the demand of its class. Votes go up right away and are only relaxed
+// once the demand stayed lower for kRelaxFrames frames or kRelaxTimeNs, whichever is first.
+class QosPredictor {
+ public:
+  static const uint32_t kMaxScenes = 16;
+  static const uint32_t kRelaxFrames = 30;
+  static const uint64_t kRelaxTimeNs = 500000000;
+
+  struct Stats {
+    uint64_t frames = 0;
+    uint64_t predicted = 0;  // Frames voted up to the learned demand of their scene
+    uint64_t held = 0;       // Frames voted up to the demand of earlier frames
+  };
+
+  // Geometry class of a frame: per layer the format, HDR transfer, rotation, the screen area and
+  // the scale factor, quantized so that frames of one scene share the class.
+  static uint64_t GetSceneClass(const std::vector<Layer> &layers, uint32_t width, uint32_t height);
+
+  // Replaces the vote computed for a frame of the given scene with the predicted vote, and learns
+  // the computed vote as demand of the scene.
+  void Predict(uint64_t scene, HWQosData *qos_data);
+  // Called for every committed frame. Frames committed without a validate keep the vote of the
+  // last validated frame, they count towards relaxing a held vote here.
+  void Commit(uint64_t now_ns, HWQosData *qos_data);
+  // Forgets the held vote, e.g. after the display was powered off.
+  void ResetVote();
+  // Forgets everything, demand depends on the display mode.
+  void Reset();
+  const Stats &GetStats() const { return stats_; }
+  std::string Dump() const;
+
+ private:
+  struct Scene {
+    uint64_t key = 0;
+    uint64_t last_use = 0;
+    HWQosData demand = {};
+  };
+
+  Scene *FindScene(uint64_t key);
+  void LearnDemand(uint64_t key, const HWQosData &demand);
+
+  std::vector<Scene> scenes_;
+  HWQosData vote_ = {};
+  HWQosData target_ = {};  // Vote of the last validated frame without the hold
+  uint32_t relax_frames_ = 0;
+  uint64_t hold_start_ns_ = 0;
+  bool predicted_ = false;  // Predict ran for the frame being committed
+  uint64_t scene_ = 0;
+  Stats stats_ = {};
+};
+
+}  // namespace sdm
+
+#endif  // __QOS_PREDICTOR_H__
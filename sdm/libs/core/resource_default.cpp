@@ -992,7 +992,81 @@ DisplayError ResourceDefault::ValidateAndSetCursorPosition(Handle display_ctx,
                                                            DispLayerStack *disp_layer_stack,
                                                            int x, int y,
                                                            DisplayConfigVariableInfo *fb_config) {
-  return kErrorNotSupported;
+  DisplayResourceContext *display_resource_ctx =
+                          reinterpret_cast<DisplayResourceContext *>(display_ctx);
+  HWMixerAttributes &mixer_attributes = display_resource_ctx->mixer_attributes;
+  HWLayersInfo &layer_info = disp_layer_stack->info;
+
+  uint32_t index = 0;
+  uint32_t layer_count = std::min(UINT32(layer_info.hw_layers.size()), UINT32(kMaxSDELayers));
+  while (index < layer_count && layer_info.hw_layers.at(index).composition != kCompositionCursor) {
+    index++;
+  }
+  if (index == layer_count) {
+    DLOGV_IF(kTagResources, "No cursor layer");
+    return kErrorNotSupported;
+  }
+
+  // An async update only moves the pipes of the cursor, anything else needs a full cycle.
+  Layer &layer = layer_info.hw_layers.at(index);
+  HWLayerConfig &layer_config = layer_info.config[index];
+  if (!layer_config.left_pipe.valid || layer_config.use_solidfill_stage ||
+      layer_config.hw_rotator_session.mode != kRotatorNone) {
+    return kErrorNotSupported;
+  }
+
+  LayerRect dst_rect = layer.dst_rect;
+  dst_rect.right = FLOAT(x) + (dst_rect.right - dst_rect.left);
+  dst_rect.bottom = FLOAT(y) + (dst_rect.bottom - dst_rect.top);
+  dst_rect.left = FLOAT(x);
+  dst_rect.top = FLOAT(y);
+
+  LayerRect fb_domain = {0.0f, 0.0f, FLOAT(fb_config->x_pixels), FLOAT(fb_config->y_pixels)};
+  LayerRect mixer_domain = {0.0f, 0.0f, FLOAT(mixer_attributes.width),
+                            FLOAT(mixer_attributes.height)};
+  LayerRect src_rect = layer.src_rect;
+  LayerRect mixer_dst_rect = {};
+  MapRect(fb_domain, mixer_domain, dst_rect, &mixer_dst_rect);
+
+  // A cursor moved off screen has its pipe disabled, which only a full cycle can do.
+  if (!CalculateCropRects(mixer_domain, &src_rect, &mixer_dst_rect)) {
+    return kErrorNotSupported;
+  }
+
+  HWLayerConfig cursor_config = {};
+  DisplayError error = kErrorNone;
+  if (hw_res_info_.is_src_split) {
+    error = SrcSplitConfig(display_resource_ctx, src_rect, mixer_dst_rect, &cursor_config);
+  } else {
+    error = DisplaySplitConfig(display_resource_ctx, src_rect, mixer_dst_rect, &cursor_config);
+  }
+  if (error != kErrorNone) {
+    return error;
+  }
+  error = AlignPipeConfig(&layer, &cursor_config.left_pipe, &cursor_config.right_pipe);
+  if (error != kErrorNone) {
+    return error;
+  }
+
+  // The pipes of the cursor are fixed until the next full cycle, it must not cross a split.
+  HWPipeInfo &left_pipe = layer_config.left_pipe;
+  HWPipeInfo &right_pipe = layer_config.right_pipe;
+  if (cursor_config.left_pipe.valid != left_pipe.valid ||
+      cursor_config.right_pipe.valid != right_pipe.valid) {
+    DLOGV_IF(kTagResources, "Cursor at %d, %d needs a different pipe split", x, y);
+    return kErrorNotSupported;
+  }
+
+  left_pipe.src_roi = cursor_config.left_pipe.src_roi;
+  left_pipe.dst_roi = cursor_config.left_pipe.dst_roi;
+  if (right_pipe.valid) {
+    right_pipe.src_roi = cursor_config.right_pipe.src_roi;
+    right_pipe.dst_roi = cursor_config.right_pipe.dst_roi;
+  }
+  layer.dst_rect = dst_rect;
+  Log(kTagResources, "cursor left pipe dst", left_pipe.dst_roi);
+
+  return kErrorNone;
 }
 
 DisplayError ResourceDefault::SetMaxBandwidthMode(HWBwModes mode) {
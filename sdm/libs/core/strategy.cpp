@@ -110,6 +110,9 @@ DisplayError Strategy::Start(DispLayerStack *disp_layer_stack, uint32_t *max_att
       *max_attempts = 1;
       error = kErrorNeedsValidate;
     }
+  } else {
+    // GPU composition is the only strategy without an extension.
+    *max_attempts = 1;
   }
 
   disp_layer_stack_->stack->flags.default_strategy = !extn_start_success_;
@@ -160,6 +163,9 @@ DisplayError Strategy::GetNextStrategy() {
   LayerRect dst_domain = (LayerRect){0.0f, 0.0f, layer_mixer_width, layer_mixer_height};
 
   Layer layer = *gpu_target_layer;
+  disp_layer_stack_->info.index.clear();
+  disp_layer_stack_->info.roi_index.clear();
+  disp_layer_stack_->info.hw_layers.clear();
   disp_layer_stack_->info.index.push_back(disp_layer_stack_->info.gpu_target_index);
   disp_layer_stack_->info.roi_index.push_back(0);
   layer.transform.flip_horizontal ^= hw_panel_info_.panel_orientation.flip_horizontal;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../idle_governor.h"
+
+using namespace sdm;
+
+namespace {
+
+// Frame gap traces modelled on captures of common use cases. A fixed seed keeps them stable.
+class TraceBuilder {
+ public:
+  // Keystrokes 150-450 ms apart, each followed by a short cursor and suggestion animation.
+  TraceBuilder &Typing(uint32_t keys) {
+    for (uint32_t i = 0; i < keys; i++) {
+      Add(150 + Next() % 300);
+      for (uint32_t j = 0; j < 3; j++) {
+        Add(16);
+      }
+    }
+    return *this;
+  }
+
+  // Reading: static periods of 3-10 s broken up by short 60 fps scrolls.
+  TraceBuilder &Reading(uint32_t pages) {
+    for (uint32_t i = 0; i < pages; i++) {
+      Add(3000 + Next() % 7000);
+      for (uint32_t j = 0; j < 20; j++) {
+        Add(16);
+      }
+    }
+    return *this;
+  }
+
+  TraceBuilder &Video(uint32_t frames) {
+    for (uint32_t i = 0; i < frames; i++) {
+      Add(33);
+    }
+    return *this;
+  }
+
+  const std::vector<uint32_t> &Get() const { return gaps_; }
+
+ private:
+  void Add(uint32_t gap_ms) { gaps_.push_back(gap_ms); }
+  uint32_t Next() {
+    seed_ = seed_ * 1103515245 + 12345;
+    return (seed_ >> 16) & 0x7fff;
+  }
+
+  uint32_t seed_ = 1;
+  std::vector<uint32_t> gaps_;
+};
+
+struct SimResult {
+  uint32_t idle_entries = 0;
+  uint32_t churn = 0;
+  uint64_t full_power_ms = 0;  // Time spent waiting for the timeout before idling
+};
+
+// Replays a trace against the idle timer. governor is null for a fixed timeout.
+SimResult Simulate(const std::vector<uint32_t> &gaps, uint32_t fixed_ms, IdleGovernor *governor,
+                   uint32_t churn_window_ms = 1000) {
+  SimResult result;
+  for (uint32_t gap_ms : gaps) {
+    uint32_t timeout_ms = governor ? governor->GetTimeoutMs() : fixed_ms;
+    if (gap_ms > timeout_ms) {
+      result.idle_entries++;
+      result.full_power_ms += timeout_ms;
+      if (gap_ms - timeout_ms < churn_window_ms) {
+        result.churn++;
+      }
+    }
+    if (governor) {
+      governor->AddFrameGap(gap_ms);
+      EXPECT_GE(governor->GetTimeoutMs(), governor->GetConfig().min_timeout_ms);
+      EXPECT_LE(governor->GetTimeoutMs(), governor->GetConfig().max_timeout_ms);
+    }
+  }
+  return result;
+}
+
+IdleGovernorConfig MakeConfig(uint32_t power_bias) {
+  IdleGovernorConfig config;
+  config.default_timeout_ms = 70;
+  config.min_timeout_ms = 35;
+  config.max_timeout_ms = 560;
+  config.power_bias = power_bias;
+  return config;
+}
+
+TEST(IdleGovernorTest, KeepsDefaultUntilWarmedUp) {
+  IdleGovernor governor;
+  governor.Configure(MakeConfig(50));
+  EXPECT_EQ(governor.GetTimeoutMs(), 70u);
+  for (uint32_t i = 0; i + 1 < IdleGovernor::kUpdateFrames; i++) {
+    EXPECT_FALSE(governor.AddFrameGap(5000));
+  }
+  EXPECT_EQ(governor.GetTimeoutMs(), 70u);
+  // Long static gaps only cost power, the shortest timeout wins.
+  EXPECT_TRUE(governor.AddFrameGap(5000));
+  EXPECT_EQ(governor.GetTimeoutMs(), 35u);
+}
+
+TEST(IdleGovernorTest, TypingAvoidsFallbackChurn) {
+  TraceBuilder trace;
+  trace.Typing(400);
+
+  SimResult fixed = Simulate(trace.Get(), 70, nullptr);
+  IdleGovernor governor;
+  governor.Configure(MakeConfig(50));
+  SimResult adaptive = Simulate(trace.Get(), 0, &governor);
+
+  // Every keystroke churns with the fixed timeout, the governor learns to wait them out.
+  EXPECT_GE(fixed.churn, 390u);
+  EXPECT_LT(adaptive.churn, fixed.churn / 10);
+  EXPECT_GT(governor.GetTimeoutMs(), 450u);
+}
+
+TEST(IdleGovernorTest, StaticScreensIdleEarly) {
+  TraceBuilder trace;
+  trace.Reading(100);
+
+  SimResult fixed = Simulate(trace.Get(), 560, nullptr);
+  IdleGovernor governor;
+  governor.Configure(MakeConfig(50));
+  SimResult adaptive = Simulate(trace.Get(), 0, &governor);
+
+  EXPECT_EQ(adaptive.idle_entries, fixed.idle_entries);
+  EXPECT_EQ(adaptive.churn, 0u);
+  EXPECT_LT(adaptive.full_power_ms, fixed.full_power_ms / 4);
+  EXPECT_EQ(governor.GetTimeoutMs(), 35u);
+}
+
+TEST(IdleGovernorTest, PowerBiasTradesChurnForPower) {
+  TraceBuilder trace;
+  trace.Typing(100).Reading(10).Typing(100);
+
+  IdleGovernor churn_averse;
+  churn_averse.Configure(MakeConfig(10));
+  SimResult averse = Simulate(trace.Get(), 0, &churn_averse);
+  IdleGovernor power_saver;
+  power_saver.Configure(MakeConfig(98));
+  SimResult saver = Simulate(trace.Get(), 0, &power_saver);
+
+  EXPECT_LT(averse.churn, saver.churn);
+  EXPECT_GT(averse.full_power_ms, saver.full_power_ms);
+}
+
+TEST(IdleGovernorTest, FollowsWorkloadChanges) {
+  IdleGovernor governor;
+  governor.Configure(MakeConfig(50));
+
+  TraceBuilder typing;
+  Simulate(typing.Typing(200).Get(), 0, &governor);
+  uint32_t typing_ms = governor.GetTimeoutMs();
+
+  // Video never idles, the decision is left to the remaining history.
+  TraceBuilder video;
+  Simulate(video.Video(300).Get(), 0, &governor);
+
+  TraceBuilder reading;
+  Simulate(reading.Reading(40).Get(), 0, &governor);
+  EXPECT_LT(governor.GetTimeoutMs(), typing_ms);
+  EXPECT_FALSE(governor.Dump().empty());
+}
+
+}  // namespace
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "../layer_stack_trace.h"
+
+using namespace sdm;
+
+namespace {
+
+LayerStackTraceConfig MakeConfig() {
+  LayerStackTraceConfig config;
+  config.display_id = 4;
+  config.display_type = kBuiltIn;
+  config.display_attributes.x_pixels = 1080;
+  config.display_attributes.y_pixels = 2400;
+  config.display_attributes.fps = 120;
+  config.display_attributes.vsync_period_ns = 8333333;
+  config.display_attributes.topology = kDualLMDSC;
+  config.display_attributes.topology_num_split = 2;
+  config.panel_info.mode = kModeCommand;
+  config.panel_info.partial_update = true;
+  config.panel_info.min_fps = 60;
+  config.panel_info.max_fps = 120;
+  config.panel_info.split_info.left_split = 540;
+  config.panel_info.qsync_support = true;
+  config.mixer_attributes.width = 1080;
+  config.mixer_attributes.height = 2400;
+  config.mixer_attributes.split_left = 540;
+  config.mixer_attributes.split_type = kDualSplit;
+  config.fb_config.x_pixels = 1080;
+  config.fb_config.y_pixels = 2400;
+  config.hw_resource.num_vig_pipe = 4;
+  config.hw_resource.num_dma_pipe = 6;
+  config.hw_resource.num_blending_stages = 11;
+  config.hw_resource.max_mixer_width = 2560;
+  config.hw_resource.has_ubwc = true;
+  return config;
+}
+
+void MakeFrame(LayerStackTraceFrame *frame) {
+  frame->layers.resize(2);
+  Layer &app = frame->layers[0];
+  app.input_buffer.width = 1088;
+  app.input_buffer.height = 2400;
+  app.input_buffer.format = kFormatRGBA8888Ubwc;
+  app.input_buffer.buffer_id = 77;
+  app.src_rect = LayerRect(0, 0, 1080, 2400);
+  app.dst_rect = LayerRect(0, 0, 1080, 2400);
+  app.visible_regions.push_back(LayerRect(0, 0, 1080, 2400));
+  app.dirty_regions.push_back(LayerRect(0, 100, 1080, 200));
+  app.composition = kCompositionSDE;
+  app.flags.updating = 1;
+  app.update_mask.set(kSurfaceDamage);
+  app.layer_id = 12;
+  app.layer_name = "com.example.app/MainActivity#0";
+
+  Layer &target = frame->layers[1];
+  target.composition = kCompositionGPUTarget;
+  target.transform.flip_vertical = true;
+  target.plane_alpha = 0x80;
+
+  frame->stack.layers = { &app, &target };
+  frame->stack.flags.geometry_changed = 1;
+  frame->stack.force_refresh_rate = 90;
+}
+
+TEST(LayerStackTraceTest, ConfigRoundTrip) {
+  LayerStackTraceConfig config = MakeConfig();
+  std::string payload;
+  LayerStackTrace::EncodeConfig(config, &payload);
+
+  LayerStackTraceConfig decoded;
+  ASSERT_TRUE(LayerStackTrace::DecodeConfig(payload, &decoded));
+  EXPECT_EQ(decoded.display_id, 4);
+  EXPECT_TRUE(decoded.display_attributes == config.display_attributes);
+  EXPECT_TRUE(decoded.panel_info == config.panel_info);
+  EXPECT_TRUE(decoded.mixer_attributes == config.mixer_attributes);
+  EXPECT_TRUE(decoded.fb_config == config.fb_config);
+  EXPECT_EQ(decoded.hw_resource.num_vig_pipe, 4u);
+  EXPECT_EQ(decoded.hw_resource.max_mixer_width, 2560u);
+  EXPECT_TRUE(decoded.hw_resource.has_ubwc);
+
+  // Truncated payloads are rejected.
+  payload.pop_back();
+  EXPECT_FALSE(LayerStackTrace::DecodeConfig(payload, &decoded));
+}
+
+TEST(LayerStackTraceTest, FrameRoundTrip) {
+  LayerStackTraceFrame frame;
+  MakeFrame(&frame);
+  std::string payload;
+  LayerStackTrace::EncodeFrame(frame.stack, 123456789, &payload);
+
+  LayerStackTraceFrame decoded;
+  ASSERT_TRUE(LayerStackTrace::DecodeFrame(payload, &decoded));
+  EXPECT_EQ(decoded.timestamp_ns, 123456789);
+  ASSERT_EQ(decoded.stack.layers.size(), 2u);
+  EXPECT_EQ(decoded.stack.layers[0], &decoded.layers[0]);
+  EXPECT_EQ(decoded.stack.flags.geometry_changed, 1u);
+  EXPECT_EQ(decoded.stack.force_refresh_rate, 90u);
+
+  const Layer &app = decoded.layers[0];
+  EXPECT_EQ(app.input_buffer.width, 1088u);
+  EXPECT_EQ(app.input_buffer.format, kFormatRGBA8888Ubwc);
+  EXPECT_EQ(app.input_buffer.buffer_id, 77u);
+  EXPECT_TRUE(app.dst_rect == LayerRect(0, 0, 1080, 2400));
+  ASSERT_EQ(app.dirty_regions.size(), 1u);
+  EXPECT_TRUE(app.dirty_regions[0] == LayerRect(0, 100, 1080, 200));
+  EXPECT_EQ(app.composition, kCompositionSDE);
+  EXPECT_EQ(app.flags.updating, 1u);
+  EXPECT_TRUE(app.update_mask.test(kSurfaceDamage));
+  EXPECT_EQ(app.layer_id, 12u);
+  EXPECT_EQ(app.layer_name, "com.example.app/MainActivity#0");
+
+  const Layer &target = decoded.layers[1];
+  EXPECT_EQ(target.composition, kCompositionGPUTarget);
+  EXPECT_TRUE(target.transform.flip_vertical);
+  EXPECT_EQ(target.plane_alpha, 0x80);
+
+  payload.append(1, '\0');
+  EXPECT_FALSE(LayerStackTrace::DecodeFrame(payload, &decoded));
+}
+
+TEST(LayerStackTraceTest, FileRoundTrip) {
+  char path[] = "/tmp/layer_stack_trace_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  LayerStackTraceConfig config = MakeConfig();
+  LayerStackTraceFrame frame;
+  MakeFrame(&frame);
+
+  LayerStackTraceWriter writer;
+  ASSERT_EQ(writer.Open(path, 2), kErrorNone);
+  // Frames are dropped until the display setup has been recorded.
+  EXPECT_NE(writer.WriteFrame(frame.stack, 1), kErrorNone);
+  EXPECT_TRUE(writer.NeedsConfig(config.display_attributes, config.panel_info,
+                                 config.mixer_attributes, config.fb_config));
+  ASSERT_EQ(writer.WriteConfig(config), kErrorNone);
+  EXPECT_FALSE(writer.NeedsConfig(config.display_attributes, config.panel_info,
+                                  config.mixer_attributes, config.fb_config));
+  EXPECT_EQ(writer.WriteFrame(frame.stack, 1), kErrorNone);
+  EXPECT_EQ(writer.WriteFrame(frame.stack, 2), kErrorNone);
+  // The writer stops accepting frames once max_frames have been captured.
+  EXPECT_FALSE(writer.IsOpen());
+  EXPECT_NE(writer.WriteFrame(frame.stack, 3), kErrorNone);
+  EXPECT_EQ(writer.GetFrameCount(), 2u);
+  // Waits for the writer thread to write out the queued records.
+  writer.Close();
+
+  LayerStackTraceReader reader;
+  ASSERT_EQ(reader.Open(path), kErrorNone);
+  LayerStackTraceConfig decoded_config;
+  LayerStackTraceFrame decoded_frame;
+  EXPECT_EQ(reader.Next(&decoded_config, &decoded_frame), LayerStackTraceReader::kResultConfig);
+  EXPECT_EQ(decoded_config.display_id, 4);
+  EXPECT_EQ(reader.Next(&decoded_config, &decoded_frame), LayerStackTraceReader::kResultFrame);
+  EXPECT_EQ(decoded_frame.timestamp_ns, 1);
+  EXPECT_EQ(reader.Next(&decoded_config, &decoded_frame), LayerStackTraceReader::kResultFrame);
+  EXPECT_EQ(decoded_frame.timestamp_ns, 2);
+  EXPECT_EQ(reader.Next(&decoded_config, &decoded_frame), LayerStackTraceReader::kResultEnd);
+  reader.Close();
+
+  // Anything but a trace is refused.
+  FILE *fp = fopen(path, "wb");
+  ASSERT_NE(fp, nullptr);
+  fputs("not a trace", fp);
+  fclose(fp);
+  EXPECT_EQ(reader.Open(path), kErrorVersion);
+
+  unlink(path);
+}
+
+}  // namespace
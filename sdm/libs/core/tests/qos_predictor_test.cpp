@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../qos_predictor.h"
+
+using namespace sdm;
+
+namespace {
+
+const uint32_t kWidth = 1080;
+const uint32_t kHeight = 2400;
+
+Layer MakeLayer(LayerBufferFormat format, const LayerRect &src, const LayerRect &dst) {
+  Layer layer;
+  layer.composition = kCompositionSDE;
+  layer.input_buffer.format = format;
+  layer.src_rect = src;
+  layer.dst_rect = dst;
+  return layer;
+}
+
+// Launcher: wallpaper and icons.
+std::vector<Layer> UiScene() {
+  return {MakeLayer(kFormatRGBA8888Ubwc, LayerRect(0, 0, 1080, 2400), LayerRect(0, 0, 1080, 2400)),
+          MakeLayer(kFormatRGBA8888Ubwc, LayerRect(0, 0, 1080, 600),
+                    LayerRect(0, 1800, 1080, 2400))};
+}
+
+// Full screen landscape 4K video rotated and downscaled onto the panel, under the controls.
+std::vector<Layer> VideoScene(bool hdr) {
+  std::vector<Layer> layers = UiScene();
+  Layer video = MakeLayer(kFormatYCbCr420SPVenusUbwc, LayerRect(0, 0, 3840, 2160),
+                          LayerRect(0, 0, 1080, 2400));
+  video.transform.rotation = 90.0f;
+  if (hdr) {
+    video.input_buffer.color_metadata.transfer = Transfer_SMPTE_ST2084;
+  }
+  layers.insert(layers.begin() + 1, video);
+  return layers;
+}
+
+HWQosData MakeQos(uint64_t bps, uint32_t clock_hz) {
+  HWQosData qos_data;
+  qos_data.valid = true;
+  qos_data.core_ab_bps = bps;
+  qos_data.core_ib_bps = bps * 2;
+  qos_data.dram_ab_bps = bps;
+  qos_data.dram_ib_bps = bps * 2;
+  qos_data.clock_hz = clock_hz;
+  return qos_data;
+}
+
+struct SimScene {
+  std::vector<Layer> layers;
+  HWQosData need;
+};
+
+struct SimResult {
+  uint32_t underruns = 0;  // Frames committed below their need
+};
+
+// Replays scene transitions. The computed vote ramps towards a new scene like a resource manager
+// that only sees the current frame: the first frame of a heavier scene is voted at the midpoint
+// between the previous and the new demand.
+SimResult Simulate(const std::vector<std::pair<const SimScene *, uint32_t>> &trace,
+                   QosPredictor *predictor) {
+  SimResult result;
+  const SimScene *previous = nullptr;
+  for (auto &segment : trace) {
+    const SimScene &scene = *segment.first;
+    uint64_t scene_class = QosPredictor::GetSceneClass(scene.layers, kWidth, kHeight);
+    for (uint32_t frame = 0; frame < segment.second; frame++) {
+      HWQosData qos_data = scene.need;
+      if (frame == 0 && previous && previous->need.core_ab_bps < scene.need.core_ab_bps) {
+        qos_data = MakeQos((previous->need.core_ab_bps + scene.need.core_ab_bps) / 2,
+                           (previous->need.clock_hz + scene.need.clock_hz) / 2);
+      }
+      if (predictor) {
+        predictor->Predict(scene_class, &qos_data);
+      }
+      if (qos_data.core_ab_bps < scene.need.core_ab_bps ||
+          qos_data.clock_hz < scene.need.clock_hz) {
+        result.underruns++;
+      }
+    }
+    previous = &scene;
+  }
+  return result;
+}
+
+TEST(QosPredictorTest, SceneClassFollowsGeometry) {
+  uint64_t ui = QosPredictor::GetSceneClass(UiScene(), kWidth, kHeight);
+  uint64_t video = QosPredictor::GetSceneClass(VideoScene(false), kWidth, kHeight);
+  uint64_t hdr = QosPredictor::GetSceneClass(VideoScene(true), kWidth, kHeight);
+  EXPECT_NE(ui, video);
+  EXPECT_NE(video, hdr);
+  EXPECT_EQ(ui, QosPredictor::GetSceneClass(UiScene(), kWidth, kHeight));
+
+  // Small moves keep the class, scaling and rotation do not.
+  std::vector<Layer> moved = UiScene();
+  moved[1].dst_rect = LayerRect(0, 1790, 1080, 2390);
+  EXPECT_EQ(ui, QosPredictor::GetSceneClass(moved, kWidth, kHeight));
+  std::vector<Layer> scaled = VideoScene(false);
+  scaled[1].src_rect = LayerRect(0, 0, 1920, 1080);
+  EXPECT_NE(video, QosPredictor::GetSceneClass(scaled, kWidth, kHeight));
+  std::vector<Layer> landscape = VideoScene(false);
+  landscape[1].transform.rotation = 0.0f;
+  EXPECT_NE(video, QosPredictor::GetSceneClass(landscape, kWidth, kHeight));
+}
+
+TEST(QosPredictorTest, RecurringVideoStartIsPrevoted) {
+  SimScene ui = {UiScene(), MakeQos(1000000000, 200000000)};
+  SimScene video = {VideoScene(false), MakeQos(4000000000, 400000000)};
+  SimScene hdr = {VideoScene(true), MakeQos(5000000000, 460000000)};
+  std::vector<std::pair<const SimScene *, uint32_t>> trace;
+  for (uint32_t i = 0; i < 5; i++) {
+    trace.push_back({&ui, 120});
+    trace.push_back({(i % 2) ? &hdr : &video, 240});
+  }
+
+  SimResult computed = Simulate(trace, nullptr);
+  QosPredictor predictor;
+  SimResult predicted = Simulate(trace, &predictor);
+
+  // Every video start underruns on the computed vote, only the first start of each kind does
+  // with prediction.
+  EXPECT_EQ(computed.underruns, 5u);
+  EXPECT_EQ(predicted.underruns, 2u);
+  EXPECT_GT(predictor.GetStats().predicted, 0u);
+}
+
+TEST(QosPredictorTest, RelaxesOnlyAfterSustainedLowerDemand) {
+  QosPredictor predictor;
+  uint64_t ui = QosPredictor::GetSceneClass(UiScene(), kWidth, kHeight);
+  uint64_t video = QosPredictor::GetSceneClass(VideoScene(false), kWidth, kHeight);
+  HWQosData low = MakeQos(1000, 10);
+  HWQosData high = MakeQos(4000, 40);
+
+  HWQosData qos_data = high;
+  predictor.Predict(video, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+
+  // Lower demand keeps the vote for kRelaxFrames - 1 frames and then drops it in one step.
+  for (uint32_t i = 1; i < QosPredictor::kRelaxFrames; i++) {
+    qos_data = low;
+    predictor.Predict(ui, &qos_data);
+    EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+    EXPECT_EQ(qos_data.clock_hz, 40u);
+  }
+  qos_data = low;
+  predictor.Predict(ui, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 1000u);
+  EXPECT_EQ(predictor.GetStats().held, QosPredictor::kRelaxFrames - 1);
+
+  // A single heavy frame restarts the hold, a higher clock alone raises the vote.
+  qos_data = high;
+  predictor.Predict(video, &qos_data);
+  qos_data = low;
+  qos_data.clock_hz = 80;
+  predictor.Predict(ui, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+  EXPECT_EQ(qos_data.clock_hz, 80u);
+
+  predictor.ResetVote();
+  qos_data = low;
+  predictor.Predict(ui, &qos_data);
+  EXPECT_EQ(qos_data.clock_hz, 80u);  // The ui scene itself learned the higher clock
+  EXPECT_EQ(qos_data.core_ab_bps, 1000u);
+}
+
+TEST(QosPredictorTest, RelaxesOnFramesCommittedWithoutValidate) {
+  QosPredictor predictor;
+  uint64_t ui = QosPredictor::GetSceneClass(UiScene(), kWidth, kHeight);
+  uint64_t video = QosPredictor::GetSceneClass(VideoScene(false), kWidth, kHeight);
+  const uint64_t start_ns = 1000000;
+
+  HWQosData qos_data = MakeQos(4000, 40);
+  predictor.Predict(video, &qos_data);
+  predictor.Commit(start_ns, &qos_data);
+  qos_data = MakeQos(1000, 10);
+  predictor.Predict(ui, &qos_data);
+  predictor.Commit(start_ns, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+
+  // The client keeps committing the same stack without a validate, every commit counts once.
+  for (uint32_t i = 2; i < QosPredictor::kRelaxFrames; i++) {
+    predictor.Commit(start_ns, &qos_data);
+    EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+  }
+  predictor.Commit(start_ns, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 1000u);
+  EXPECT_EQ(qos_data.clock_hz, 10u);
+}
+
+TEST(QosPredictorTest, RelaxesHeldVoteAfterTimeout) {
+  QosPredictor predictor;
+  uint64_t ui = QosPredictor::GetSceneClass(UiScene(), kWidth, kHeight);
+  uint64_t video = QosPredictor::GetSceneClass(VideoScene(false), kWidth, kHeight);
+  const uint64_t start_ns = 1000000;
+
+  HWQosData qos_data = MakeQos(4000, 40);
+  predictor.Predict(video, &qos_data);
+  predictor.Commit(start_ns, &qos_data);
+  qos_data = MakeQos(1000, 10);
+  predictor.Predict(ui, &qos_data);
+  predictor.Commit(start_ns, &qos_data);
+
+  // A static screen commits rarely, the hold ends after kRelaxTimeNs however few frames came.
+  predictor.Commit(start_ns + QosPredictor::kRelaxTimeNs - 1, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 4000u);
+  predictor.Commit(start_ns + QosPredictor::kRelaxTimeNs, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 1000u);
+
+  // Once relaxed, later commits leave the vote alone.
+  predictor.Commit(start_ns + 2 * QosPredictor::kRelaxTimeNs, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 1000u);
+}
+
+TEST(QosPredictorTest, SceneHistoryIsBounded) {
+  QosPredictor predictor;
+  for (uint64_t scene = 1; scene <= 2 * QosPredictor::kMaxScenes; scene++) {
+    HWQosData qos_data = MakeQos(scene * 1000, 10);
+    predictor.Predict(scene, &qos_data);
+  }
+  predictor.ResetVote();
+
+  // The oldest scenes were evicted, the most recent ones are still predicted.
+  HWQosData qos_data = MakeQos(10, 10);
+  predictor.Predict(1, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 10u);
+  predictor.ResetVote();
+  qos_data = MakeQos(10, 10);
+  predictor.Predict(2 * QosPredictor::kMaxScenes, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 2 * QosPredictor::kMaxScenes * 1000);
+
+  predictor.Reset();
+  qos_data = MakeQos(10, 10);
+  predictor.Predict(2 * QosPredictor::kMaxScenes, &qos_data);
+  EXPECT_EQ(qos_data.core_ab_bps, 10u);
+}
+
+TEST(QosPredictorTest, InvalidVoteIsUntouched) {
+  QosPredictor predictor;
+  HWQosData qos_data = MakeQos(1000, 10);
+  predictor.Predict(1, &qos_data);
+  HWQosData invalid = {};
+  predictor.Predict(1, &invalid);
+  EXPECT_FALSE(invalid.valid);
+  EXPECT_EQ(invalid.core_ab_bps, 0u);
+  EXPECT_EQ(predictor.GetStats().frames, 1u);
+  EXPECT_FALSE(predictor.Dump().empty());
+}
+
+}  // namespace
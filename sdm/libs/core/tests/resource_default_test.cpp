@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include "../resource_default.h"
+
+using namespace sdm;
+
+namespace {
+
+const uint32_t kWidth = 1080;
+const uint32_t kHeight = 2400;
+
+::testing::AssertionResult SameRect(const LayerRect &rect, const LayerRect &expected) {
+  if (rect.left == expected.left && rect.top == expected.top && rect.right == expected.right &&
+      rect.bottom == expected.bottom) {
+    return ::testing::AssertionSuccess();
+  }
+  return ::testing::AssertionFailure() << "[" << rect.left << ", " << rect.top << ", "
+                                       << rect.right << ", " << rect.bottom << "] != ["
+                                       << expected.left << ", " << expected.top << ", "
+                                       << expected.right << ", " << expected.bottom << "]";
+}
+
+// A single mixer panel with a 64x64 cursor over a full screen app, as the strategy left it after
+// the last full cycle.
+class CursorPositionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SetUpResource(true /* src_split */, kNoSplit);
+  }
+
+  void TearDown() override {
+    if (resource_) {
+      resource_->UnregisterDisplay(display_ctx_);
+      ResourceDefault::DestroyResourceDefault(resource_);
+      resource_ = nullptr;
+    }
+  }
+
+  void SetUpResource(bool src_split, HWMixerSplit split_type) {
+    TearDown();
+
+    HWResourceInfo hw_res_info;
+    hw_res_info.num_vig_pipe = 2;
+    hw_res_info.num_rgb_pipe = 2;
+    hw_res_info.num_dma_pipe = 2;
+    PipeType types[] = {kPipeTypeVIG, kPipeTypeVIG, kPipeTypeRGB, kPipeTypeRGB, kPipeTypeDMA,
+                        kPipeTypeDMA};
+    for (uint32_t i = 0; i < 6; i++) {
+      HWPipeCaps pipe_caps;
+      pipe_caps.type = types[i];
+      pipe_caps.id = i;
+      hw_res_info.hw_pipes.push_back(pipe_caps);
+    }
+    hw_res_info.max_scale_up = 20;
+    hw_res_info.max_scale_down = 4;
+    hw_res_info.is_src_split = src_split;
+    ASSERT_EQ(ResourceDefault::CreateResourceDefault(hw_res_info, &resource_), kErrorNone);
+
+    HWDisplayAttributes display_attributes;
+    display_attributes.x_pixels = kWidth;
+    display_attributes.y_pixels = kHeight;
+    HWMixerAttributes mixer_attributes;
+    mixer_attributes.width = kWidth;
+    mixer_attributes.height = kHeight;
+    mixer_attributes.split_type = split_type;
+    mixer_attributes.split_left = (split_type == kNoSplit) ? kWidth : kWidth / 2;
+    ASSERT_EQ(resource_->RegisterDisplay(0, kBuiltIn, display_attributes, HWPanelInfo(),
+                                         mixer_attributes, Resolution(), &display_ctx_),
+              kErrorNone);
+
+    fb_config_.x_pixels = kWidth;
+    fb_config_.y_pixels = kHeight;
+
+    HWLayersInfo &info = disp_layer_stack_.info;
+    info.hw_layers.resize(2);
+    Layer &app = info.hw_layers[0];
+    app.composition = kCompositionSDE;
+    app.src_rect = LayerRect(0, 0, kWidth, kHeight);
+    app.dst_rect = app.src_rect;
+    info.config[0].left_pipe.valid = true;
+    info.config[0].left_pipe.src_roi = app.src_rect;
+    info.config[0].left_pipe.dst_roi = app.dst_rect;
+
+    Layer &cursor = info.hw_layers[1];
+    cursor.composition = kCompositionCursor;
+    cursor.input_buffer.format = kFormatRGBA8888;
+    cursor.src_rect = LayerRect(0, 0, 64, 64);
+    cursor.dst_rect = LayerRect(100, 100, 164, 164);
+    info.config[1].left_pipe.valid = true;
+    info.config[1].left_pipe.pipe_id = 5;
+    info.config[1].left_pipe.src_roi = cursor.src_rect;
+    info.config[1].left_pipe.dst_roi = cursor.dst_rect;
+  }
+
+  DisplayError Move(int x, int y) {
+    return resource_->ValidateAndSetCursorPosition(display_ctx_, &disp_layer_stack_, x, y,
+                                                   &fb_config_);
+  }
+
+  const HWPipeInfo &CursorPipe(bool right = false) {
+    HWLayerConfig &config = disp_layer_stack_.info.config[1];
+    return right ? config.right_pipe : config.left_pipe;
+  }
+
+  Layer &CursorLayer() { return disp_layer_stack_.info.hw_layers[1]; }
+
+  ResourceInterface *resource_ = nullptr;
+  Handle display_ctx_ = nullptr;
+  DispLayerStack disp_layer_stack_;
+  DisplayConfigVariableInfo fb_config_;
+};
+
+TEST_F(CursorPositionTest, MovesCursorPipeOnly) {
+  ASSERT_EQ(Move(400, 700), kErrorNone);
+
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(400, 700, 464, 764)));
+  EXPECT_TRUE(SameRect(CursorPipe().src_roi, LayerRect(0, 0, 64, 64)));
+  EXPECT_EQ(CursorPipe().pipe_id, 5u);
+  EXPECT_FALSE(CursorPipe(true).valid);
+  EXPECT_TRUE(SameRect(CursorLayer().dst_rect, LayerRect(400, 700, 464, 764)));
+
+  // The app layer keeps its pipe untouched.
+  EXPECT_TRUE(SameRect(disp_layer_stack_.info.config[0].left_pipe.dst_roi,
+                       LayerRect(0, 0, kWidth, kHeight)));
+}
+
+TEST_F(CursorPositionTest, MapsFramebufferToMixer) {
+  // The client renders at twice the mixer resolution, the cursor is downscaled onto the mixer.
+  fb_config_.x_pixels = kWidth * 2;
+  fb_config_.y_pixels = kHeight * 2;
+  ASSERT_EQ(Move(800, 1400), kErrorNone);
+
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(400, 700, 432, 732)));
+  EXPECT_TRUE(SameRect(CursorPipe().src_roi, LayerRect(0, 0, 64, 64)));
+}
+
+TEST_F(CursorPositionTest, ClipsAtPanelEdge) {
+  // Only the left 30 columns remain visible, the source is cropped by the same amount.
+  ASSERT_EQ(Move(INT(kWidth) - 30, 200), kErrorNone);
+
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(kWidth - 30, 200, kWidth, 264)));
+  EXPECT_TRUE(SameRect(CursorPipe().src_roi, LayerRect(0, 0, 30, 64)));
+
+  // Top left corner, the source loses the clipped rows and columns.
+  ASSERT_EQ(Move(-10, -20), kErrorNone);
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(0, 0, 54, 44)));
+  EXPECT_TRUE(SameRect(CursorPipe().src_roi, LayerRect(10, 20, 64, 64)));
+}
+
+TEST_F(CursorPositionTest, RefusesOffScreenCursor) {
+  LayerRect dst_roi = CursorPipe().dst_roi;
+  EXPECT_NE(Move(INT(kWidth) + 5, 200), kErrorNone);
+  EXPECT_NE(Move(200, -100), kErrorNone);
+
+  // Nothing is changed, the next full cycle disables the pipe.
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, dst_roi));
+  EXPECT_TRUE(SameRect(CursorLayer().dst_rect, LayerRect(100, 100, 164, 164)));
+}
+
+TEST_F(CursorPositionTest, RefusesWithoutCursorPlane) {
+  disp_layer_stack_.info.hw_layers[1].composition = kCompositionGPU;
+  EXPECT_EQ(Move(400, 700), kErrorNotSupported);
+
+  disp_layer_stack_.info.hw_layers[1].composition = kCompositionCursor;
+  disp_layer_stack_.info.config[1].left_pipe.valid = false;
+  EXPECT_EQ(Move(400, 700), kErrorNotSupported);
+}
+
+TEST_F(CursorPositionTest, RefusesCrossingMixerSplit) {
+  SetUpResource(false /* src_split */, kDualSplit);
+
+  // Within the left mixer half the single pipe is kept.
+  ASSERT_EQ(Move(200, 300), kErrorNone);
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(200, 300, 264, 364)));
+
+  // Straddling the split would need a second pipe, which only a full cycle can assign.
+  EXPECT_EQ(Move(INT(kWidth / 2) - 20, 300), kErrorNotSupported);
+  EXPECT_TRUE(SameRect(CursorPipe().dst_roi, LayerRect(200, 300, 264, 364)));
+}
+
+}  // namespace
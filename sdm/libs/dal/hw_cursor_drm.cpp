@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include "hw_cursor_drm.h"
+
+#define __CLASS__ "HWCursorDRM"
+
+using sde_drm::DRMOps;
+using sde_drm::DRMRect;
+
+namespace sdm {
+
+static DRMRect ToDRMRect(const LayerRect &rect) {
+  return DRMRect{UINT32(rect.left), UINT32(rect.top), UINT32(rect.right), UINT32(rect.bottom)};
+}
+
+int HWCursorDRM::GetCursorIndex(const HWLayersInfo &hw_layers_info) {
+  for (uint32_t i = 0; i < hw_layers_info.hw_layers.size() && i < UINT32(kMaxSDELayers); i++) {
+    if (hw_layers_info.hw_layers.at(i).composition == kCompositionCursor &&
+        hw_layers_info.config[i].left_pipe.valid) {
+      return INT(i);
+    }
+  }
+
+  return -1;
+}
+
+DisplayError HWCursorDRM::Commit(sde_drm::DRMAtomicReqInterface *drm_atomic_intf,
+                                 const HWLayerConfig &layer_config) {
+  for (const HWPipeInfo *pipe_info : {&layer_config.left_pipe, &layer_config.right_pipe}) {
+    if (!pipe_info->valid) {
+      continue;
+    }
+    drm_atomic_intf->Perform(DRMOps::PLANE_SET_SRC_RECT, pipe_info->pipe_id,
+                             ToDRMRect(pipe_info->src_roi));
+    drm_atomic_intf->Perform(DRMOps::PLANE_SET_DST_RECT, pipe_info->pipe_id,
+                             ToDRMRect(pipe_info->dst_roi));
+  }
+
+  // Fails with -EBUSY while a frame commit is still pending. The caller skips the move then, the
+  // next frame carries the cursor position.
+  int ret = drm_atomic_intf->Commit(false /* synchronous */, true /* retain_planes */);
+  if (ret) {
+    DLOGI_IF(kTagDriverConfig, "Cursor commit failed with error %d", ret);
+    return kErrorHardware;
+  }
+
+  return kErrorNone;
+}
+
+}  // namespace sdm
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_CURSOR_DRM_H__
+#define __HW_CURSOR_DRM_H__
+
+#include <drm_interface.h>
+#include <private/hw_info_types.h>
+
+namespace sdm {
+
+// Moves the cursor of a display without recomposing. The cursor layer keeps the planes, buffer and
+// blend state of the last full commit. Only the source and destination rects of its planes are
+// sent, in a non blocking atomic commit that retains all other planes.
+class HWCursorDRM {
+ public:
+  // Returns the index of the cursor layer in hw_layers_info, or -1 if no plane shows a cursor.
+  static int GetCursorIndex(const HWLayersInfo &hw_layers_info);
+  static DisplayError Commit(sde_drm::DRMAtomicReqInterface *drm_atomic_intf,
+                             const HWLayerConfig &layer_config);
+};
+
+}  // namespace sdm
+
+#endif  // __HW_CURSOR_DRM_H__
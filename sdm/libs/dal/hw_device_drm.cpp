@@ -73,6 +73,7 @@
 #include <limits>
 
 #include "hw_device_drm.h"
+#include "hw_cursor_drm.h"
 
 #define __CLASS__ "HWDeviceDRM"
 
@@ -521,6 +522,7 @@ DisplayError HWDeviceDRM::Init() {
   }
 
   display_id_ = static_cast<int32_t>(token_.conn_id);
+  latency_stats_ = FrameLatencyStats::Get(display_id_);
 
   ret = drm_mgr_intf_->CreateAtomicReq(token_, &drm_atomic_intf_);
   if (ret) {
@@ -1784,6 +1786,7 @@ void HWDeviceDRM::ClearSolidfillStages() {
 
 DisplayError HWDeviceDRM::Validate(HWLayersInfo *hw_layers_info) {
   DTRACE_SCOPED();
+  ScopedFrameLatency latency(latency_stats_, kLatencyHwValidate);
 
   DisplayError err = kErrorNone;
   registry_.Register(hw_layers_info);
@@ -1808,6 +1811,7 @@ DisplayError HWDeviceDRM::Validate(HWLayersInfo *hw_layers_info) {
 
 DisplayError HWDeviceDRM::Commit(HWLayersInfo *hw_layers_info) {
   DTRACE_SCOPED();
+  ScopedFrameLatency latency(latency_stats_, kLatencyHwCommit);
 
   DisplayError err = kErrorNone;
   registry_.Register(hw_layers_info);
@@ -1891,9 +1895,16 @@ DisplayError HWDeviceDRM::AtomicCommit(HWLayersInfo *hw_layers_info) {
     }
   }
 
+  if (cursor_retire_fence_) {
+    // A cursor move still in flight would fail this commit with -EBUSY, it lands within a vsync.
+    Fence::Wait(cursor_retire_fence_);
+    cursor_retire_fence_ = nullptr;
+  }
+
   int ret = drm_atomic_intf_->Commit(sync_commit, false /* retain_planes*/);
   shared_ptr<Fence> release_fence = Fence::Create(INT(release_fence_fd), "release");
   shared_ptr<Fence> retire_fence = Fence::Create(INT(retire_fence_fd), "retire");
+  frame_retire_fence_ = ret ? nullptr : retire_fence;
   if (ret) {
     DLOGE("%s failed with error %d crtc %d", __FUNCTION__, ret, token_.crtc_id);
     DumpHWLayers(hw_layers_info);
@@ -2169,7 +2180,28 @@ bool HWDeviceDRM::EnableHotPlugDetection(int enable) {
 
 DisplayError HWDeviceDRM::SetCursorPosition(HWLayersInfo *hw_layers_info, int x, int y) {
   DTRACE_SCOPED();
-  return kErrorNone;
+  // The cursor pipes were already moved by the resource manager, only program them.
+  int index = HWCursorDRM::GetCursorIndex(*hw_layers_info);
+  if (default_mode_ || index < 0) {
+    return kErrorNotSupported;
+  }
+
+  // Skip the move while the last frame is not on screen yet rather than wait for it, the next
+  // frame carries the cursor position.
+  if (Fence::GetStatus(frame_retire_fence_) == Fence::Status::kPending) {
+    DLOGV_IF(kTagDriverConfig, "Frame commit pending, cursor move to %d, %d skipped", x, y);
+    return kErrorNotSupported;
+  }
+
+  int64_t retire_fence_fd = -1;
+  drm_atomic_intf_->Perform(DRMOps::CONNECTOR_GET_RETIRE_FENCE, token_.conn_id, &retire_fence_fd);
+  DisplayError error = HWCursorDRM::Commit(drm_atomic_intf_, hw_layers_info->config[index]);
+  shared_ptr<Fence> retire_fence = Fence::Create(INT(retire_fence_fd), "cursor_retire");
+  if (error == kErrorNone) {
+    cursor_retire_fence_ = retire_fence;
+  }
+
+  return error;
 }
 
 DisplayError HWDeviceDRM::GetPPFeaturesVersion(PPFeatureVersion *vers) {
@@ -37,6 +37,7 @@
 #define __HW_DEVICE_DRM_H__
 
 #include <utils/formats.h>
+#include <utils/frame_latency_stats.h>
 #include <private/hw_interface.h>
 #include <drm_interface.h>
 #include <errno.h>
@@ -284,6 +285,7 @@ class HWDeviceDRM : public HWInterface {
   const char *device_name_ = {};
   bool default_mode_ = false;
   int32_t display_id_ = -1;
+  FrameLatencyStats *latency_stats_ = nullptr;
   sde_drm::DRMDisplayType disp_type_ = {};
   HWInfoInterface *hw_info_intf_ = {};
   int dev_fd_ = -1;
@@ -335,6 +337,10 @@ class HWDeviceDRM : public HWInterface {
   static std::mutex cwb_state_lock_;  // cwb state lock. Set before accesing or updating cwb_config_
   uint32_t transfer_time_updated_ = 0;
   bool force_tonemapping_ = false;
+  // Frame and cursor commits are both non blocking, the driver rejects one while the other is
+  // still pending. Their retire fences tell when a commit has landed.
+  shared_ptr<Fence> frame_retire_fence_ = nullptr;
+  shared_ptr<Fence> cursor_retire_fence_ = nullptr;
 
  private:
   void GetCWBCapabilities();
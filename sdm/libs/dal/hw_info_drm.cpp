@@ -87,6 +87,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -165,6 +166,19 @@ static InlineRotationVersion GetInRotVersion(sde_drm::InlineRotationVersion drm_
 
 HWResourceInfo *HWInfoDRM::hw_resource_ = nullptr;
 
+static PipeType GetPipeType(DRMPlaneType drm_type) {
+  switch (drm_type) {
+    case DRMPlaneType::DMA:
+      return kPipeTypeDMA;
+    case DRMPlaneType::VIG:
+      return kPipeTypeVIG;
+    case DRMPlaneType::CURSOR:
+      return kPipeTypeCursor;
+    default:
+      return kPipeTypeUnused;
+  }
+}
+
 DisplayError HWInfoDRM::Init() {
   default_mode_ = (DRMLibLoader::GetInstance()->IsLoaded() == false);
   if (!default_mode_) {
@@ -196,6 +210,10 @@ DisplayError HWInfoDRM::Init() {
 }
 
 void HWInfoDRM::Deinit() {
+  if (snapshot_validator_.joinable()) {
+    snapshot_validator_.join();
+  }
+
   delete hw_resource_;
   hw_resource_ = nullptr;
 
@@ -230,12 +248,7 @@ DisplayError HWInfoDRM::GetDynamicBWLimits(HWResourceInfo *hw_resource) {
   return kErrorNone;
 }
 
-DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
-  if (hw_resource_) {
-    *hw_resource = *hw_resource_;
-    return kErrorNone;
-  }
-
+void HWInfoDRM::ProbeHWResourceInfo(HWResourceInfo *hw_resource) {
   hw_resource->num_blending_stages = 1;
   hw_resource->max_pipe_width = 5120;
   hw_resource->max_cursor_size = 128;
@@ -275,6 +288,46 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   GetHWPlanesInfo(hw_resource);
   GetWBInfo(hw_resource);
 
+  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
+    GetHWRotatorInfo(hw_resource);
+  }
+}
+
+DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
+  if (hw_resource_) {
+    *hw_resource = *hw_resource_;
+    return kErrorNone;
+  }
+
+  int enable_snapshot = 0;
+  Debug::GetProperty(ENABLE_HW_INFO_SNAPSHOT_PROP, &enable_snapshot);
+  bool use_snapshot = (enable_snapshot == 1);
+
+  HWInfoSnapshotKey snapshot_key;
+  bool from_snapshot = false;
+  if (use_snapshot) {
+    // /data/vendor/display may not be mounted yet when the composer starts, the load then fails
+    // and this boot probes live. A stale rotator entry in a served snapshot is only caught once
+    // ValidateSnapshot finishes, and is kept for the rest of this boot.
+    GetSnapshotKey(&snapshot_key);
+    from_snapshot = LoadSnapshot(snapshot_key, hw_resource);
+    if (from_snapshot && !snapshot_validator_.joinable()) {
+      snapshot_validator_ = std::thread(&HWInfoDRM::ValidateSnapshot, this, snapshot_key,
+                                        *hw_resource);
+    }
+  }
+
+  if (!from_snapshot) {
+    ProbeHWResourceInfo(hw_resource);
+    if (use_snapshot) {
+      DisplayError error = HWInfoSnapshot::Store(HWInfoSnapshot::kDefaultPath, snapshot_key,
+                                                 *hw_resource);
+      if (error != kErrorNone) {
+        DLOGW("Failed to store hw info snapshot. Error = %d", error);
+      }
+    }
+  }
+
   // Disable destination scalar count to 0 if extension library is not present or disabled
   // through property
   int value = 0;
@@ -323,10 +376,6 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   DLOGI("\tFudge_factor = %d", hw_resource->extra_fudge_factor);
   DLOGI("\tib_fudge_factor = %f", hw_resource->ib_fudge_factor);
 
-  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
-    GetHWRotatorInfo(hw_resource);
-  }
-
   DLOGI("Has Support for multiple bw limits shown below");
   for (int index = 0; index < kBwModeMax; index++) {
     DLOGI("Mode-index=%d  total_bw_limit=%" PRIu64 " and pipe_bw_limit=%" PRIu64, index,
@@ -342,6 +391,85 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   return kErrorNone;
 }
 
+void HWInfoDRM::GetSnapshotKey(HWInfoSnapshotKey *key) {
+  string panel_id;
+  GetPanelBootParamString(&panel_id);
+
+  // Debug properties read while probing change the result, so they are part of the key.
+  uint32_t max_vig_pipes = 0;
+  uint32_t max_dma_pipes = 0;
+  int disable_src_tonemap = 0;
+  Debug::GetReducedConfig(&max_vig_pipes, &max_dma_pipes);
+  Debug::Get()->GetProperty(DISABLE_SRC_TONEMAP_PROP, &disable_src_tonemap);
+  string probe_config = to_string(max_vig_pipes) + "," + to_string(max_dma_pipes) + "," +
+                        to_string(disable_src_tonemap);
+
+  char vendor_dlkm_build[kMaxStringLength] = {};
+  Debug::Get()->GetProperty("ro.vendor_dlkm.build.fingerprint", vendor_dlkm_build);
+
+  HWInfoSnapshot::GetSystemKey(vendor_dlkm_build, panel_id, probe_config, key);
+}
+
+bool HWInfoDRM::LoadSnapshot(const HWInfoSnapshotKey &key, HWResourceInfo *hw_resource) {
+  HWResourceInfo snapshot;
+  DisplayError error = HWInfoSnapshot::Load(HWInfoSnapshot::kDefaultPath, key, &snapshot);
+  if (error != kErrorNone) {
+    DLOGI("No usable hw info snapshot. Error = %d", error);
+    return false;
+  }
+
+  // Plane properties are already parsed by the DRM manager, so checking that every snapshot
+  // pipe is still exposed with the same type is cheap and catches a changed pipe layout.
+  DRMPlanesInfo planes;
+  drm_mgr_intf_->GetPlanesInfo(&planes);
+  for (auto &pipe_caps : snapshot.hw_pipes) {
+    auto it = std::find_if(planes.begin(), planes.end(), [&pipe_caps](const auto &plane) {
+      return plane.first == pipe_caps.id;
+    });
+    if (it == planes.end() || GetPipeType(it->second.type) != pipe_caps.type) {
+      DLOGW("Pipe %d in hw info snapshot does not match the hardware", pipe_caps.id);
+      HWInfoSnapshot::Remove(HWInfoSnapshot::kDefaultPath);
+      return false;
+    }
+  }
+
+  // Continuous splash state is not part of the snapshot, it changes from boot to boot.
+  MapPlaneToConnector(&snapshot);
+  GetInitialDemuraInfo(&snapshot);
+  for (auto &pipe_caps : snapshot.hw_pipes) {
+    SetPipeSplashInfo(snapshot, &pipe_caps);
+  }
+
+  *hw_resource = std::move(snapshot);
+  DLOGI("Loaded hw info snapshot");
+  return true;
+}
+
+void HWInfoDRM::ValidateSnapshot(HWInfoSnapshotKey key, HWResourceInfo snapshot) {
+  // The rotator is probed through V4L2 nodes which do not depend on the DRM manager, so it is
+  // re-probed off the startup path. A mismatch is served for this boot only, the snapshot is
+  // rewritten for the next one.
+  if (!snapshot.separate_rotator && !snapshot.num_dma_pipe) {
+    return;
+  }
+
+  HWResourceInfo live = snapshot;
+  live.hw_rot_info = {};
+  live.supported_formats_map.erase(kHWRotatorInput);
+  live.supported_formats_map.erase(kHWRotatorOutput);
+  GetHWRotatorInfo(&live);
+
+  string expected_payload, live_payload;
+  HWInfoSnapshot::Serialize(snapshot, &expected_payload);
+  HWInfoSnapshot::Serialize(live, &live_payload);
+  if (expected_payload != live_payload) {
+    DLOGW("Rotator caps changed since the hw info snapshot was taken, refreshing it");
+    if (HWInfoSnapshot::Store(HWInfoSnapshot::kDefaultPath, key, live) != kErrorNone) {
+      HWInfoSnapshot::Remove(HWInfoSnapshot::kDefaultPath);
+    }
+  }
+}
+
 void HWInfoDRM::GetSystemInfo(HWResourceInfo *hw_resource) {
   DRMCrtcInfo info;
   drm_mgr_intf_->GetCrtcInfo(0 /* system_info */, &info);
@@ -510,14 +638,7 @@ void HWInfoDRM::GetHWPlanesInfo(HWResourceInfo *hw_resource) {
         continue;  // Not adding any other pipe type
     }
     pipe_caps.id = pipe_obj.first;
-    auto it = hw_resource->plane_to_connector.find(pipe_caps.id);
-    if (it != hw_resource->plane_to_connector.end()) {
-      pipe_caps.cont_splash_disp_id = it->second;
-      auto it2 = std::find(hw_resource->initial_demura_planes.begin(),
-                           hw_resource->initial_demura_planes.end(), pipe_caps.id);
-      pipe_caps.splash_type = (it2 != hw_resource->initial_demura_planes.end()) ? kSplashDemura
-                                                                                : kSplashLayer;
-    }
+    SetPipeSplashInfo(*hw_resource, &pipe_caps);
     pipe_caps.master_pipe_id = pipe_obj.second.master_plane_id;
     pipe_caps.block_sec_ui = pipe_obj.second.block_sec_ui;
     DLOGI("Adding %s Pipe : Id %d, master_pipe_id : Id %d block_sec_ui: %d",
@@ -563,6 +684,19 @@ void HWInfoDRM::GetHWPlanesInfo(HWResourceInfo *hw_resource) {
   hw_resource->has_excl_rect = planes[0].second.has_excl_rect;
 }
 
+void HWInfoDRM::SetPipeSplashInfo(const HWResourceInfo &hw_resource, HWPipeCaps *pipe_caps) {
+  pipe_caps->cont_splash_disp_id = -1;
+  pipe_caps->splash_type = kSplashNone;
+  auto it = hw_resource.plane_to_connector.find(pipe_caps->id);
+  if (it != hw_resource.plane_to_connector.end()) {
+    pipe_caps->cont_splash_disp_id = it->second;
+    auto it2 = std::find(hw_resource.initial_demura_planes.begin(),
+                         hw_resource.initial_demura_planes.end(), pipe_caps->id);
+    pipe_caps->splash_type = (it2 != hw_resource.initial_demura_planes.end()) ? kSplashDemura
+                                                                              : kSplashLayer;
+  }
+}
+
 void HWInfoDRM::MapPlaneToConnector(HWResourceInfo *hw_resource) {
   drm_mgr_intf_->MapPlaneToConnector(&hw_resource->plane_to_connector);
 }
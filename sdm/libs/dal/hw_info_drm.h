@@ -37,10 +37,12 @@
 #include <drm_interface.h>
 #include <private/hw_info_types.h>
 #include <private/hw_info_interface.h>
+#include <private/hw_info_snapshot.h>
 #include <bitset>
 #include <vector>
 #include <map>
 #include <string>
+#include <thread>
 
 namespace sdm {
 
@@ -60,6 +62,10 @@ class HWInfoDRM : public HWInfoInterface {
 
  private:
   void Deinit();
+  void ProbeHWResourceInfo(HWResourceInfo *hw_resource);
+  void GetSnapshotKey(HWInfoSnapshotKey *key);
+  bool LoadSnapshot(const HWInfoSnapshotKey &key, HWResourceInfo *hw_resource);
+  void ValidateSnapshot(HWInfoSnapshotKey key, HWResourceInfo snapshot);
   DisplayError GetHWRotatorInfo(HWResourceInfo *hw_resource);
   void GetSystemInfo(HWResourceInfo *hw_resource);
   void GetHWPlanesInfo(HWResourceInfo *hw_resource);
@@ -79,9 +85,11 @@ class HWInfoDRM : public HWInfoInterface {
   void PopulatePipeBWCaps(const sde_drm::DRMPlaneTypeInfo &info, HWResourceInfo *hw_resource);
   void MapPlaneToConnector(HWResourceInfo *hw_resource);
   void GetInitialDemuraInfo(HWResourceInfo *hw_resource);
+  void SetPipeSplashInfo(const HWResourceInfo &hw_resource, HWPipeCaps *pipe_caps);
 
   sde_drm::DRMManagerInterface *drm_mgr_intf_ = {};
   bool default_mode_ = false;
+  std::thread snapshot_validator_;
 
   static const int kMaxStringLength = 1024;
   static const int kKiloUnit = 1000;
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <private/hw_info_snapshot.h>
+#include <utils/binary_stream.h>
+#include <utils/constants.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sdm {
+
+namespace {
+
+// FNV-1a, only meant to catch truncated or torn files.
+uint64_t Checksum(const char *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::string ReadFirstLine(const char *path) {
+  std::ifstream fs(path);
+  std::string line;
+  if (fs.is_open()) {
+    std::getline(fs, line);
+  }
+  return line;
+}
+
+}  // namespace
+
+void HWInfoSnapshot::GetSystemKey(const std::string &vendor_dlkm_build,
+                                  const std::string &panel_id, const std::string &probe_config,
+                                  HWInfoSnapshotKey *key) {
+  struct utsname name = {};
+  if (!uname(&name)) {
+    key->kernel_build = std::string(name.release) + " " + name.version;
+  }
+  key->soc_id = ReadFirstLine("/sys/devices/soc0/soc_id");
+  // The display driver can be updated in vendor_dlkm without a new kernel build. A built in
+  // driver has no srcversion and is covered by kernel_build.
+  key->module_build = vendor_dlkm_build + " " + ReadFirstLine("/sys/module/msm_drm/srcversion");
+  key->panel_id = panel_id;
+  key->probe_config = probe_config;
+}
+
+void HWInfoSnapshot::Serialize(const HWResourceInfo &hw, std::string *payload) {
+  payload->clear();
+  BinaryWriter w(payload);
+
+  w.Put(hw.hw_version);
+  w.Put(hw.num_dma_pipe);
+  w.Put(hw.num_vig_pipe);
+  w.Put(hw.num_rgb_pipe);
+  w.Put(hw.num_cursor_pipe);
+  w.Put(hw.num_blending_stages);
+  w.Put(hw.num_solidfill_stages);
+  w.Put(hw.max_scale_up);
+  w.Put(hw.max_scale_down);
+  w.Put(hw.max_bandwidth_low);
+  w.Put(hw.max_bandwidth_high);
+  w.Put(hw.max_mixer_width);
+  w.Put(hw.max_pipe_width);
+  w.Put(hw.max_pipe_width_dma);
+  w.Put(hw.max_scaler_pipe_width);
+  w.Put(hw.max_rotation_pipe_width);
+  w.Put(hw.max_cursor_size);
+  w.Put(hw.max_pipe_bw);
+  w.Put(hw.max_pipe_bw_high);
+  w.Put(hw.max_sde_clk);
+  w.Put(hw.clk_fudge_factor);
+  w.Put(hw.macrotile_nv12_factor);
+  w.Put(hw.macrotile_factor);
+  w.Put(hw.linear_factor);
+  w.Put(hw.scale_factor);
+  w.Put(hw.extra_fudge_factor);
+  w.Put(hw.amortizable_threshold);
+  w.Put(hw.system_overhead_lines);
+  w.PutBool(hw.has_ubwc);
+  w.PutBool(hw.has_decimation);
+  w.PutBool(hw.has_non_scalar_rgb);
+  w.PutBool(hw.is_src_split);
+  w.PutBool(hw.separate_rotator);
+  w.PutBool(hw.has_qseed3);
+  w.PutBool(hw.has_concurrent_writeback);
+  w.PutEnumVector(hw.tap_points);
+  w.PutBool(hw.has_ppp);
+  w.PutBool(hw.has_excl_rect);
+  w.Put(hw.writeback_index);
+
+  w.Put(hw.dyn_bw_info.cur_mode);
+  for (int i = 0; i < kBwModeMax; i++) {
+    w.Put(hw.dyn_bw_info.total_bw_limit[i]);
+    w.Put(hw.dyn_bw_info.pipe_bw_limit[i]);
+  }
+
+  w.Put<uint32_t>(UINT32(hw.hw_pipes.size()));
+  for (auto &pipe : hw.hw_pipes) {
+    w.PutEnum(pipe.type);
+    w.Put(pipe.id);
+    w.Put(pipe.master_pipe_id);
+    w.Put(pipe.max_rects);
+    w.PutBool(pipe.inverse_pma);
+    w.Put(pipe.dgm_csc_version);
+    w.Put<uint32_t>(UINT32(pipe.tm_lut_version_map.size()));
+    for (auto &lut : pipe.tm_lut_version_map) {
+      w.PutEnum(lut.first);
+      w.Put(lut.second);
+    }
+    w.PutBool(pipe.block_sec_ui);
+    w.Put(pipe.pipe_idx);
+    w.Put(pipe.demura_block_capability);
+  }
+
+  w.Put<uint32_t>(UINT32(hw.supported_formats_map.size()));
+  for (auto &formats : hw.supported_formats_map) {
+    w.PutEnum(formats.first);
+    w.PutEnumVector(formats.second);
+  }
+
+  w.Put(hw.hw_rot_info.num_rotator);
+  w.PutBool(hw.hw_rot_info.has_downscale);
+  w.PutString(hw.hw_rot_info.device_path);
+  w.Put(hw.hw_rot_info.min_downscale);
+  w.PutBool(hw.hw_rot_info.downscale_compression);
+  w.Put(hw.hw_rot_info.max_line_width);
+
+  w.Put(hw.hw_dest_scalar_info.count);
+  w.Put(hw.hw_dest_scalar_info.max_input_width);
+  w.Put(hw.hw_dest_scalar_info.max_output_width);
+  w.Put(hw.hw_dest_scalar_info.max_scale_up);
+  w.Put(hw.hw_dest_scalar_info.prefill_lines);
+
+  w.PutBool(hw.has_hdr);
+  w.PutEnum(hw.smart_dma_rev);
+  w.Put(hw.ib_fudge_factor);
+  w.Put(hw.undersized_prefill_lines);
+  for (auto *comp_ratio_map : {&hw.comp_ratio_rt_map, &hw.comp_ratio_nrt_map}) {
+    w.Put<uint32_t>(UINT32(comp_ratio_map->size()));
+    for (auto &ratio : *comp_ratio_map) {
+      w.PutEnum(ratio.first);
+      w.Put(ratio.second);
+    }
+  }
+  w.Put(hw.cache_size);
+  w.PutEnum(hw.pipe_qseed3_version);
+  w.Put(hw.min_prefill_lines);
+
+  w.PutEnum(hw.inline_rot_info.inrot_version);
+  w.PutEnumVector(hw.inline_rot_info.inrot_fmts_supported);
+  w.Put(hw.inline_rot_info.max_downscale_rt);
+  w.Put(hw.inline_rot_info.max_ds_without_pre_downscaler);
+
+  w.Put<uint32_t>(UINT32(hw.src_tone_map.to_ulong()));
+  w.Put(hw.secure_disp_blend_stage);
+  w.Put(hw.line_width_constraints_count);
+  for (auto *limits : {&hw.line_width_limits, &hw.line_width_constraints}) {
+    w.Put<uint32_t>(UINT32(limits->size()));
+    for (auto &limit : *limits) {
+      w.Put(limit.first);
+      w.Put(limit.second);
+    }
+  }
+  w.Put(hw.num_mnocports);
+  w.Put(hw.mnoc_bus_width);
+  w.PutBool(hw.use_baselayer_for_stage);
+  w.PutBool(hw.has_micro_idle);
+  w.Put(hw.ubwc_version);
+  w.Put(hw.rc_total_mem_size);
+  w.Put(hw.demura_count);
+  w.Put(hw.dspp_count);
+  w.PutBool(hw.skip_inline_rot_threshold);
+  w.PutBool(hw.has_noise_layer);
+  w.Put(hw.dsc_block_count);
+  w.PutEnum(hw.ddr_version);
+}
+
+bool HWInfoSnapshot::Deserialize(const std::string &payload, HWResourceInfo *out) {
+  BinaryReader r(payload);
+  HWResourceInfo hw;
+  uint32_t count = 0;
+
+  bool ok = r.Get(&hw.hw_version) && r.Get(&hw.num_dma_pipe) && r.Get(&hw.num_vig_pipe) &&
+            r.Get(&hw.num_rgb_pipe) && r.Get(&hw.num_cursor_pipe) &&
+            r.Get(&hw.num_blending_stages) && r.Get(&hw.num_solidfill_stages) &&
+            r.Get(&hw.max_scale_up) && r.Get(&hw.max_scale_down) &&
+            r.Get(&hw.max_bandwidth_low) && r.Get(&hw.max_bandwidth_high) &&
+            r.Get(&hw.max_mixer_width) && r.Get(&hw.max_pipe_width) &&
+            r.Get(&hw.max_pipe_width_dma) && r.Get(&hw.max_scaler_pipe_width) &&
+            r.Get(&hw.max_rotation_pipe_width) && r.Get(&hw.max_cursor_size) &&
+            r.Get(&hw.max_pipe_bw) && r.Get(&hw.max_pipe_bw_high) && r.Get(&hw.max_sde_clk) &&
+            r.Get(&hw.clk_fudge_factor) && r.Get(&hw.macrotile_nv12_factor) &&
+            r.Get(&hw.macrotile_factor) && r.Get(&hw.linear_factor) &&
+            r.Get(&hw.scale_factor) && r.Get(&hw.extra_fudge_factor) &&
+            r.Get(&hw.amortizable_threshold) && r.Get(&hw.system_overhead_lines) &&
+            r.GetBool(&hw.has_ubwc) && r.GetBool(&hw.has_decimation) &&
+            r.GetBool(&hw.has_non_scalar_rgb) && r.GetBool(&hw.is_src_split) &&
+            r.GetBool(&hw.separate_rotator) && r.GetBool(&hw.has_qseed3) &&
+            r.GetBool(&hw.has_concurrent_writeback) && r.GetEnumVector(&hw.tap_points) &&
+            r.GetBool(&hw.has_ppp) && r.GetBool(&hw.has_excl_rect) &&
+            r.Get(&hw.writeback_index) && r.Get(&hw.dyn_bw_info.cur_mode);
+  for (int i = 0; ok && i < kBwModeMax; i++) {
+    ok = r.Get(&hw.dyn_bw_info.total_bw_limit[i]) && r.Get(&hw.dyn_bw_info.pipe_bw_limit[i]);
+  }
+
+  ok = ok && r.GetCount(&count, sizeof(uint32_t));
+  for (uint32_t i = 0; ok && i < count; i++) {
+    HWPipeCaps pipe;
+    uint32_t luts = 0;
+    ok = r.GetEnum(&pipe.type) && r.Get(&pipe.id) && r.Get(&pipe.master_pipe_id) &&
+         r.Get(&pipe.max_rects) && r.GetBool(&pipe.inverse_pma) &&
+         r.Get(&pipe.dgm_csc_version) && r.GetCount(&luts, 2 * sizeof(uint32_t));
+    for (uint32_t j = 0; ok && j < luts; j++) {
+      HWToneMapLut lut = kLutNone;
+      uint32_t version = 0;
+      ok = r.GetEnum(&lut) && r.Get(&version);
+      pipe.tm_lut_version_map[lut] = version;
+    }
+    ok = ok && r.GetBool(&pipe.block_sec_ui) && r.Get(&pipe.pipe_idx) &&
+         r.Get(&pipe.demura_block_capability);
+    hw.hw_pipes.push_back(std::move(pipe));
+  }
+
+  ok = ok && r.GetCount(&count, 2 * sizeof(uint32_t));
+  for (uint32_t i = 0; ok && i < count; i++) {
+    HWSubBlockType sub_blk_type = kHWVIGPipe;
+    std::vector<LayerBufferFormat> formats;
+    ok = r.GetEnum(&sub_blk_type) && r.GetEnumVector(&formats);
+    hw.supported_formats_map[sub_blk_type] = std::move(formats);
+  }
+
+  ok = ok && r.Get(&hw.hw_rot_info.num_rotator) && r.GetBool(&hw.hw_rot_info.has_downscale) &&
+       r.GetString(&hw.hw_rot_info.device_path) && r.Get(&hw.hw_rot_info.min_downscale) &&
+       r.GetBool(&hw.hw_rot_info.downscale_compression) &&
+       r.Get(&hw.hw_rot_info.max_line_width) && r.Get(&hw.hw_dest_scalar_info.count) &&
+       r.Get(&hw.hw_dest_scalar_info.max_input_width) &&
+       r.Get(&hw.hw_dest_scalar_info.max_output_width) &&
+       r.Get(&hw.hw_dest_scalar_info.max_scale_up) &&
+       r.Get(&hw.hw_dest_scalar_info.prefill_lines) && r.GetBool(&hw.has_hdr) &&
+       r.GetEnum(&hw.smart_dma_rev) && r.Get(&hw.ib_fudge_factor) &&
+       r.Get(&hw.undersized_prefill_lines);
+
+  for (auto *comp_ratio_map : {&hw.comp_ratio_rt_map, &hw.comp_ratio_nrt_map}) {
+    ok = ok && r.GetCount(&count, sizeof(uint32_t) + sizeof(float));
+    for (uint32_t i = 0; ok && i < count; i++) {
+      LayerBufferFormat format = kFormatInvalid;
+      float ratio = 0.0f;
+      ok = r.GetEnum(&format) && r.Get(&ratio);
+      (*comp_ratio_map)[format] = ratio;
+    }
+  }
+
+  uint32_t src_tone_map = 0;
+  ok = ok && r.Get(&hw.cache_size) && r.GetEnum(&hw.pipe_qseed3_version) &&
+       r.Get(&hw.min_prefill_lines) && r.GetEnum(&hw.inline_rot_info.inrot_version) &&
+       r.GetEnumVector(&hw.inline_rot_info.inrot_fmts_supported) &&
+       r.Get(&hw.inline_rot_info.max_downscale_rt) &&
+       r.Get(&hw.inline_rot_info.max_ds_without_pre_downscaler) && r.Get(&src_tone_map) &&
+       r.Get(&hw.secure_disp_blend_stage) && r.Get(&hw.line_width_constraints_count);
+  hw.src_tone_map = src_tone_map;
+
+  for (auto *limits : {&hw.line_width_limits, &hw.line_width_constraints}) {
+    ok = ok && r.GetCount(&count, 2 * sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < count; i++) {
+      std::pair<uint32_t, uint32_t> limit;
+      ok = r.Get(&limit.first) && r.Get(&limit.second);
+      limits->push_back(limit);
+    }
+  }
+
+  ok = ok && r.Get(&hw.num_mnocports) && r.Get(&hw.mnoc_bus_width) &&
+       r.GetBool(&hw.use_baselayer_for_stage) && r.GetBool(&hw.has_micro_idle) &&
+       r.Get(&hw.ubwc_version) && r.Get(&hw.rc_total_mem_size) && r.Get(&hw.demura_count) &&
+       r.Get(&hw.dspp_count) && r.GetBool(&hw.skip_inline_rot_threshold) &&
+       r.GetBool(&hw.has_noise_layer) && r.Get(&hw.dsc_block_count) &&
+       r.GetEnum(&hw.ddr_version) && r.Done();
+
+  if (!ok) {
+    return false;
+  }
+
+  *out = std::move(hw);
+  return true;
+}
+
+DisplayError HWInfoSnapshot::Load(const char *path, const HWInfoSnapshotKey &key,
+                                  HWResourceInfo *hw_resource) {
+  std::ifstream fs(path, std::ios::binary);
+  if (!fs.is_open()) {
+    return kErrorNotSupported;
+  }
+  std::stringstream buffer;
+  buffer << fs.rdbuf();
+  std::string file = buffer.str();
+
+  if (file.size() < sizeof(uint64_t)) {
+    return kErrorParameters;
+  }
+  size_t body_size = file.size() - sizeof(uint64_t);
+  uint64_t checksum = 0;
+  memcpy(&checksum, file.data() + body_size, sizeof(checksum));
+  if (checksum != Checksum(file.data(), body_size)) {
+    return kErrorParameters;
+  }
+  file.resize(body_size);
+
+  BinaryReader r(file);
+  uint32_t magic = 0, version = 0, struct_size = 0;
+  HWInfoSnapshotKey file_key;
+  std::string payload;
+  if (!r.Get(&magic) || !r.Get(&version) || !r.Get(&struct_size) || magic != kMagic ||
+      version != kVersion || struct_size != sizeof(HWResourceInfo)) {
+    return kErrorVersion;
+  }
+  if (!r.GetString(&file_key.kernel_build) || !r.GetString(&file_key.soc_id) ||
+      !r.GetString(&file_key.module_build) || !r.GetString(&file_key.panel_id) ||
+      !r.GetString(&file_key.probe_config) || !r.GetString(&payload) || !r.Done()) {
+    return kErrorParameters;
+  }
+  if (file_key != key) {
+    return kErrorNotSupported;
+  }
+
+  return Deserialize(payload, hw_resource) ? kErrorNone : kErrorParameters;
+}
+
+DisplayError HWInfoSnapshot::Store(const char *path, const HWInfoSnapshotKey &key,
+                                   const HWResourceInfo &hw_resource) {
+  std::string payload;
+  Serialize(hw_resource, &payload);
+
+  std::string file;
+  BinaryWriter w(&file);
+  w.Put(kMagic);
+  w.Put(kVersion);
+  w.Put<uint32_t>(UINT32(sizeof(HWResourceInfo)));
+  w.PutString(key.kernel_build);
+  w.PutString(key.soc_id);
+  w.PutString(key.module_build);
+  w.PutString(key.panel_id);
+  w.PutString(key.probe_config);
+  w.PutString(payload);
+  w.Put(Checksum(file.data(), file.size()));
+
+  // Write aside and rename, so a reader never sees a partially written snapshot.
+  std::string tmp_path = std::string(path) + ".tmp";
+  FILE *fp = fopen(tmp_path.c_str(), "wb");
+  if (!fp) {
+    return kErrorPermission;
+  }
+  bool written = (fwrite(file.data(), 1, file.size(), fp) == file.size());
+  written = (fflush(fp) == 0) && written;
+  written = (fsync(fileno(fp)) == 0) && written;
+  fclose(fp);
+  if (!written || rename(tmp_path.c_str(), path)) {
+    unlink(tmp_path.c_str());
+    return kErrorResources;
+  }
+
+  return kErrorNone;
+}
+
+void HWInfoSnapshot::Remove(const char *path) {
+  unlink(path);
+}
+
+}  // namespace sdm
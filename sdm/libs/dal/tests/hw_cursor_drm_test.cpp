@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <stdarg.h>
+
+#include <vector>
+
+#include "../hw_cursor_drm.h"
+
+using namespace sdm;
+using sde_drm::DRMOps;
+using sde_drm::DRMRect;
+
+namespace {
+
+// Records the plane rects of each commit instead of talking to the driver.
+class StubAtomicReq : public sde_drm::DRMAtomicReqInterface {
+ public:
+  struct Op {
+    DRMOps opcode;
+    uint32_t obj_id;
+    DRMRect rect;
+  };
+
+  struct CommitInfo {
+    std::vector<Op> ops;
+    bool synchronous;
+    bool retain_planes;
+  };
+
+  int Perform(DRMOps opcode, uint32_t obj_id, ...) override {
+    va_list args;
+    va_start(args, obj_id);
+    Op op = {opcode, obj_id, {}};
+    if (opcode == DRMOps::PLANE_SET_SRC_RECT || opcode == DRMOps::PLANE_SET_DST_RECT) {
+      op.rect = va_arg(args, DRMRect);
+    }
+    va_end(args);
+    pending_.push_back(op);
+    return 0;
+  }
+
+  int Commit(bool synchronous, bool retain_planes) override {
+    commits_.push_back({pending_, synchronous, retain_planes});
+    pending_.clear();
+    return busy_ ? -EBUSY : 0;
+  }
+
+  int Validate() override { return 0; }
+
+  std::vector<CommitInfo> commits_;
+  bool busy_ = false;
+
+ private:
+  std::vector<Op> pending_;
+};
+
+// Wallpaper, an app window and a 64x64 cursor on its own plane.
+HWLayersInfo MakeDesktop() {
+  HWLayersInfo info;
+  info.hw_layers.resize(3);
+  info.hw_layers[0].composition = kCompositionSDE;
+  info.hw_layers[1].composition = kCompositionSDE;
+  info.hw_layers[2].composition = kCompositionCursor;
+  for (uint32_t i = 0; i < 3; i++) {
+    info.config[i].left_pipe.valid = true;
+    info.config[i].left_pipe.pipe_id = 100 + i;
+  }
+  info.config[2].left_pipe.src_roi = LayerRect(0, 0, 64, 64);
+  info.config[2].left_pipe.dst_roi = LayerRect(500, 300, 564, 364);
+  return info;
+}
+
+bool SameRect(const DRMRect &drm_rect, const LayerRect &rect) {
+  return drm_rect.left == UINT32(rect.left) && drm_rect.top == UINT32(rect.top) &&
+         drm_rect.right == UINT32(rect.right) && drm_rect.bottom == UINT32(rect.bottom);
+}
+
+TEST(HWCursorDRMTest, FindsCursorLayer) {
+  HWLayersInfo info = MakeDesktop();
+  EXPECT_EQ(HWCursorDRM::GetCursorIndex(info), 2);
+
+  // A cursor layer the strategy did not put on a plane cannot be moved.
+  info.config[2].left_pipe.valid = false;
+  EXPECT_EQ(HWCursorDRM::GetCursorIndex(info), -1);
+  info.hw_layers[2].composition = kCompositionSDE;
+  info.config[2].left_pipe.valid = true;
+  EXPECT_EQ(HWCursorDRM::GetCursorIndex(info), -1);
+}
+
+TEST(HWCursorDRMTest, CommitsOnlyCursorRects) {
+  HWLayersInfo info = MakeDesktop();
+  StubAtomicReq atomic_req;
+
+  // A mouse drag: every move is one commit carrying the cursor plane only.
+  for (uint32_t i = 0; i < 10; i++) {
+    HWPipeInfo &pipe = info.config[2].left_pipe;
+    pipe.dst_roi = LayerRect(500 + 7 * i, 300 + 3 * i, 564 + 7 * i, 364 + 3 * i);
+    ASSERT_EQ(HWCursorDRM::Commit(&atomic_req, info.config[2]), kErrorNone);
+
+    const StubAtomicReq::CommitInfo &commit = atomic_req.commits_.back();
+    EXPECT_FALSE(commit.synchronous);
+    EXPECT_TRUE(commit.retain_planes);
+    ASSERT_EQ(commit.ops.size(), 2u);
+    for (auto &op : commit.ops) {
+      EXPECT_EQ(op.obj_id, 102u);
+    }
+    EXPECT_EQ(commit.ops[0].opcode, DRMOps::PLANE_SET_SRC_RECT);
+    EXPECT_TRUE(SameRect(commit.ops[0].rect, pipe.src_roi));
+    EXPECT_EQ(commit.ops[1].opcode, DRMOps::PLANE_SET_DST_RECT);
+    EXPECT_TRUE(SameRect(commit.ops[1].rect, pipe.dst_roi));
+  }
+  EXPECT_EQ(atomic_req.commits_.size(), 10u);
+}
+
+TEST(HWCursorDRMTest, SplitCursorMovesBothPlanes) {
+  HWLayersInfo info = MakeDesktop();
+  HWLayerConfig &config = info.config[2];
+  config.left_pipe.src_roi = LayerRect(0, 0, 24, 64);
+  config.left_pipe.dst_roi = LayerRect(1056, 300, 1080, 364);
+  config.right_pipe.valid = true;
+  config.right_pipe.pipe_id = 105;
+  config.right_pipe.src_roi = LayerRect(24, 0, 64, 64);
+  config.right_pipe.dst_roi = LayerRect(1080, 300, 1120, 364);
+
+  StubAtomicReq atomic_req;
+  ASSERT_EQ(HWCursorDRM::Commit(&atomic_req, config), kErrorNone);
+  const std::vector<StubAtomicReq::Op> &ops = atomic_req.commits_.back().ops;
+  ASSERT_EQ(ops.size(), 4u);
+  EXPECT_EQ(ops[0].obj_id, 102u);
+  EXPECT_EQ(ops[2].obj_id, 105u);
+  EXPECT_TRUE(SameRect(ops[3].rect, config.right_pipe.dst_roi));
+}
+
+TEST(HWCursorDRMTest, BusyCommitFallsBack) {
+  HWLayersInfo info = MakeDesktop();
+  StubAtomicReq atomic_req;
+  atomic_req.busy_ = true;
+  EXPECT_NE(HWCursorDRM::Commit(&atomic_req, info.config[2]), kErrorNone);
+}
+
+}  // namespace
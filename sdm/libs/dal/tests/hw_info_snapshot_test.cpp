@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <private/hw_info_snapshot.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+using namespace sdm;
+
+namespace {
+
+HWResourceInfo MakeResourceInfo() {
+  HWResourceInfo hw;
+  hw.hw_version = 0x90000000;
+  hw.num_dma_pipe = 4;
+  hw.num_vig_pipe = 4;
+  hw.max_bandwidth_low = 15600000;
+  hw.max_sde_clk = 514000000;
+  hw.clk_fudge_factor = 1.05f;
+  hw.has_ubwc = true;
+  hw.has_concurrent_writeback = true;
+  hw.tap_points = {CwbTapPoint::kLmTapPoint, CwbTapPoint::kDsppTapPoint};
+  hw.dyn_bw_info.total_bw_limit[kBwVFEOn] = 123;
+  hw.dyn_bw_info.pipe_bw_limit[kBwVFEOff] = 456;
+
+  HWPipeCaps pipe;
+  pipe.type = kPipeTypeVIG;
+  pipe.id = 47;
+  pipe.max_rects = 2;
+  pipe.inverse_pma = true;
+  pipe.tm_lut_version_map[kVig3dGamut] = 3;
+  pipe.pipe_idx = 1;
+  hw.hw_pipes.push_back(pipe);
+  pipe.type = kPipeTypeDMA;
+  pipe.id = 53;
+  pipe.master_pipe_id = 47;
+  pipe.tm_lut_version_map.clear();
+  hw.hw_pipes.push_back(pipe);
+
+  hw.supported_formats_map[kHWVIGPipe] = {kFormatRGBA8888, kFormatYCbCr420SemiPlanarVenus};
+  hw.supported_formats_map[kHWWBIntfOutput] = {kFormatRGB888};
+  hw.hw_rot_info.num_rotator = 1;
+  hw.hw_rot_info.device_path = "/dev/video3";
+  hw.hw_rot_info.min_downscale = 1.5f;
+  hw.hw_dest_scalar_info.count = 2;
+  hw.smart_dma_rev = SmartDMARevision::V2p5;
+  hw.comp_ratio_rt_map[kFormatRGBA8888Ubwc] = 1.4f;
+  hw.comp_ratio_nrt_map[kFormatInvalid] = 1.0f;
+  hw.pipe_qseed3_version = kQseed3litev8;
+  hw.inline_rot_info.inrot_version = kInlineRotationV2;
+  hw.inline_rot_info.inrot_fmts_supported = {kFormatYCbCr420TP10Ubwc};
+  hw.src_tone_map[kSrcTonemap3d] = 1;
+  hw.secure_disp_blend_stage = -1;
+  hw.line_width_limits = {{1, 2560}, {2, 5120}};
+  hw.line_width_constraints = {{3, 4096}};
+  hw.demura_count = 2;
+  hw.dsc_block_count = 4;
+  hw.ddr_version = kDDRVersion4;
+  return hw;
+}
+
+HWInfoSnapshotKey MakeKey() {
+  HWInfoSnapshotKey key;
+  key.kernel_build = "5.15.94 #1 SMP PREEMPT";
+  key.soc_id = "519";
+  key.module_build = "qcom/pineapple/pineapple:14/AP1A/1:user/release-keys 8A2D9C3F5E7B";
+  key.panel_id = "dsi_display0=qcom,mdss_dsi_panel_cmd:";
+  key.probe_config = "0,0,0";
+  return key;
+}
+
+class HWInfoSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = testing::TempDir() + "hw_info_snapshot_test_" + std::to_string(getpid()) + ".bin";
+  }
+  void TearDown() override { unlink(path_.c_str()); }
+
+  std::string ReadFile() {
+    std::ifstream fs(path_, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+  }
+  void WriteFile(const std::string &contents) {
+    std::ofstream fs(path_, std::ios::binary | std::ios::trunc);
+    fs << contents;
+  }
+
+  std::string path_;
+};
+
+TEST_F(HWInfoSnapshotTest, PayloadRoundTrip) {
+  HWResourceInfo hw = MakeResourceInfo();
+  std::string payload;
+  HWInfoSnapshot::Serialize(hw, &payload);
+
+  HWResourceInfo restored;
+  ASSERT_TRUE(HWInfoSnapshot::Deserialize(payload, &restored));
+  EXPECT_EQ(restored.hw_version, hw.hw_version);
+  EXPECT_EQ(restored.clk_fudge_factor, hw.clk_fudge_factor);
+  EXPECT_EQ(restored.tap_points, hw.tap_points);
+  ASSERT_EQ(restored.hw_pipes.size(), 2u);
+  EXPECT_EQ(restored.hw_pipes[0].tm_lut_version_map, hw.hw_pipes[0].tm_lut_version_map);
+  EXPECT_EQ(restored.hw_pipes[1].master_pipe_id, 47u);
+  EXPECT_EQ(restored.supported_formats_map, hw.supported_formats_map);
+  EXPECT_EQ(restored.hw_rot_info.device_path, hw.hw_rot_info.device_path);
+  EXPECT_EQ(restored.comp_ratio_nrt_map, hw.comp_ratio_nrt_map);
+  EXPECT_EQ(restored.src_tone_map, hw.src_tone_map);
+  EXPECT_EQ(restored.line_width_limits, hw.line_width_limits);
+  EXPECT_EQ(restored.ddr_version, kDDRVersion4);
+
+  // Every field is covered, so encoding the restored copy gives the same bytes.
+  std::string again;
+  HWInfoSnapshot::Serialize(restored, &again);
+  EXPECT_EQ(again, payload);
+}
+
+TEST_F(HWInfoSnapshotTest, SplashStateIsNotPersisted) {
+  HWResourceInfo hw = MakeResourceInfo();
+  std::string payload;
+  HWInfoSnapshot::Serialize(hw, &payload);
+
+  hw.plane_to_connector[47] = 31;
+  hw.initial_demura_planes = {53};
+  hw.hw_pipes[0].cont_splash_disp_id = 31;
+  hw.hw_pipes[0].splash_type = kSplashLayer;
+  std::string with_splash;
+  HWInfoSnapshot::Serialize(hw, &with_splash);
+  EXPECT_EQ(with_splash, payload);
+}
+
+TEST_F(HWInfoSnapshotTest, TruncatedPayloadIsRejected) {
+  std::string payload;
+  HWInfoSnapshot::Serialize(MakeResourceInfo(), &payload);
+
+  HWResourceInfo restored;
+  for (size_t size = 0; size < payload.size(); size += 7) {
+    EXPECT_FALSE(HWInfoSnapshot::Deserialize(payload.substr(0, size), &restored));
+  }
+  EXPECT_FALSE(HWInfoSnapshot::Deserialize(payload + '\0', &restored));
+}
+
+TEST_F(HWInfoSnapshotTest, StoreAndLoad) {
+  HWResourceInfo hw = MakeResourceInfo();
+  ASSERT_EQ(HWInfoSnapshot::Store(path_.c_str(), MakeKey(), hw), kErrorNone);
+
+  HWResourceInfo loaded;
+  ASSERT_EQ(HWInfoSnapshot::Load(path_.c_str(), MakeKey(), &loaded), kErrorNone);
+  std::string expected, actual;
+  HWInfoSnapshot::Serialize(hw, &expected);
+  HWInfoSnapshot::Serialize(loaded, &actual);
+  EXPECT_EQ(actual, expected);
+}
+
+TEST_F(HWInfoSnapshotTest, KeyMismatchIsRejected) {
+  ASSERT_EQ(HWInfoSnapshot::Store(path_.c_str(), MakeKey(), MakeResourceInfo()), kErrorNone);
+
+  HWResourceInfo loaded;
+  HWInfoSnapshotKey key = MakeKey();
+  key.kernel_build = "5.15.94 #2 SMP PREEMPT";
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), key, &loaded), kErrorNotSupported);
+  key = MakeKey();
+  key.module_build = "qcom/pineapple/pineapple:14/AP1A/2:user/release-keys 41C07E2B9D3A";
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), key, &loaded), kErrorNotSupported);
+  key = MakeKey();
+  key.panel_id = "dsi_display0=qcom,mdss_dsi_panel_video:";
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), key, &loaded), kErrorNotSupported);
+  key = MakeKey();
+  key.probe_config = "2,2,0";
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), key, &loaded), kErrorNotSupported);
+}
+
+TEST_F(HWInfoSnapshotTest, CorruptFileIsRejected) {
+  ASSERT_EQ(HWInfoSnapshot::Store(path_.c_str(), MakeKey(), MakeResourceInfo()), kErrorNone);
+  std::string contents = ReadFile();
+
+  HWResourceInfo loaded;
+  std::string flipped = contents;
+  flipped[flipped.size() / 2] ^= 0x40;
+  WriteFile(flipped);
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), MakeKey(), &loaded), kErrorParameters);
+
+  WriteFile(contents.substr(0, contents.size() - 3));
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), MakeKey(), &loaded), kErrorParameters);
+}
+
+TEST_F(HWInfoSnapshotTest, MissingFileIsNotAnError) {
+  HWResourceInfo loaded;
+  EXPECT_EQ(HWInfoSnapshot::Load(path_.c_str(), MakeKey(), &loaded), kErrorNotSupported);
+  HWInfoSnapshot::Remove(path_.c_str());
+}
+
+}  // namespace
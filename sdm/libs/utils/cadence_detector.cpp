@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/cadence_detector.h>
+
+#include <cstdlib>
+
+namespace sdm {
+
+static const int64_t kNsPerSec = 1000000000LL;
+// Gaps longer than this are pauses in the content, not part of its cadence.
+static const int64_t kMaxIntervalNs = 100000000LL;
+// Frame rates content is commonly produced at.
+static const uint32_t kContentRates[] = {24, 25, 30, 48, 50, 60, 72, 90, 120};
+static const uint32_t kRateTolerancePercent = 3;
+
+void CadenceDetector::OnBufferUpdate(int64_t timestamp_ns) {
+  int64_t interval_ns = timestamp_ns - last_timestamp_ns_;
+  bool first_update = (last_timestamp_ns_ == 0);
+  last_timestamp_ns_ = timestamp_ns;
+  if (first_update || interval_ns <= 0) {
+    return;
+  }
+
+  if (interval_ns > kMaxIntervalNs) {
+    Reset();
+    last_timestamp_ns_ = timestamp_ns;
+    return;
+  }
+
+  // Content sped up past the locked rate. A single short interval is usually a late frame being
+  // caught up, two in a row are not.
+  if (locked_rate_ && (interval_ns * locked_rate_ * 4 < kNsPerSec * 3)) {
+    if (++short_count_ >= kUnlockCount) {
+      locked_rate_ = 0;
+      candidate_count_ = 0;
+    }
+  } else {
+    short_count_ = 0;
+  }
+
+  intervals_ns_[index_] = interval_ns;
+  index_ = (index_ + 1) % kWindowSize;
+  if (count_ < kWindowSize && ++count_ < kWindowSize) {
+    return;
+  }
+
+  // Use the mean over the window so that pulldown patterns like 3:2 resolve to the content rate.
+  int64_t sum_ns = 0;
+  for (uint32_t i = 0; i < kWindowSize; i++) {
+    sum_ns += intervals_ns_[i];
+  }
+  int64_t mean_ns = sum_ns / kWindowSize;
+
+  bool stable = true;
+  for (uint32_t i = 0; i < kWindowSize; i++) {
+    if (std::llabs(intervals_ns_[i] - mean_ns) * 2 > mean_ns) {
+      stable = false;
+      break;
+    }
+  }
+
+  uint32_t rate = stable ? SnapToContentRate(mean_ns) : 0;
+  if (!rate) {
+    candidate_count_ = 0;
+    if (++unstable_count_ >= kUnlockCount) {
+      locked_rate_ = 0;
+    }
+    return;
+  }
+
+  unstable_count_ = 0;
+  if (rate == candidate_rate_) {
+    candidate_count_++;
+  } else {
+    candidate_rate_ = rate;
+    candidate_count_ = 1;
+  }
+
+  // Moving up is never delayed, moving down needs the new cadence to hold.
+  if ((locked_rate_ && rate > locked_rate_) || candidate_count_ >= kLockCount) {
+    locked_rate_ = rate;
+  }
+}
+
+void CadenceDetector::Reset() {
+  last_timestamp_ns_ = 0;
+  index_ = 0;
+  count_ = 0;
+  candidate_rate_ = 0;
+  candidate_count_ = 0;
+  unstable_count_ = 0;
+  short_count_ = 0;
+  locked_rate_ = 0;
+}
+
+uint32_t CadenceDetector::SnapToContentRate(int64_t interval_ns) {
+  uint32_t rate = 0;
+  int64_t min_error_ns = 0;
+  for (auto content_rate : kContentRates) {
+    int64_t content_interval_ns = kNsPerSec / content_rate;
+    int64_t error_ns = std::llabs(interval_ns - content_interval_ns);
+    if ((error_ns * 100 <= content_interval_ns * kRateTolerancePercent) &&
+        (!rate || error_ns < min_error_ns)) {
+      rate = content_rate;
+      min_error_ns = error_ns;
+    }
+  }
+
+  return rate;
+}
+
+}  // namespace sdm
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/frame_latency_stats.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace sdm {
+
+static const char *kStageNames[kLatencyStageMax] = {
+  "hwc validate",
+  "hwc present",
+  "prepare",
+  "comp prepare",
+  "hw validate",
+  "hw commit",
+  "async commit",
+};
+
+uint32_t LatencyHistogram::GetBucket(uint64_t value) {
+  if (value < (1u << kSubBucketBits)) {
+    return static_cast<uint32_t>(value);
+  }
+  uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+  uint32_t shift = msb - kSubBucketBits;
+  uint32_t sub_bucket = static_cast<uint32_t>(value >> shift) & ((1u << kSubBucketBits) - 1);
+  return ((shift + 1) << kSubBucketBits) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(uint32_t bucket) {
+  if (bucket < (1u << kSubBucketBits)) {
+    return bucket;
+  }
+  uint32_t shift = (bucket >> kSubBucketBits) - 1;
+  uint64_t mantissa = (1u << kSubBucketBits) + (bucket & ((1u << kSubBucketBits) - 1));
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  buckets_[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Reset() {
+  // Records racing with a reset may survive it partially, which only skews the next dump.
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetMean() const {
+  uint64_t count = GetCount();
+  return count ? (sum_.load(std::memory_order_relaxed) / count) : 0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(uint32_t percent) const {
+  uint64_t counts[kBuckets];
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < kBuckets; i++) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (!total) {
+    return 0;
+  }
+
+  uint64_t rank = (total * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < kBuckets; i++) {
+    seen += counts[i];
+    if (seen >= rank && counts[i]) {
+      return std::min(GetBucketUpperBound(i), GetMax());
+    }
+  }
+  return GetMax();
+}
+
+FrameLatencyStats *FrameLatencyStats::GetTable() {
+  // Entries are never released, so pointers handed out stay valid for the process lifetime.
+  static FrameLatencyStats table[kMaxDisplays];
+  return table;
+}
+
+FrameLatencyStats *FrameLatencyStats::Get(int32_t display_id) {
+  if (display_id == kInvalidId) {
+    return nullptr;
+  }
+
+  FrameLatencyStats *table = GetTable();
+  for (int32_t i = 0; i < kMaxDisplays; i++) {
+    int32_t id = table[i].display_id_.load(std::memory_order_acquire);
+    if (id == kInvalidId) {
+      // Claim the free entry, unless another thread raced in with the same id.
+      if (table[i].display_id_.compare_exchange_strong(id, display_id,
+                                                       std::memory_order_acq_rel)) {
+        return &table[i];
+      }
+    }
+    if (id == display_id) {
+      return &table[i];
+    }
+  }
+
+  return nullptr;
+}
+
+std::string FrameLatencyStats::DumpAll() {
+  std::string dump;
+  FrameLatencyStats *table = GetTable();
+  // Entries are claimed in order, the first free one ends the table.
+  for (int32_t i = 0; i < kMaxDisplays; i++) {
+    if (table[i].display_id_.load(std::memory_order_acquire) == kInvalidId) {
+      break;
+    }
+    dump += table[i].Dump();
+  }
+  return dump;
+}
+
+void FrameLatencyStats::ResetAll() {
+  FrameLatencyStats *table = GetTable();
+  for (int32_t i = 0; i < kMaxDisplays; i++) {
+    if (table[i].display_id_.load(std::memory_order_acquire) == kInvalidId) {
+      break;
+    }
+    table[i].Reset();
+  }
+}
+
+void FrameLatencyStats::Record(FrameLatencyStage stage, int64_t duration_ns) {
+  if (stage < kLatencyStageMax && duration_ns >= 0) {
+    stages_[stage].Record(static_cast<uint64_t>(duration_ns) / 1000);
+  }
+}
+
+void FrameLatencyStats::Reset() {
+  for (auto &stage : stages_) {
+    stage.Reset();
+  }
+  strategy_count_.Reset();
+}
+
+std::string FrameLatencyStats::Dump() const {
+  std::ostringstream os;
+  os << "Frame latency display " << display_id_.load(std::memory_order_relaxed) << " (us)\n";
+  os << std::left << std::setw(16) << "stage" << std::right << std::setw(10) << "count"
+     << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+     << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+
+  auto dump_histogram = [&os](const char *name, const LatencyHistogram &histogram) {
+    os << std::left << std::setw(16) << name << std::right << std::setw(10)
+       << histogram.GetCount() << std::setw(10) << histogram.GetMean() << std::setw(10)
+       << histogram.GetPercentile(50) << std::setw(10) << histogram.GetPercentile(90)
+       << std::setw(10) << histogram.GetPercentile(99) << std::setw(10) << histogram.GetMax()
+       << "\n";
+  };
+  for (int stage = 0; stage < kLatencyStageMax; stage++) {
+    dump_histogram(kStageNames[stage], stages_[stage]);
+  }
+  dump_histogram("strategies", strategy_count_);
+
+  return os.str();
+}
+
+}  // namespace sdm
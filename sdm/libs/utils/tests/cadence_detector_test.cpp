@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <utils/cadence_detector.h>
+
+#include <vector>
+
+using namespace sdm;
+
+namespace {
+
+const int64_t kNsPerSec = 1000000000LL;
+const int64_t kNsPerMs = 1000000LL;
+
+// Buffer change times of content at content_fps latched on the next vsync of a panel running at
+// panel_fps. jitter_ns is added to every other frame to model late latches.
+std::vector<int64_t> Trace(uint32_t content_fps, uint32_t panel_fps, uint32_t frames,
+                           int64_t start_ns = kNsPerSec, int64_t jitter_ns = 0) {
+  std::vector<int64_t> trace;
+  for (uint32_t i = 0; i < frames; i++) {
+    int64_t vsync = (int64_t(i) * panel_fps + content_fps - 1) / content_fps;
+    int64_t latched_ns = (vsync * kNsPerSec) / panel_fps;
+    trace.push_back(start_ns + latched_ns + ((i % 2) ? jitter_ns : 0));
+  }
+  return trace;
+}
+
+struct ReplayResult {
+  int lock_frame = -1;
+  uint32_t locked_rate = 0;
+  uint32_t rate_changes = 0;
+  std::vector<uint32_t> rates;
+};
+
+ReplayResult Replay(CadenceDetector *detector, const std::vector<int64_t> &trace) {
+  ReplayResult result;
+  uint32_t prev_rate = detector->GetRate();
+  for (size_t i = 0; i < trace.size(); i++) {
+    detector->OnBufferUpdate(trace[i]);
+    uint32_t rate = detector->GetRate();
+    if (rate && result.lock_frame < 0) {
+      result.lock_frame = static_cast<int>(i);
+    }
+    if (rate != prev_rate) {
+      result.rate_changes++;
+    }
+    prev_rate = rate;
+    result.rates.push_back(rate);
+  }
+  result.locked_rate = prev_rate;
+  return result;
+}
+
+}  // namespace
+
+TEST(CadenceDetector, LocksOnStandardRates) {
+  struct { uint32_t content; uint32_t panel; } cases[] = {
+    {24, 60}, {24, 90}, {24, 120}, {25, 120}, {30, 60}, {30, 90}, {48, 120}, {60, 120},
+  };
+  for (auto &c : cases) {
+    CadenceDetector detector;
+    ReplayResult result = Replay(&detector, Trace(c.content, c.panel, 120));
+    EXPECT_EQ(c.content, result.locked_rate) << c.content << "@" << c.panel;
+    // Window fill plus the lock hysteresis.
+    EXPECT_GE(result.lock_frame, 0) << c.content << "@" << c.panel;
+    EXPECT_LE(result.lock_frame, 11) << c.content << "@" << c.panel;
+    EXPECT_EQ(1u, result.rate_changes) << c.content << "@" << c.panel;
+  }
+}
+
+TEST(CadenceDetector, StaysLockedUnderJitter) {
+  CadenceDetector detector;
+  ReplayResult result = Replay(&detector, Trace(30, 120, 300, kNsPerSec, 3 * kNsPerMs));
+  EXPECT_EQ(30u, result.locked_rate);
+  EXPECT_EQ(1u, result.rate_changes);
+}
+
+TEST(CadenceDetector, ToleratesSingleLateFrame) {
+  CadenceDetector detector;
+  std::vector<int64_t> trace = Trace(30, 60, 60);
+  // One frame latched a vsync late, the next one on time.
+  trace[40] += kNsPerSec / 60;
+  ReplayResult result = Replay(&detector, trace);
+  EXPECT_EQ(30u, result.locked_rate);
+  for (size_t i = 41; i < trace.size(); i++) {
+    EXPECT_NE(0u, result.rates[i]) << i;
+  }
+}
+
+TEST(CadenceDetector, NeverReportsBelowContentWhenSpeedingUp) {
+  CadenceDetector detector;
+  std::vector<int64_t> trace = Trace(24, 120, 60);
+  std::vector<int64_t> fast = Trace(60, 120, 60, trace.back() + kNsPerSec / 60);
+  ReplayResult slow = Replay(&detector, trace);
+  ASSERT_EQ(24u, slow.locked_rate);
+
+  ReplayResult result = Replay(&detector, fast);
+  // The second short interval drops the lock, any rate reported after that covers the content.
+  EXPECT_EQ(0u, result.rates[1]);
+  for (size_t i = 1; i < result.rates.size(); i++) {
+    EXPECT_TRUE(result.rates[i] == 0 || result.rates[i] >= 60) << i;
+  }
+  EXPECT_EQ(60u, result.locked_rate);
+}
+
+TEST(CadenceDetector, SlowsDownOnlyAfterHysteresis) {
+  CadenceDetector detector;
+  std::vector<int64_t> fast = Trace(60, 120, 60);
+  std::vector<int64_t> slow = Trace(30, 120, 60, fast.back() + kNsPerSec / 30);
+  ASSERT_EQ(60u, Replay(&detector, fast).locked_rate);
+
+  ReplayResult result = Replay(&detector, slow);
+  EXPECT_EQ(30u, result.locked_rate);
+  // The lower rate is only reported once the window holds the new cadence.
+  for (size_t i = 0; i < 8; i++) {
+    EXPECT_NE(30u, result.rates[i]) << i;
+  }
+}
+
+TEST(CadenceDetector, IgnoresNonStandardAndIrregularContent) {
+  CadenceDetector detector;
+  EXPECT_EQ(0u, Replay(&detector, Trace(40, 120, 120)).locked_rate);
+
+  // Timestamps recorded from a scrolling list, touch driven and irregular.
+  const int64_t recorded_ms[] = {
+    0, 8, 17, 25, 42, 50, 58, 75, 83, 92, 117, 125, 133, 142, 167, 175, 183, 200, 208, 233,
+    242, 250, 258, 275, 292, 300, 317, 325, 333, 342, 358, 367, 392, 400, 408, 417, 433, 450,
+  };
+  std::vector<int64_t> trace;
+  for (auto ms : recorded_ms) {
+    trace.push_back(kNsPerSec + ms * kNsPerMs);
+  }
+  detector.Reset();
+  ReplayResult result = Replay(&detector, trace);
+  EXPECT_EQ(0u, result.rate_changes);
+}
+
+TEST(CadenceDetector, ResetsAfterPause) {
+  CadenceDetector detector;
+  std::vector<int64_t> trace = Trace(24, 120, 60);
+  ASSERT_EQ(24u, Replay(&detector, trace).locked_rate);
+
+  detector.OnBufferUpdate(trace.back() + kNsPerSec);
+  EXPECT_EQ(0u, detector.GetRate());
+}
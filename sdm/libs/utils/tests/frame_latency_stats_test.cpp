@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+#include <utils/frame_latency_stats.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sdm;
+
+namespace {
+
+TEST(LatencyHistogramTest, BucketsCoverValueRange) {
+  for (uint64_t value : {0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 1000ull, 16666ull,
+                         (1ull << 40) + 12345ull, ~0ull}) {
+    uint32_t bucket = LatencyHistogram::GetBucket(value);
+    EXPECT_GE(LatencyHistogram::GetBucketUpperBound(bucket), value);
+    if (bucket) {
+      EXPECT_LT(LatencyHistogram::GetBucketUpperBound(bucket - 1), value);
+    }
+  }
+}
+
+TEST(LatencyHistogramTest, BucketsAreMonotonic) {
+  uint32_t prev = 0;
+  for (uint64_t value = 0; value < 100000; value++) {
+    uint32_t bucket = LatencyHistogram::GetBucket(value);
+    ASSERT_GE(bucket, prev);
+    ASSERT_LE(bucket - prev, 1u);
+    prev = bucket;
+  }
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.GetPercentile(50), 0u);
+
+  for (uint64_t value = 1; value <= 1000; value++) {
+    histogram.Record(value);
+  }
+  EXPECT_EQ(histogram.GetCount(), 1000u);
+  EXPECT_EQ(histogram.GetMean(), 500u);
+  EXPECT_EQ(histogram.GetMax(), 1000u);
+
+  for (uint32_t percent : {50u, 90u, 99u}) {
+    uint64_t exact = percent * 10;
+    uint64_t estimate = histogram.GetPercentile(percent);
+    EXPECT_GE(estimate, exact);
+    EXPECT_LE(estimate, exact + exact / 4);
+  }
+  EXPECT_EQ(histogram.GetPercentile(100), 1000u);
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.GetCount(), 0u);
+  EXPECT_EQ(histogram.GetMax(), 0u);
+  EXPECT_EQ(histogram.GetPercentile(99), 0u);
+}
+
+TEST(LatencyHistogramTest, TailIsNotHiddenByMean) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 980; i++) {
+    histogram.Record(2000);
+  }
+  for (int i = 0; i < 20; i++) {
+    histogram.Record(30000);
+  }
+  EXPECT_LT(histogram.GetPercentile(50), 2500u);
+  EXPECT_GE(histogram.GetPercentile(99), 30000u);
+  EXPECT_EQ(histogram.GetMax(), 30000u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecords) {
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&histogram, t]() {
+      for (uint64_t i = 0; i < 10000; i++) {
+        histogram.Record(t * 10000 + i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(histogram.GetCount(), 40000u);
+  EXPECT_EQ(histogram.GetMax(), 39999u);
+}
+
+TEST(FrameLatencyStatsTest, PerDisplayEntries) {
+  FrameLatencyStats *primary = FrameLatencyStats::Get(0);
+  FrameLatencyStats *external = FrameLatencyStats::Get(1);
+  ASSERT_NE(primary, nullptr);
+  ASSERT_NE(external, nullptr);
+  EXPECT_NE(primary, external);
+  EXPECT_EQ(FrameLatencyStats::Get(0), primary);
+  EXPECT_EQ(FrameLatencyStats::Get(-1), nullptr);
+
+  primary->Reset();
+  external->Reset();
+  {
+    ScopedFrameLatency latency(primary, kLatencyHwCommit);
+  }
+  primary->Record(kLatencyPrepare, 4000000);
+  primary->RecordStrategyCount(2);
+  external->Record(kLatencyPrepare, 1000);
+
+  std::string dump = primary->Dump();
+  EXPECT_NE(dump.find("Frame latency display 0"), std::string::npos);
+  EXPECT_NE(dump.find("prepare"), std::string::npos);
+  EXPECT_NE(dump.find("strategies"), std::string::npos);
+
+  std::string all = FrameLatencyStats::DumpAll();
+  EXPECT_NE(all.find("Frame latency display 0"), std::string::npos);
+  EXPECT_NE(all.find("Frame latency display 1"), std::string::npos);
+
+  FrameLatencyStats::ResetAll();
+  EXPECT_EQ(primary->Dump().find("4000"), std::string::npos);
+}
+
+TEST(FrameLatencyStatsTest, TableFull) {
+  std::vector<FrameLatencyStats *> entries;
+  for (int32_t id = 100; id < 200; id++) {
+    FrameLatencyStats *stats = FrameLatencyStats::Get(id);
+    if (!stats) {
+      break;
+    }
+    entries.push_back(stats);
+  }
+  EXPECT_LT(entries.size(), 100u);
+  EXPECT_EQ(FrameLatencyStats::Get(200), nullptr);
+  // Existing entries remain reachable.
+  EXPECT_EQ(FrameLatencyStats::Get(100), entries.front());
+  // Recording against a missing entry is a no-op.
+  ScopedFrameLatency latency(nullptr, kLatencyHwcPresent);
+}
+
+}  // namespace